@@ -116,6 +116,10 @@ enum class Update_t { Local, Global, LazyGlobal };
 
 enum class Regularizer_t { L1, L2 };
 
+enum class CachePolicy_t { LRU, LFU, CLOCK };
+
+enum class StoragePrecision_t { FP32, FP16, BF16, INT8 };
+
 enum class Layer_t {
   BatchNorm,
   BinaryCrossEntropyLoss,
@@ -16,6 +16,7 @@
 
 #include <sys/stat.h>
 #include <common.hpp>
+#include <data_readers/block_codec.hpp>
 #include <fstream>
 #include <random>
 #include <memory>
@@ -112,7 +113,8 @@ class Checker_Traits<Check_t::Sum> {
 
   static char accum(char pre, char x) { return pre + x; }
 
-  static void write(int N, char* array, char chk_bits, std::ofstream& stream) {
+  template <typename Stream>
+  static void write(int N, char* array, char chk_bits, Stream& stream) {
     stream.write(reinterpret_cast<char*>(&N), sizeof(int));
     stream.write(reinterpret_cast<char*>(array), N);
     stream.write(reinterpret_cast<char*>(&chk_bits), sizeof(char));
@@ -128,21 +130,40 @@ class Checker_Traits<Check_t::None> {
 
   static char accum(char pre, char x) { return 0; }
 
-  static void write(int N, char* array, char chk_bits, std::ofstream& stream) {
+  template <typename Stream>
+  static void write(int N, char* array, char chk_bits, Stream& stream) {
     stream.write(reinterpret_cast<char*>(array), N);
   }
 
   static long long ID() { return 0; }
 };
 
+/**
+ * Writes the records of a Norm file. With a compression, the records written by write()
+ * are put into the frames of BlockWriter, whereas write_header() always writes uncompressed.
+ * The header must flag the compression in reserved[0], and flush() must be called before
+ * the header is rewritten or the stream is closed.
+ */
 template <Check_t T>
 class DataWriter {
   std::vector<char> array_;
   std::ofstream& stream_;
   char check_char_{0};
+  BlockWriter block_writer_;
+
+  template <typename Stream>
+  void write_to(Stream& stream) {
+    Checker_Traits<T>::write(static_cast<int>(array_.size()), array_.data(), check_char_, stream);
+    check_char_ = Checker_Traits<T>::zero();
+    array_.clear();
+  }
 
  public:
-  DataWriter(std::ofstream& stream) : stream_(stream) { check_char_ = Checker_Traits<T>::zero(); }
+  DataWriter(std::ofstream& stream, Compression_t compression = Compression_t::None,
+             size_t block_bytes = 1 << 20)
+      : stream_(stream), block_writer_(stream, compression, block_bytes) {
+    check_char_ = Checker_Traits<T>::zero();
+  }
   void append(char* array, int N) {
     for (int i = 0; i < N; i++) {
       array_.push_back(array[i]);
@@ -150,16 +171,18 @@ class DataWriter {
     }
   }
   void write() {
-    Checker_Traits<T>::write(static_cast<int>(array_.size()), array_.data(), check_char_, stream_);
-    check_char_ = Checker_Traits<T>::zero();
-    array_.clear();
+    write_to(block_writer_);
+    block_writer_.end_record();
   }
+  void write_header() { write_to(stream_); }
+  void flush() { block_writer_.flush(); }
 };
 
 template <typename T, Check_t CK_T>
 void data_generation_for_test(std::string file_list_name, std::string data_prefix, int num_files,
                               int num_records_per_file, int slot_num, int vocabulary_size,
-                              int label_dim, int dense_dim, int max_nnz, bool long_tail = false, float alpha = 0.0) {
+                              int label_dim, int dense_dim, int max_nnz, bool long_tail = false, float alpha = 0.0,
+                              Compression_t compression = Compression_t::None) {
   if (file_exist(file_list_name)) {
     std::cout << "File (" + file_list_name +
                      ") exist. To generate new dataset plesae remove this file."
@@ -182,13 +205,19 @@ void data_generation_for_test(std::string file_list_name, std::string data_prefi
     // data generation;
     std::ofstream out_stream(tmp_file_name, std::ofstream::binary);
 
-    DataWriter<CK_T> data_writer(out_stream);
+    DataWriter<CK_T> data_writer(out_stream, compression);
 
-    DataSetHeader header = {
-        Checker_Traits<CK_T>::ID(), num_records_per_file, label_dim, dense_dim, slot_num, 0, 0, 0};
+    DataSetHeader header = {Checker_Traits<CK_T>::ID(),
+                            num_records_per_file,
+                            label_dim,
+                            dense_dim,
+                            slot_num,
+                            static_cast<long long>(compression),
+                            0,
+                            0};
 
     data_writer.append(reinterpret_cast<char*>(&header), sizeof(DataSetHeader));
-    data_writer.write();
+    data_writer.write_header();
 
     for (int i = 0; i < num_records_per_file; i++) {
       IntUniformDataSimulator<int> idata_sim(1, max_nnz);            // for nnz
@@ -216,6 +245,7 @@ void data_generation_for_test(std::string file_list_name, std::string data_prefi
       }
       data_writer.write();
     }
+    data_writer.flush();
     out_stream.close();
   }
   file_list_stream.close();
@@ -357,8 +387,14 @@ inline void data_generation_for_raw(
     std::string file_name, long long num_samples, int label_dim = 1, int dense_dim = 13,
     int sparse_dim = 26, float float_label_dense = false,
     const std::vector<long long> slot_size = std::vector<long long>(),
-    bool long_tail = false, float alpha = 0.0) {
+    bool long_tail = false, float alpha = 0.0,
+    Compression_t compression = Compression_t::None) {
   std::ofstream out_stream(file_name, std::ofstream::binary);
+  if (compression != Compression_t::None) {
+    write_raw_compressed_header(out_stream, num_samples, label_dim, dense_dim, sparse_dim,
+                                compression);
+  }
+  BlockWriter block_writer(out_stream, compression);
   size_t size_label_dense = float_label_dense ? sizeof(float) : sizeof(int);
   for (long long i = 0; i < num_samples; i++) {
     for (int j = 0; j < label_dim; j++) {
@@ -366,14 +402,14 @@ inline void data_generation_for_raw(
       float label_float = static_cast<float>(label_int);
       char* label_ptr = float_label_dense ? reinterpret_cast<char*>(&label_float)
                                           : reinterpret_cast<char*>(&label_int);
-      out_stream.write(label_ptr, size_label_dense);
+      block_writer.write(label_ptr, size_label_dense);
     }
     for (int j = 0; j < dense_dim; j++) {
       int dense_int = j;
       float dense_float = static_cast<float>(dense_int);
       char* dense_ptr = float_label_dense ? reinterpret_cast<char*>(&dense_float)
                                           : reinterpret_cast<char*>(&dense_int);
-      out_stream.write(dense_ptr, size_label_dense);
+      block_writer.write(dense_ptr, size_label_dense);
     }
     for (int j = 0; j < sparse_dim; j++) {
       int sparse = 0;
@@ -389,9 +425,11 @@ inline void data_generation_for_raw(
       } else {
         sparse = j;
       }
-      out_stream.write(reinterpret_cast<char*>(&sparse), sizeof(int));
+      block_writer.write(reinterpret_cast<char*>(&sparse), sizeof(int));
     }
+    block_writer.end_record();
   }
+  block_writer.flush();
   out_stream.close();
   return;
 }
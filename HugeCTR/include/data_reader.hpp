@@ -53,13 +53,20 @@ public:
 
   virtual void create_drwg_norm(std::string file_list, 
                         Check_t check_type,
-                        bool start_reading_from_beginning = true) = 0;
+                        bool start_reading_from_beginning = true,
+                        bool use_mmap = false,
+                        int num_parse_threads = 1,
+                        int shuffle_buffer_size = 0,
+                        bool shuffle_files = false,
+                        int async_io_depth = 0) = 0;
   virtual void create_drwg_raw( std::string file_name, 
                         long long num_samples,
                         const std::vector<long long> slot_offset, 
                         bool float_label_dense,
                         bool data_shuffle, 
-                        bool start_reading_from_beginning = true) = 0;
+                        bool start_reading_from_beginning = true,
+                        long long shuffle_block_size = 0,
+                        int async_io_depth = 0) = 0;
 
   virtual void create_drwg_parquet( std::string file_list,
                             const std::vector<long long> slot_offset,
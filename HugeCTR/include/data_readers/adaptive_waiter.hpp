@@ -0,0 +1,84 @@
+/*
+ * Copyright (c) 2020, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+namespace HugeCTR {
+
+inline void cpu_relax() {
+#if defined(__x86_64__) || defined(__i386__)
+  __builtin_ia32_pause();
+#endif
+}
+
+/**
+ * @brief Spin-then-park waiting on a predicate.
+ *
+ * The waiter spins (and then yields) for a bounded number of iterations, which covers the
+ * common case where the other side is about to publish, and only then parks on a
+ * condition variable.
+ * notify_all() is cheap when nobody is parked: it does not touch the mutex.
+ * The predicate must become true through a store that precedes the notify_all() call.
+ */
+class AdaptiveWaiter {
+ private:
+  const int spin_count_;
+  std::atomic<int> num_parked_{0};
+  std::mutex mtx_;
+  std::condition_variable cv_;
+
+ public:
+  AdaptiveWaiter(int spin_count = 1024) : spin_count_(spin_count) {}
+  AdaptiveWaiter(const AdaptiveWaiter&) = delete;
+  AdaptiveWaiter& operator=(const AdaptiveWaiter&) = delete;
+
+  template <typename Pred>
+  void wait(Pred pred) {
+    for (int i = 0; i < spin_count_; i++) {
+      if (pred()) {
+        return;
+      }
+      // give the time slice away in the second half, in case the other side shares the core
+      if (i < spin_count_ / 2) {
+        cpu_relax();
+      } else {
+        std::this_thread::yield();
+      }
+    }
+    num_parked_.fetch_add(1);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    {
+      std::unique_lock<std::mutex> lock(mtx_);
+      cv_.wait(lock, pred);
+    }
+    num_parked_.fetch_sub(1);
+  }
+
+  void notify_all() {
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (num_parked_.load(std::memory_order_relaxed) > 0) {
+      std::lock_guard<std::mutex> lock(mtx_);
+      cv_.notify_all();
+    }
+  }
+};
+
+}  // namespace HugeCTR
@@ -0,0 +1,330 @@
+/*
+ * Copyright (c) 2020, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+#include <cuda_runtime_api.h>
+#include <fcntl.h>
+#include <linux/aio_abi.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <common.hpp>
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace HugeCTR {
+
+/**
+ * Statistics of an AsyncReader.
+ */
+struct AsyncIoStats {
+  size_t bytes_read{0};
+  size_t requests{0};    /**< requests submitted to the kernel */
+  size_t depth_sum{0};   /**< requests in flight, summed over the submissions */
+  size_t max_depth{0};   /**< the most requests in flight */
+  double io_seconds{0};  /**< time while at least one request was in flight */
+  double wait_seconds{0}; /**< time the consumer was blocked on the I/O */
+
+  double bytes_per_sec() const { return io_seconds > 0 ? bytes_read / io_seconds : 0; }
+  double average_depth() const { return requests > 0 ? double(depth_sum) / requests : 0; }
+};
+
+/**
+ * Host buffers aligned for the direct I/O, which are also pinned if a GPU is present,
+ * so that they can be copied to the devices asynchronously.
+ */
+class AlignedHostBuffer {
+ public:
+  static const size_t ALIGNMENT = 4096;
+
+  explicit AlignedHostBuffer(size_t size) : size_(size) {
+    if (posix_memalign(&ptr_, ALIGNMENT, size) != 0) {
+      CK_THROW_(Error_t::OutOfMemory, "posix_memalign failed");
+    }
+    int num_devices = 0;
+    if (cudaGetDeviceCount(&num_devices) == cudaSuccess && num_devices > 0) {
+      pinned_ = cudaHostRegister(ptr_, size, cudaHostRegisterDefault) == cudaSuccess;
+    }
+    cudaGetLastError();
+  }
+  ~AlignedHostBuffer() {
+    if (pinned_) {
+      cudaHostUnregister(ptr_);
+    }
+    free(ptr_);
+  }
+  AlignedHostBuffer(const AlignedHostBuffer&) = delete;
+  AlignedHostBuffer& operator=(const AlignedHostBuffer&) = delete;
+
+  char* get_ptr() const { return static_cast<char*>(ptr_); }
+  size_t get_size() const { return size_; }
+  bool is_pinned() const { return pinned_; }
+
+ private:
+  void* ptr_{nullptr};
+  size_t size_;
+  bool pinned_{false};
+};
+
+/**
+ * @brief Reads a file with the Linux native AIO, keeping many requests in flight.
+ *
+ * The file is opened with O_DIRECT where the file system allows it, so that the reads
+ * bypass the page cache and go to the drives in parallel. Reads are submitted and consumed
+ * in FIFO order; each of them takes one of "queue_depth" slots with its own buffer and is
+ * split into requests of at most MAX_REQUEST_BYTES. A read does not need to be aligned:
+ * the aligned range around it is read and front() points into it.
+ */
+class AsyncReader {
+ public:
+  static const size_t MAX_REQUEST_BYTES = 1 << 20;
+
+ private:
+  struct Slot {
+    std::unique_ptr<AlignedHostBuffer> buffer;
+    size_t head{0};    /**< the requested data starts after these bytes */
+    size_t bytes{0};   /**< requested bytes */
+    size_t valid{0};   /**< requested bytes before the end of file */
+    int pending{0};    /**< requests not completed */
+    bool failed{false};
+  };
+
+  const int queue_depth_;
+  const size_t slot_bytes_;
+  std::vector<Slot> slots_;
+  int front_{0};
+  int num_used_{0};
+  int in_flight_{0}; /**< requests of all slots */
+  aio_context_t ctx_{0};
+  int fd_{-1};
+  size_t file_size_{0};
+  std::vector<struct iocb> iocbs_;
+  std::vector<struct iocb*> iocb_ptrs_;
+  std::vector<struct io_event> events_;
+  AsyncIoStats stats_;
+  std::chrono::steady_clock::time_point busy_since_;
+
+  static size_t max_requests_per_slot(size_t slot_bytes) {
+    return (slot_bytes + MAX_REQUEST_BYTES - 1) / MAX_REQUEST_BYTES;
+  }
+
+  /**
+   * Reap at least "min_events" completions.
+   */
+  void reap(long min_events) {
+    long n;
+    do {
+      n = syscall(SYS_io_getevents, ctx_, min_events, static_cast<long>(events_.size()),
+                  events_.data(), nullptr);
+    } while (n < 0 && errno == EINTR);
+    if (n < 0) {
+      CK_THROW_(Error_t::UnspecificError, "io_getevents failed: " + std::string(strerror(errno)));
+    }
+    for (long i = 0; i < n; i++) {
+      Slot& slot = slots_[events_[i].data];
+      slot.pending--;
+      if (events_[i].res < 0) {
+        slot.failed = true;
+      }
+    }
+    in_flight_ -= n;
+    if (n > 0 && in_flight_ == 0) {
+      stats_.io_seconds += std::chrono::duration<double>(std::chrono::steady_clock::now() -
+                                                         busy_since_).count();
+    }
+  }
+
+ public:
+  /**
+   * Ctor
+   * @param queue_depth the number of reads in flight
+   * @param max_read_bytes the largest read to be submitted
+   */
+  AsyncReader(int queue_depth, size_t max_read_bytes)
+      : queue_depth_(queue_depth),
+        slot_bytes_((max_read_bytes + 2 * AlignedHostBuffer::ALIGNMENT - 1) /
+                    AlignedHostBuffer::ALIGNMENT * AlignedHostBuffer::ALIGNMENT),
+        slots_(queue_depth) {
+    if (queue_depth <= 0) {
+      CK_THROW_(Error_t::WrongInput, "queue_depth <= 0");
+    }
+    for (auto& slot : slots_) {
+      slot.buffer.reset(new AlignedHostBuffer(slot_bytes_));
+    }
+    const size_t max_requests = queue_depth * max_requests_per_slot(slot_bytes_);
+    if (syscall(SYS_io_setup, max_requests, &ctx_) < 0) {
+      CK_THROW_(Error_t::UnspecificError, "io_setup failed: " + std::string(strerror(errno)));
+    }
+    iocbs_.resize(max_requests_per_slot(slot_bytes_));
+    iocb_ptrs_.resize(iocbs_.size());
+    events_.resize(max_requests);
+  }
+
+  ~AsyncReader() {
+    try {
+      close();
+    } catch (const std::runtime_error& rt_err) {
+      std::cerr << rt_err.what() << std::endl;
+    }
+    syscall(SYS_io_destroy, ctx_);
+  }
+
+  /**
+   * Open a file, discarding the reads of the previous one.
+   * @return `Success` or `FileCannotOpen`
+   */
+  Error_t open(const std::string& file_name) {
+    close();
+    fd_ = ::open(file_name.c_str(), O_RDONLY | O_DIRECT);
+    if (fd_ == -1) {
+      // e.g. tmpfs doesn't support O_DIRECT
+      fd_ = ::open(file_name.c_str(), O_RDONLY);
+    }
+    if (fd_ == -1) {
+      return Error_t::FileCannotOpen;
+    }
+    struct stat st;
+    if (fstat(fd_, &st) != 0) {
+      close();
+      return Error_t::FileCannotOpen;
+    }
+    file_size_ = st.st_size;
+    return Error_t::Success;
+  }
+
+  void close() {
+    while (in_flight_ > 0) {
+      reap(1);
+    }
+    front_ = 0;
+    num_used_ = 0;
+    if (fd_ != -1) {
+      ::close(fd_);
+      fd_ = -1;
+    }
+    file_size_ = 0;
+  }
+
+  size_t get_file_size() const { return file_size_; }
+
+  bool full() const { return num_used_ == queue_depth_; }
+
+  bool empty() const { return num_used_ == 0; }
+
+  /**
+   * Start reading "bytes" at "offset". The bytes after the end of file are not read.
+   */
+  void submit(size_t offset, size_t bytes) {
+    if (full()) {
+      CK_THROW_(Error_t::OutOfBound, "no free slot");
+    }
+    if (bytes > slot_bytes_ - AlignedHostBuffer::ALIGNMENT) {
+      CK_THROW_(Error_t::OutOfBound, "bytes > max_read_bytes");
+    }
+    const int slot_id = (front_ + num_used_) % queue_depth_;
+    Slot& slot = slots_[slot_id];
+    const size_t begin = offset / AlignedHostBuffer::ALIGNMENT * AlignedHostBuffer::ALIGNMENT;
+    const size_t end = std::min(offset + bytes, file_size_);
+    const size_t aligned_end = (end + AlignedHostBuffer::ALIGNMENT - 1) /
+                               AlignedHostBuffer::ALIGNMENT * AlignedHostBuffer::ALIGNMENT;
+    slot.head = offset - begin;
+    slot.bytes = bytes;
+    slot.valid = end > offset ? end - offset : 0;
+    slot.failed = false;
+    slot.pending = 0;
+    num_used_++;
+
+    int n = 0;
+    for (size_t pos = begin; pos < aligned_end; pos += MAX_REQUEST_BYTES, n++) {
+      struct iocb& cb = iocbs_[n];
+      memset(&cb, 0, sizeof(cb));
+      cb.aio_data = slot_id;
+      cb.aio_lio_opcode = IOCB_CMD_PREAD;
+      cb.aio_fildes = fd_;
+      cb.aio_buf = reinterpret_cast<uint64_t>(slot.buffer->get_ptr() + (pos - begin));
+      cb.aio_nbytes = std::min(MAX_REQUEST_BYTES, aligned_end - pos);
+      cb.aio_offset = pos;
+      iocb_ptrs_[n] = &cb;
+    }
+    if (in_flight_ == 0 && n > 0) {
+      busy_since_ = std::chrono::steady_clock::now();
+    }
+    int submitted = 0;
+    while (submitted < n) {
+      long ret = syscall(SYS_io_submit, ctx_, static_cast<long>(n - submitted),
+                         iocb_ptrs_.data() + submitted);
+      if (ret < 0) {
+        if ((errno == EAGAIN && in_flight_ > 0) || errno == EINTR) {
+          reap(errno == EAGAIN ? 1 : 0);
+          continue;
+        }
+        CK_THROW_(Error_t::UnspecificError, "io_submit failed: " + std::string(strerror(errno)));
+      }
+      submitted += ret;
+      slot.pending += ret;
+      in_flight_ += ret;
+      stats_.requests += ret;
+      stats_.depth_sum += in_flight_ * ret;
+      stats_.max_depth = std::max<size_t>(stats_.max_depth, in_flight_);
+    }
+  }
+
+  /**
+   * Wait for the oldest read.
+   * @param valid the bytes read, which are less than requested only at the end of file
+   * @return pointer to the data, which is valid until pop()
+   */
+  const char* front(size_t* valid) {
+    if (empty()) {
+      CK_THROW_(Error_t::OutOfBound, "no read is submitted");
+    }
+    Slot& slot = slots_[front_];
+    if (slot.pending > 0) {
+      auto start = std::chrono::steady_clock::now();
+      while (slot.pending > 0) {
+        reap(1);
+      }
+      stats_.wait_seconds +=
+          std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    }
+    if (slot.failed) {
+      CK_THROW_(Error_t::BrokenFile, "async read failed");
+    }
+    *valid = slot.valid;
+    return slot.buffer->get_ptr() + slot.head;
+  }
+
+  /**
+   * Release the oldest read.
+   */
+  void pop() {
+    size_t valid;
+    front(&valid);
+    stats_.bytes_read += valid;
+    front_ = (front_ + 1) % queue_depth_;
+    num_used_--;
+  }
+
+  const AsyncIoStats& get_stats() const { return stats_; }
+};
+
+}  // namespace HugeCTR
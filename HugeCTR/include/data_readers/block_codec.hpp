@@ -0,0 +1,253 @@
+/*
+ * Copyright (c) 2020, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+#include <common.hpp>
+#include <cstdint>
+#include <cstring>
+#include <ostream>
+#include <string>
+#include <vector>
+#ifdef ENABLE_LZ4
+#include <lz4.h>
+#endif
+#ifdef ENABLE_ZSTD
+#include <zstd.h>
+#endif
+
+namespace HugeCTR {
+
+/**
+ * The block compression of the data files, which is flagged in DataSetHeader::reserved[0].
+ *
+ * A compressed file keeps its header as is, and the rest of it is a sequence of frames.
+ * Each of them is a BlockFrameHeader followed by "compressed_size" bytes which decompress to
+ * "raw_size" bytes of whole records, laid out exactly as in the uncompressed file.
+ * Hence the records never straddle two frames.
+ * The frames are LZ4 blocks (liblz4, with ENABLE_LZ4) or Zstd frames (libzstd, with ENABLE_ZSTD).
+ */
+enum class Compression_t { None = 0, LZ4 = 1, Zstd = 2 };
+
+struct BlockFrameHeader {
+  int compressed_size;
+  int raw_size;
+  int num_records;
+  int reserved;
+};
+
+/**
+ * A Raw file is compressed if it starts with this magic, which is followed by a DataSetHeader
+ * (without check bits) and the frames of samples.
+ */
+const char RAW_COMPRESSED_MAGIC[8] = {'H', 'C', 'T', 'R', 'R', 'A', 'W', 'Z'};
+
+/**
+ * Write the header of a compressed Raw file, which can be rewritten in place later.
+ */
+inline void write_raw_compressed_header(std::ostream& stream, long long num_samples,
+                                        long long label_dim, long long dense_dim,
+                                        long long slot_num, Compression_t compression) {
+  DataSetHeader header = {
+      0, num_samples, label_dim, dense_dim, slot_num, static_cast<long long>(compression), 0, 0};
+  stream.write(RAW_COMPRESSED_MAGIC, sizeof(RAW_COMPRESSED_MAGIC));
+  stream.write(reinterpret_cast<const char*>(&header), sizeof(header));
+}
+
+inline Compression_t compression_from_string(const std::string& name) {
+  if (name == "none" || name == "None") {
+    return Compression_t::None;
+  } else if (name == "lz4" || name == "LZ4") {
+    return Compression_t::LZ4;
+  } else if (name == "zstd" || name == "Zstd") {
+    return Compression_t::Zstd;
+  }
+  CK_THROW_(Error_t::WrongInput, "unknown compression: " + name);
+  return Compression_t::None;  // to elimate compile error
+}
+
+inline Compression_t compression_from_header(const DataSetHeader& header) {
+  switch (header.reserved[0]) {
+    case 0:
+      return Compression_t::None;
+    case 1:
+      return Compression_t::LZ4;
+    case 2:
+      return Compression_t::Zstd;
+    default:
+      CK_THROW_(Error_t::BrokenFile,
+                "unknown compression in the header: " + std::to_string(header.reserved[0]));
+  }
+  return Compression_t::None;  // to elimate compile error
+}
+
+inline size_t compress_bound(Compression_t compression, size_t size) {
+  switch (compression) {
+#ifdef ENABLE_LZ4
+    case Compression_t::LZ4:
+      return LZ4_compressBound(static_cast<int>(size));
+#endif
+#ifdef ENABLE_ZSTD
+    case Compression_t::Zstd:
+      return ZSTD_compressBound(size);
+#endif
+    default:
+      return size;
+  }
+}
+
+/**
+ * Compress a block into "dst", which is resized to the compressed size.
+ */
+inline void compress_block(Compression_t compression, const char* src, size_t size,
+                           std::vector<char>* dst, int level = 3) {
+  dst->resize(compress_bound(compression, size));
+  switch (compression) {
+    case Compression_t::None:
+      memcpy(dst->data(), src, size);
+      break;
+    case Compression_t::LZ4: {
+#ifdef ENABLE_LZ4
+      if (size > LZ4_MAX_INPUT_SIZE) {
+        CK_THROW_(Error_t::WrongInput, "the block is too large for LZ4: " + std::to_string(size));
+      }
+      int compressed = LZ4_compress_default(src, dst->data(), static_cast<int>(size),
+                                            static_cast<int>(dst->size()));
+      if (compressed <= 0) {
+        CK_THROW_(Error_t::UnspecificError, "LZ4_compress_default failed");
+      }
+      dst->resize(compressed);
+#else
+      CK_THROW_(Error_t::WrongInput, "HugeCTR is built without ENABLE_LZ4");
+#endif
+      break;
+    }
+    case Compression_t::Zstd: {
+#ifdef ENABLE_ZSTD
+      size_t compressed = ZSTD_compress(dst->data(), dst->size(), src, size, level);
+      if (ZSTD_isError(compressed)) {
+        CK_THROW_(Error_t::UnspecificError,
+                  std::string("ZSTD_compress failed: ") + ZSTD_getErrorName(compressed));
+      }
+      dst->resize(compressed);
+#else
+      CK_THROW_(Error_t::WrongInput, "HugeCTR is built without ENABLE_ZSTD");
+#endif
+      break;
+    }
+  }
+}
+
+/**
+ * Decompress a block of exactly "raw_size" bytes.
+ * @return `Success`, `BrokenFile` or `WrongInput` if the codec is not built in
+ */
+inline Error_t decompress_block(Compression_t compression, const char* src, size_t size,
+                                char* dst, size_t raw_size) noexcept {
+  switch (compression) {
+    case Compression_t::None:
+      if (size != raw_size) {
+        return Error_t::BrokenFile;
+      }
+      memcpy(dst, src, size);
+      return Error_t::Success;
+    case Compression_t::LZ4: {
+#ifdef ENABLE_LZ4
+      // LZ4_decompress_safe never reads or writes out of the buffers, even on a corrupted block
+      if (size > LZ4_MAX_INPUT_SIZE || raw_size > LZ4_MAX_INPUT_SIZE) {
+        return Error_t::BrokenFile;
+      }
+      int decompressed = LZ4_decompress_safe(src, dst, static_cast<int>(size),
+                                             static_cast<int>(raw_size));
+      return decompressed >= 0 && static_cast<size_t>(decompressed) == raw_size
+                 ? Error_t::Success
+                 : Error_t::BrokenFile;
+#else
+      ERROR_MESSAGE_("HugeCTR is built without ENABLE_LZ4");
+      return Error_t::WrongInput;
+#endif
+    }
+    case Compression_t::Zstd: {
+#ifdef ENABLE_ZSTD
+      size_t decompressed = ZSTD_decompress(dst, raw_size, src, size);
+      return !ZSTD_isError(decompressed) && decompressed == raw_size ? Error_t::Success
+                                                                     : Error_t::BrokenFile;
+#else
+      ERROR_MESSAGE_("HugeCTR is built without ENABLE_ZSTD");
+      return Error_t::WrongInput;
+#endif
+    }
+  }
+  return Error_t::WrongInput;
+}
+
+/**
+ * @brief Writes the records of a data file in frames of about "block_bytes".
+ *
+ * The records are buffered until end_record() finds at least "block_bytes" of them,
+ * and then compressed into a frame. With Compression_t::None they go to the stream directly.
+ * flush() must be called after the last record.
+ */
+class BlockWriter {
+  std::ostream& stream_;
+  const Compression_t compression_;
+  const size_t block_bytes_;
+  std::vector<char> raw_;
+  std::vector<char> compressed_;
+  int num_records_{0};
+
+ public:
+  BlockWriter(std::ostream& stream, Compression_t compression, size_t block_bytes = 1 << 20)
+      : stream_(stream), compression_(compression), block_bytes_(block_bytes) {}
+
+  ~BlockWriter() {
+    try {
+      flush();
+    } catch (const std::runtime_error& rt_err) {
+      std::cerr << rt_err.what() << std::endl;
+    }
+  }
+
+  void write(const char* ptr, std::streamsize bytes) {
+    if (compression_ == Compression_t::None) {
+      stream_.write(ptr, bytes);
+    } else {
+      raw_.insert(raw_.end(), ptr, ptr + bytes);
+    }
+  }
+
+  void end_record() {
+    num_records_++;
+    if (raw_.size() >= block_bytes_) {
+      flush();
+    }
+  }
+
+  void flush() {
+    if (compression_ == Compression_t::None || num_records_ == 0) {
+      num_records_ = 0;
+      return;
+    }
+    compress_block(compression_, raw_.data(), raw_.size(), &compressed_);
+    BlockFrameHeader frame = {static_cast<int>(compressed_.size()), static_cast<int>(raw_.size()),
+                              num_records_, 0};
+    stream_.write(reinterpret_cast<const char*>(&frame), sizeof(frame));
+    stream_.write(compressed_.data(), compressed_.size());
+    raw_.clear();
+    num_records_ = 0;
+  }
+};
+
+}  // namespace HugeCTR
@@ -0,0 +1,34 @@
+/*
+ * Copyright (c) 2020, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <cstddef>
+
+namespace HugeCTR {
+
+/**
+ * Sum of "size" bytes starting at "data", truncated to char as in CheckSum.
+ * The AVX2 or SSE2 implementation is picked at runtime if the CPU supports it.
+ */
+char byte_sum(const char* data, size_t size);
+
+/**
+ * The scalar reference of byte_sum().
+ */
+char byte_sum_scalar(const char* data, size_t size);
+
+}  // namespace HugeCTR
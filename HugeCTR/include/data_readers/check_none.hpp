@@ -45,6 +45,10 @@ class CheckNone : public Checker {
     }
   }
 
+  Error_t read_ptr(const char** ptr, size_t bytes_to_read) noexcept {
+    return Checker::src_.read_ptr(ptr, bytes_to_read);
+  }
+
   /**
    * Start a new file to read.
    * @return `FileCannotOpen` or `UnspecificError`
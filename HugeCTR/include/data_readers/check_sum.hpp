@@ -17,6 +17,7 @@
 #pragma once
 
 #include <common.hpp>
+#include <cstring>
 #include <data_readers/checker.hpp>
 #include <data_readers/source.hpp>
 
@@ -75,6 +76,46 @@ class CheckSum : public Checker {
     }
   }
 
+  /**
+   * Same as read() but the bytes stay in the source.
+   * @return `DataCheckError` `OutOfBound` `Success` `BrokenFile`
+   */
+  Error_t read_ptr(const char** ptr, size_t bytes_to_read) noexcept {
+    const char* p = nullptr;
+    if (counter_ == 0) {
+      Error_t err = Checker::src_.read_ptr(&p, sizeof(int));
+      if (err != Error_t::Success) {
+        return err;
+      }
+      memcpy(&counter_, p, sizeof(int));
+    }
+    counter_ -= bytes_to_read;
+    // if user read more data than expected, return `BrokenFile`.
+    if (counter_ < 0) {
+      std::cerr << "counter_ " + std::to_string(counter_) + "< 0" << std::endl;
+      return Error_t::BrokenFile;
+    }
+    Error_t err = Checker::src_.read_ptr(ptr, bytes_to_read);
+    if (err != Error_t::Success) {
+      return err;
+    }
+    for (unsigned int i = 0; i < bytes_to_read; i++) {
+      accum_ += (*ptr)[i];
+    }
+    // do checksum when counter_ == 0.
+    if (counter_ == 0) {
+      err = Checker::src_.read_ptr(&p, sizeof(char));
+      if (err != Error_t::Success) {
+        return err;
+      }
+      char check_sum = *p;
+      char accum = accum_;
+      accum_ = 0;
+      return accum == check_sum ? Error_t::Success : Error_t::DataCheckError;
+    }
+    return Error_t::Success;
+  }
+
   /**
    * Start a new file to read.
    * @return `FileCannotOpen` or `UnspecificError`
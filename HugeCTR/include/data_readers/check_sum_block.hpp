@@ -0,0 +1,151 @@
+/*
+ * Copyright (c) 2020, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <common.hpp>
+#include <cstring>
+#include <data_readers/byte_sum.hpp>
+#include <data_readers/checker.hpp>
+#include <data_readers/source.hpp>
+#include <vector>
+
+namespace HugeCTR {
+
+/**
+ * A checker of the same file format as CheckSum, but it works on a whole record at a time.
+ * The first read of a record fetches its length, body and check bit from the source at once
+ * and validates the body with a vectorized byte sum. The following reads are served from the
+ * record without touching the source, so read_ptr() is always available.
+ * A record which fails the check is dropped as a whole and `DataCheckError` is returned.
+ */
+class CheckSumBlock : public Checker {
+ private:
+  const int MAX_TRY_{10};
+  std::vector<char> buffer_; /**< record body and check bit if the source is not zero-copy */
+  const char* record_{nullptr};
+  size_t record_size_{0};
+  size_t offset_{0}; /**< read position in the current record */
+
+  Error_t load_record() noexcept {
+    record_ = nullptr;
+    record_size_ = 0;
+    offset_ = 0;
+    int length = 0;
+    const char* ptr = nullptr;
+    const bool zero_copy = Checker::src_.is_zero_copy();
+    Error_t err = zero_copy ? Checker::src_.read_ptr(&ptr, sizeof(int))
+                            : Checker::src_.read(reinterpret_cast<char*>(&length), sizeof(int));
+    if (err != Error_t::Success) {
+      return err;
+    }
+    if (zero_copy) {
+      memcpy(&length, ptr, sizeof(int));
+    }
+    if (length <= 0) {
+      std::cerr << "invalid record length " + std::to_string(length) << std::endl;
+      return Error_t::BrokenFile;
+    }
+    // body and check bit in one go
+    if (zero_copy) {
+      err = Checker::src_.read_ptr(&ptr, length + 1);
+    } else {
+      buffer_.resize(length + 1);
+      err = Checker::src_.read(buffer_.data(), length + 1);
+      ptr = buffer_.data();
+    }
+    if (err != Error_t::Success) {
+      return err;
+    }
+    if (byte_sum(ptr, length) != ptr[length]) {
+      return Error_t::DataCheckError;
+    }
+    record_ = ptr;
+    record_size_ = length;
+    return Error_t::Success;
+  }
+
+ public:
+  CheckSumBlock(Source& src) : Checker(src) {}
+
+  /**
+   * Read "bytes_to_read" byte to the memory associated to ptr.
+   * @param ptr pointer to user located buffer
+   * @param bytes_to_read bytes to read
+   * @return `DataCheckError` `OutOfBound` `Success` `BrokenFile`
+   */
+  Error_t read(char* ptr, size_t bytes_to_read) noexcept {
+    const char* src = nullptr;
+    Error_t err = read_ptr(&src, bytes_to_read);
+    if (err == Error_t::Success && bytes_to_read > 0) {
+      memcpy(ptr, src, bytes_to_read);
+    }
+    return err;
+  }
+
+  /**
+   * Get the pointer to the next "bytes_to_read" bytes of the current record.
+   * It is valid until the next record is read.
+   * @return `DataCheckError` `OutOfBound` `Success` `BrokenFile`
+   */
+  Error_t read_ptr(const char** ptr, size_t bytes_to_read) noexcept {
+    if (bytes_to_read == 0) {
+      *ptr = record_;
+      return Error_t::Success;
+    }
+    if (offset_ == record_size_) {
+      Error_t err = load_record();
+      if (err != Error_t::Success) {
+        return err;
+      }
+    }
+    // if user read more data than expected, return `BrokenFile`.
+    if (bytes_to_read > record_size_ - offset_) {
+      std::cerr << "record overrun: " + std::to_string(bytes_to_read) + " > " +
+                       std::to_string(record_size_ - offset_)
+                << std::endl;
+      offset_ = record_size_;
+      return Error_t::BrokenFile;
+    }
+    *ptr = record_ + offset_;
+    offset_ += bytes_to_read;
+    return Error_t::Success;
+  }
+
+  bool is_zero_copy() noexcept { return true; }
+
+  /**
+   * Start a new file to read.
+   * @return `FileCannotOpen` or `UnspecificError`
+   */
+  Error_t next_source() {
+    // initialize
+    record_ = nullptr;
+    record_size_ = 0;
+    offset_ = 0;
+    for (int i = MAX_TRY_; i > 0; i--) {
+      Error_t flag_eof = Checker::src_.next_source();
+      if (flag_eof == Error_t::Success ||
+          flag_eof == Error_t::EndOfFile) {
+        return flag_eof;
+      }
+    }
+    CK_THROW_(Error_t::FileCannotOpen, "Checker::src_.next_source() == Error_t::Success failed");
+    return Error_t::FileCannotOpen; // to elimate compile error
+  }
+};
+
+}  // namespace HugeCTR
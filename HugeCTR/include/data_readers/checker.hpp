@@ -36,6 +36,17 @@ class Checker {
    */
   virtual Error_t read(char* ptr, size_t bytes_to_read) noexcept = 0;
 
+  /**
+   * Same as read() but returns the pointer to the data in the source instead of copying it.
+   * Only valid if is_zero_copy().
+   * @param ptr the pointer to the data is written to it
+   * @param bytes_to_read bytes to read
+   * @return `IllegalCall` `DataCheckError` `OutOfBound` `Success` `UnspecificError`
+   */
+  virtual Error_t read_ptr(const char** ptr, size_t bytes_to_read) noexcept {
+    return Error_t::IllegalCall;
+  }
+
   /**
    * Start a new file to read.
    * @return `FileCannotOpen` or `UnspecificError`
@@ -43,6 +54,8 @@ class Checker {
   virtual Error_t next_source() = 0;
 
   virtual bool is_open() noexcept { return src_.is_open(); }
+
+  virtual bool is_zero_copy() noexcept { return src_.is_zero_copy(); }
 };
 
 }  // namespace HugeCTR
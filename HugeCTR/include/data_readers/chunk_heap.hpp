@@ -0,0 +1,36 @@
+/*
+ * Copyright (c) 2020, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <data_readers/chunk_consumer.hpp>
+#include <data_readers/chunk_producer.hpp>
+
+namespace HugeCTR {
+
+/**
+ * @brief An interface of the chunk pool shared by the data reader workers and DataCollector
+ */
+template <typename T>
+class ChunkHeap : public ChunkConsumer<T>, public ChunkProducer<T> {
+ public:
+  virtual void reset() = 0;
+  virtual void break_and_return() = 0;
+  virtual int get_size() = 0;
+  virtual ~ChunkHeap() = default;
+};
+
+}  // namespace HugeCTR
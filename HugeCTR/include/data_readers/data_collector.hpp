@@ -19,6 +19,7 @@
 #include <atomic>
 #include <common.hpp>
 #include <condition_variable>
+#include <data_readers/adaptive_waiter.hpp>
 #include <memory>
 #include <mutex>
 #include <queue>
@@ -74,7 +75,7 @@ class DataCollector {
   enum STATUS { READY_TO_WRITE, READY_TO_READ, STOP };
   std::atomic<STATUS> stat_{READY_TO_WRITE};
   std::mutex stat_mtx_;
-  std::condition_variable stat_cv_;
+  AdaptiveWaiter stat_waiter_; /**< spin-then-park on the transitions of stat_ */
   std::shared_ptr<ChunkConsumer<CSRChunk<TypeKey>>> csr_heap_;
 
   Tensors2<float> label_tensors_;
@@ -108,6 +109,15 @@ class DataCollector {
   void collect_();
   bool started_ = false;
 
+  void set_stat_(STATUS stat) {
+    stat_ = stat;
+    stat_waiter_.notify_all();
+  }
+
+  void wait_stat_(STATUS stat) {
+    stat_waiter_.wait([this, stat]() { return stat_ == stat || stat_ == STOP; });
+  }
+
  public:
   /**
    * Ctor.
@@ -148,8 +158,7 @@ class DataCollector {
 #ifdef ENABLE_MPI
     CK_MPI_THROW_(MPI_Barrier(MPI_COMM_WORLD));
 #endif
-    stat_ = STOP;
-    // stat_cv_.notify_all();
+    set_stat_(STOP);
   }
 
   void start();
@@ -292,17 +301,13 @@ template <typename TypeKey>
 void DataCollector<TypeKey>::collect_blank_() {
   std::unique_lock<std::mutex> lock(stat_mtx_);
 
-  while (stat_ != READY_TO_WRITE && stat_ != STOP) {
-    // stat_cv_.wait(lock);
-    usleep(2);
-  }
+  wait_stat_(READY_TO_WRITE);
   if (stat_ == STOP) {
     return;
   }
 
-  stat_ = READY_TO_READ;
+  set_stat_(READY_TO_READ);
   lock.unlock();
-  // stat_cv_.notify_all();
 }
 
 /**************************************
@@ -319,9 +324,7 @@ void DataCollector<TypeKey>::collect_() {
 
   int total_device_count = resource_manager_->get_global_gpu_count();
 
-  while (stat_ != READY_TO_WRITE && stat_ != STOP) {
-    usleep(2);
-  }
+  wait_stat_(READY_TO_WRITE);
   if (stat_ == STOP) {
     return;
   }
@@ -331,7 +334,7 @@ void DataCollector<TypeKey>::collect_() {
     internal_buffer->current_batchsize = 0;
     reverse_ = !reverse_;
     csr_heap_->return_free_chunk();
-    stat_ = READY_TO_READ;
+    set_stat_(READY_TO_READ);
     return;
   }
 
@@ -408,15 +411,13 @@ void DataCollector<TypeKey>::collect_() {
 
   csr_heap_->return_free_chunk();
 
-  stat_ = READY_TO_READ;
+  set_stat_(READY_TO_READ);
 }
 
 template <typename TypeKey>
 long long DataCollector<TypeKey>::read_a_batch_to_device() {
   auto& internal_buffer = internal_buffers_[counter_ % internal_buffers_.size()];
-  while (stat_ != READY_TO_READ && stat_ != STOP) {
-    usleep(2);
-  }
+  wait_stat_(READY_TO_READ);
   if (stat_ == STOP || internal_buffer->current_batchsize == 0) {
     counter_++;
     return internal_buffer->current_batchsize;
@@ -463,7 +464,7 @@ void DataCollector<TypeKey>::set_ready_to_write_sync() {
 
 template <typename TypeKey>
 void DataCollector<TypeKey>::set_ready_to_write() {
-  stat_ = READY_TO_WRITE;
+  set_stat_(READY_TO_WRITE);
 }
 
 }  // namespace HugeCTR
@@ -26,6 +26,8 @@
 #include <data_readers/data_reader_worker_group_norm.hpp>
 #include <data_readers/data_reader_worker_group_parquet.hpp>
 #include <data_readers/data_reader_worker_group_raw.hpp>
+#include <data_readers/heapex.hpp>
+#include <data_readers/lock_free_heap.hpp>
 #include <fstream>
 #include <gpu_resource.hpp>
 #include <tensor2.hpp>
@@ -49,7 +51,7 @@ static int core_offset_ = 0;
 template <typename TypeKey>
 class DataReader : public IDataReader {
  private:
-  std::shared_ptr<HeapEx<CSRChunk<TypeKey>>> csr_heap_; /**< heap to cache the data set */
+  std::shared_ptr<ChunkHeap<CSRChunk<TypeKey>>> csr_heap_; /**< heap to cache the data set */
   Tensors2<float> label_tensors_;                       /**< Label tensors for the usage of loss */
   std::vector<TensorBag2> dense_tensors_;               /**< Dense tensors for the usage of loss */
   /* Each gpu will have several csr output for different embedding */
@@ -109,7 +111,8 @@ class DataReader : public IDataReader {
   DataReader(int batchsize, size_t label_dim, int dense_dim,
              std::vector<DataReaderSparseParam>& params,
              const std::shared_ptr<ResourceManager>& resource_manager, bool repeat,
-             int num_chunk_threads, bool use_mixed_precision, int cache_num_iters);
+             int num_chunk_threads, bool use_mixed_precision, int cache_num_iters,
+             int prefetch_depth = 1, bool lock_free_heap = false);
 
   const Tensors2<float>& get_label_tensors() const { return label_tensors_; }
   const std::vector<TensorBag2>& get_dense_tensors() const { return dense_tensors_; }
@@ -139,21 +142,30 @@ class DataReader : public IDataReader {
   }
 
   void create_drwg_norm(std::string file_name, Check_t check_type,
-                        bool start_reading_from_beginning = true) override {
+                        bool start_reading_from_beginning = true,
+                        bool use_mmap = false,
+                        int num_parse_threads = 1,
+                        int shuffle_buffer_size = 0,
+                        bool shuffle_files = false,
+                        int async_io_depth = 0) override {
     source_type_ = SourceType_t::FileList;
     worker_group_.reset(new DataReaderWorkerGroupNorm<TypeKey>(
-        csr_heap_, file_name, repeat_, check_type, params_, start_reading_from_beginning));
+        csr_heap_, file_name, repeat_, check_type, params_, start_reading_from_beginning,
+        use_mmap, num_parse_threads, shuffle_buffer_size, shuffle_files, async_io_depth));
     file_name_ = file_name;
   }
 
   void create_drwg_raw(std::string file_name, long long num_samples,
                        const std::vector<long long> slot_offset, bool float_label_dense,
                        bool data_shuffle = false,
-                       bool start_reading_from_beginning = true) override {
+                       bool start_reading_from_beginning = true,
+                       long long shuffle_block_size = 0,
+                       int async_io_depth = 0) override {
     source_type_ = SourceType_t::Mmap;
     worker_group_.reset(new DataReaderWorkerGroupRaw<TypeKey>(
         csr_heap_, file_name, num_samples, repeat_, params_, slot_offset, label_dim_, dense_dim_,
-        batchsize_, float_label_dense, data_shuffle, start_reading_from_beginning));
+        batchsize_, float_label_dense, data_shuffle, start_reading_from_beginning,
+        shuffle_block_size, async_io_depth));
     file_name_ = file_name;
   }
 
@@ -195,7 +207,7 @@ DataReader<TypeKey>::DataReader(int batchsize, size_t label_dim, int dense_dim,
                                 std::vector<DataReaderSparseParam>& params,
                                 const std::shared_ptr<ResourceManager>& resource_manager,
                                 bool repeat, int num_chunk_threads, bool use_mixed_precision,
-                                int cache_num_iters)
+                                int cache_num_iters, int prefetch_depth, bool lock_free_heap)
     : params_(params),
       resource_manager_(resource_manager),
       use_mixed_precision_(use_mixed_precision),
@@ -216,9 +228,16 @@ DataReader<TypeKey>::DataReader(int batchsize, size_t label_dim, int dense_dim,
               "batchsize_ % total_gpu_count");
   }
 
-  // init the heap
-  csr_heap_.reset(new HeapEx<CSRChunk<TypeKey>>(num_chunk_threads, total_gpu_count, batchsize_,
-                                                label_dim_ + dense_dim_, params_));
+  // init the heap: each worker owns prefetch_depth chunks to overlap parsing and H2D copy
+  if (lock_free_heap) {
+    csr_heap_.reset(new LockFreeHeap<CSRChunk<TypeKey>>(num_chunk_threads, prefetch_depth,
+                                                        total_gpu_count, batchsize_,
+                                                        label_dim_ + dense_dim_, params_));
+  } else {
+    csr_heap_.reset(new HeapEx<CSRChunk<TypeKey>>(num_chunk_threads, prefetch_depth,
+                                                  total_gpu_count, batchsize_,
+                                                  label_dim_ + dense_dim_, params_));
+  }
 
   std::vector<std::shared_ptr<GeneralBuffer2<CudaAllocator>>> buffs;
   for (size_t i = 0; i < local_gpu_count; i++) {
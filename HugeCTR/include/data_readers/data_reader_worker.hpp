@@ -17,15 +17,20 @@
 #pragma once
 #include <common.hpp>
 #include <data_readers/check_none.hpp>
-#include <data_readers/check_sum.hpp>
+#include <data_readers/check_sum_block.hpp>
 #include <data_readers/csr.hpp>
 #include <data_readers/csr_chunk.hpp>
 #include <data_readers/data_reader_worker_interface.hpp>
 #include <data_readers/file_list.hpp>
 #include <data_readers/file_source.hpp>
+#include <data_readers/file_source_async.hpp>
+#include <data_readers/file_source_compressed.hpp>
+#include <data_readers/file_source_mmap.hpp>
 #include <data_readers/chunk_producer.hpp>
 #include <data_readers/heapex.hpp>
+#include <algorithm>
 #include <fstream>
+#include <random>
 #include <vector>
 
 namespace HugeCTR {
@@ -41,11 +46,47 @@ class DataReaderWorker : public IDataReaderWorker {
   Check_t check_type_;   /**< check type for data set */
   std::vector<DataReaderSparseParam> params_; /**< configuration of data reader sparse input */
   T* feature_ids_;                   /**< a buffer to cache the readed feature from data set */
+  std::shared_ptr<DecompressingSource> decompressing_source_; /**< on top of source_ */
   std::shared_ptr<Checker> checker_; /**< checker aim to perform error check of the input data */
   bool skip_read_{false};            /**< set to true when you want to stop the data reading */
   const int MAX_TRY = 10;
   int current_record_index_{0};
   int slots_{0};
+  bool zero_copy_{false}; /**< parse the records in place if the checker can hand them out */
+
+  /**
+   * Samples decoded by a parser thread, in the order of the records.
+   */
+  struct ParsedFragment {
+    std::vector<float> label_dense; /**< label_dense_dim per sample */
+    std::vector<int> nnz;           /**< slots_ per sample */
+    std::vector<T> keys;
+    int num_dropped{0}; /**< records which failed the check */
+  };
+
+  // intra-file parallel parsing, only with a memory mapped source
+  const int num_parse_threads_{1};
+  std::shared_ptr<MmapFileSource> mmap_source_; /**< nullptr unless parsing in parallel */
+  const char* records_{nullptr}; /**< the records of the current file, after its header */
+  size_t records_size_{0};
+  size_t scan_offset_{0};             /**< records_ before it are indexed */
+  std::vector<size_t> record_index_;  /**< offsets of the records to parse in this round */
+  std::vector<ParsedFragment> fragments_;
+
+  // shuffle buffer: a reservoir of up to shuffle_buffer_size_ decoded samples.
+  // Each of them takes a fixed-size slot, so the memory is bounded.
+  const int shuffle_buffer_size_{0};
+  int shuffle_buffer_count_{0}; /**< samples in the reservoir */
+  bool shuffle_eof_{false};     /**< no more sample to put into the reservoir */
+  std::vector<float> shuffle_label_dense_;
+  std::vector<int> shuffle_nnz_;
+  std::vector<T> shuffle_keys_;
+  size_t max_keys_per_sample_{0}; /**< sum of the max_feature_num of params_ */
+  std::mt19937 shuffle_gen_;
+  // the next sample in fragments_ to put into the reservoir, in the parallel parsing mode
+  size_t fragment_id_{0};
+  size_t fragment_sample_{0};
+  size_t fragment_key_{0};
 
   // TODO(minseokl, 11062020): they must be moved to the parent class if the EOF is enabled
   // in the other workers such as Parquet and Raw.
@@ -71,23 +112,458 @@ class DataReaderWorker : public IDataReaderWorker {
         continue;
       }
       if (err == Error_t::Success) {
+        if (mmap_source_ != nullptr && decompressing_source_->is_compressed()) {
+          CK_THROW_(Error_t::WrongInput,
+                    "the compressed files can't be parsed with num_parse_threads > 1");
+        }
+        if (mmap_source_ != nullptr) {
+          records_ = mmap_source_->peek();
+          records_size_ = mmap_source_->get_remaining_bytes();
+          scan_offset_ = 0;
+        }
         return;
       }
     }
     CK_THROW_(Error_t::BrokenFile, "failed to read a file");
   }
 
+  /**
+   * Put the offsets of the next (at most) "num" records into record_index_, followed by
+   * the end of the last one. Only the record lengths (Check_t::Sum) or the nnz (Check_t::None)
+   * are visited, so it is much cheaper than parsing.
+   * @return the number of records found before the end of file or a broken record.
+   */
+  int index_records(int num) {
+    const size_t label_dense_bytes =
+        sizeof(float) * (data_set_header_.label_dim + data_set_header_.dense_dim);
+    record_index_.clear();
+    record_index_.push_back(scan_offset_);
+    for (int r = 0; r < num; r++) {
+      size_t offset = scan_offset_;
+      if (check_type_ == Check_t::Sum) {
+        int length;
+        if (records_size_ - offset < sizeof(int)) {
+          break;
+        }
+        memcpy(&length, records_ + offset, sizeof(int));
+        if (length <= 0 || records_size_ - offset - sizeof(int) < (size_t)length + 1) {
+          break;
+        }
+        offset += sizeof(int) + length + 1;
+      } else {
+        if (records_size_ - offset < label_dense_bytes) {
+          break;
+        }
+        offset += label_dense_bytes;
+        bool broken = false;
+        for (int k = 0; k < slots_; k++) {
+          int nnz;
+          if (records_size_ - offset < sizeof(int)) {
+            broken = true;
+            break;
+          }
+          memcpy(&nnz, records_ + offset, sizeof(int));
+          offset += sizeof(int);
+          if (nnz < 0 || (records_size_ - offset) / sizeof(T) < (size_t)nnz) {
+            broken = true;
+            break;
+          }
+          offset += sizeof(T) * nnz;
+        }
+        if (broken) {
+          break;
+        }
+      }
+      scan_offset_ = offset;
+      record_index_.push_back(offset);
+    }
+    return record_index_.size() - 1;
+  }
+
+  /**
+   * Decode one record body into "fragment". Nothing is appended if it is broken.
+   */
+  bool parse_record(const char* body, size_t size, ParsedFragment& fragment) const {
+    const int label_dense_dim = data_set_header_.label_dim + data_set_header_.dense_dim;
+    const size_t label_dense_bytes = sizeof(float) * label_dense_dim;
+    if (size < label_dense_bytes) {
+      return false;
+    }
+    const size_t label_dense_size = fragment.label_dense.size();
+    const size_t nnz_size = fragment.nnz.size();
+    const size_t keys_size = fragment.keys.size();
+    fragment.label_dense.resize(label_dense_size + label_dense_dim);
+    memcpy(fragment.label_dense.data() + label_dense_size, body, label_dense_bytes);
+    size_t offset = label_dense_bytes;
+    for (int k = 0; k < slots_; k++) {
+      int nnz = -1;
+      if (size - offset >= sizeof(int)) {
+        memcpy(&nnz, body + offset, sizeof(int));
+        offset += sizeof(int);
+      }
+      if (nnz < 0 || (size - offset) / sizeof(T) < (size_t)nnz) {
+        fragment.label_dense.resize(label_dense_size);
+        fragment.nnz.resize(nnz_size);
+        fragment.keys.resize(keys_size);
+        return false;
+      }
+      fragment.nnz.push_back(nnz);
+      const size_t old_size = fragment.keys.size();
+      fragment.keys.resize(old_size + nnz);
+      memcpy(fragment.keys.data() + old_size, body + offset, sizeof(T) * nnz);
+      offset += sizeof(T) * nnz;
+    }
+    return true;
+  }
+
+  /**
+   * Decode the records in record_index_ into fragments_ with num_parse_threads_ threads.
+   * Each thread takes a contiguous range, so that the order of the samples is kept.
+   */
+  void parse_records_in_parallel() {
+    const int num_records = record_index_.size() - 1;
+    const int num_threads = std::min(num_parse_threads_, num_records);
+#pragma omp parallel for num_threads(num_threads) schedule(static, 1)
+    for (int t = 0; t < num_threads; t++) {
+      ParsedFragment& fragment = fragments_[t];
+      fragment.label_dense.clear();
+      fragment.nnz.clear();
+      fragment.keys.clear();
+      fragment.num_dropped = 0;
+      const int begin = static_cast<long long>(num_records) * t / num_threads;
+      const int end = static_cast<long long>(num_records) * (t + 1) / num_threads;
+      for (int r = begin; r < end; r++) {
+        const char* body = records_ + record_index_[r];
+        size_t size = record_index_[r + 1] - record_index_[r];
+        if (check_type_ == Check_t::Sum) {
+          size -= sizeof(int) + 1;
+          body += sizeof(int);
+          if (byte_sum(body, size) != body[size]) {
+            fragment.num_dropped++;
+            continue;
+          }
+        }
+        if (!parse_record(body, size, fragment)) {
+          fragment.num_dropped++;
+        }
+      }
+    }
+    for (int t = num_threads; t < num_parse_threads_; t++) {
+      fragments_[t].label_dense.clear();
+      fragments_[t].nnz.clear();
+      fragments_[t].keys.clear();
+      fragments_[t].num_dropped = 0;
+    }
+  }
+
+  /**
+   * Put a decoded sample into the chunk as sample "i".
+   */
+  void push_sample(CSRChunk<T>* csr_chunk, int i, const float* label_dense, const int* nnz,
+                   const T* keys) {
+    Tensors2<float>& label_dense_buffers = csr_chunk->get_label_buffers();
+    const int label_dense_dim = csr_chunk->get_label_dense_dim();
+    const int samples_per_buffer = csr_chunk->get_batchsize() / label_dense_buffers.size();
+    float* ptr = label_dense_buffers[i / samples_per_buffer].get_ptr();
+    memcpy(ptr + (i % samples_per_buffer) * label_dense_dim, label_dense,
+           sizeof(float) * label_dense_dim);
+    int param_id = 0;
+    for (auto& param : params_) {
+      for (int k = 0; k < param.slot_num; k++, nnz++) {
+        if (param.type == DataReaderSparse_t::Distributed) {
+          for (int dev_id = 0; dev_id < csr_chunk->get_num_devices(); dev_id++) {
+            csr_chunk->get_csr_buffer(param_id, dev_id).new_row();
+          }
+          for (int j = 0; j < *nnz; j++) {
+            int dev_id = std::abs(static_cast<int>(keys[j] % csr_chunk->get_num_devices()));
+            csr_chunk->get_csr_buffer(param_id, dev_id).push_back(keys[j]);
+          }
+        } else if (param.type == DataReaderSparse_t::Localized) {
+          int dev_id = k % csr_chunk->get_num_devices();
+          CSR<T>& csr = csr_chunk->get_csr_buffer(param_id, dev_id);
+          csr.new_row();
+          for (int j = 0; j < *nnz; j++) {
+            csr.push_back(keys[j]);
+          }
+        } else {
+          CK_THROW_(Error_t::UnspecificError, "param.type is not defined");
+        }
+        keys += *nnz;
+      }
+      param_id++;
+    }
+  }
+
+  /**
+   * Append the samples of fragments_ to the chunk in order, starting from sample "i".
+   * @return the index of the next sample
+   */
+  int stitch_fragments(CSRChunk<T>* csr_chunk, int i) {
+    const int label_dense_dim = csr_chunk->get_label_dense_dim();
+    for (auto& fragment : fragments_) {
+      for (int d = 0; d < fragment.num_dropped; d++) {
+        ERROR_MESSAGE_("Error_t::DataCheckError");
+      }
+      const T* keys = fragment.keys.data();
+      const int* nnz = fragment.nnz.data();
+      const int num_samples = fragment.label_dense.size() / label_dense_dim;
+      for (int s = 0; s < num_samples; s++, i++) {
+        push_sample(csr_chunk, i, fragment.label_dense.data() + s * label_dense_dim, nnz, keys);
+        for (int k = 0; k < slots_; k++, nnz++) {
+          keys += *nnz;
+        }
+      }
+    }
+    return i;
+  }
+
+  /**
+   * Index and parse the next (at most) "max_records" records of the current file into
+   * fragments_, opening the next file if the current one is done.
+   * It can throw `EndOfFile`.
+   */
+  void parse_next_records(int max_records) {
+    while (true) {
+      if (current_record_index_ >= data_set_header_.number_of_records) {
+        read_new_file();  // can throw Error_t::EOF
+      }
+      int num = std::min(max_records, static_cast<int>(data_set_header_.number_of_records -
+                                                       current_record_index_));
+      int num_indexed = index_records(num);
+      if (num_indexed == 0) {
+        ERROR_MESSAGE_("broken record in the file");
+        current_record_index_ = data_set_header_.number_of_records;
+        continue;
+      }
+      parse_records_in_parallel();
+      current_record_index_ += num_indexed;
+      return;
+    }
+  }
+
+  /**
+   * Fill the chunk with the samples of the current file, parsed by num_parse_threads_ threads.
+   * Broken records are skipped and replaced by the following ones.
+   * @return the number of samples in the chunk, which is less than the batchsize only if the
+   * EOF is faced; in that case, it throws `EndOfFile` if the number is 0.
+   */
+  int read_samples_in_parallel(CSRChunk<T>* csr_chunk) {
+    const int batchsize = csr_chunk->get_batchsize();
+    int i = 0;
+    while (i < batchsize) {
+      try {
+        parse_next_records(batchsize - i);
+      } catch (const internal_runtime_error& rt_err) {
+        if (rt_err.get_error() == Error_t::EndOfFile && i > 0) {
+          return i;
+        }
+        throw;
+      }
+      i = stitch_fragments(csr_chunk, i);
+    }
+    return i;
+  }
+
+  /**
+   * Decode the next sample in the file order into the given slot of the reservoir.
+   * It can throw `EndOfFile`.
+   */
+  void decode_next_sample(int slot, int batchsize) {
+    const int label_dense_dim = data_set_header_.label_dim + data_set_header_.dense_dim;
+    float* label_dense = shuffle_label_dense_.data() + static_cast<size_t>(slot) * label_dense_dim;
+    int* nnz = shuffle_nnz_.data() + static_cast<size_t>(slot) * slots_;
+    T* keys = shuffle_keys_.data() + static_cast<size_t>(slot) * max_keys_per_sample_;
+    if (mmap_source_ != nullptr) {
+      while (fragment_id_ >= fragments_.size() ||
+             fragment_sample_ * label_dense_dim >= fragments_[fragment_id_].label_dense.size()) {
+        if (fragment_id_ < fragments_.size()) {
+          fragment_id_++;
+          fragment_sample_ = 0;
+          fragment_key_ = 0;
+          continue;
+        }
+        parse_next_records(batchsize);  // can throw Error_t::EOF
+        for (auto& fragment : fragments_) {
+          for (int d = 0; d < fragment.num_dropped; d++) {
+            ERROR_MESSAGE_("Error_t::DataCheckError");
+          }
+        }
+        fragment_id_ = 0;
+        fragment_sample_ = 0;
+        fragment_key_ = 0;
+      }
+      ParsedFragment& fragment = fragments_[fragment_id_];
+      memcpy(label_dense, fragment.label_dense.data() + fragment_sample_ * label_dense_dim,
+             sizeof(float) * label_dense_dim);
+      const int* fragment_nnz = fragment.nnz.data() + fragment_sample_ * slots_;
+      size_t num_keys = 0;
+      for (int k = 0; k < slots_; k++) {
+        nnz[k] = fragment_nnz[k];
+        num_keys += nnz[k];
+      }
+      if (num_keys > max_keys_per_sample_) {
+        CK_THROW_(Error_t::OutOfBound, "more keys than max_feature_num");
+      }
+      memcpy(keys, fragment.keys.data() + fragment_key_, sizeof(T) * num_keys);
+      fragment_sample_++;
+      fragment_key_ += num_keys;
+      return;
+    }
+
+    while (true) {
+      if (current_record_index_ >= data_set_header_.number_of_records) {
+        read_new_file();  // can throw Error_t::EOF
+      }
+      try {
+        // without zero copy, the label and dense are read in place
+        const char* label_dense_ptr =
+            read_(reinterpret_cast<char*>(label_dense), sizeof(float) * label_dense_dim,
+                  "failure in reading label_dense");
+        if (label_dense_ptr != reinterpret_cast<char*>(label_dense)) {
+          memcpy(label_dense, label_dense_ptr, sizeof(float) * label_dense_dim);
+        }
+        size_t num_keys = 0;
+        for (int k = 0; k < slots_; k++) {
+          nnz[k] = read_value_<int>("failure in reading nnz");
+          if (nnz[k] < 0 || num_keys + nnz[k] > max_keys_per_sample_) {
+            CK_THROW_(Error_t::BrokenFile, "more keys than max_feature_num | nnz < 0");
+          }
+          const char* ptr = read_(reinterpret_cast<char*>(keys + num_keys), sizeof(T) * nnz[k],
+                                  "failure in reading feature_ids_");
+          if (ptr != reinterpret_cast<char*>(keys + num_keys)) {
+            memcpy(keys + num_keys, ptr, sizeof(T) * nnz[k]);
+          }
+          num_keys += nnz[k];
+        }
+        current_record_index_++;
+        return;
+      } catch (const internal_runtime_error& rt_err) {
+        if (rt_err.get_error() == Error_t::DataCheckError) {
+          ERROR_MESSAGE_("Error_t::DataCheckError");
+          current_record_index_++;
+        } else {  // Error_t::BrokenFile, Error_t::UnspecificEror, ...
+          read_new_file();  // can throw Error_t::EOF
+        }
+      }
+    }
+  }
+
+  /**
+   * Fill the chunk with samples drawn at random from the reservoir, each of which is replaced
+   * by the next sample in the file order. Once the EOF is faced, the reservoir is drained.
+   * @return the number of samples in the chunk, which is less than the batchsize only if the
+   * EOF is faced; in that case, it throws `EndOfFile` if the number is 0.
+   */
+  int read_samples_shuffled(CSRChunk<T>* csr_chunk) {
+    const int batchsize = csr_chunk->get_batchsize();
+    const int label_dense_dim = csr_chunk->get_label_dense_dim();
+    // label_dense_dim is known only after the first header is read
+    shuffle_label_dense_.resize(static_cast<size_t>(shuffle_buffer_size_) * label_dense_dim);
+    try {
+      while (!shuffle_eof_ && shuffle_buffer_count_ < shuffle_buffer_size_) {
+        decode_next_sample(shuffle_buffer_count_, batchsize);
+        shuffle_buffer_count_++;
+      }
+    } catch (const internal_runtime_error& rt_err) {
+      if (rt_err.get_error() != Error_t::EndOfFile) {
+        throw;
+      }
+      shuffle_eof_ = true;
+    }
+    int i = 0;
+    for (; i < batchsize && shuffle_buffer_count_ > 0; i++) {
+      int slot = std::uniform_int_distribution<int>(0, shuffle_buffer_count_ - 1)(shuffle_gen_);
+      push_sample(csr_chunk, i,
+                  shuffle_label_dense_.data() + static_cast<size_t>(slot) * label_dense_dim,
+                  shuffle_nnz_.data() + static_cast<size_t>(slot) * slots_,
+                  shuffle_keys_.data() + static_cast<size_t>(slot) * max_keys_per_sample_);
+      bool refilled = false;
+      if (!shuffle_eof_) {
+        try {
+          decode_next_sample(slot, batchsize);
+          refilled = true;
+        } catch (const internal_runtime_error& rt_err) {
+          if (rt_err.get_error() != Error_t::EndOfFile) {
+            throw;
+          }
+          shuffle_eof_ = true;
+        }
+      }
+      if (!refilled) {
+        // move the last sample to the hole
+        shuffle_buffer_count_--;
+        if (slot != shuffle_buffer_count_) {
+          copy_shuffle_slot(shuffle_buffer_count_, slot, label_dense_dim);
+        }
+      }
+    }
+    if (i == 0) {
+      throw internal_runtime_error(Error_t::EndOfFile, "EndOfFile");
+    }
+    return i;
+  }
+
+  void copy_shuffle_slot(int from, int to, int label_dense_dim) {
+    memcpy(shuffle_label_dense_.data() + static_cast<size_t>(to) * label_dense_dim,
+           shuffle_label_dense_.data() + static_cast<size_t>(from) * label_dense_dim,
+           sizeof(float) * label_dense_dim);
+    int* nnz = shuffle_nnz_.data() + static_cast<size_t>(from) * slots_;
+    memcpy(shuffle_nnz_.data() + static_cast<size_t>(to) * slots_, nnz, sizeof(int) * slots_);
+    size_t num_keys = 0;
+    for (int k = 0; k < slots_; k++) {
+      num_keys += nnz[k];
+    }
+    memcpy(shuffle_keys_.data() + static_cast<size_t>(to) * max_keys_per_sample_,
+           shuffle_keys_.data() + static_cast<size_t>(from) * max_keys_per_sample_,
+           sizeof(T) * num_keys);
+  }
+
   void create_checker() {
+    decompressing_source_ = std::make_shared<DecompressingSource>(source_, check_type_);
     switch (check_type_) {
       case Check_t::Sum:
-        checker_ = std::make_shared<CheckSum>(*source_);
+        checker_ = std::make_shared<CheckSumBlock>(*decompressing_source_);
         break;
       case Check_t::None:
-        checker_ = std::make_shared<CheckNone>(*source_);
+        checker_ = std::make_shared<CheckNone>(*decompressing_source_);
         break;
       default:
         assert(!"Error: no such Check_t && should never get here!!");
     }
+    zero_copy_ = checker_->is_zero_copy();
+    mmap_source_ = num_parse_threads_ > 1 ? std::dynamic_pointer_cast<MmapFileSource>(source_)
+                                          : nullptr;
+    records_ = nullptr;
+    records_size_ = 0;
+    scan_offset_ = 0;
+    fragment_id_ = fragments_.size();
+    shuffle_buffer_count_ = 0;
+    shuffle_eof_ = false;
+  }
+
+  /**
+   * Read "bytes" from the checker and return the pointer to them.
+   * In the zero-copy mode, the pointer refers to the mapped file and "buffer" is not touched.
+   * The returned data can be unaligned.
+   */
+  const char* read_(char* buffer, size_t bytes, const char* what) {
+    if (zero_copy_) {
+      const char* ptr = nullptr;
+      CK_THROW_(checker_->read_ptr(&ptr, bytes), what);
+      return ptr;
+    }
+    CK_THROW_(checker_->read(buffer, bytes), what);
+    return buffer;
+  }
+
+  template <typename V>
+  V read_value_(const char* what) {
+    V value;
+    const char* ptr = read_(reinterpret_cast<char*>(&value), sizeof(V), what);
+    if (ptr != reinterpret_cast<char*>(&value)) {
+      memcpy(&value, ptr, sizeof(V));
+    }
+    return value;
   }
 
   void post_set_source() override {
@@ -104,22 +580,51 @@ class DataReaderWorker : public IDataReaderWorker {
                    const std::shared_ptr<ChunkProducer<CSRChunk<T>>>& csr_heap,
                    const std::string& file_list, size_t buffer_length, bool repeat,
                    Check_t check_type,
-                   const std::vector<DataReaderSparseParam>& params)
+                   const std::vector<DataReaderSparseParam>& params, bool use_mmap = false,
+                   int num_parse_threads = 1, int shuffle_buffer_size = 0,
+                   bool shuffle_files = false, unsigned int seed = 0, int async_io_depth = 0)
       : worker_id_(worker_id),
         worker_num_(worker_num),
         csr_heap_(csr_heap),
         buffer_length_(buffer_length),
         check_type_(check_type),
         params_(params),
-        feature_ids_(new T[buffer_length]()) {
+        feature_ids_(new T[buffer_length]()),
+        num_parse_threads_(num_parse_threads),
+        fragments_(num_parse_threads),
+        shuffle_buffer_size_(shuffle_buffer_size),
+        shuffle_gen_(seed + worker_id) {
     if (worker_id >= worker_num) {
       CK_THROW_(Error_t::BrokenFile, "DataReaderWorker: worker_id >= worker_num");
     }
+    if (num_parse_threads <= 0) {
+      CK_THROW_(Error_t::WrongInput, "DataReaderWorker: num_parse_threads <= 0");
+    }
+    if (shuffle_buffer_size < 0) {
+      CK_THROW_(Error_t::WrongInput, "DataReaderWorker: shuffle_buffer_size < 0");
+    }
     slots_ = 0;
     for (auto& p : params) {
       slots_ += p.slot_num;
+      max_keys_per_sample_ += p.max_feature_num;
+    }
+    if (shuffle_buffer_size > 0) {
+      shuffle_nnz_.resize(static_cast<size_t>(shuffle_buffer_size) * slots_);
+      shuffle_keys_.resize(static_cast<size_t>(shuffle_buffer_size) * max_keys_per_sample_);
+    }
+    if (use_mmap && async_io_depth > 0) {
+      CK_THROW_(Error_t::WrongInput, "DataReaderWorker: use_mmap with async_io_depth > 0");
+    }
+    if (use_mmap) {
+      source_ = std::make_shared<MmapFileSource>(worker_id, worker_num, file_list, repeat,
+                                                 shuffle_files, seed);
+    } else if (async_io_depth > 0) {
+      source_ = std::make_shared<AsyncFileSource>(worker_id, worker_num, file_list, repeat,
+                                                  shuffle_files, seed, async_io_depth);
+    } else {
+      source_ = std::make_shared<FileSource>(worker_id, worker_num, file_list, repeat,
+                                             shuffle_files, seed);
     }
-    source_ = std::make_shared<FileSource>(worker_id, worker_num, file_list, repeat);
     // In the no-repeat mode, the data reader worker doesn't start from the beginning.
     // Thus, whe constructed, it is considered as the same as the EOF state,
     // so that set_*_source can be done on the client code side.
@@ -165,91 +670,106 @@ void DataReaderWorker<T>::read_a_batch() {
 
       csr_chunk->apply_to_csr_buffers(&CSR<T>::reset);
       assert(label_dense_buffers.size() > 0);
-      // batch loop
-      for (i = 0; i < csr_chunk->get_batchsize(); i++) {
-        try {
-          int param_id = 0;
-          csr_chunk->apply_to_csr_buffers(&CSR<T>::set_check_point);
-
-          CK_THROW_(checker_->read(reinterpret_cast<char*>(label_dense.get()),
-                                  sizeof(float) * label_dense_dim),
-                    "failure in reading label_dense");
-
-          {
-            // We suppose that the data parallel mode is like this
-            // The subsequence samples will be located to the same GPU
-            int buffer_id = i / (csr_chunk->get_batchsize() / label_dense_buffers.size());
-            assert((unsigned int)buffer_id < label_dense_buffers.size());
-            int local_id = i % (csr_chunk->get_batchsize() / label_dense_buffers.size());
-            assert((unsigned int)local_id <
-                   (csr_chunk->get_batchsize() / label_dense_buffers.size()));
-            float* ptr = label_dense_buffers[buffer_id].get_ptr();
-            for (int j = 0; j < label_dense_dim; j++) {
-              ptr[local_id * label_dense_dim + j] = label_dense[j];  // row major for label buffer
-            }
+      if (shuffle_buffer_size_ > 0 || mmap_source_ != nullptr) {
+        i = shuffle_buffer_size_ > 0 ? read_samples_shuffled(csr_chunk)
+                                     : read_samples_in_parallel(csr_chunk);
+        if (i < csr_chunk->get_batchsize()) {
+#ifndef NDEBUG
+          MESSAGE_("Worker" + std::to_string(worker_id_) +
+                   " generated the last batch with " +
+                   std::to_string(i) + " samples");
+#endif
+          csr_chunk->set_current_batchsize(i);
+          for (int j = i; j < csr_chunk->get_batchsize(); j++) {
+            fill_empty_sample(params_, csr_chunk);
           }
+        }
+      } else {
+        // batch loop
+        for (i = 0; i < csr_chunk->get_batchsize(); i++) {
+          try {
+            int param_id = 0;
+            csr_chunk->apply_to_csr_buffers(&CSR<T>::set_check_point);
 
-          for (auto& param : params_) {
-            for (int k = 0; k < param.slot_num; k++) {
-              int nnz;
-              CK_THROW_(checker_->read(reinterpret_cast<char*>(&nnz), sizeof(int)),
-                        "failure in reading nnz");
+            const char* label_dense_ptr =
+                read_(reinterpret_cast<char*>(label_dense.get()), sizeof(float) * label_dense_dim,
+                      "failure in reading label_dense");
 
-              if (nnz > (int)buffer_length_ || nnz < 0) {
-                ERROR_MESSAGE_("nnz > buffer_length_ | nnz < 0");
-              }
+            {
+              // We suppose that the data parallel mode is like this
+              // The subsequence samples will be located to the same GPU
+              int buffer_id = i / (csr_chunk->get_batchsize() / label_dense_buffers.size());
+              assert((unsigned int)buffer_id < label_dense_buffers.size());
+              int local_id = i % (csr_chunk->get_batchsize() / label_dense_buffers.size());
+              assert((unsigned int)local_id <
+                     (csr_chunk->get_batchsize() / label_dense_buffers.size()));
+              float* ptr = label_dense_buffers[buffer_id].get_ptr();
+              // row major for label buffer
+              memcpy(ptr + local_id * label_dense_dim, label_dense_ptr,
+                     sizeof(float) * label_dense_dim);
+            }
 
-              CK_THROW_(checker_->read(reinterpret_cast<char*>(feature_ids_),
-                                       sizeof(T) * nnz),
-                        "failure in reading feature_ids_");
-              if (param.type == DataReaderSparse_t::Distributed) {
-                for (int dev_id = 0; dev_id < csr_chunk->get_num_devices(); dev_id++) {
-                  csr_chunk->get_csr_buffer(param_id, dev_id).new_row();
-                }
-                for (int j = 0; j < nnz; j++) {
-                  int dev_id = feature_ids_[j] % csr_chunk->get_num_devices();
-                  dev_id = std::abs(dev_id);
-                  T local_id = feature_ids_[j];
-                  assert(dev_id < csr_chunk->get_num_devices());
-                  csr_chunk->get_csr_buffer(param_id, dev_id).push_back(local_id);
+            for (auto& param : params_) {
+              for (int k = 0; k < param.slot_num; k++) {
+                int nnz = read_value_<int>("failure in reading nnz");
+
+                if (nnz > (int)buffer_length_ || nnz < 0) {
+                  ERROR_MESSAGE_("nnz > buffer_length_ | nnz < 0");
                 }
-              } else if (param.type == DataReaderSparse_t::Localized) {
-                int dev_id = k % csr_chunk->get_num_devices();
-                csr_chunk->get_csr_buffer(param_id, dev_id).new_row();
-                for (int j = 0; j < nnz; j++) {
-                  T local_id = feature_ids_[j];
-                  csr_chunk->get_csr_buffer(param_id, dev_id).push_back(local_id);
+
+                const char* feature_ids = read_(reinterpret_cast<char*>(feature_ids_),
+                                                sizeof(T) * nnz, "failure in reading feature_ids_");
+                if (param.type == DataReaderSparse_t::Distributed) {
+                  for (int dev_id = 0; dev_id < csr_chunk->get_num_devices(); dev_id++) {
+                    csr_chunk->get_csr_buffer(param_id, dev_id).new_row();
+                  }
+                  for (int j = 0; j < nnz; j++) {
+                    T local_id;
+                    memcpy(&local_id, feature_ids + j * sizeof(T), sizeof(T));
+                    int dev_id = local_id % csr_chunk->get_num_devices();
+                    dev_id = std::abs(dev_id);
+                    assert(dev_id < csr_chunk->get_num_devices());
+                    csr_chunk->get_csr_buffer(param_id, dev_id).push_back(local_id);
+                  }
+                } else if (param.type == DataReaderSparse_t::Localized) {
+                  int dev_id = k % csr_chunk->get_num_devices();
+                  csr_chunk->get_csr_buffer(param_id, dev_id).new_row();
+                  for (int j = 0; j < nnz; j++) {
+                    T local_id;
+                    memcpy(&local_id, feature_ids + j * sizeof(T), sizeof(T));
+                    csr_chunk->get_csr_buffer(param_id, dev_id).push_back(local_id);
+                  }
+                } else {
+                  CK_THROW_(Error_t::UnspecificError, "param.type is not defined");
                 }
-              } else {
-                CK_THROW_(Error_t::UnspecificError, "param.type is not defined");
               }
+              param_id++;
+            }  // for(auto& param: params_)
+          }
+          catch (const internal_runtime_error &rt_err) {
+            i--; // restart i-th sample
+            csr_chunk->apply_to_csr_buffers(&CSR<T>::roll_back);
+            Error_t err = rt_err.get_error();
+            if (err == Error_t::DataCheckError) {
+              ERROR_MESSAGE_("Error_t::DataCheckError");
+            }
+            else { // Error_t::BrokenFile, Error_t::UnspecificEror, ...
+              read_new_file(); // can throw Error_t::EOF
             }
-            param_id++;
-          }  // for(auto& param: params_)
-        }
-        catch (const internal_runtime_error &rt_err) {
-          i--; // restart i-th sample
-          csr_chunk->apply_to_csr_buffers(&CSR<T>::roll_back);
-          Error_t err = rt_err.get_error();
-          if (err == Error_t::DataCheckError) {
-            ERROR_MESSAGE_("Error_t::DataCheckError");
           }
-          else { // Error_t::BrokenFile, Error_t::UnspecificEror, ...
-            read_new_file(); // can throw Error_t::EOF
+          catch (const std::runtime_error& rt_err) {
+            std::cerr << rt_err.what() << std::endl;
+            throw;
           }
-        }
-        catch (const std::runtime_error& rt_err) {
-          std::cerr << rt_err.what() << std::endl;
-          throw;
-        }
 
-        current_record_index_++;
+          current_record_index_++;
 
-        // start a new file when finish one file read
-        if (current_record_index_ >= data_set_header_.number_of_records) {
-          read_new_file(); // can throw Error_t::EOF
-        }
-      }  // batch loop
+          // start a new file when finish one file read
+          if (current_record_index_ >= data_set_header_.number_of_records) {
+            read_new_file(); // can throw Error_t::EOF
+          }
+        }  // batch loop
+      }
       // write the last index to row
       csr_chunk->apply_to_csr_buffers(&CSR<T>::new_row);
     }
@@ -24,21 +24,43 @@ namespace HugeCTR {
 template <typename TypeKey>
 class DataReaderWorkerGroupNorm : public DataReaderWorkerGroup {
   std::string file_list_; /**< file list of data set */
+  bool use_mmap_;         /**< memory map the data files instead of streaming them */
+  bool shuffle_files_;    /**< visit the files in a different order every epoch */
+  unsigned int seed_;     /**< shared by all the workers, so that they agree on the order */
+  int async_io_depth_;    /**< reads in flight per worker, or 0 for the blocking I/O */
 
   std::shared_ptr<Source> create_source(size_t worker_id, size_t num_worker,
       const std::string& file_name, bool repeat) override {
-    return std::make_shared<FileSource>(worker_id, num_worker, file_name, repeat);
+    if (use_mmap_) {
+      return std::make_shared<MmapFileSource>(worker_id, num_worker, file_name, repeat,
+                                              shuffle_files_, seed_);
+    }
+    if (async_io_depth_ > 0) {
+      return std::make_shared<AsyncFileSource>(worker_id, num_worker, file_name, repeat,
+                                               shuffle_files_, seed_, async_io_depth_);
+    }
+    return std::make_shared<FileSource>(worker_id, num_worker, file_name, repeat, shuffle_files_,
+                                        seed_);
   }
 
  public:
   // Ctor
-  DataReaderWorkerGroupNorm(std::shared_ptr<HeapEx<CSRChunk<TypeKey>>> csr_heap,
+  DataReaderWorkerGroupNorm(std::shared_ptr<ChunkHeap<CSRChunk<TypeKey>>> csr_heap,
                             std::string file_list,
                             bool repeat,
                             Check_t check_type,
                             const std::vector<DataReaderSparseParam> params,
-                            bool start_reading_from_beginning = true)
-      : DataReaderWorkerGroup(start_reading_from_beginning, DataReaderType_t::Norm) {
+                            bool start_reading_from_beginning = true,
+                            bool use_mmap = false,
+                            int num_parse_threads = 1,
+                            int shuffle_buffer_size = 0,
+                            bool shuffle_files = false,
+                            int async_io_depth = 0)
+      : DataReaderWorkerGroup(start_reading_from_beginning, DataReaderType_t::Norm),
+        use_mmap_(use_mmap),
+        shuffle_files_(shuffle_files),
+        seed_(std::random_device()()),
+        async_io_depth_(async_io_depth) {
     if (file_list.empty()) {
       CK_THROW_(Error_t::WrongInput, "file_name.empty()");
     }
@@ -54,7 +76,9 @@ class DataReaderWorkerGroupNorm : public DataReaderWorkerGroup {
     int NumThreads = csr_heap->get_size();
     for (int i = 0; i < NumThreads; i++) {
       std::shared_ptr<IDataReaderWorker> data_reader(new DataReaderWorker<TypeKey>(
-          i, NumThreads, csr_heap, file_list, max_feature_num_per_sample, repeat, check_type, params));
+          i, NumThreads, csr_heap, file_list, max_feature_num_per_sample, repeat, check_type, params,
+          use_mmap, num_parse_threads, shuffle_buffer_size, shuffle_files, seed_,
+          async_io_depth));
       data_readers_.push_back(data_reader);
     }
     create_data_reader_threads();
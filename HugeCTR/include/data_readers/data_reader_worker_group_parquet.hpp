@@ -16,6 +16,7 @@
 
 #pragma once
 
+#include <data_readers/chunk_heap.hpp>
 #include <data_readers/data_reader_worker_group.hpp>
 #include <data_readers/parquet_data_reader_worker.hpp>
 
@@ -31,7 +32,7 @@ class DataReaderWorkerGroupParquet : public DataReaderWorkerGroup {
 
  public:
   // Ctor
-  DataReaderWorkerGroupParquet(std::shared_ptr<HeapEx<CSRChunk<TypeKey>>> csr_heap,
+  DataReaderWorkerGroupParquet(std::shared_ptr<ChunkHeap<CSRChunk<TypeKey>>> csr_heap,
                                std::string file_list,
                                const std::vector<DataReaderSparseParam> params,
                                const std::vector<long long> slot_offset,
@@ -16,6 +16,7 @@
 
 #pragma once
 
+#include <data_readers/chunk_heap.hpp>
 #include <data_readers/data_reader_worker_group.hpp>
 #include <data_readers/data_reader_worker_raw.hpp>
 
@@ -29,6 +30,8 @@ class DataReaderWorkerGroupRaw : public DataReaderWorkerGroup {
   long long stride_;
   long long batchsize_;
   bool data_shuffle_;
+  long long shuffle_block_size_;
+  int async_io_depth_; /**< batches in flight per worker, or 0 to read the mapping */
 
   std::shared_ptr<Source> create_source(size_t worker_id, size_t num_worker,
       const std::string& file_name, bool repeat) override {
@@ -36,27 +39,34 @@ class DataReaderWorkerGroupRaw : public DataReaderWorkerGroup {
     std::shared_ptr<MmapOffsetList> mmap_offset_list;
     if (!worker_id && create_offset_) {
       file_offset_list_.reset(new MmapOffsetList(
-          file_name, num_samples_, stride_, batchsize_, data_shuffle_, num_worker, repeat));
+          file_name, num_samples_, stride_, batchsize_, data_shuffle_, num_worker, repeat,
+          shuffle_block_size_));
       create_offset_ = false;
     }
     mmap_offset_list = file_offset_list_;
     create_offset_ = (worker_id == num_worker - 1) ? true : create_offset_;
 
+    if (async_io_depth_ > 0) {
+      return std::make_shared<AsyncMmapSource>(mmap_offset_list, worker_id, async_io_depth_);
+    }
     return std::make_shared<MmapSource>(mmap_offset_list, worker_id);
   }
 
  public:
   // Ctor
-  DataReaderWorkerGroupRaw(std::shared_ptr<HeapEx<CSRChunk<TypeKey>>> csr_heap,
+  DataReaderWorkerGroupRaw(std::shared_ptr<ChunkHeap<CSRChunk<TypeKey>>> csr_heap,
                            std::string file_name, long long num_samples, bool repeat,
                            const std::vector<DataReaderSparseParam> params,
                            const std::vector<long long> slot_offset, int label_dim, int dense_dim,
                            int batchsize, bool float_label_dense, bool data_shuffle = false,
-                           bool start_reading_from_beginning = true)
+                           bool start_reading_from_beginning = true,
+                           long long shuffle_block_size = 0, int async_io_depth = 0)
       : DataReaderWorkerGroup(start_reading_from_beginning, DataReaderType_t::Raw),
         num_samples_(num_samples),
         batchsize_(batchsize),
-        data_shuffle_(data_shuffle) {
+        data_shuffle_(data_shuffle),
+        shuffle_block_size_(shuffle_block_size),
+        async_io_depth_(async_io_depth) {
     // todo param check
     if (file_name.empty()) {
       CK_THROW_(Error_t::WrongInput, "file_name.empty()");
@@ -70,14 +80,15 @@ class DataReaderWorkerGroupRaw : public DataReaderWorkerGroup {
       size_t stride = slots * sizeof(int) +
                       (label_dim + dense_dim) * (float_label_dense ? sizeof(float) : sizeof(int));
       file_offset_list_.reset(new MmapOffsetList(file_name, num_samples, stride, batchsize,
-                                                 data_shuffle, csr_heap->get_size(), repeat));
+                                                 data_shuffle, csr_heap->get_size(), repeat,
+                                                 shuffle_block_size));
       stride_ = stride;
     }
 
     for (int i = 0; i < csr_heap->get_size(); i++) {
       std::shared_ptr<IDataReaderWorker> data_reader(new DataReaderWorkerRaw<TypeKey>(
           i, csr_heap->get_size(), file_offset_list_, csr_heap, repeat, params, slot_offset,
-          label_dim, float_label_dense));
+          label_dim, float_label_dense, async_io_depth));
       data_readers_.push_back(data_reader);
     }
     create_data_reader_threads();
@@ -17,11 +17,14 @@
 #pragma once
 #include <common.hpp>
 #include <data_readers/check_none.hpp>
+#include <data_readers/chunk_producer.hpp>
 #include <data_readers/csr.hpp>
 #include <data_readers/csr_chunk.hpp>
 #include <data_readers/data_reader_worker_interface.hpp>
-#include <data_readers/heapex.hpp>
 #include <data_readers/mmap_source.hpp>
+#include <data_readers/mmap_source_async.hpp>
+#include <data_readers/raw_transform.hpp>
+#include <algorithm>
 #include <fstream>
 #include <vector>
 
@@ -31,7 +34,7 @@ class DataReaderWorkerRaw : public IDataReaderWorker {
  private:
   const unsigned int worker_id_{0};
   const unsigned int worker_num_{0};
-  std::shared_ptr<HeapEx<CSRChunk<T>>> csr_heap_; /**< heap to cache the data set */
+  std::shared_ptr<ChunkProducer<CSRChunk<T>>> csr_heap_; /**< heap to cache the data set */
   std::vector<DataReaderSparseParam> params_;     /**< configuration of data reader sparse input */
   int* feature_ids_;               /**< a buffer to cache the readed feature from data set */
   bool skip_read_{false};          /**< set to true when you want to stop the data reading */
@@ -40,12 +43,27 @@ class DataReaderWorkerRaw : public IDataReaderWorker {
   const std::vector<long long> slot_offset_;
   const int label_dim_{1};
   const bool float_label_dense_;
+  std::vector<T> key_offset_; /**< slot_offset_ in T, or 0 if it is empty */
+  std::vector<T> key_tile_;   /**< keys of a tile of samples with the slot offsets added */
+  std::vector<int> slot_ids_; /**< the slots on a device */
+
+  /**
+   * Number of samples transposed at a time, so that their keys stay in the cache
+   * while they are scattered to the devices.
+   */
+  static const int TILE_SIZE = 128;
+
+  void read_samples_columnar(CSRChunk<T>* csr_chunk, const char* data_buffer,
+                             long long current_batchsize);
 
   void read_new_file() {
     Error_t flag = source_->next_source();
     if (flag == Error_t::EndOfFile) {
       throw internal_runtime_error(Error_t::EndOfFile, "EndOfFile");
     }
+    if (flag != Error_t::Success) {
+      CK_THROW_(flag, "failed to get the next batch");
+    }
   }
   //  std::vector<int> data_buffer_; /**< data buffer with size of full batchsize*/
 
@@ -63,11 +81,11 @@ class DataReaderWorkerRaw : public IDataReaderWorker {
    */
   DataReaderWorkerRaw(unsigned int worker_id, unsigned int worker_num,
                       std::shared_ptr<MmapOffsetList>& file_offset_list,
-                      const std::shared_ptr<HeapEx<CSRChunk<T>>>& csr_heap,
+                      const std::shared_ptr<ChunkProducer<CSRChunk<T>>>& csr_heap,
                       bool repeat,
                       const std::vector<DataReaderSparseParam>& params,
                       const std::vector<long long>& slot_offset, int label_dim,
-                      bool float_label_dense)
+                      bool float_label_dense, int async_io_depth = 0)
       : worker_id_(worker_id),
         worker_num_(worker_num),
         csr_heap_(csr_heap),
@@ -86,8 +104,16 @@ class DataReaderWorkerRaw : public IDataReaderWorker {
       CK_THROW_(Error_t::WrongInput, "DataReaderWorkerRaw: slots_ != slot_offset_.size()");
     }
     feature_ids_ = new int[slots_]();
+    key_offset_.resize(slots_, 0);
+    for (size_t k = 0; k < slot_offset_.size(); k++) {
+      key_offset_[k] = static_cast<T>(slot_offset_[k]);
+    }
 
-    source_ = std::make_shared<MmapSource>(file_offset_list, worker_id);
+    if (async_io_depth > 0) {
+      source_ = std::make_shared<AsyncMmapSource>(file_offset_list, worker_id, async_io_depth);
+    } else {
+      source_ = std::make_shared<MmapSource>(file_offset_list, worker_id);
+    }
 
     if (!repeat) {
       is_eof_ = true;
@@ -107,6 +133,160 @@ class DataReaderWorkerRaw : public IDataReaderWorker {
   }
 };
 
+/**
+ * Every Raw sample has exactly one key per slot, so the row offsets are implicit except for
+ * the distributed slots on multiple devices. The keys are transposed from the sample-major
+ * file into the CSR value arrays of each device tile by tile, without per-key bound checks.
+ * The samples from current_batchsize to the batchsize are left empty.
+ */
+template <class T>
+void DataReaderWorkerRaw<T>::read_samples_columnar(CSRChunk<T>* csr_chunk,
+                                                   const char* data_buffer,
+                                                   long long current_batchsize) {
+  const int batchsize = csr_chunk->get_batchsize();
+  const int num_devices = csr_chunk->get_num_devices();
+  const int label_dense_dim = csr_chunk->get_label_dense_dim();
+  const size_t label_dense_length =
+      label_dense_dim * (float_label_dense_ ? sizeof(float) : sizeof(int));
+  const size_t sample_length = slots_ * sizeof(int) + label_dense_length;
+  const int num_samples = std::min<long long>(current_batchsize, batchsize);
+
+  // label and dense
+  Tensors2<float>& label_dense_buffers = csr_chunk->get_label_buffers();
+  const int samples_per_buffer = batchsize / label_dense_buffers.size();
+  for (int i = 0; i < num_samples; i++) {
+    const char* sample_cur = data_buffer + sample_length * i;
+    // label buffer is in row-major layout
+    float* ptr = label_dense_buffers[i / samples_per_buffer].get_ptr() +
+                 (i % samples_per_buffer) * label_dense_dim;
+    if (float_label_dense_) {
+      memcpy(ptr, sample_cur, sizeof(float) * label_dense_dim);
+    } else {
+      const int* label_dense = reinterpret_cast<const int*>(sample_cur);
+      for (int j = 0; j < label_dim_; j++) {
+        ptr[j] = label_dense[j];
+      }
+      // DLRM-style preprocessing of the dense features
+      log1p_transform(label_dense + label_dim_, ptr + label_dim_, label_dense_dim - label_dim_);
+    }
+  }
+
+  // the keys are written without bound checks, so the capacity of every CSR buffer is checked
+  // first, for the worst case of the distributed slots on multiple devices where all the keys
+  // of a sample may go to one device
+  for (size_t param_id = 0; param_id < params_.size(); param_id++) {
+    auto& param = params_[param_id];
+    for (int dev_id = 0; dev_id < num_devices; dev_id++) {
+      size_t num_slots = param.slot_num;
+      if (param.type == DataReaderSparse_t::Localized) {
+        num_slots = dev_id < param.slot_num
+                        ? (param.slot_num - dev_id + num_devices - 1) / num_devices
+                        : 0;
+      }
+      // one key per row
+      const size_t max_value_size = static_cast<size_t>(num_samples) * num_slots;
+      CSR<T>& csr = csr_chunk->get_csr_buffer(param_id, dev_id);
+      if (max_value_size > csr.get_value_tensor().get_num_elements() ||
+          max_value_size > csr.get_num_rows()) {
+        CK_THROW_(Error_t::OutOfBound,
+                  "CSR out of bound " + std::to_string(csr.get_value_tensor().get_num_elements()) +
+                      " values and " + std::to_string(csr.get_num_rows()) + " rows for " +
+                      std::to_string(max_value_size) + " keys");
+      }
+    }
+  }
+
+  // rows and values written so far to each CSR buffer
+  std::vector<size_t> num_values(num_devices * params_.size(), 0);
+  key_tile_.resize(TILE_SIZE * slots_);
+  for (int tile_begin = 0; tile_begin < num_samples; tile_begin += TILE_SIZE) {
+    const int tile_size =
+        num_samples - tile_begin < TILE_SIZE ? num_samples - tile_begin : TILE_SIZE;
+    for (int s = 0; s < tile_size; s++) {
+      const char* sample_cur = data_buffer + sample_length * (tile_begin + s);
+      add_slot_offset(reinterpret_cast<const int*>(sample_cur + label_dense_length),
+                      key_offset_.data(), key_tile_.data() + s * slots_, slots_);
+    }
+
+    int slot_base = 0;
+    for (size_t param_id = 0; param_id < params_.size(); param_id++) {
+      auto& param = params_[param_id];
+      if (param.type == DataReaderSparse_t::Distributed && num_devices > 1) {
+        // the row offsets depend on the keys
+        for (int s = 0; s < tile_size; s++) {
+          const T* keys = key_tile_.data() + s * slots_ + slot_base;
+          size_t row = static_cast<size_t>(tile_begin + s) * param.slot_num;
+          for (int k = 0; k < param.slot_num; k++, row++) {
+            for (int dev_id = 0; dev_id < num_devices; dev_id++) {
+              csr_chunk->get_csr_buffer(param_id, dev_id).get_row_offset_tensor().get_ptr()[row] =
+                  num_values[dev_id * params_.size() + param_id];
+            }
+            int dev_id = std::abs(static_cast<int>(keys[k] % num_devices));
+            size_t& value_id = num_values[dev_id * params_.size() + param_id];
+            csr_chunk->get_csr_buffer(param_id, dev_id).get_value_tensor().get_ptr()[value_id++] =
+                keys[k];
+          }
+        }
+      } else {
+        for (int dev_id = 0; dev_id < num_devices; dev_id++) {
+          slot_ids_.clear();
+          if (param.type == DataReaderSparse_t::Distributed) {
+            for (int k = 0; k < param.slot_num; k++) {
+              slot_ids_.push_back(slot_base + k);
+            }
+          } else if (param.type == DataReaderSparse_t::Localized) {
+            for (int k = dev_id; k < param.slot_num; k += num_devices) {
+              slot_ids_.push_back(slot_base + k);
+            }
+          } else {
+            CK_THROW_(Error_t::UnspecificError, "param.type is not defined");
+          }
+          const size_t num_slots = slot_ids_.size();
+          T* values = csr_chunk->get_csr_buffer(param_id, dev_id).get_value_tensor().get_ptr() +
+                      num_values[dev_id * params_.size() + param_id];
+          if (num_slots == static_cast<size_t>(slots_)) {
+            memcpy(values, key_tile_.data(), sizeof(T) * tile_size * slots_);
+          } else {
+            for (int s = 0; s < tile_size; s++) {
+              const T* keys = key_tile_.data() + s * slots_;
+              for (size_t j = 0; j < num_slots; j++) {
+                values[s * num_slots + j] = keys[slot_ids_[j]];
+              }
+            }
+          }
+          num_values[dev_id * params_.size() + param_id] += tile_size * num_slots;
+        }
+      }
+      slot_base += param.slot_num;
+    }
+  }
+
+  for (size_t param_id = 0; param_id < params_.size(); param_id++) {
+    auto& param = params_[param_id];
+    for (int dev_id = 0; dev_id < num_devices; dev_id++) {
+      CSR<T>& csr = csr_chunk->get_csr_buffer(param_id, dev_id);
+      const size_t value_size = num_values[dev_id * params_.size() + param_id];
+      const size_t num_rows = csr.get_num_rows();
+      T* row_offset = csr.get_row_offset_tensor().get_ptr();
+      size_t row = 0;
+      if (param.type == DataReaderSparse_t::Distributed && num_devices > 1) {
+        row = static_cast<size_t>(num_samples) * param.slot_num;
+      } else {
+        // one key per row
+        for (; row < value_size; row++) {
+          row_offset[row] = row;
+        }
+      }
+      // empty rows of the samples after current_batchsize
+      for (; row < num_rows; row++) {
+        row_offset[row] = value_size;
+      }
+      csr.update_row_offset(num_rows);
+      csr.update_value_size(value_size);
+    }
+  }
+}
+
 template <class T>
 void DataReaderWorkerRaw<T>::read_a_batch() {
   try {
@@ -121,115 +301,10 @@ void DataReaderWorkerRaw<T>::read_a_batch() {
                   << "batchsize: " << csr_chunk->get_batchsize() << std::endl;
       }
       csr_chunk->set_current_batchsize(current_batchsize);
-      Tensors2<float>& label_dense_buffers = csr_chunk->get_label_buffers();
-
-      int slot_id = 0;
-
       csr_chunk->apply_to_csr_buffers(&CSR<T>::reset);
-      assert(label_dense_buffers.size() > 0);
-
-      size_t num_slots = 0;
-      for (auto& param : params_) {
-        num_slots += param.slot_num;
-      }
-      const int label_dense_dim = csr_chunk->get_label_dense_dim();
-      size_t label_dense_length =
-          label_dense_dim * (float_label_dense_ ? sizeof(float) : sizeof(int));
-      size_t sample_length = num_slots * sizeof(int) + label_dense_length;
+      assert(csr_chunk->get_label_buffers().size() > 0);
 
-      char* data_buffer = source_->get_ptr();
-
-      // batch loop
-      for (int i = 0; i < csr_chunk->get_batchsize(); i++) {
-        // to compensate the csr when current_batchsize != csr_chunk->get_batchsize()
-        char* sample_cur = data_buffer + sample_length * i;
-        if (i >= current_batchsize) {
-	  fill_empty_sample(params_, csr_chunk);
-          continue;
-        }  // if(i>= current_batchsize)
-
-        int param_id = 0;
-        csr_chunk->apply_to_csr_buffers(&CSR<T>::set_check_point);
-
-        {
-          // We suppose that the data parallel mode is like this
-          // The subsequence samples will be located to the same GPU
-          int buffer_id = i / (csr_chunk->get_batchsize() / label_dense_buffers.size());
-          assert((unsigned int)buffer_id < label_dense_buffers.size());
-          int local_id = i % (csr_chunk->get_batchsize() / label_dense_buffers.size());
-          assert((unsigned int)local_id <
-                 (csr_chunk->get_batchsize() / label_dense_buffers.size()));
-
-          float* ptr = label_dense_buffers[buffer_id].get_ptr();
-          for (int j = 0; j < label_dense_dim; j++) {
-            if (j < label_dim_) {
-              // label buffer is in row-major layout
-              ptr[local_id * label_dense_dim + j] = float_label_dense_
-                                                        ? reinterpret_cast<float*>(sample_cur)[j]
-                                                        : reinterpret_cast<int*>(sample_cur)[j];
-            } else {
-              // if the underlying value is int, do DLRM-style preprocessing
-              // otherwise, the value is just directly used.
-              float val = float_label_dense_ ? reinterpret_cast<float*>(sample_cur)[j]
-                                             : log(reinterpret_cast<int*>(sample_cur)[j] + 1.f);
-              ptr[local_id * label_dense_dim + j] = val;
-            }
-          }
-          // if(local_id == 0)
-          //   std::cout << std::endl;
-        }
-
-        int* feature_ids = reinterpret_cast<int*>(sample_cur + label_dense_length);
-        if (params_.size() == 1 && params_[0].type == DataReaderSparse_t::Localized &&
-            !slot_offset_.empty()) {
-          auto& param = params_[0];
-          for (int k = 0; k < param.slot_num; k++) {
-            int dev_id = k % csr_chunk->get_num_devices();
-            T local_id = feature_ids[k] + slot_offset_[k];
-            csr_chunk->get_csr_buffer(param_id, dev_id).push_back_new_row(local_id);
-          }
-        } else {
-          slot_id = 0;
-          for (auto& param : params_) {
-            for (int k = 0; k < param.slot_num; k++) {
-              long long slot_offset = slot_offset_.empty() ? 0 : slot_offset_[slot_id];
-              if (param.type == DataReaderSparse_t::Distributed) {
-                for (int dev_id = 0; dev_id < csr_chunk->get_num_devices(); dev_id++) {
-                  csr_chunk->get_csr_buffer(param_id, dev_id).new_row();
-                }
-                {
-                  T local_id = feature_ids[k] + slot_offset;
-                  int dev_id = local_id % csr_chunk->get_num_devices();
-                  dev_id = std::abs(dev_id);
-
-                  assert(dev_id < csr_chunk->get_num_devices());
-                  /* #ifndef NDEBUG
-                                    if (i >= 0)
-                                      std::cout << "[HCDEBUG]"
-                                                << "feature_ids:" << feature_ids[k] << " local_id: "
-                  << local_id
-                                                << " param_id: " << param_id << " dev_id: " <<
-                  dev_id << std::endl;
-                  #endif */
-
-                  csr_chunk->get_csr_buffer(param_id, dev_id).push_back(local_id);
-                }
-              } else if (param.type == DataReaderSparse_t::Localized) {
-                int dev_id = k % csr_chunk->get_num_devices();
-                csr_chunk->get_csr_buffer(param_id, dev_id).new_row();
-                T local_id = feature_ids[k] + slot_offset;
-                csr_chunk->get_csr_buffer(param_id, dev_id).push_back(local_id);
-
-              } else {
-                CK_THROW_(Error_t::UnspecificError, "param.type is not defined");
-              }
-              slot_id++;
-            }
-            feature_ids += param.slot_num;
-            param_id++;
-          }  // for(auto& param: params_)
-        }
-      }  // batch loop
+      read_samples_columnar(csr_chunk, source_->get_ptr(), current_batchsize);
       // write the last index to row
       csr_chunk->apply_to_csr_buffers(&CSR<T>::new_row);
     }
@@ -15,8 +15,11 @@
  */
 
 #pragma once
+#include <algorithm>
 #include <atomic>
 #include <fstream>
+#include <numeric>
+#include <random>
 #include <vector>
 #include "data_readers/metadata.hpp"
 
@@ -35,6 +38,9 @@ namespace HugeCTR {
  * 2.txt
  * 3.txt
  * @endverbatim
+ * If "shuffle" is set, the files are visited in a different order in every epoch, i.e.
+ * every num_of_files_ consecutive ids. The order only depends on "seed" and the epoch, so
+ * the workers with their own FileList still split the files of an epoch among themselves.
  */
 class FileList {
  private:
@@ -42,6 +48,26 @@ class FileList {
   std::vector<std::string> file_vector_; /**< the vector of file names. */
   std::atomic<unsigned int> counter_{0};
   std::string file_type_;
+  const bool shuffle_{false};
+  const unsigned int seed_{0};
+  long long epoch_{-1};           /**< the epoch of permutation_ */
+  std::vector<int> permutation_; /**< order of the files in epoch_ */
+
+  int get_file_index(unsigned int id) {
+    int index = id % num_of_files_;
+    if (!shuffle_) {
+      return index;
+    }
+    long long epoch = id / num_of_files_;
+    if (epoch != epoch_) {
+      permutation_.resize(num_of_files_);
+      std::iota(permutation_.begin(), permutation_.end(), 0);
+      std::mt19937 gen(seed_ + epoch);
+      std::shuffle(permutation_.begin(), permutation_.end(), gen);
+      epoch_ = epoch;
+    }
+    return permutation_[index];
+  }
 
   std::string get_file_type(std::string file_name) {
     std::string type = "None";
@@ -55,7 +81,8 @@ class FileList {
   /*
    * Ctor
    */
-  FileList(const std::string& file_list_name) {
+  FileList(const std::string& file_list_name, bool shuffle = false, unsigned int seed = 0)
+      : shuffle_(shuffle), seed_(seed) {
     try {
       std::ifstream read_stream(file_list_name, std::ifstream::in);
       if (!read_stream.is_open()) {
@@ -104,12 +131,12 @@ class FileList {
    */
   std::string get_a_file_with_id(unsigned int id, bool repeat) {
     if (repeat) {
-      int current_file_idx = id % num_of_files_;
+      int current_file_idx = get_file_index(id);
       return file_vector_[current_file_idx];
     }
     else {
       if (static_cast<int>(id) < num_of_files_) {
-        return file_vector_[id];
+        return file_vector_[get_file_index(id)];
       } else {
         return std::string();
       }
@@ -37,8 +37,10 @@ class FileSource : public Source {
   FileSource(long long offset,
              long long stride,
              const std::string& file_list,
-             bool repeat)
-      : file_list_(file_list),
+             bool repeat,
+             bool shuffle_files = false,
+             unsigned int seed = 0)
+      : file_list_(file_list, shuffle_files, seed),
       offset_(offset),
       stride_(stride),
       repeat_(repeat) {}
@@ -0,0 +1,161 @@
+/*
+ * Copyright (c) 2020, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+#include <common.hpp>
+#include <algorithm>
+#include <cstring>
+#include <data_readers/async_reader.hpp>
+#include <data_readers/file_list.hpp>
+#include <data_readers/source.hpp>
+
+namespace HugeCTR {
+
+/**
+ * @brief A source of the Norm data files read with the asynchronous I/O.
+ *
+ * It goes through the file list in the same way as FileSource, but each file is read
+ * in blocks of "block_bytes", with "queue_depth" of them requested ahead of the cursor.
+ */
+class AsyncFileSource : public Source {
+ private:
+  FileList file_list_;    /**< file list of data set */
+  std::string file_name_; /**< file name of current file */
+  const long long offset_;
+  const long long stride_;
+  bool repeat_;
+  unsigned int counter_{0};
+  const size_t block_bytes_;
+  AsyncReader reader_;
+  bool is_open_{false};
+
+  size_t next_block_{0}; /**< file offset of the next block to submit */
+  const char* block_{nullptr};
+  size_t block_size_{0};
+  size_t cursor_{0}; /**< in block_ */
+
+  void submit_blocks_() {
+    while (!reader_.full() && next_block_ < reader_.get_file_size()) {
+      reader_.submit(next_block_, block_bytes_);
+      next_block_ += block_bytes_;
+    }
+  }
+
+  /**
+   * Move to the next block.
+   * @return false at the end of file
+   */
+  bool next_block_ready_() {
+    if (block_ != nullptr) {
+      reader_.pop();
+      block_ = nullptr;
+    }
+    submit_blocks_();
+    if (reader_.empty()) {
+      return false;
+    }
+    block_ = reader_.front(&block_size_);
+    cursor_ = 0;
+    return true;
+  }
+
+ public:
+  AsyncFileSource(long long offset, long long stride, const std::string& file_list, bool repeat,
+                  bool shuffle_files = false, unsigned int seed = 0, int queue_depth = 8,
+                  size_t block_bytes = AsyncReader::MAX_REQUEST_BYTES)
+      : file_list_(file_list, shuffle_files, seed),
+        offset_(offset),
+        stride_(stride),
+        repeat_(repeat),
+        block_bytes_(block_bytes),
+        reader_(queue_depth, block_bytes) {}
+
+  ~AsyncFileSource() {
+    const AsyncIoStats& stats = reader_.get_stats();
+    if (stats.bytes_read > 0) {
+      MESSAGE_("Async I/O of source " + std::to_string(offset_) + ": " +
+               std::to_string(stats.bytes_per_sec() / (1 << 20)) + " MB/s, queue depth " +
+               std::to_string(stats.average_depth()) + " on average and " +
+               std::to_string(stats.max_depth) + " at most, waited " +
+               std::to_string(stats.wait_seconds) + " s");
+    }
+  }
+
+  /**
+   * Read "bytes_to_read" byte to the memory associated to ptr.
+   * @param ptr pointer to user located buffer
+   * @param bytes_to_read bytes to read
+   * @return `FileCannotOpen` `OutOfBound` `Success` `UnspecificError`
+   */
+  Error_t read(char* ptr, size_t bytes_to_read) noexcept {
+    try {
+      if (!is_open_) {
+        return Error_t::FileCannotOpen;
+      }
+      while (bytes_to_read > 0) {
+        if (cursor_ == block_size_ && !next_block_ready_()) {
+          return Error_t::OutOfBound;
+        }
+        size_t bytes = std::min(bytes_to_read, block_size_ - cursor_);
+        memcpy(ptr, block_ + cursor_, bytes);
+        cursor_ += bytes;
+        ptr += bytes;
+        bytes_to_read -= bytes;
+      }
+      return Error_t::Success;
+    } catch (const std::runtime_error& rt_err) {
+      std::cerr << rt_err.what() << std::endl;
+      return Error_t::UnspecificError;
+    }
+  }
+
+  /**
+   * Start a new file to read.
+   * @return `Success`, `FileCannotOpen` or `UnspecificError`
+   */
+  Error_t next_source() noexcept {
+    try {
+      block_ = nullptr;
+      block_size_ = 0;
+      cursor_ = 0;
+      next_block_ = 0;
+      reader_.close();
+      is_open_ = false;
+      std::string file_name =
+          file_list_.get_a_file_with_id(offset_ + counter_ * stride_, repeat_);
+      counter_++;  // counter_ should be accum for every source.
+      if (file_name.empty()) {
+        return Error_t::EndOfFile;
+      }
+      if (reader_.open(file_name) != Error_t::Success) {
+        CK_RETURN_(Error_t::FileCannotOpen, "failed to open " + file_name);
+      }
+      file_name_ = file_name;
+      is_open_ = true;
+      submit_blocks_();
+      return Error_t::Success;
+    } catch (const std::runtime_error& rt_err) {
+      std::cerr << rt_err.what() << std::endl;
+      return Error_t::UnspecificError;
+    }
+  }
+
+  bool is_open() noexcept { return is_open_; }
+
+  const AsyncIoStats& get_io_stats() const { return reader_.get_stats(); }
+};
+
+}  // namespace HugeCTR
@@ -0,0 +1,198 @@
+/*
+ * Copyright (c) 2020, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+#include <common.hpp>
+#include <algorithm>
+#include <cstring>
+#include <data_readers/block_codec.hpp>
+#include <data_readers/source.hpp>
+#include <memory>
+#include <vector>
+
+namespace HugeCTR {
+
+/**
+ * @brief A source of the Norm data files which decompresses them on the fly.
+ *
+ * It is put between a source and the checker. The header of each file is passed through,
+ * and if it flags a compression, the frames after it are decompressed one at a time, so that
+ * the checker sees the same bytes as in the uncompressed file. The uncompressed files are
+ * read from the source as is.
+ * read_ptr() is available on a compressed file regardless of the source, and the pointer
+ * is valid until the next frame, which is never in the middle of a record.
+ */
+class DecompressingSource : public Source {
+ private:
+  std::shared_ptr<Source> src_;
+  const size_t header_bytes_; /**< of the header record including its check bits */
+  std::vector<char> header_;
+  Error_t header_error_{Error_t::Success};
+  size_t header_cursor_{0};
+  Compression_t compression_{Compression_t::None};
+
+  std::vector<char> compressed_; /**< if the source is not zero-copy */
+  std::vector<char> frame_;
+  size_t frame_size_{0};
+  size_t frame_cursor_{0};
+
+  Error_t next_frame_() noexcept {
+    const bool zero_copy = src_->is_zero_copy();
+    BlockFrameHeader frame;
+    const char* ptr = nullptr;
+    Error_t err = zero_copy ? src_->read_ptr(&ptr, sizeof(frame))
+                            : src_->read(reinterpret_cast<char*>(&frame), sizeof(frame));
+    if (err != Error_t::Success) {
+      return err;
+    }
+    if (zero_copy) {
+      memcpy(&frame, ptr, sizeof(frame));
+    }
+    if (frame.compressed_size < 0 || frame.raw_size <= 0) {
+      ERROR_MESSAGE_("invalid frame: " + std::to_string(frame.compressed_size) + ", " +
+                     std::to_string(frame.raw_size));
+      return Error_t::BrokenFile;
+    }
+    if (zero_copy) {
+      err = src_->read_ptr(&ptr, frame.compressed_size);
+    } else {
+      compressed_.resize(frame.compressed_size);
+      err = src_->read(compressed_.data(), frame.compressed_size);
+      ptr = compressed_.data();
+    }
+    if (err != Error_t::Success) {
+      return err;
+    }
+    if (frame_.size() < static_cast<size_t>(frame.raw_size)) {
+      frame_.resize(frame.raw_size);
+    }
+    err = decompress_block(compression_, ptr, frame.compressed_size, frame_.data(),
+                           frame.raw_size);
+    if (err != Error_t::Success) {
+      return err;
+    }
+    frame_size_ = frame.raw_size;
+    frame_cursor_ = 0;
+    return Error_t::Success;
+  }
+
+ public:
+  DecompressingSource(const std::shared_ptr<Source>& src, Check_t check_type)
+      : src_(src),
+        header_bytes_(check_type == Check_t::Sum ? sizeof(int) + sizeof(DataSetHeader) + 1
+                                                 : sizeof(DataSetHeader)) {}
+
+  Error_t read(char* ptr, size_t bytes_to_read) noexcept {
+    if (header_cursor_ < header_.size()) {
+      if (header_error_ != Error_t::Success) {
+        return header_error_;
+      }
+      size_t bytes = std::min(bytes_to_read, header_.size() - header_cursor_);
+      memcpy(ptr, header_.data() + header_cursor_, bytes);
+      header_cursor_ += bytes;
+      ptr += bytes;
+      bytes_to_read -= bytes;
+    }
+    if (compression_ == Compression_t::None) {
+      return bytes_to_read > 0 ? src_->read(ptr, bytes_to_read) : Error_t::Success;
+    }
+    while (bytes_to_read > 0) {
+      if (frame_cursor_ == frame_size_) {
+        Error_t err = next_frame_();
+        if (err != Error_t::Success) {
+          return err;
+        }
+      }
+      size_t bytes = std::min(bytes_to_read, frame_size_ - frame_cursor_);
+      memcpy(ptr, frame_.data() + frame_cursor_, bytes);
+      frame_cursor_ += bytes;
+      ptr += bytes;
+      bytes_to_read -= bytes;
+    }
+    return Error_t::Success;
+  }
+
+  Error_t read_ptr(const char** ptr, size_t bytes_to_read) noexcept {
+    if (header_cursor_ < header_.size()) {
+      if (header_error_ != Error_t::Success) {
+        return header_error_;
+      }
+      if (bytes_to_read > header_.size() - header_cursor_) {
+        return Error_t::OutOfBound;
+      }
+      *ptr = header_.data() + header_cursor_;
+      header_cursor_ += bytes_to_read;
+      return Error_t::Success;
+    }
+    if (compression_ == Compression_t::None) {
+      return src_->read_ptr(ptr, bytes_to_read);
+    }
+    if (frame_cursor_ == frame_size_ && bytes_to_read > 0) {
+      Error_t err = next_frame_();
+      if (err != Error_t::Success) {
+        return err;
+      }
+    }
+    if (bytes_to_read > frame_size_ - frame_cursor_) {
+      ERROR_MESSAGE_("a record straddles two frames");
+      return Error_t::BrokenFile;
+    }
+    *ptr = frame_.data() + frame_cursor_;
+    frame_cursor_ += bytes_to_read;
+    return Error_t::Success;
+  }
+
+  bool is_zero_copy() noexcept { return src_->is_zero_copy(); }
+
+  /**
+   * Start a new file to read and fetch its header to find the compression.
+   * @return `Success`, `EndOfFile`, `FileCannotOpen` or `UnspecificError`
+   */
+  Error_t next_source() noexcept {
+    header_.clear();
+    header_cursor_ = 0;
+    header_error_ = Error_t::Success;
+    compression_ = Compression_t::None;
+    frame_size_ = 0;
+    frame_cursor_ = 0;
+    Error_t err = src_->next_source();
+    if (err != Error_t::Success) {
+      return err;
+    }
+    header_.resize(header_bytes_);
+    header_error_ = src_->read(header_.data(), header_bytes_);
+    if (header_error_ == Error_t::Success) {
+      DataSetHeader header;
+      const size_t offset = header_bytes_ > sizeof(DataSetHeader) ? sizeof(int) : 0;
+      memcpy(&header, header_.data() + offset, sizeof(DataSetHeader));
+      try {
+        compression_ = compression_from_header(header);
+      } catch (const std::runtime_error&) {
+        // an unknown flag is left to the check of the header by the reader
+        compression_ = Compression_t::None;
+      }
+    }
+    return Error_t::Success;
+  }
+
+  bool is_open() noexcept { return src_->is_open(); }
+
+  bool is_compressed() const { return compression_ != Compression_t::None; }
+
+  const std::shared_ptr<Source>& get_source() const { return src_; }
+};
+
+}  // namespace HugeCTR
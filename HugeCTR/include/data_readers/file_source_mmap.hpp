@@ -0,0 +1,178 @@
+/*
+ * Copyright (c) 2020, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <unistd.h>
+#include <common.hpp>
+#include <algorithm>
+#include <cstring>
+#include <data_readers/file_list.hpp>
+#include <data_readers/source.hpp>
+
+namespace HugeCTR {
+
+/**
+ * @brief A memory mapped source of the Norm data files.
+ *
+ * It goes through the file list in the same way as FileSource, but every file is mapped
+ * as a whole, so that the records can be parsed in place via read_ptr().
+ * The kernel is told that the access is sequential, and the next "readahead_bytes"
+ * are requested ahead of the cursor while the consumed pages are released.
+ */
+class MmapFileSource : public Source {
+ private:
+  FileList file_list_; /**< file list of data set */
+  std::string file_name_;     /**< file name of current file */
+  const long long offset_;
+  const long long stride_;
+  bool repeat_;
+  unsigned int counter_{0};
+  const size_t readahead_bytes_;
+
+  char* mmapped_data_{nullptr};
+  size_t file_size_{0};
+  size_t cursor_{0};
+  size_t next_advise_{0}; /**< cursor_ position to issue the next readahead */
+  size_t released_{0};    /**< the pages before it are released */
+
+  void unmap_() {
+    if (mmapped_data_ != nullptr) {
+      munmap(mmapped_data_, file_size_);
+      mmapped_data_ = nullptr;
+    }
+    file_size_ = 0;
+    cursor_ = 0;
+    next_advise_ = 0;
+    released_ = 0;
+  }
+
+  void advise_() {
+    const size_t page_size = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    size_t begin = cursor_ / page_size * page_size;
+    size_t length = std::min(readahead_bytes_, file_size_ - begin);
+    madvise(mmapped_data_ + begin, length, MADV_WILLNEED);
+    if (begin > released_) {
+      madvise(mmapped_data_ + released_, begin - released_, MADV_DONTNEED);
+      released_ = begin;
+    }
+    next_advise_ = cursor_ + readahead_bytes_ / 2;
+  }
+
+ public:
+  MmapFileSource(long long offset, long long stride, const std::string& file_list, bool repeat,
+                 bool shuffle_files = false, unsigned int seed = 0,
+                 size_t readahead_bytes = 16 * 1024 * 1024)
+      : file_list_(file_list, shuffle_files, seed),
+        offset_(offset),
+        stride_(stride),
+        repeat_(repeat),
+        readahead_bytes_(readahead_bytes) {}
+
+  ~MmapFileSource() { unmap_(); }
+
+  /**
+   * Read "bytes_to_read" byte to the memory associated to ptr.
+   * @param ptr pointer to user located buffer
+   * @param bytes_to_read bytes to read
+   * @return `FileCannotOpen` `OutOfBound` `Success`
+   */
+  Error_t read(char* ptr, size_t bytes_to_read) noexcept {
+    const char* src = nullptr;
+    Error_t err = read_ptr(&src, bytes_to_read);
+    if (err == Error_t::Success) {
+      memcpy(ptr, src, bytes_to_read);
+    }
+    return err;
+  }
+
+  /**
+   * Get the pointer to the next "bytes_to_read" bytes in the mapping and move forward.
+   * @return `FileCannotOpen` `OutOfBound` `Success`
+   */
+  Error_t read_ptr(const char** ptr, size_t bytes_to_read) noexcept {
+    if (mmapped_data_ == nullptr) {
+      return Error_t::FileCannotOpen;
+    }
+    if (bytes_to_read > file_size_ - cursor_) {
+      cursor_ = file_size_;
+      return Error_t::OutOfBound;
+    }
+    *ptr = mmapped_data_ + cursor_;
+    cursor_ += bytes_to_read;
+    if (cursor_ >= next_advise_) {
+      advise_();
+    }
+    return Error_t::Success;
+  }
+
+  bool is_zero_copy() noexcept { return true; }
+
+  /**
+   * Pointer to the unread part of the current file, which is get_remaining_bytes() long.
+   * It allows random access to the rest of the file without moving the cursor.
+   */
+  const char* peek() const noexcept { return mmapped_data_ + cursor_; }
+  size_t get_remaining_bytes() const noexcept { return file_size_ - cursor_; }
+
+  /**
+   * Start a new file to read.
+   * @return `Success`, `EndOfFile`, `FileCannotOpen` or `UnspecificError`
+   */
+  Error_t next_source() noexcept {
+    try {
+      unmap_();
+      std::string file_name = file_list_.get_a_file_with_id(offset_ + counter_ * stride_,
+                                                            repeat_);
+      counter_++;  // counter_ should be accum for every source.
+      if (file_name.empty()) {
+        return Error_t::EndOfFile;
+      }
+      int fd = open(file_name.c_str(), O_RDONLY, 0);
+      if (fd == -1) {
+        CK_RETURN_(Error_t::FileCannotOpen, "open failed: " + file_name);
+      }
+      struct stat st;
+      if (fstat(fd, &st) != 0 || st.st_size == 0) {
+        close(fd);
+        CK_RETURN_(Error_t::FileCannotOpen, "empty or invalid file: " + file_name);
+      }
+      file_size_ = st.st_size;
+      void* mmapped_data = mmap(0, file_size_, PROT_READ, MAP_PRIVATE, fd, 0);
+      // the mapping is still valid after closing the fd
+      close(fd);
+      if (mmapped_data == MAP_FAILED) {
+        file_size_ = 0;
+        CK_RETURN_(Error_t::FileCannotOpen, "mmap failed: " + file_name);
+      }
+      mmapped_data_ = reinterpret_cast<char*>(mmapped_data);
+      madvise(mmapped_data_, file_size_, MADV_SEQUENTIAL);
+      advise_();
+      file_name_ = file_name;
+      return Error_t::Success;
+    } catch (const std::runtime_error& rt_err) {
+      std::cerr << rt_err.what() << std::endl;
+      return Error_t::UnspecificError;
+    }
+  }
+
+  bool is_open() noexcept { return mmapped_data_ != nullptr; }
+};
+
+}  // namespace HugeCTR
@@ -23,8 +23,7 @@
 #include <queue>
 #include <thread>
 #include <vector>
-#include <data_readers/chunk_producer.hpp>
-#include <data_readers/chunk_consumer.hpp>
+#include <data_readers/chunk_heap.hpp>
 
 namespace HugeCTR {
 
@@ -35,12 +34,16 @@ namespace HugeCTR {
  * the sake of high input throughput. The specific chunk in a heap
  * will be locked while it's in use by one of the threads, and will be
  * unlocked when it's checkin.
- * Note that at most 32 chunks are avaliable for a heap.
+ * Each worker owns "num_chunks_per_worker" chunks, so that it can keep parsing
+ * the next batches while the previous ones are being consumed. The chunks of
+ * a worker are delivered in the order they are committed.
+ * Note that at most 32 workers are avaliable for a heap.
  */
 template <typename T>
-class HeapEx : public ChunkConsumer<T>, public ChunkProducer<T> {
+class HeapEx : public ChunkHeap<T> {
  private:
   const int num_threads_;
+  const int num_chunks_per_worker_;
 
   std::vector<T*> chunks_;
   std::vector<std::queue<T*>> ready_queue_;
@@ -73,7 +76,7 @@ class HeapEx : public ChunkConsumer<T>, public ChunkProducer<T> {
   /**
    * After writting, check in the chunk
    */
-  void commit_data_chunk(unsigned int ch_id, bool is_nop) {
+  void commit_data_chunk(unsigned int ch_id, bool is_nop) override {
     std::unique_lock<std::mutex> lock(mtx_[ch_id]);
     ch_id = ch_id % num_threads_;
     // because nop can be inserted anytime, the emptiness must be checked
@@ -143,7 +146,7 @@ class HeapEx : public ChunkConsumer<T>, public ChunkProducer<T> {
   /**
    * Reset all the internal states
    */
-  void reset() {
+  void reset() override {
     for (int id = 0; id < num_threads_; id++) {
       std::unique_lock<std::mutex> lock(mtx_[id]);
       while (!ready_queue_[id].empty()) {
@@ -167,7 +170,7 @@ class HeapEx : public ChunkConsumer<T>, public ChunkProducer<T> {
   /**
    * break the spin lock.
    */
-  void break_and_return() {
+  void break_and_return() override {
     for (int id = 0; id < num_threads_; id++) {
       ready_queue_[id].push(nullptr);
       credits_[id].push(nullptr);
@@ -179,11 +182,14 @@ class HeapEx : public ChunkConsumer<T>, public ChunkProducer<T> {
 
   /**
    * Ctor.
-   * Make "num" copy of the chunks.
+   * Make "num * num_chunks_per_worker" copy of the chunks.
+   * @param num the number of workers (producers).
+   * @param num_chunks_per_worker prefetch depth, i.e., chunks owned by each worker.
    */
   template <typename... Args>
-  HeapEx(int num, Args&&... args)
+  HeapEx(int num, int num_chunks_per_worker, Args&&... args)
       : num_threads_(num),
+        num_chunks_per_worker_(num_chunks_per_worker),
         ready_queue_(num),
         wait_queue_(num),
         credits_(num),
@@ -194,17 +200,21 @@ class HeapEx : public ChunkConsumer<T>, public ChunkProducer<T> {
       CK_THROW_(Error_t::OutOfBound, "num > sizeof(unsigned int) * 8");
     } else if (num <= 0) {
       CK_THROW_(Error_t::WrongInput, "num <= 0");
+    } else if (num_chunks_per_worker <= 0) {
+      CK_THROW_(Error_t::WrongInput, "num_chunks_per_worker <= 0");
     }
 
     for (int i = 0; i < num; i++) {
-      for (int j = 0; j < 1; j++) {
-        chunks_.emplace_back(new T(std::forward<Args>(args)...));
+      for (int j = 0; j < num_chunks_per_worker; j++) {
+        chunks_.emplace_back(new T(args...));
         credits_[i].emplace(chunks_.back());
       }
     }
   }
 
-  int get_size() { return num_threads_; }
+  int get_size() override { return num_threads_; }
+
+  int get_num_chunks_per_worker() const { return num_chunks_per_worker_; }
 
   ~HeapEx() {
     for (size_t i = 0; i < chunks_.size(); i++) {
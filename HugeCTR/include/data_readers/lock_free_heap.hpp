@@ -0,0 +1,248 @@
+/*
+ * Copyright (c) 2020, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+#include <atomic>
+#include <common.hpp>
+#include <data_readers/adaptive_waiter.hpp>
+#include <data_readers/chunk_heap.hpp>
+#include <data_readers/spsc_ring.hpp>
+#include <chrono>
+#include <memory>
+#include <thread>
+#include <vector>
+
+namespace HugeCTR {
+
+/**
+ * @brief A lock-free alternative of HeapEx.
+ *
+ * Every worker is connected to the single consumer (DataCollector) by two SPSC rings:
+ * the ready ring carries committed chunks (or nop markers) from the worker to the consumer,
+ * and the free ring carries the consumed chunks back. Both sides spin briefly and then
+ * park when a ring is empty, so that neither a mutex nor a syscall is on the fast path.
+ * The ordering and the EOF (nop) semantics are the same as HeapEx.
+ * Each ch_id must be used by one producer thread at a time.
+ * reset() touches the private states of the producers, so it requires all of them to be parked,
+ * i.e., to have committed a nop and to wait for a new source before their next checkout.
+ * A worker parks right after its nop is published, so reset() waits briefly for it.
+ */
+template <typename T>
+class LockFreeHeap : public ChunkHeap<T> {
+ private:
+  struct Worker {
+    SpscRing<T*> ready;        /**< worker -> consumer */
+    SpscRing<T*> free;         /**< consumer -> worker */
+    AdaptiveWaiter ready_waiter; /**< the consumer waits for ready */
+    AdaptiveWaiter free_waiter;  /**< the worker waits for free or a room in ready */
+    // producer private states
+    std::vector<T*> checked_out;
+    std::vector<T*> spare; /**< chunks released by nop commits */
+    // set by the worker when it commits a nop, and cleared by its next checkout
+    std::atomic<bool> parked{true};
+
+    Worker(size_t capacity) : ready(capacity), free(capacity) {}
+  };
+
+  static const int PARK_TIMEOUT_MS = 100;
+
+  const int num_threads_;
+  const int num_chunks_per_worker_;
+  std::vector<T*> chunks_;
+  std::vector<std::unique_ptr<Worker>> workers_;
+  std::atomic<bool> stop_{false};
+  int count_{0};
+
+  void push_ready(Worker& w, T* chunk) {
+    w.free_waiter.wait([this, &w, chunk]() { return w.ready.try_push(chunk) || stop_; });
+    w.ready_waiter.notify_all();
+  }
+
+ public:
+  /**
+   * will try to checkout a free chunk of the worker ch_id
+   * if not avaliable just hold
+   */
+  T* checkout_free_chunk(unsigned int ch_id) override {
+    Worker& w = *workers_[ch_id % num_threads_];
+    T* chunk = nullptr;
+    if (!w.spare.empty()) {
+      chunk = w.spare.back();
+      w.spare.pop_back();
+    } else {
+      w.free_waiter.wait([this, &w, &chunk]() { return w.free.try_pop(chunk) || stop_; });
+    }
+    w.parked.store(false, std::memory_order_relaxed);
+    if (chunk != nullptr) {
+      w.checked_out.push_back(chunk);
+    }
+    return chunk;
+  }
+
+  /**
+   * After writting, check in the chunk
+   */
+  void commit_data_chunk(unsigned int ch_id, bool is_nop) override {
+    Worker& w = *workers_[ch_id % num_threads_];
+    // because nop can be inserted anytime, the emptiness must be checked
+    if (!w.checked_out.empty()) {
+      T* cand = w.checked_out.front();
+      w.checked_out.erase(w.checked_out.begin());
+      if (is_nop) {
+        w.spare.push_back(cand);
+        push_ready(w, nullptr);
+      } else {
+        push_ready(w, cand);
+      }
+    } else if (is_nop) {
+      push_ready(w, nullptr);
+    }
+    if (is_nop) {
+      // the private states are not touched again until the next checkout
+      w.parked.store(true, std::memory_order_release);
+    }
+  }
+
+  /**
+   * Checkout the data of the worker count_
+   * if not avaliable hold
+   * return nullptr means EOF data set.
+   */
+  T* checkout_data_chunk() override {
+    for (int i = 0; i < num_threads_; i++) {
+      int id = (count_ + i) % num_threads_;
+      Worker& w = *workers_[id];
+      w.ready_waiter.wait([this, &w]() { return !w.ready.empty() || stop_; });
+      if (w.ready.empty()) {
+        return nullptr;
+      }
+      T* cand = w.ready.front();
+      if (cand != nullptr) {
+        count_ = id;
+        return cand;
+      }
+    }
+    return nullptr;
+  }
+
+  /**
+   * Free the chunk of the worker count_ after using.
+   */
+  void return_free_chunk() override {
+    Worker& w = *workers_[count_];
+    if (w.ready.empty()) {
+      return;
+    }
+    T* chunk = w.ready.front();
+    if (chunk != nullptr) {
+      w.ready.pop();
+      w.free.try_push(chunk);
+      w.free_waiter.notify_all();
+      count_ = (count_ + 1) % num_threads_;
+    } else {
+      for (auto& worker : workers_) {
+        if (!worker->ready.empty() && worker->ready.front() == nullptr) {
+          worker->ready.pop();
+          worker->free_waiter.notify_all();
+        }
+      }
+    }
+  }
+
+  /**
+   * Reset all the internal states.
+   * The workers must be parked, e.g., waiting for a new source after the EOF. A worker which
+   * is still running after PARK_TIMEOUT_MS makes it throw.
+   */
+  void reset() override {
+    for (auto& w : workers_) {
+      // the consumer may see the nop before the worker stores parked
+      auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(PARK_TIMEOUT_MS);
+      while (!w->parked.load(std::memory_order_acquire)) {
+        if (std::chrono::steady_clock::now() > deadline) {
+          CK_THROW_(Error_t::IllegalCall, "LockFreeHeap::reset() while a worker is not parked");
+        }
+        std::this_thread::yield();
+      }
+    }
+    for (auto& w : workers_) {
+      T* chunk = nullptr;
+      while (w->ready.try_pop(chunk)) {
+        if (chunk != nullptr) {
+          w->free.try_push(chunk);
+        }
+      }
+      for (auto cand : w->checked_out) {
+        w->free.try_push(cand);
+      }
+      w->checked_out.clear();
+      w->free_waiter.notify_all();
+    }
+    count_ = 0;
+  }
+
+  /**
+   * break the waiting of both sides.
+   */
+  void break_and_return() override {
+    stop_ = true;
+    for (auto& w : workers_) {
+      w->ready_waiter.notify_all();
+      w->free_waiter.notify_all();
+    }
+  }
+
+  /**
+   * Ctor.
+   * Make "num * num_chunks_per_worker" copy of the chunks.
+   * @param num the number of workers (producers).
+   * @param num_chunks_per_worker prefetch depth, i.e., chunks owned by each worker.
+   */
+  template <typename... Args>
+  LockFreeHeap(int num, int num_chunks_per_worker, Args&&... args)
+      : num_threads_(num), num_chunks_per_worker_(num_chunks_per_worker) {
+    if (num > static_cast<int>(sizeof(unsigned int) * 8)) {
+      CK_THROW_(Error_t::OutOfBound, "num > sizeof(unsigned int) * 8");
+    } else if (num <= 0) {
+      CK_THROW_(Error_t::WrongInput, "num <= 0");
+    } else if (num_chunks_per_worker <= 0) {
+      CK_THROW_(Error_t::WrongInput, "num_chunks_per_worker <= 0");
+    }
+
+    // the ready ring must also hold the nop markers
+    const size_t capacity = num_chunks_per_worker + 2;
+    for (int i = 0; i < num; i++) {
+      workers_.emplace_back(new Worker(capacity));
+      for (int j = 0; j < num_chunks_per_worker; j++) {
+        chunks_.emplace_back(new T(args...));
+        workers_.back()->free.try_push(chunks_.back());
+      }
+    }
+  }
+
+  int get_size() override { return num_threads_; }
+
+  int get_num_chunks_per_worker() const { return num_chunks_per_worker_; }
+
+  ~LockFreeHeap() {
+    for (size_t i = 0; i < chunks_.size(); i++) {
+      T* cand = chunks_[i];
+      delete cand;
+    }
+  }
+};
+
+}  // namespace HugeCTR
@@ -21,9 +21,13 @@
 #include <sys/stat.h>
 #include <sys/types.h>
 #include <unistd.h>
+#include <data_readers/block_codec.hpp>
 #include <algorithm>
 #include <atomic>
 #include <fstream>
+#include <limits>
+#include <memory>
+#include <mutex>
 #include <random>
 #include <vector>
 
@@ -47,24 +51,181 @@ struct MmapOffset {
  * 2.txt
  * 3.txt
  * @endverbatim
+ *
+ * With "shuffle_block_size" > 0, the samples are shuffled in blocks of that many samples
+ * instead of whole batches, and each batch is gathered from its blocks with gather().
+ * The order of the blocks is drawn again every epoch; the mapping is kept as is.
+ *
+ * A compressed file (which starts with RAW_COMPRESSED_MAGIC) is mapped as is, and the batches
+ * are decompressed from its frames with decompress() instead of get_offset().
  */
 class MmapOffsetList {
+ public:
+  /**
+   * The last frame decompressed by a reader, which the next batch likely starts in.
+   */
+  struct FrameCache {
+    long long frame{-1};
+    std::vector<char> data;
+  };
+
  private:
-  const long long length_;
+  long long length_; /**< of the mapping */
   std::vector<MmapOffset> offsets_;
   std::atomic<long long> counter_{0};
   const int num_workers_;
   bool repeat_;
   char* mmapped_data_;
   int fd_;
+  const std::string file_name_;
+
+  // shuffling at the block granularity
+  const long long num_samples_;
+  const long long stride_;
+  const long long batchsize_;
+  const long long block_size_{0}; /**< samples per block, or 0 to shuffle the batches */
+  long long num_batches_{0};
+  long long num_full_blocks_{0};
+  long long tail_size_{0}; /**< samples of the last block which can be partial */
+  unsigned int seed_{0};
+
+  // compressed file
+  struct Frame {
+    const char* data;
+    int compressed_size;
+    long long first_sample;
+    long long num_samples;
+  };
+  Compression_t compression_{Compression_t::None};
+  std::vector<Frame> frames_;
+  std::vector<long long> first_samples_; /**< of the batches, instead of offsets_ */
+
+  /**
+   * Check the header of a compressed file and index its frames.
+   */
+  void index_frames(long long num_samples, long long stride) {
+    DataSetHeader header;
+    memcpy(&header, mmapped_data_ + sizeof(RAW_COMPRESSED_MAGIC), sizeof(header));
+    compression_ = compression_from_header(header);
+    if ((header.label_dim + header.dense_dim + header.slot_num) * sizeof(int) !=
+        static_cast<size_t>(stride)) {
+      CK_THROW_(Error_t::WrongInput, "the sample size of the compressed file doesn't match");
+    }
+    if (header.number_of_records < num_samples) {
+      CK_THROW_(Error_t::WrongInput, "the compressed file has " +
+                                         std::to_string(header.number_of_records) +
+                                         " samples < num_samples");
+    }
+    long long pos = sizeof(RAW_COMPRESSED_MAGIC) + sizeof(header);
+    long long first_sample = 0;
+    while (first_sample < num_samples) {
+      BlockFrameHeader frame;
+      if (pos + static_cast<long long>(sizeof(frame)) > length_) {
+        CK_THROW_(Error_t::BrokenFile, "the compressed file is truncated");
+      }
+      memcpy(&frame, mmapped_data_ + pos, sizeof(frame));
+      pos += sizeof(frame);
+      if (frame.compressed_size < 0 || pos + frame.compressed_size > length_ ||
+          frame.num_records <= 0 ||
+          static_cast<long long>(frame.raw_size) != frame.num_records * stride) {
+        CK_THROW_(Error_t::BrokenFile, "invalid frame at " + std::to_string(pos));
+      }
+      frames_.push_back({mmapped_data_ + pos, frame.compressed_size, first_sample,
+                         frame.num_records});
+      pos += frame.compressed_size;
+      first_sample += frame.num_records;
+    }
+  }
+
+  /**
+   * Order of the blocks in an epoch. The tail block is put at "tail_pos".
+   */
+  struct Permutation {
+    long long epoch{-1};
+    std::vector<unsigned int> blocks;
+    long long tail_pos{0};
+  };
+  std::mutex permutation_mtx_;
+  std::shared_ptr<const Permutation> permutations_[2]; /**< the two latest epochs */
+
+  std::shared_ptr<const Permutation> get_permutation(long long epoch) {
+    std::lock_guard<std::mutex> lock(permutation_mtx_);
+    for (auto& permutation : permutations_) {
+      if (permutation != nullptr && permutation->epoch == epoch) {
+        return permutation;
+      }
+    }
+    // the workers at most a few batches apart share the epochs, so this is rare
+    auto permutation = std::make_shared<Permutation>();
+    permutation->epoch = epoch;
+    permutation->blocks.resize(num_full_blocks_);
+    for (long long b = 0; b < num_full_blocks_; b++) {
+      permutation->blocks[b] = b;
+    }
+    std::mt19937_64 gen(seed_ + epoch);
+    std::shuffle(permutation->blocks.begin(), permutation->blocks.end(), gen);
+    permutation->tail_pos = std::uniform_int_distribution<long long>(0, num_full_blocks_)(gen);
+    int oldest = (permutations_[0] == nullptr ||
+                  (permutations_[1] != nullptr && permutations_[0]->epoch < permutations_[1]->epoch))
+                     ? 0
+                     : 1;
+    permutations_[oldest] = permutation;
+    return permutation;
+  }
+
+  /**
+   * Where the "j"-th sample of an epoch is in the file, with the number of samples after it
+   * in the same block.
+   */
+  long long locate(const Permutation& permutation, long long j, long long* run) const {
+    const long long tail_begin = permutation.tail_pos * block_size_;
+    if (j >= tail_begin && j < tail_begin + tail_size_) {
+      *run = tail_begin + tail_size_ - j;
+      return num_full_blocks_ * block_size_ + (j - tail_begin);
+    }
+    if (j >= tail_begin) {
+      j -= tail_size_;
+    }
+    *run = block_size_ - j % block_size_;
+    return permutation.blocks[j / block_size_] * block_size_ + j % block_size_;
+  }
+
+  /**
+   * Ask the kernel to read the blocks of a batch ahead of the gather.
+   * Only the blocks spanning whole pages are worth a system call.
+   */
+  void will_need(long long pos) {
+    const long long page_size = sysconf(_SC_PAGESIZE);
+    if (block_size_ * stride_ < page_size || (!repeat_ && pos >= num_batches_)) {
+      return;
+    }
+    auto permutation = get_permutation(pos / num_batches_);
+    const long long begin = (pos % num_batches_) * batchsize_;
+    const long long end = std::min(begin + batchsize_, num_samples_);
+    for (long long j = begin; j < end;) {
+      long long run = 0;
+      long long sample = locate(*permutation, j, &run);
+      run = std::min(run, end - j);
+      long long first = sample * stride_ / page_size * page_size;
+      long long last = (sample + run) * stride_;
+      madvise(mmapped_data_ + first, last - first, MADV_WILLNEED);
+      j += run;
+    }
+  }
 
  public:
   // stride: samle size in byte
   MmapOffsetList(std::string file_name, long long num_samples, long long stride,
-                 long long batchsize, bool use_shuffle, int num_workers, bool repeat)
+                 long long batchsize, bool use_shuffle, int num_workers, bool repeat,
+                 long long shuffle_block_size = 0)
       : length_(num_samples * stride),
         num_workers_(num_workers),
-        repeat_(repeat) {
+        repeat_(repeat),
+        file_name_(file_name),
+        num_samples_(num_samples),
+        stride_(stride),
+        batchsize_(batchsize),
+        block_size_(use_shuffle ? shuffle_block_size : 0) {
     try {
       fd_ = open(file_name.c_str(), O_RDONLY, 0);
       if (fd_ == -1) {
@@ -72,6 +233,19 @@ class MmapOffsetList {
         return;
       }
 
+      char magic[sizeof(RAW_COMPRESSED_MAGIC)] = {0};
+      const bool compressed =
+          pread(fd_, magic, sizeof(magic), 0) == sizeof(magic) &&
+          memcmp(magic, RAW_COMPRESSED_MAGIC, sizeof(magic)) == 0;
+      if (compressed) {
+        struct stat st;
+        if (fstat(fd_, &st) != 0) {
+          close(fd_);
+          CK_THROW_(Error_t::BrokenFile, "Error getting the file size");
+        }
+        length_ = st.st_size;
+      }
+
       /* Get the size of the file. */
       mmapped_data_ = (char*)mmap(0, length_, PROT_READ, MAP_PRIVATE, fd_, 0);
       if (mmapped_data_ == MAP_FAILED) {
@@ -80,6 +254,22 @@ class MmapOffsetList {
         return;
       }
 
+      if (compressed) {
+        if (shuffle_block_size > 0) {
+          CK_THROW_(Error_t::WrongInput, "the compressed file can't be shuffled in blocks");
+        }
+        index_frames(num_samples, stride);
+        for (long long sample_idx = 0; sample_idx < num_samples; sample_idx += batchsize) {
+          first_samples_.push_back(sample_idx);
+        }
+        if (use_shuffle) {
+          std::random_device rd;
+          auto rng = std::default_random_engine{rd()};
+          std::shuffle(std::begin(first_samples_), std::end(first_samples_), rng);
+        }
+        return;
+      }
+
       auto offset_gen = [stride](char* mmapped_data, long long idx,
                                  long long samples) -> MmapOffset {
         char* offset = mmapped_data + idx * stride;
@@ -94,8 +284,24 @@ class MmapOffsetList {
           offsets_.emplace_back(offset_gen(mmapped_data_, sample_idx, num_samples - sample_idx));
         }
       }
+      if (block_size_ < 0) {
+        CK_THROW_(Error_t::WrongInput, "shuffle_block_size < 0");
+      }
+      if (block_size_ > 0) {
+        num_batches_ = (num_samples + batchsize - 1) / batchsize;
+        num_full_blocks_ = num_samples / block_size_;
+        tail_size_ = num_samples % block_size_;
+        if (num_full_blocks_ > std::numeric_limits<unsigned int>::max()) {
+          CK_THROW_(Error_t::WrongInput, "too many shuffle blocks");
+        }
+        seed_ = std::random_device()();
+        // the blocks are read out of order, so the kernel read-ahead only helps within a page
+        if (block_size_ * stride >= sysconf(_SC_PAGESIZE)) {
+          madvise(mmapped_data_, length_, MADV_RANDOM);
+        }
+      }
       // shuffle
-      if (use_shuffle) {
+      if (use_shuffle && block_size_ == 0) {
         std::random_device rd;
         auto rng = std::default_random_engine{rd()};
         std::shuffle(std::begin(offsets_), std::end(offsets_), rng);
@@ -113,6 +319,9 @@ class MmapOffsetList {
   }
 
   MmapOffset get_offset(long long round, int worker_id) {
+    if (is_compressed()) {
+      CK_THROW_(Error_t::IllegalCall, "the batches of a compressed file must be decompressed");
+    }
     size_t worker_pos = round * num_workers_ + worker_id;
     if (!repeat_ && worker_pos >= offsets_.size()) {
       throw internal_runtime_error(Error_t::EndOfFile, "EndOfFile");
@@ -127,5 +336,117 @@ class MmapOffsetList {
     }
     return offsets_[counter];
   }
+
+  bool is_gathered() const { return block_size_ > 0; }
+
+  bool is_compressed() const { return compression_ != Compression_t::None; }
+
+  const std::string& get_file_name() const { return file_name_; }
+
+  /**
+   * Where a batch from get_offset() starts in the file.
+   */
+  long long get_file_offset(const MmapOffset& offset) const {
+    return offset.offset - mmapped_data_;
+  }
+
+  long long get_batchsize() const { return batchsize_; }
+
+  long long get_stride() const { return stride_; }
+
+  /**
+   * Copy the samples of a batch of the worker into "buffer", which must hold
+   * batchsize * stride bytes, and hint the kernel about its next batch.
+   * Only valid with shuffle_block_size > 0.
+   * @return the number of samples in the batch
+   */
+  long long gather(long long round, int worker_id, char* buffer) {
+    if (worker_id >= num_workers_) {
+      CK_THROW_(Error_t::WrongInput, "worker_id >= num_workers_");
+    }
+    const long long pos = round * num_workers_ + worker_id;
+    if (!repeat_ && pos >= num_batches_) {
+      throw internal_runtime_error(Error_t::EndOfFile, "EndOfFile");
+    }
+    will_need(pos + num_workers_);
+    auto permutation = get_permutation(pos / num_batches_);
+    const long long begin = (pos % num_batches_) * batchsize_;
+    const long long end = std::min(begin + batchsize_, num_samples_);
+    // the source rows are prefetched a few runs ahead of the copy
+    const int PREFETCH_DISTANCE = 4;
+    const long long PREFETCH_BYTES = 256;
+    long long runs[PREFETCH_DISTANCE][2];  // first sample and length
+    long long j = begin;
+    int num_runs = 0;
+    auto next_run = [&](long long* run) {
+      run[0] = locate(*permutation, j, &run[1]);
+      run[1] = std::min(run[1], end - j);
+      j += run[1];
+      const char* src = mmapped_data_ + run[0] * stride_;
+      for (long long b = 0; b < std::min(run[1] * stride_, PREFETCH_BYTES); b += 64) {
+        __builtin_prefetch(src + b);
+      }
+    };
+    for (; num_runs < PREFETCH_DISTANCE && j < end; num_runs++) {
+      next_run(runs[num_runs]);
+    }
+    for (int r = 0; num_runs > 0; r = (r + 1) % PREFETCH_DISTANCE, num_runs--) {
+      memcpy(buffer, mmapped_data_ + runs[r][0] * stride_, runs[r][1] * stride_);
+      buffer += runs[r][1] * stride_;
+      if (j < end) {
+        next_run(runs[r]);
+        num_runs++;
+      }
+    }
+    return end - begin;
+  }
+
+  /**
+   * Decompress the samples of a batch of the worker into "buffer", which must hold
+   * batchsize * stride bytes. Only valid with is_compressed().
+   * The frames lying in the batch as a whole are decompressed into "buffer" directly,
+   * and the others through "cache".
+   * @return the number of samples in the batch
+   */
+  long long decompress(long long round, int worker_id, char* buffer, FrameCache* cache) {
+    if (worker_id >= num_workers_) {
+      CK_THROW_(Error_t::WrongInput, "worker_id >= num_workers_");
+    }
+    const size_t pos = round * num_workers_ + worker_id;
+    if (!repeat_ && pos >= first_samples_.size()) {
+      throw internal_runtime_error(Error_t::EndOfFile, "EndOfFile");
+    }
+    const long long begin = first_samples_[pos % first_samples_.size()];
+    const long long end = std::min(begin + batchsize_, num_samples_);
+    size_t f = std::upper_bound(frames_.begin(), frames_.end(), begin,
+                                [](long long sample, const Frame& frame) {
+                                  return sample < frame.first_sample;
+                                }) -
+               frames_.begin() - 1;
+    for (long long j = begin; j < end; f++) {
+      const Frame& frame = frames_[f];
+      const long long frame_end = frame.first_sample + frame.num_samples;
+      const size_t raw_size = frame.num_samples * stride_;
+      if (j == frame.first_sample && frame_end <= end) {
+        Error_t err =
+            decompress_block(compression_, frame.data, frame.compressed_size, buffer, raw_size);
+        CK_THROW_(err, "failed to decompress a frame");
+      } else {
+        if (cache->frame != static_cast<long long>(f)) {
+          cache->frame = -1;
+          cache->data.resize(raw_size);
+          Error_t err = decompress_block(compression_, frame.data, frame.compressed_size,
+                                         cache->data.data(), raw_size);
+          CK_THROW_(err, "failed to decompress a frame");
+          cache->frame = f;
+        }
+        memcpy(buffer, cache->data.data() + (j - frame.first_sample) * stride_,
+               (std::min(end, frame_end) - j) * stride_);
+      }
+      buffer += (std::min(end, frame_end) - j) * stride_;
+      j = std::min(end, frame_end);
+    }
+    return end - begin;
+  }
 };
 }  // namespace HugeCTR
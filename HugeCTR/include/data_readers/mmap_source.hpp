@@ -18,18 +18,29 @@
 
 #include <data_readers/mmap_offset_list.hpp>
 #include <data_readers/source.hpp>
+#include <vector>
 
 namespace HugeCTR {
+/**
+ * A batch of samples in the mapped file, or a copy of them if the list shuffles them
+ * at a finer granularity than the batches or the file is compressed.
+ */
 class MmapSource : public Source {
  private:
   std::shared_ptr<MmapOffsetList> mmap_offset_list_;
   MmapOffset offset_;
   int worker_id_;
   long long round_{0};
+  std::vector<char> gather_buffer_; /**< the samples of the batch, if gathered or decompressed */
+  MmapOffsetList::FrameCache frame_cache_;
 
  public:
   MmapSource(std::shared_ptr<MmapOffsetList> mmap_offset_list, int worker_id)
-      : mmap_offset_list_(mmap_offset_list), worker_id_(worker_id) {}
+      : mmap_offset_list_(mmap_offset_list), worker_id_(worker_id) {
+    if (mmap_offset_list_->is_gathered() || mmap_offset_list_->is_compressed()) {
+      gather_buffer_.resize(mmap_offset_list_->get_batchsize() * mmap_offset_list_->get_stride());
+    }
+  }
 
   char* get_ptr() { return offset_.offset; }
 
@@ -38,7 +49,17 @@ class MmapSource : public Source {
 
   Error_t next_source() noexcept {
     try {
-      offset_ = mmap_offset_list_->get_offset(round_, worker_id_);
+      if (mmap_offset_list_->is_compressed()) {
+        offset_.samples = mmap_offset_list_->decompress(round_, worker_id_, gather_buffer_.data(),
+                                                        &frame_cache_);
+        offset_.offset = gather_buffer_.data();
+      } else if (mmap_offset_list_->is_gathered()) {
+        offset_.samples =
+            mmap_offset_list_->gather(round_, worker_id_, gather_buffer_.data());
+        offset_.offset = gather_buffer_.data();
+      } else {
+        offset_ = mmap_offset_list_->get_offset(round_, worker_id_);
+      }
       round_++;
       return Error_t::Success;
     } catch (const internal_runtime_error& rt_err) {
@@ -0,0 +1,122 @@
+/*
+ * Copyright (c) 2020, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <data_readers/async_reader.hpp>
+#include <data_readers/mmap_offset_list.hpp>
+#include <data_readers/source.hpp>
+#include <deque>
+
+namespace HugeCTR {
+
+/**
+ * @brief The batches of MmapOffsetList read with the asynchronous I/O instead of page faults.
+ *
+ * The next "queue_depth" batches of the worker are requested ahead, and get_ptr() points
+ * to the buffer of the current one. The mapping of the list is not touched.
+ */
+class AsyncMmapSource : public Source {
+ private:
+  std::shared_ptr<MmapOffsetList> mmap_offset_list_;
+  int worker_id_;
+  long long round_{0};        /**< the next batch to submit */
+  bool submitted_all_{false}; /**< the EOF is faced in the no-repeat mode */
+  std::deque<long long> samples_; /**< of the submitted batches */
+  const char* current_{nullptr};
+  AsyncReader reader_;
+
+  void submit_batches_() {
+    while (!submitted_all_ && !reader_.full()) {
+      MmapOffset offset;
+      try {
+        offset = mmap_offset_list_->get_offset(round_, worker_id_);
+      } catch (const internal_runtime_error& rt_err) {
+        if (rt_err.get_error() != Error_t::EndOfFile) {
+          throw;
+        }
+        submitted_all_ = true;
+        break;
+      }
+      round_++;
+      reader_.submit(mmap_offset_list_->get_file_offset(offset),
+                     offset.samples * mmap_offset_list_->get_stride());
+      samples_.push_back(offset.samples);
+    }
+  }
+
+ public:
+  AsyncMmapSource(std::shared_ptr<MmapOffsetList> mmap_offset_list, int worker_id,
+                  int queue_depth)
+      : mmap_offset_list_(mmap_offset_list),
+        worker_id_(worker_id),
+        reader_(queue_depth, mmap_offset_list->get_batchsize() * mmap_offset_list->get_stride()) {
+    if (mmap_offset_list_->is_gathered()) {
+      CK_THROW_(Error_t::WrongInput, "the asynchronous I/O can't gather shuffled samples");
+    }
+    if (mmap_offset_list_->is_compressed()) {
+      CK_THROW_(Error_t::WrongInput, "the asynchronous I/O can't read the compressed file");
+    }
+    if (reader_.open(mmap_offset_list_->get_file_name()) != Error_t::Success) {
+      CK_THROW_(Error_t::FileCannotOpen,
+                "failed to open " + mmap_offset_list_->get_file_name());
+    }
+  }
+
+  ~AsyncMmapSource() {
+    const AsyncIoStats& stats = reader_.get_stats();
+    if (stats.bytes_read > 0) {
+      MESSAGE_("Async I/O of worker " + std::to_string(worker_id_) + ": " +
+               std::to_string(stats.bytes_per_sec() / (1 << 20)) + " MB/s, queue depth " +
+               std::to_string(stats.average_depth()) + " on average and " +
+               std::to_string(stats.max_depth) + " at most, waited " +
+               std::to_string(stats.wait_seconds) + " s");
+    }
+  }
+
+  char* get_ptr() { return const_cast<char*>(current_); }
+
+  // no use here
+  bool is_open() noexcept { return true; }
+
+  Error_t next_source() noexcept {
+    try {
+      if (current_ != nullptr) {
+        reader_.pop();
+        samples_.pop_front();
+        current_ = nullptr;
+      }
+      submit_batches_();
+      if (reader_.empty()) {
+        return Error_t::EndOfFile;
+      }
+      size_t valid;
+      current_ = reader_.front(&valid);
+      if (static_cast<long long>(valid) != samples_.front() * mmap_offset_list_->get_stride()) {
+        CK_RETURN_(Error_t::BrokenFile, "the file is shorter than num_samples");
+      }
+      return Error_t::Success;
+    } catch (const std::runtime_error& rt_err) {
+      std::cerr << rt_err.what() << std::endl;
+      return Error_t::UnspecificError;
+    }
+  }
+
+  long long get_num_of_items_in_source() { return current_ != nullptr ? samples_.front() : 0; }
+
+  const AsyncIoStats& get_io_stats() const { return reader_.get_stats(); }
+};
+}  // namespace HugeCTR
@@ -38,6 +38,7 @@
 #pragma GCC diagnostic pop
 #pragma GCC diagnostic pop
 #pragma GCC diagnostic pop
+#include "data_readers/chunk_producer.hpp"
 #include "data_readers/file_list.hpp"
 #include "data_readers/metadata.hpp"
 #include "data_readers/parquet_data_converter.hpp"
@@ -52,7 +53,7 @@ class ParquetDataReaderWorker : public IDataReaderWorker {
   const unsigned int worker_id_{0};
   const unsigned int worker_num_{0};
   size_t buffer_length_;                          /**< buffer size for internal use */
-  std::shared_ptr<HeapEx<CSRChunk<T>>> csr_heap_; /**< heap to cache the data set */
+  std::shared_ptr<ChunkProducer<CSRChunk<T>>> csr_heap_; /**< heap to cache the data set */
   std::vector<DataReaderSparseParam> params_;     /**< configuration of data reader sparse input */
   bool skip_read_{false}; /**< set to true when you want to stop the data reading */
   const int MAX_TRY = 10;
@@ -135,7 +136,7 @@ class ParquetDataReaderWorker : public IDataReaderWorker {
    * Ctor
    */
   ParquetDataReaderWorker(unsigned int worker_id, unsigned int worker_num,
-                          const std::shared_ptr<HeapEx<CSRChunk<T>>>& csr_heap,
+                          const std::shared_ptr<ChunkProducer<CSRChunk<T>>>& csr_heap,
                           const std::string& file_list, size_t buffer_length,
                           const std::vector<DataReaderSparseParam>& params,
                           const std::vector<long long>& slot_offset,
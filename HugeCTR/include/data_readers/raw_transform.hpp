@@ -0,0 +1,41 @@
+/*
+ * Copyright (c) 2020, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <cstddef>
+
+namespace HugeCTR {
+
+/**
+ * out[i] = keys[i] + slot_offset[i] for i in [0, n), which maps the per-slot keys of a Raw
+ * sample into the global key space. AVX2 is used if the CPU supports it.
+ */
+void add_slot_offset(const int* keys, const long long* slot_offset, long long* out, size_t n);
+
+/**
+ * The same for 32-bit keys. Only the lower 32 bits of the slot offsets are needed.
+ */
+void add_slot_offset(const int* keys, const unsigned int* slot_offset, unsigned int* out,
+                     size_t n);
+
+/**
+ * out[i] = log(in[i] + 1.f), the DLRM-style preprocessing of the integer dense features.
+ * The AVX2 version may differ from std::log in the last bit.
+ */
+void log1p_transform(const int* in, float* out, size_t n);
+
+}  // namespace HugeCTR
@@ -33,6 +33,19 @@ class Source {
     return Error_t::Success;
   }
 
+  /**
+   * Get the pointer to the next "bytes_to_read" bytes without copying them.
+   * Only available when is_zero_copy() is true. The memory is valid until next_source().
+   * @param ptr the pointer to the data is written to it
+   * @param bytes_to_read bytes to read
+   * @return `IllegalCall` `FileCannotOpen` `OutOfBound` `Success`
+   */
+  virtual Error_t read_ptr(const char** ptr, size_t bytes_to_read) noexcept {
+    return Error_t::IllegalCall;
+  }
+
+  virtual bool is_zero_copy() noexcept { return false; }
+
   virtual char* get_ptr() {
     CK_THROW_(Error_t::BrokenFile, "Invalid Call");
     return nullptr;
@@ -0,0 +1,93 @@
+/*
+ * Copyright (c) 2020, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <vector>
+
+namespace HugeCTR {
+
+/**
+ * @brief A bounded lock-free single-producer/single-consumer ring.
+ *
+ * Only one thread may call try_push() and only one (other) thread may call
+ * empty(), front(), pop() and try_pop(). The capacity is rounded up to a power of two.
+ */
+template <typename T>
+class SpscRing {
+ private:
+  static constexpr size_t CACHE_LINE_SIZE = 64;
+
+  std::vector<T> buffer_;
+  size_t mask_;
+  char pad0_[CACHE_LINE_SIZE];
+  std::atomic<size_t> head_{0}; /**< next slot to read, written by the consumer */
+  char pad1_[CACHE_LINE_SIZE];
+  std::atomic<size_t> tail_{0}; /**< next slot to write, written by the producer */
+  char pad2_[CACHE_LINE_SIZE];
+
+ public:
+  SpscRing(size_t capacity) {
+    size_t size = 1;
+    while (size < capacity) {
+      size <<= 1;
+    }
+    buffer_.resize(size);
+    mask_ = size - 1;
+  }
+  SpscRing(const SpscRing&) = delete;
+  SpscRing& operator=(const SpscRing&) = delete;
+
+  size_t capacity() const { return mask_ + 1; }
+
+  bool try_push(const T& item) {
+    size_t tail = tail_.load(std::memory_order_relaxed);
+    if (tail - head_.load(std::memory_order_acquire) > mask_) {
+      return false;
+    }
+    buffer_[tail & mask_] = item;
+    tail_.store(tail + 1, std::memory_order_release);
+    return true;
+  }
+
+  bool empty() const {
+    return head_.load(std::memory_order_relaxed) == tail_.load(std::memory_order_acquire);
+  }
+
+  /**
+   * The ring must not be empty.
+   */
+  T& front() { return buffer_[head_.load(std::memory_order_relaxed) & mask_]; }
+
+  /**
+   * The ring must not be empty.
+   */
+  void pop() {
+    head_.store(head_.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+  }
+
+  bool try_pop(T& item) {
+    if (empty()) {
+      return false;
+    }
+    item = front();
+    pop();
+    return true;
+  }
+};
+
+}  // namespace HugeCTR
@@ -39,6 +39,7 @@ class IEmbedding {
   virtual Embedding_t get_embedding_type() const = 0;
   virtual void load_parameters(BufferBag& buf_bag, size_t num) = 0;
   virtual void dump_parameters(BufferBag& buf_bag, size_t* num) const = 0;
+  virtual void dump_dirty_parameters(BufferBag& buf_bag, size_t* num) = 0;
   virtual void reset() = 0;
 
   virtual void dump_opt_states(std::ofstream& stream) = 0;
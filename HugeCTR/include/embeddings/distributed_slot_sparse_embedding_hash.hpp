@@ -82,6 +82,8 @@ class DistributedSlotSparseEmbeddingHash : public Embedding<TypeHashKey, TypeEmb
 
   Tensors2<uint32_t> new_hash_value_flag_tensors_;
   Tensors2<uint32_t> hash_value_flag_sumed_tensors_;
+  Tensors2<char> dirty_flag_tensors_; /**< A flag per row of the hash table value, set by
+                                         update_params() and cleared by dump_dirty_parameters(). */
 
   Tensors2<TypeHashKey> sample_id_tensors_; /**< The temp memory to store the sample ids of hash
                                               table value in      update_params(). */
@@ -143,10 +145,15 @@ class DistributedSlotSparseEmbeddingHash : public Embedding<TypeHashKey, TypeEmb
       std::ofstream &weight_stream, size_t vocabulary_size, size_t embedding_vec_size,
       const Tensors2<float> &hash_table_value_tensors,
       const std::vector<std::shared_ptr<HashTable<TypeHashKey, size_t>>> &hash_tables) const;
+  /**
+   * dump_parameters for the model oversubscriber, to the buffers of keys and embeddings.
+   * @param dirty_flag_tensors if not null, only the rows flagged in them are dumped
+   */
   void dump_parameters(
       Tensor2<TypeHashKey> &keys, Tensor2<float> &embeddings, size_t *num, size_t vocabulary_size,
       size_t embedding_vec_size, const Tensors2<float> &embedding_tensors,
-      const std::vector<std::shared_ptr<HashTable<TypeHashKey, size_t>>> &hash_tables) const;
+      const std::vector<std::shared_ptr<HashTable<TypeHashKey, size_t>>> &hash_tables,
+      const Tensors2<char> *dirty_flag_tensors = nullptr) const;
 
  public:
   /**
@@ -253,6 +260,12 @@ class DistributedSlotSparseEmbeddingHash : public Embedding<TypeHashKey, TypeEmb
           temp_storage_sort_tensors_[id], temp_storage_scan_tensors_[id], wgrad_tensors_[id],
           hash_table_value_tensors_[id], Base::get_local_gpu(id).get_sm_count(),
           Base::get_local_gpu(id).get_stream());
+
+      // the global update changes every row, so all of them are dumped anyway
+      if (Base::get_update_type() != Update_t::Global) {
+        functors_.mark_dirty(*Base::get_nnz_array(true)[id], hash_value_index_tensors_[id].get_ptr(),
+                             dirty_flag_tensors_[id].get_ptr(), Base::get_local_gpu(id).get_stream());
+      }
     }
 
     return;
@@ -281,6 +294,7 @@ class DistributedSlotSparseEmbeddingHash : public Embedding<TypeHashKey, TypeEmb
    */
   void dump_parameters(std::ofstream &weight_stream) const override;
   void dump_parameters(BufferBag& buf_bag, size_t *num) const override;
+  void dump_dirty_parameters(BufferBag& buf_bag, size_t *num) override;
 
   void dump_opt_states(std::ofstream& stream) override;
   void load_opt_states(std::ifstream& stream) override;
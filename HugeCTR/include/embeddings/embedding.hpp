@@ -288,6 +288,16 @@ class Embedding : public IEmbedding {
    */
   virtual void dump_parameters(BufferBag& buf_bag, size_t* num) const = 0;
 
+  /**
+   * Download only the rows updated by update_params() since reset() or the last call, for
+   * the model oversubscriber to write back. The embedding which doesn't track the updates
+   * downloads all the rows.
+   * @param buf_bag the buffer bag for model oversubscriber.
+   */
+  virtual void dump_dirty_parameters(BufferBag& buf_bag, size_t* num) override {
+    dump_parameters(buf_bag, num);
+  }
+
   virtual void dump_opt_states(std::ofstream& stream) = 0;
   virtual void load_opt_states(std::ifstream& stream) = 0;
 
@@ -80,6 +80,8 @@ class LocalizedSlotSparseEmbeddingHash : public Embedding<TypeHashKey, TypeEmbed
 
   Tensors2<uint32_t> new_hash_value_flag_tensors_;
   Tensors2<uint32_t> hash_value_flag_sumed_tensors_;
+  Tensors2<char> dirty_flag_tensors_; /**< A flag per row of the hash table value, set by
+                                         update_params() and cleared by dump_dirty_parameters(). */
 
   Tensors2<uint32_t> hash_value_index_count_counter_tensors_; /**< The temp memory to store the
                                                                 counter of the count of hash table
@@ -214,13 +216,15 @@ class LocalizedSlotSparseEmbeddingHash : public Embedding<TypeHashKey, TypeEmbed
    * @param hash_table_value_tensors the hash table value on multi-GPU.
    * @param hash_table_slot_id_tensors the hash table slot_ids on multi-GPU
    * @param hash_tables the hash tables on multi GPUs
+   * @param dirty_flag_tensors if not null, only the rows flagged in them are dumped
    */
   void dump_parameters(
       Tensor2<TypeHashKey> &keys, Tensor2<size_t> &slot_id, Tensor2<float> &embeddings,
       size_t *num, size_t vocabulary_size, size_t embedding_vec_size,
       const Tensors2<float> &hash_table_value_tensors,
       const Tensors2<size_t> &hash_table_slot_id_tensors,
-      const std::vector<std::shared_ptr<HashTable<TypeHashKey, size_t>>> &hash_tables) const;
+      const std::vector<std::shared_ptr<HashTable<TypeHashKey, size_t>>> &hash_tables,
+      const Tensors2<char> *dirty_flag_tensors = nullptr) const;
 
  public:
   /**
@@ -389,6 +393,12 @@ class LocalizedSlotSparseEmbeddingHash : public Embedding<TypeHashKey, TypeEmbed
           temp_storage_sort_tensors_[id], temp_storage_scan_tensors_[id], wgrad_tensors_[id],
           hash_table_value_tensors_[id], Base::get_local_gpu(id).get_sm_count(),
           Base::get_local_gpu(id).get_stream());
+
+      // the global update changes every row, so all of them are dumped anyway
+      if (Base::get_update_type() != Update_t::Global) {
+        functors_.mark_dirty(*Base::get_nnz_array(true)[id], hash_value_index_tensors_[id].get_ptr(),
+                             dirty_flag_tensors_[id].get_ptr(), Base::get_local_gpu(id).get_stream());
+      }
     }
   }
 
@@ -429,6 +439,7 @@ class LocalizedSlotSparseEmbeddingHash : public Embedding<TypeHashKey, TypeEmbed
    */
   void dump_parameters(std::ofstream &stream) const override;
   void dump_parameters(BufferBag& buf_bag, size_t *num) const override;
+  void dump_dirty_parameters(BufferBag& buf_bag, size_t *num) override;
 
   void dump_opt_states(std::ofstream& stream) override;
   void load_opt_states(std::ifstream& stream) override;
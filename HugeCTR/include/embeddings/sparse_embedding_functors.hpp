@@ -588,6 +588,32 @@ class SparseEmbeddingFunctors {
                       const float *hash_table_value, float *value_retrieved,
                       cudaStream_t stream) const;
 
+  /**
+   * flag the rows of the hash table value updated by update_params()
+   * @param nnz the number of value indexes.
+   * @param value_index the pointer of the value indexes of the updated rows.
+   * @param dirty_flags the pointer of a flag per row of the hash table value.
+   * @param stream cuda stream.
+   */
+  void mark_dirty(size_t nnz, const size_t *value_index, char *dirty_flags,
+                  cudaStream_t stream) const;
+
+  /**
+   * select the keys and value indexes of the flagged rows, in no particular order
+   * @param count the number of keys and value indexes.
+   * @param dirty_flags the pointer of a flag per row of the hash table value.
+   * @param keys the pointer of the keys.
+   * @param value_index the pointer of the value indexes.
+   * @param dirty_keys the pointer of the selected keys.
+   * @param dirty_value_index the pointer of the selected value indexes.
+   * @param num_dirty the pointer of the number of the selected ones on the device.
+   * @param stream cuda stream.
+   */
+  template <typename TypeHashKey>
+  void select_dirty(size_t count, const char *dirty_flags, const TypeHashKey *keys,
+                    const size_t *value_index, TypeHashKey *dirty_keys, size_t *dirty_value_index,
+                    size_t *num_dirty, cudaStream_t stream) const;
+
   template <typename TypeEmbeddingComp>
   void dump_opt_states(std::ofstream& stream, const ResourceManager &resource_manager,
                        std::vector<Tensors2<TypeEmbeddingComp>>& opt_states);
@@ -22,6 +22,9 @@
 #include <network.hpp>
 #include <parser.hpp>
 #include <utils.hpp>
+#include <atomic>
+#include <mutex>
+#include <shared_mutex>
 #include <string>
 #include <thread>
 #include <utility>
@@ -58,12 +61,21 @@ class embedding_cache : public embedding_interface {
                        embedding_cache_workspace& workspace_handler, // The handler to the workspace buffers
                        const std::vector<cudaStream_t>& streams); // The CUDA stream to launch kernel to each emb_cache for each emb_table, size = # of emb_table(cache)
 
-  // Update the embedding cache with missing embeddingcolumns from query API
+  // Update the embedding cache with missing embeddingcolumns from query API, unless the parameter
+  // server changed since they were queried
   virtual void update(embedding_cache_workspace& workspace_handler, 
                       const std::vector<cudaStream_t>& streams);
 
  private:
   static const size_t BLOCK_SIZE_ = 64;
+  // The # of embeddingcolumns refreshed at a time by invalidate_
+  static const size_t REFRESH_BATCH_SIZE_ = 16384;
+
+  // Refresh the emb_vec of the embeddingcolumns of an embedding table which are in its GPU
+  // embedding cache from the parameter server, or of all the cached ones if keys is nullptr
+  void invalidate_(size_t embedding_table_id, const TypeHashKey* keys, size_t length);
+  // Free the stream, the events and the buffers of invalidate_ which were created, if any
+  void free_refresh_resources_();
   
   // The GPU embedding cache type
   using cache_ = gpu_cache::gpu_cache<TypeHashKey, uint64_t, std::numeric_limits<TypeHashKey>::max(), SET_ASSOCIATIVITY, SLAB_SIZE>;
@@ -78,6 +90,28 @@ class embedding_cache : public embedding_interface {
 
   // The cache configuration
   embedding_cache_config cache_config_;
+
+  // The id of the invalidation callback registered to the parameter server
+  size_t invalidation_callback_id_;
+  // Bumped by invalidate_, so that the emb_vec which a look_up read from the parameter server
+  // before are not inserted by its update
+  std::atomic<uint64_t> invalidation_epoch_{0};
+  // Held shared by update() and exclusively to bump invalidation_epoch_
+  std::shared_timed_mutex invalidation_mutex_;
+  // The stream and the buffers of invalidate_, allocated once for the largest embedding_vec_size,
+  // as the parameter server calls it one at a time
+  cudaStream_t refresh_stream_{nullptr};
+  TypeHashKey* d_refresh_keys_{nullptr};
+  TypeHashKey* h_refresh_keys_{nullptr};
+  float* d_refresh_vals_{nullptr};
+  float* h_refresh_vals_{nullptr};
+  size_t* d_dump_counter_{nullptr};
+  size_t* h_dump_counter_{nullptr};
+  // Recorded after the Replace of each embedding table by update(), which chains them across the
+  // streams, so that invalidate_ waits for those issued before on the refresh stream alone
+  std::vector<cudaEvent_t> replace_events_;
+  // Held by update() to wait for and record the replace_events_
+  std::mutex replace_mutex_;
   
 };
 
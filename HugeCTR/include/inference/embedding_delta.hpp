@@ -0,0 +1,70 @@
+/*
+ * Copyright (c) 2020, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+#include <common.hpp>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace HugeCTR {
+
+// The header at the beginning of a delta file
+struct embedding_delta_header {
+  char magic[8];
+  uint32_t version;
+  uint32_t key_size_in_byte;
+  uint64_t embedding_vec_size;
+  uint64_t num_upserts;
+  uint64_t num_deletes;
+};
+
+// The changes of one embedding table between two versions of a model, which the parameter server
+// applies to the table in use instead of loading the new version in full.
+// A delta file is made of the embedding_delta_header, then num_upserts rows
+// <key, embedding_vector> of the keys which were added or changed, then the num_deletes keys
+// which were removed. A key upserted twice keeps its first vector, like in a sparse model file,
+// and a key both upserted and deleted is deleted.
+template <typename TypeHashKey>
+class embedding_delta {
+ public:
+  static const char MAGIC[8];
+  static const uint32_t VERSION = 1;
+
+  // An empty delta, to be filled with upsert() and erase() and written
+  explicit embedding_delta(size_t embedding_vec_size);
+  // Read a delta file of a table of embedding_vec_size, which it checks
+  embedding_delta(const std::string& file_name, size_t embedding_vec_size);
+
+  void upsert(TypeHashKey key, const float* embedding_vector);
+  void erase(TypeHashKey key);
+
+  void write(const std::string& file_name) const;
+
+  size_t get_embedding_vec_size() const { return embedding_vec_size_; }
+  const std::vector<TypeHashKey>& get_upsert_keys() const { return upsert_keys_; }
+  // The vectors of the upserted keys, back to back in the same order
+  const std::vector<float>& get_upsert_vectors() const { return upsert_vectors_; }
+  const std::vector<TypeHashKey>& get_delete_keys() const { return delete_keys_; }
+
+ private:
+  size_t embedding_vec_size_;
+  std::vector<TypeHashKey> upsert_keys_;
+  std::vector<float> upsert_vectors_;
+  std::vector<TypeHashKey> delete_keys_;
+};
+
+}  // namespace HugeCTR
@@ -44,6 +44,7 @@ struct embedding_cache_workspace{
   std::vector<void*> unique_op_obj_; // The unique op object for to de-duplicate queried emb_id to each emb_table, size = # of emb_table
   double* h_hit_rate_; // The hit rate for each emb_table on host, size = # of emb_table
   bool use_gpu_embedding_cache_; // whether to use gpu embedding cache
+  uint64_t invalidation_epoch_; // The invalidation epoch of the embedding cache when look_up began
 };
 
 struct embedding_cache_config{
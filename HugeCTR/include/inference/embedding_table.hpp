@@ -0,0 +1,130 @@
+/*
+ * Copyright (c) 2020, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+#include <common.hpp>
+#include <inference/embedding_delta.hpp>
+#include <model_oversubscriber/flat_hash_table.hpp>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace HugeCTR {
+
+// An embedding table of the parameter server, loaded from a sparse model file of rows
+// <key, (slot_id,) embedding_vector>.
+// The embedding vectors are stored back to back in one page-aligned arena, in the order of the
+// file, and the keys are indexed by their row in a FlatHashTable, so a row costs its vector plus
+// 20 to 40 bytes of index, and a look-up touches the index and one contiguous row.
+// An indexed snapshot (see IndexedSnapshot) is opened in place instead: its value block and its
+// persisted index are mapped read-only, so the table is ready as soon as it is mapped, and only
+// the pages of the keys looked up are read from the file and stay resident.
+// A delta is applied to a table by a new table over it, which indexes only the rows of the keys
+// upserted or deleted since the table was loaded, and falls back to the loaded table for the
+// other keys. The table it is applied to is left as is for the look-ups in flight.
+template <typename TypeHashKey>
+class cpu_embedding_table {
+ public:
+  // Load the table from a sparse model file, in blocks read by several threads, or map it if the
+  // file is an indexed snapshot.
+  // A key repeated in the file keeps its first row. The keys not in the table are looked up as
+  // a vector filled with default_emb_vec_value.
+  cpu_embedding_table(const std::string& file_name, size_t embedding_vec_size, bool has_slot_id,
+                      float default_emb_vec_value = 0.0f);
+  // Apply a delta to a table, which this table shares. The rows of the deltas applied to the
+  // table before are copied, so the cost is that of the rows changed since the table was loaded.
+  cpu_embedding_table(std::shared_ptr<const cpu_embedding_table> table,
+                      const embedding_delta<TypeHashKey>& delta);
+  ~cpu_embedding_table();
+
+  cpu_embedding_table(const cpu_embedding_table&) = delete;
+  cpu_embedding_table& operator=(const cpu_embedding_table&) = delete;
+
+  // The embedding vector of a key, or nullptr if the key is not in the table.
+  // A key deleted by a delta has DELETED_ROW_, which is past the rows like the row of a
+  // corrupted mapped index, so one compare rejects both instead of reading out of the values
+  const float* find(TypeHashKey key) const {
+    const auto* entry = FlatHashTable<TypeHashKey>::find_in_place(index_ctrl_, index_entries_,
+                                                                  index_capacity_, key);
+    if (entry) {
+      return entry->offset() < num_rows_ ? values_ + entry->offset() * embedding_vec_size_
+                                         : nullptr;
+    }
+    return base_ ? base_->find(key) : nullptr;
+  }
+
+  // Copy the embedding vectors of length keys to embedding_vectors, or the default vector for
+  // the keys not in the table. The keys are split into batches, spread over up to num_threads
+  // OpenMP threads; a batch prefetches the index entries of all its keys, then their rows,
+  // before it copies them, so that the cache misses of a batch overlap.
+  void look_up(const TypeHashKey* keys, size_t length, float* embedding_vectors,
+               int num_threads) const;
+
+  size_t size() const { return size_; }
+  size_t get_embedding_vec_size() const { return embedding_vec_size_; }
+
+  // Whether the table is mapped from an indexed snapshot, or applies deltas to one
+  bool is_mapped() const { return base_ ? base_->is_mapped() : mapped_; }
+
+  // Bytes of the arena and the index, or of the mapping of an indexed snapshot, of which only
+  // the pages looked up are resident, and of the table the deltas are applied to
+  size_t memory_usage() const {
+    return mapping_size_in_byte_ + index_.memory_usage() + (base_ ? base_->memory_usage() : 0);
+  }
+
+  // The bytes of memory which the table of a file would take while it is loaded, and 0 if the
+  // file is an indexed snapshot, whose pages can be reclaimed
+  static size_t estimate_memory_usage(const std::string& file_name, size_t embedding_vec_size,
+                                      bool has_slot_id);
+
+ private:
+  static const size_t BLOCK_SIZE_IN_BYTE_ = size_t(64) << 20;
+  static const size_t LOOK_UP_BATCH_SIZE_ = 64;
+  // Fewer keys than that are looked up by the calling thread only
+  static const size_t MIN_KEYS_PER_THREAD_ = 4096;
+  // The row of a key deleted by a delta, which no file has
+  static const size_t DELETED_ROW_ = (size_t(1) << FlatHashTable<TypeHashKey>::OFFSET_BITS) - 1;
+
+  float* allocate_(size_t num_rows);
+  void load_(const std::string& file_name, bool has_slot_id);
+  void map_(const std::string& file_name, bool has_slot_id);
+  void apply_(const cpu_embedding_table& table, const embedding_delta<TypeHashKey>& delta);
+  void prefetch_(TypeHashKey key) const;
+  void look_up_batch_(const TypeHashKey* keys, size_t length, float* embedding_vectors) const;
+
+  size_t embedding_vec_size_;
+  // The arena, or the mapping of the whole indexed snapshot
+  void* mapping_{nullptr};
+  size_t mapping_size_in_byte_{0};
+  // The embedding vectors, embedding_vec_size_ floats per row
+  const float* values_{nullptr};
+  // The rows of values_, which bound the rows of the index
+  size_t num_rows_{0};
+  // <key, <0, row>>, built from the file or the deltas, or empty if the table is mapped
+  FlatHashTable<TypeHashKey> index_;
+  // The control bytes and the entries of index_, or of the index of the indexed snapshot
+  const int8_t* index_ctrl_{nullptr};
+  const typename FlatHashTable<TypeHashKey>::Entry* index_entries_{nullptr};
+  size_t index_capacity_{0};
+  size_t size_{0};
+  bool mapped_{false};
+  // The table loaded or mapped from a file which the deltas are applied to, if any
+  std::shared_ptr<const cpu_embedding_table> base_;
+  // The vector of the keys not in the table
+  std::vector<float> default_vector_;
+};
+
+}  // namespace HugeCTR
@@ -75,6 +75,24 @@ public:
                const float* d_values, 
                cudaStream_t stream);
 
+  // Update API, i.e. Overwrite the values of the keys which are in the cache, e.g. after they
+  // changed in the parameter server. The other keys are not inserted.
+  void Update(const key_type* d_keys, 
+              const size_t len, 
+              const float* d_values, 
+              cudaStream_t stream);
+
+  // Dump API, i.e. Append the keys in the slabsets [start_set_index, end_set_index) of the cache
+  // to d_keys, and add their number to d_dump_counter
+  void Dump(key_type* d_keys, 
+            size_t* d_dump_counter, 
+            const size_t start_set_index, 
+            const size_t end_set_index, 
+            cudaStream_t stream);
+
+  // The number of slabsets, for the Dump API
+  size_t get_capacity_in_set() const { return capacity_in_set_; }
+
 public:
     using slabset = slab_set<set_associativity, key_type, warp_size>;
 #ifdef LIBCUDACXX_VERSION
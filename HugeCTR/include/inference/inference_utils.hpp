@@ -15,6 +15,7 @@
  */
 
 #pragma once
+#include <functional>
 #include <string>
 #include <thread>
 #include <map>
@@ -41,6 +42,12 @@ class HugectrUtility {
   virtual ~HugectrUtility();
   // Should not be called directly, should be called by embedding cache
   virtual void look_up(const TypeHashKey* h_embeddingcolumns, size_t length, float* h_embeddingoutputvector, const std::string& model_name, size_t embedding_table_id) = 0;
+  // Called once the look_up calls return the new embedding vectors of an embedding table of a
+  // model: with the keys which were upserted or deleted, or with nullptr if any may have changed
+  using invalidation_callback = std::function<void(size_t embedding_table_id, const TypeHashKey* keys, size_t length)>;
+  // Should be called by embedding cache, which must unregister before it is destroyed
+  virtual size_t register_invalidation_callback(const std::string& model_name, invalidation_callback callback) = 0;
+  virtual void unregister_invalidation_callback(size_t callback_id) = 0;
   static HugectrUtility<TypeHashKey>* Create_Parameter_Server(INFER_TYPE Infer_type, const std::vector<std::string>& model_config_path, const std::vector<std::string>& model_name);
 };
 
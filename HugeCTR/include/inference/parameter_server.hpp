@@ -26,29 +26,75 @@
 #include <thread>
 #include <utility>
 #include <vector>
-#include <unordered_map>
+#include <memory>
+#include <map>
+#include <mutex>
 #include <inference/inference_utils.hpp>
+#include <inference/embedding_table.hpp>
+#include <inference/versioned_ptr.hpp>
 
 namespace HugeCTR {
 
 class parameter_server_base {
 public:
   virtual ~parameter_server_base() = 0;
+  // Load a new version of the embedding tables of a model from its sparse model files, in the
+  // background, and switch the look-ups to it once it is loaded
+  virtual void update_model(const std::string& model_name, const std::vector<std::string>& sparse_model_files) = 0;
+  // Wait for the update in flight, if any, and rethrow its error
+  virtual void wait_for_update() = 0;
+  // Apply a delta file to an embedding table of a model in use, and refresh the embedding
+  // caches of the model
+  virtual void apply_delta(const std::string& model_name, size_t embedding_table_id, const std::string& delta_file) = 0;
 };
 
 template <typename TypeHashKey>
 class parameter_server : public parameter_server_base, public HugectrUtility<TypeHashKey> {
  public:
-  parameter_server(const std::string& framework_name, const std::vector<std::string>& model_config_path, const std::vector<std::string>& model_name);
+  // An update may take up to update_memory_budget_in_byte of memory to load a new version of a
+  // model next to the one in use, or any amount if it is 0
+  parameter_server(const std::string& framework_name, const std::vector<std::string>& model_config_path, const std::vector<std::string>& model_name, size_t update_memory_budget_in_byte = 0);
   virtual ~parameter_server();
   // Should not be called directly, should be called by embedding cache
   virtual void look_up(const TypeHashKey* h_embeddingcolumns, size_t length, float* h_embeddingoutputvector, const std::string& model_name, size_t embedding_table_id);
+  // One version is loaded at a time: an update waits for the one in flight. The look_up calls
+  // which began before the switch finish with the old version, which is then freed by the
+  // update thread.
+  virtual void update_model(const std::string& model_name, const std::vector<std::string>& sparse_model_files);
+  virtual void wait_for_update();
+  // Like update_model, but in the calling thread, since it costs only the rows changed: the new
+  // version of the model shares its tables with the current one, except the table which the
+  // delta is applied over. Once it is in use, the embedding caches refresh the keys of the
+  // delta. An update in flight is waited for first.
+  virtual void apply_delta(const std::string& model_name, size_t embedding_table_id, const std::string& delta_file);
+  // The callbacks are called in the thread which updates the model, one at a time
+  virtual size_t register_invalidation_callback(const std::string& model_name, typename HugectrUtility<TypeHashKey>::invalidation_callback callback);
+  virtual void unregister_invalidation_callback(size_t callback_id);
 
  private:
+  using embedding_tables = std::vector<std::shared_ptr<const cpu_embedding_table<TypeHashKey>>>;
+
+  size_t get_model_id_(const std::string& model_name) const;
+  std::unique_ptr<embedding_tables> load_embedding_tables_(size_t model_id, const std::vector<std::string>& sparse_model_files) const;
+  void invalidate_(size_t model_id, size_t embedding_table_id, const TypeHashKey* keys, size_t length);
+  // wait_for_update() with update_mutex_ held
+  void wait_for_update_();
+
   // The framework name
   std::string framework_name_;
-  // Currently, embedding tables are implemented as CPU hashtable, 1 hashtable per embedding table per model
-  std::vector<std::vector<std::unordered_map<TypeHashKey, std::vector<float>>>> cpu_embedding_table_;
+  // The embedding tables are kept in CPU memory, 1 table per embedding table per model, in the
+  // version which the look-ups use
+  std::vector<std::unique_ptr<versioned_ptr<embedding_tables>>> cpu_embedding_table_;
+  size_t update_memory_budget_in_byte_;
+  // Held by the callers which wait for the update in flight and start or apply the next one, so
+  // that they neither join update_thread_ twice nor replace it while it is joinable
+  std::mutex update_mutex_;
+  std::thread update_thread_;
+  std::exception_ptr update_error_;
+  // <callback_id, <model_id, callback>>
+  std::map<size_t, std::pair<size_t, typename HugectrUtility<TypeHashKey>::invalidation_callback>> invalidation_callbacks_;
+  size_t next_callback_id_{0};
+  std::mutex callback_mutex_;
   // The parameter server configuration
   parameter_server_config ps_config_;
 };
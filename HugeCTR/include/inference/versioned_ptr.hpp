@@ -0,0 +1,98 @@
+/*
+ * Copyright (c) 2020, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+namespace HugeCTR {
+
+// The current version of an object, which readers use without a lock while a writer replaces it
+// (read-copy-update with epochs).
+// A reader is counted in the current epoch, then loads the version, which it may use until it
+// leaves. The writer publishes the new version, moves to the next epoch, and waits for the
+// readers counted in the previous one, the only ones which may still use the old version, before
+// it hands the old version back. The readers which start after the switch use the new version
+// and never wait for the writer.
+template <typename T>
+class versioned_ptr {
+  // The readers of the even and the odd epochs, on separate cache lines. The padding is not an
+  // alignas(64), which operator new does not honour before C++17.
+  struct reader_count {
+    std::atomic<size_t> count{0};
+    char padding[64 - sizeof(std::atomic<size_t>)];
+  };
+
+  std::atomic<T*> version_;
+  std::atomic<uint64_t> epoch_{0};
+  mutable reader_count readers_[2];
+  std::mutex update_mutex_;
+
+  std::atomic<size_t>& enter_() const {
+    for (;;) {
+      const uint64_t epoch = epoch_.load();
+      std::atomic<size_t>& count = readers_[epoch & 1].count;
+      count.fetch_add(1);
+      // a reader which was counted after the epoch moved on would not be waited for
+      if (epoch_.load() == epoch) {
+        return count;
+      }
+      count.fetch_sub(1);
+    }
+  }
+
+ public:
+  // The version in use from the construction of the guard to its destruction.
+  // A thread must not update() the versioned_ptr while it holds a guard of it.
+  class read_guard {
+    std::atomic<size_t>& count_;
+    const T* version_;
+
+   public:
+    explicit read_guard(const versioned_ptr& ptr)
+        : count_(ptr.enter_()), version_(ptr.version_.load()) {}
+    ~read_guard() { count_.fetch_sub(1); }
+    read_guard(const read_guard&) = delete;
+    read_guard& operator=(const read_guard&) = delete;
+
+    const T* get() const { return version_; }
+    const T& operator*() const { return *version_; }
+    const T* operator->() const { return version_; }
+  };
+
+  explicit versioned_ptr(std::unique_ptr<T> version) : version_(version.release()) {}
+  ~versioned_ptr() { delete version_.load(); }
+  versioned_ptr(const versioned_ptr&) = delete;
+  versioned_ptr& operator=(const versioned_ptr&) = delete;
+
+  // Switch the readers to a new version, and return the old one once no reader uses it, so that
+  // the caller decides where it is destroyed
+  std::unique_ptr<T> update(std::unique_ptr<T> version) {
+    std::lock_guard<std::mutex> lock(update_mutex_);
+    std::unique_ptr<T> old_version(version_.exchange(version.release()));
+    const uint64_t epoch = epoch_.load();
+    epoch_.store(epoch + 1);
+    while (readers_[epoch & 1].count.load() != 0) {
+      std::this_thread::yield();
+    }
+    return old_version;
+  }
+};
+
+}  // namespace HugeCTR
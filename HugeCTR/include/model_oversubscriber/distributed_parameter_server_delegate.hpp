@@ -24,17 +24,17 @@ class DistributedParameterServerDelegate : public ParameterServerDelegate<KeyTyp
  public:
   using HashTable = typename ParameterServerDelegate<KeyType>::HashTable;
 
-  void load_from_snapshot(std::ofstream& embeding_table,
-                          std::ifstream& snapshot,
-                          const size_t file_size_in_byte,
+  void load_from_snapshot(const std::string& embedding_table_path,
+                          const std::string& snapshot_path,
                           const size_t embedding_vector_size,
+                          const StoragePrecision_t storage_precision,
                           HashTable& hash_table) override;
 
-  void store_to_snapshot(std::ofstream& snapshot,
-                         std::ifstream& embedding_table,
-                         const size_t file_size_in_byte,
+  void store_to_snapshot(const std::string& snapshot_path,
+                         const std::string& embedding_table_path,
                          const size_t embedding_vector_size,
-                         HashTable& hash_table) override;
+                         const StoragePrecision_t storage_precision,
+                         const HashTable& hash_table) override;
 };
 
 }  // namespace HugeCTR
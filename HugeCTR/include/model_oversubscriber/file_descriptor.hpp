@@ -0,0 +1,85 @@
+/*
+ * Copyright (c) 2020, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <common.hpp>
+
+#include <string>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+
+namespace HugeCTR {
+
+/**
+ * @brief A file descriptor closed when it goes out of scope, with the positional reads and
+ * writes of whole buffers.
+ */
+class FileDescriptor {
+  int fd_;
+
+ public:
+  FileDescriptor(const std::string& path, int flags) : fd_(open(path.c_str(), flags, 0644)) {
+    if (fd_ == -1) {
+      CK_THROW_(Error_t::FileCannotOpen, "Cannot open the file: " + path);
+    }
+  }
+  FileDescriptor(const FileDescriptor&) = delete;
+  FileDescriptor& operator=(const FileDescriptor&) = delete;
+  ~FileDescriptor() { close(fd_); }
+
+  int get() const { return fd_; }
+
+  size_t size() const {
+    struct stat st;
+    if (fstat(fd_, &st) != 0) {
+      CK_THROW_(Error_t::BrokenFile, "Cannot get the size of a file");
+    }
+    return st.st_size;
+  }
+
+  void resize(size_t size_in_byte) const {
+    if (ftruncate(fd_, size_in_byte) != 0) {
+      CK_THROW_(Error_t::BrokenFile, "Cannot resize a file to " + std::to_string(size_in_byte));
+    }
+  }
+
+  void pread_full(char* buf, size_t size_in_byte, size_t offset) const {
+    for (size_t done = 0; done < size_in_byte;) {
+      const ssize_t ret = pread(fd_, buf + done, size_in_byte - done, offset + done);
+      if (ret <= 0) {
+        CK_THROW_(Error_t::BrokenFile, "Cannot read " + std::to_string(size_in_byte) +
+                                           " bytes at " + std::to_string(offset));
+      }
+      done += ret;
+    }
+  }
+
+  void pwrite_full(const char* buf, size_t size_in_byte, size_t offset) const {
+    for (size_t done = 0; done < size_in_byte;) {
+      const ssize_t ret = pwrite(fd_, buf + done, size_in_byte - done, offset + done);
+      if (ret <= 0) {
+        CK_THROW_(Error_t::BrokenFile, "Cannot write " + std::to_string(size_in_byte) +
+                                           " bytes at " + std::to_string(offset));
+      }
+      done += ret;
+    }
+  }
+};
+
+}  // namespace HugeCTR
@@ -0,0 +1,408 @@
+/*
+ * Copyright (c) 2020, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <common.hpp>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <string>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+namespace HugeCTR {
+
+/**
+ * @brief An open-addressing hash table from the keys to their <slot_id, offset> in the
+ * embedding file of ParameterServer.
+ *
+ * The entries are kept in one flat array, 16 bytes each, with the offset in the lower 40 bits
+ * of the value and the slot_id in the upper 24. Next to it, a control byte per entry is either
+ * EMPTY or 7 bits of the hash of its key. A lookup reads the control bytes of a group of
+ * 16 entries at once (with SSE2 where available) and compares only the keys whose control byte
+ * matches, so it usually touches one cache line of each array.
+ * The groups are probed quadratically, and the table is doubled at 7/8 of its capacity.
+ * An erased entry is marked DELETED, so that the probing goes on past it, unless its group has an
+ * EMPTY entry, which no key was ever probed past. The DELETED entries are reused by insert() and
+ * dropped by the rehash.
+ */
+template <typename KeyType>
+class FlatHashTable {
+ public:
+  static const int OFFSET_BITS = 40;
+  static const int SLOT_ID_BITS = 24;
+
+  struct Entry {
+    KeyType key;
+    uint64_t value;
+
+    size_t slot_id() const { return value >> OFFSET_BITS; }
+    size_t offset() const { return value & ((uint64_t(1) << OFFSET_BITS) - 1); }
+  };
+
+ private:
+  static const size_t GROUP_SIZE = 16;
+  static const int8_t EMPTY = -128;
+  static const int8_t DELETED = -2;
+
+  std::unique_ptr<int8_t[]> ctrl_;
+  std::unique_ptr<Entry[]> entries_;
+  size_t capacity_{0}; /**< a power of 2 which is a multiple of GROUP_SIZE, or 0 */
+  size_t size_{0};
+  size_t num_deleted_{0};
+
+  static uint64_t hash(KeyType key) {
+    uint64_t h = static_cast<uint64_t>(key);
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53ULL;
+    h ^= h >> 33;
+    return h;
+  }
+
+  static int8_t h2(uint64_t h) { return static_cast<int8_t>(h & 0x7f); }
+
+  static size_t first_group(uint64_t h, size_t capacity) {
+    return (h >> 7) & (capacity / GROUP_SIZE - 1);
+  }
+
+  /**
+   * Bit i of the mask is set if the control byte i of the group equals "value".
+   */
+  static uint32_t match(const int8_t* group, int8_t value) {
+#ifdef __SSE2__
+    __m128i ctrl = _mm_loadu_si128(reinterpret_cast<const __m128i*>(group));
+    return _mm_movemask_epi8(_mm_cmpeq_epi8(ctrl, _mm_set1_epi8(value)));
+#else
+    uint32_t mask = 0;
+    for (size_t i = 0; i < GROUP_SIZE; i++) {
+      mask |= static_cast<uint32_t>(group[i] == value) << i;
+    }
+    return mask;
+#endif
+  }
+
+  static uint64_t pack(size_t slot_id, size_t offset) {
+    if (slot_id >> SLOT_ID_BITS || offset >> OFFSET_BITS) {
+      CK_THROW_(Error_t::OutOfBound, "slot_id or offset is too large for FlatHashTable: " +
+                                         std::to_string(slot_id) + ", " + std::to_string(offset));
+    }
+    return (static_cast<uint64_t>(slot_id) << OFFSET_BITS) | offset;
+  }
+
+  /**
+   * Put a key which is not in the table, assuming a free entry.
+   */
+  Entry* emplace_new(KeyType key, uint64_t h) {
+    const size_t num_groups = capacity_ / GROUP_SIZE;
+    for (size_t g = first_group(h, capacity_), step = 1;; g = (g + step++) & (num_groups - 1)) {
+      const uint32_t empty = match(ctrl_.get() + g * GROUP_SIZE, EMPTY);
+      if (empty) {
+        const size_t pos = g * GROUP_SIZE + __builtin_ctz(empty);
+        ctrl_[pos] = h2(h);
+        entries_[pos].key = key;
+        size_++;
+        return &entries_[pos];
+      }
+    }
+  }
+
+  void rehash(size_t capacity) {
+    std::unique_ptr<int8_t[]> old_ctrl(std::move(ctrl_));
+    std::unique_ptr<Entry[]> old_entries(std::move(entries_));
+    const size_t old_capacity = capacity_;
+    ctrl_.reset(new int8_t[capacity]);
+    entries_.reset(new Entry[capacity]);
+    memset(ctrl_.get(), EMPTY, capacity);
+    capacity_ = capacity;
+    size_ = 0;
+    num_deleted_ = 0;
+    for (size_t pos = 0; pos < old_capacity; pos++) {
+      if (old_ctrl[pos] >= 0) {
+        const Entry& entry = old_entries[pos];
+        emplace_new(entry.key, hash(entry.key))->value = entry.value;
+      }
+    }
+  }
+
+  static size_t capacity_for(size_t size) {
+    size_t capacity = GROUP_SIZE;
+    while (capacity / 8 * 7 < size) {
+      capacity *= 2;
+    }
+    return capacity;
+  }
+
+ public:
+  FlatHashTable() = default;
+  FlatHashTable(const FlatHashTable&) = delete;
+  FlatHashTable& operator=(const FlatHashTable&) = delete;
+
+  size_t size() const { return size_; }
+
+  size_t capacity() const { return capacity_; }
+
+  /**
+   * Bytes of the entries and the control bytes.
+   */
+  size_t memory_usage() const { return capacity_ * (sizeof(Entry) + 1); }
+
+  /**
+   * memory_usage() of a table which was reserved for "size" keys.
+   */
+  static size_t memory_usage_for(size_t size) { return capacity_for(size) * (sizeof(Entry) + 1); }
+
+  /**
+   * The control bytes and the entries, capacity() of each, to persist the table.
+   */
+  const int8_t* get_ctrl() const { return ctrl_.get(); }
+  const Entry* get_entries() const { return entries_.get(); }
+
+  /**
+   * Whether a persisted table of that capacity can be loaded or looked up in place.
+   */
+  static bool is_valid_capacity(size_t capacity) {
+    return capacity % GROUP_SIZE == 0 && (capacity & (capacity - 1)) == 0;
+  }
+
+  /**
+   * Replace the table with a copy of one persisted from get_ctrl() and get_entries(), which
+   * had the same KeyType, so that it is not rebuilt key by key.
+   */
+  void load(const int8_t* ctrl, const Entry* entries, size_t capacity) {
+    if (!is_valid_capacity(capacity)) {
+      CK_THROW_(Error_t::WrongInput, "Invalid capacity of a hash table: " +
+                                         std::to_string(capacity));
+    }
+    ctrl_.reset(new int8_t[capacity]);
+    entries_.reset(new Entry[capacity]);
+    memcpy(ctrl_.get(), ctrl, capacity);
+    memcpy(entries_.get(), entries, capacity * sizeof(Entry));
+    capacity_ = capacity;
+    size_ = 0;
+    num_deleted_ = 0;
+    for (size_t pos = 0; pos < capacity_; pos++) {
+      if (ctrl_[pos] >= 0) {
+        size_++;
+      } else if (ctrl_[pos] == DELETED) {
+        num_deleted_++;
+      }
+    }
+  }
+
+  /**
+   * Make room for "size" keys in total without growing.
+   */
+  void reserve(size_t size) {
+    if (capacity_for(size) > capacity_) {
+      rehash(capacity_for(size));
+    }
+  }
+
+  void clear() {
+    if (capacity_ > 0) {
+      memset(ctrl_.get(), EMPTY, capacity_);
+    }
+    size_ = 0;
+    num_deleted_ = 0;
+  }
+
+  /**
+   * @return the entry of the key, or nullptr if it is not in the table.
+   */
+  const Entry* find(KeyType key) const {
+    if (size_ == 0) {
+      return nullptr;
+    }
+    return find_in_place(ctrl_.get(), entries_.get(), capacity_, key);
+  }
+
+  /**
+   * Fetch the first group of the key into the cache, ahead of find().
+   */
+  void prefetch(KeyType key) const {
+    prefetch_in_place(ctrl_.get(), entries_.get(), capacity_, key);
+  }
+
+  /**
+   * find() in a table persisted from get_ctrl() and get_entries(), without loading it, e.g. in
+   * a mapping of the file it was persisted to.
+   */
+  static const Entry* find_in_place(const int8_t* ctrl, const Entry* entries, size_t capacity,
+                                    KeyType key) {
+    if (capacity == 0) {
+      return nullptr;
+    }
+    const uint64_t h = hash(key);
+    const size_t num_groups = capacity / GROUP_SIZE;
+    for (size_t g = first_group(h, capacity), step = 1;; g = (g + step++) & (num_groups - 1)) {
+      const int8_t* group = ctrl + g * GROUP_SIZE;
+      for (uint32_t candidates = match(group, h2(h)); candidates; candidates &= candidates - 1) {
+        const Entry& entry = entries[g * GROUP_SIZE + __builtin_ctz(candidates)];
+        if (entry.key == key) {
+          return &entry;
+        }
+      }
+      if (match(group, EMPTY)) {
+        return nullptr;
+      }
+    }
+  }
+
+  /**
+   * prefetch() in a persisted table, ahead of find_in_place().
+   */
+  static void prefetch_in_place(const int8_t* ctrl, const Entry* entries, size_t capacity,
+                                KeyType key) {
+    if (capacity > 0) {
+      const size_t g = first_group(hash(key), capacity);
+      __builtin_prefetch(ctrl + g * GROUP_SIZE);
+      __builtin_prefetch(entries + g * GROUP_SIZE);
+    }
+  }
+
+  /**
+   * Insert the key if it is not in the table yet.
+   * @return false if the key was in the table, which is left as is.
+   */
+  bool insert(KeyType key, size_t slot_id, size_t offset) {
+    const uint64_t value = pack(slot_id, offset);
+    if (size_ + num_deleted_ + 1 > capacity_ / 8 * 7) {
+      // the DELETED entries are dropped, and the table is doubled if that is not enough
+      const size_t capacity = capacity_for(size_ + 1);
+      rehash(capacity > capacity_ || size_ + 1 > capacity_ / 2 ? std::max(capacity, capacity_ * 2)
+                                                              : capacity_);
+    }
+    // a key is never probed past a group with an empty entry
+    const uint64_t h = hash(key);
+    const size_t num_groups = capacity_ / GROUP_SIZE;
+    size_t free_pos = capacity_;
+    for (size_t g = first_group(h, capacity_), step = 1;; g = (g + step++) & (num_groups - 1)) {
+      int8_t* group = ctrl_.get() + g * GROUP_SIZE;
+      for (uint32_t candidates = match(group, h2(h)); candidates; candidates &= candidates - 1) {
+        if (entries_[g * GROUP_SIZE + __builtin_ctz(candidates)].key == key) {
+          return false;
+        }
+      }
+      const uint32_t deleted = match(group, DELETED);
+      if (deleted && free_pos == capacity_) {
+        free_pos = g * GROUP_SIZE + __builtin_ctz(deleted);
+      }
+      const uint32_t empty = match(group, EMPTY);
+      if (empty) {
+        if (free_pos == capacity_) {
+          free_pos = g * GROUP_SIZE + __builtin_ctz(empty);
+        } else {
+          num_deleted_--;
+        }
+        ctrl_[free_pos] = h2(h);
+        entries_[free_pos].key = key;
+        entries_[free_pos].value = value;
+        size_++;
+        return true;
+      }
+    }
+  }
+
+  /**
+   * Make room for "num_keys" calls of insert_distinct(), dropping the DELETED entries if needed.
+   */
+  void reserve_distinct(size_t num_keys) {
+    if (size_ + num_deleted_ + num_keys > capacity_ / 8 * 7) {
+      rehash(std::max(capacity_, capacity_for(size_ + num_keys)));
+    }
+  }
+
+  /**
+   * Insert a key which is not in the table, concurrently with other insert_distinct() of keys
+   * which are distinct from it, after reserve_distinct() made room for all of them. No other
+   * method may be called in the meantime.
+   * A free entry is claimed by a CAS on its control byte, which only goes from EMPTY to the hash
+   * once, so a thread which lost it moves on to the next EMPTY one.
+   */
+  void insert_distinct(KeyType key, size_t slot_id, size_t offset) {
+    const uint64_t value = pack(slot_id, offset);
+    const uint64_t h = hash(key);
+    const size_t num_groups = capacity_ / GROUP_SIZE;
+    for (size_t g = first_group(h, capacity_), step = 1;; g = (g + step++) & (num_groups - 1)) {
+      int8_t* group = ctrl_.get() + g * GROUP_SIZE;
+      for (uint32_t empty = match(group, EMPTY); empty; empty &= empty - 1) {
+        const size_t pos = g * GROUP_SIZE + __builtin_ctz(empty);
+        int8_t expected = EMPTY;
+        if (__atomic_compare_exchange_n(&ctrl_[pos], &expected, h2(h), false, __ATOMIC_RELAXED,
+                                        __ATOMIC_RELAXED)) {
+          entries_[pos].key = key;
+          entries_[pos].value = value;
+          __atomic_fetch_add(&size_, 1, __ATOMIC_RELAXED);
+          return;
+        }
+      }
+    }
+  }
+
+  /**
+   * Set the value of a key in the table.
+   * @return false if the key is not in the table.
+   */
+  bool assign(KeyType key, size_t slot_id, size_t offset) {
+    Entry* entry = const_cast<Entry*>(find(key));
+    if (entry == nullptr) {
+      return false;
+    }
+    entry->value = pack(slot_id, offset);
+    return true;
+  }
+
+  /**
+   * Erase the key if it is in the table.
+   * @return false if the key is not in the table.
+   */
+  bool erase(KeyType key) {
+    const Entry* entry = find(key);
+    if (entry == nullptr) {
+      return false;
+    }
+    const size_t pos = entry - entries_.get();
+    const int8_t* group = ctrl_.get() + pos / GROUP_SIZE * GROUP_SIZE;
+    if (match(group, EMPTY)) {
+      ctrl_[pos] = EMPTY;
+    } else {
+      ctrl_[pos] = DELETED;
+      num_deleted_++;
+    }
+    size_--;
+    return true;
+  }
+
+  /**
+   * Call "func" with every entry, in no particular order.
+   */
+  template <typename Func>
+  void for_each(Func func) const {
+    for (size_t pos = 0; pos < capacity_; pos++) {
+      if (ctrl_[pos] >= 0) {
+        func(entries_[pos]);
+      }
+    }
+  }
+};
+
+}  // namespace HugeCTR
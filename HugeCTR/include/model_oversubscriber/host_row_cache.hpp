@@ -0,0 +1,152 @@
+/*
+ * Copyright (c) 2020, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <common.hpp>
+#include <model_oversubscriber/flat_hash_table.hpp>
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+namespace HugeCTR {
+
+/**
+ * @brief A bounded host memory tier of the embedding vectors of ParameterServer, in front of its
+ * embedding file, so the hot rows of consecutive keysets are copied from DRAM instead of being
+ * paged in from the SSD again.
+ *
+ * The cache holds "capacity" rows, indexed by their offset in the embedding file. The rows of
+ * one load are acquired one by one and stay pinned until end_batch(), so that a row acquired
+ * earlier in a batch is never evicted by a later one. Once all the rows are pinned, acquire()
+ * bypasses the cache. The slots are evicted by the policy:
+ * - LRU: the least recently acquired one.
+ * - LFU: the least frequently acquired one, the least recently acquired of them.
+ * - CLOCK: the first one without the reference bit set since the last sweep of the hand.
+ *
+ * acquire() and end_batch() are not thread-safe, while the rows of distinct slots can be
+ * copied and update() can be called concurrently.
+ */
+class HostRowCache {
+ public:
+  static const uint32_t NO_SLOT = UINT32_MAX;
+
+ private:
+  const size_t capacity_;
+  const size_t embedding_vec_size_;
+  const CachePolicy_t policy_;
+
+  std::vector<float> rows_;           /**< capacity_ x embedding_vec_size_ */
+  std::vector<size_t> slot_row_;      /**< the offset of the row of each slot in use */
+  FlatHashTable<long long> row_slot_; /**< the offset of each row in use to its slot */
+  size_t size_{0};                    /**< the slots [0, size_) are in use */
+  std::vector<uint8_t> pinned_;
+  std::vector<uint32_t> pinned_slots_;
+
+  // LRU: a doubly linked list from the most recently acquired slot
+  std::vector<uint32_t> prev_;
+  std::vector<uint32_t> next_;
+  uint32_t head_{NO_SLOT};
+  uint32_t tail_{NO_SLOT};
+
+  // LFU: a min-heap of the slots not pinned, by <frequency, tick>
+  std::vector<uint32_t> heap_;
+  std::vector<uint32_t> heap_pos_;
+  std::vector<uint64_t> frequency_;
+  std::vector<uint64_t> tick_;
+  uint64_t now_{0};
+
+  // CLOCK
+  std::vector<uint8_t> referenced_;
+  size_t hand_{0};
+
+  size_t hits_{0};
+  size_t misses_{0};
+  size_t evictions_{0};
+  size_t bypasses_{0};
+
+  void touch_(uint32_t slot);
+  uint32_t evict_();
+
+  void lru_unlink_(uint32_t slot);
+  void lru_push_front_(uint32_t slot);
+
+  bool heap_less_(uint32_t a, uint32_t b) const {
+    return frequency_[a] != frequency_[b] ? frequency_[a] < frequency_[b] : tick_[a] < tick_[b];
+  }
+  void heap_swap_(size_t i, size_t j);
+  void heap_sift_up_(size_t i);
+  void heap_sift_down_(size_t i);
+  void heap_push_(uint32_t slot);
+  void heap_erase_(uint32_t slot);
+
+ public:
+  /**
+   * @param capacity the number of rows to cache.
+   * @param embedding_vec_size the number of floats of a row.
+   * @param policy the eviction policy.
+   */
+  HostRowCache(size_t capacity, size_t embedding_vec_size, CachePolicy_t policy);
+
+  HostRowCache(const HostRowCache&) = delete;
+  HostRowCache& operator=(const HostRowCache&) = delete;
+
+  /**
+   * Unpin the rows acquired since the last end_batch().
+   */
+  void end_batch();
+
+  /**
+   * Find the slot of a row, or make one for it, evicting another row if needed.
+   * @param row the offset of the row in the embedding file.
+   * @param hit set if the row is in the slot, or else it is to be filled by the caller.
+   * @return the slot, or NO_SLOT if all the slots are pinned.
+   */
+  uint32_t acquire(size_t row, bool& hit);
+
+  float* get_row(uint32_t slot) { return &rows_[slot * embedding_vec_size_]; }
+
+  /**
+   * Write a row through, if it is cached.
+   */
+  void update(size_t row, const float* vec) {
+    const auto* entry = row_slot_.find(static_cast<long long>(row));
+    if (entry != nullptr) {
+      std::copy(vec, vec + embedding_vec_size_, get_row(entry->offset()));
+    }
+  }
+
+  /**
+   * Drop all the rows, e.g. when the embedding file is rewritten.
+   */
+  void clear();
+
+  size_t size() const { return size_; }
+  size_t capacity() const { return capacity_; }
+  CachePolicy_t get_policy() const { return policy_; }
+
+  size_t get_hits() const { return hits_; }
+  size_t get_misses() const { return misses_; }
+  size_t get_evictions() const { return evictions_; }
+  size_t get_bypasses() const { return bypasses_; }
+  double get_hit_ratio() const {
+    return hits_ + misses_ ? static_cast<double>(hits_) / (hits_ + misses_) : 0.0;
+  }
+  void reset_stats() { hits_ = misses_ = evictions_ = bypasses_ = 0; }
+};
+
+}  // namespace HugeCTR
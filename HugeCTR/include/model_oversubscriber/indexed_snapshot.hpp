@@ -0,0 +1,104 @@
+/*
+ * Copyright (c) 2020, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <model_oversubscriber/flat_hash_table.hpp>
+#include <model_oversubscriber/row_codec.hpp>
+
+#include <cstdint>
+#include <string>
+
+namespace HugeCTR {
+
+/**
+ * @brief The first page of an indexed snapshot.
+ */
+struct IndexedSnapshotHeader {
+  char magic[8];
+  uint32_t version;
+  uint32_t key_size_in_byte;
+  uint32_t has_slot_id;       /**< 1 for LocalizedSlotSparseEmbeddingHash */
+  uint32_t reserved;
+  uint64_t embedding_vec_size;
+  uint64_t num_rows;
+  uint64_t values_offset;     /**< in byte, a multiple of the page size */
+  uint64_t index_offset;      /**< in byte */
+  uint64_t index_capacity;    /**< of the persisted FlatHashTable */
+};
+
+/**
+ * @brief A snapshot which a ParameterServer opens in place, instead of copying its embedding
+ * vectors to the embedding_file and indexing its keys one by one.
+ *
+ * It is made of three parts:
+ * - the IndexedSnapshotHeader, padded to a page.
+ * - the value block, at values_offset: the embedding vectors of the keys, sorted by key.
+ * - the key index, at index_offset: the control bytes and the entries of a FlatHashTable,
+ *   index_capacity of each, with the row of each key in the value block as its offset and its
+ *   slot_id. It is read back as is.
+ *
+ * The snapshot of rows <key, (slot_id,) embedding_vector> written by the parameter server
+ * delegates is converted to and from it by convert_from_snapshot() and convert_to_snapshot(),
+ * or the snapshot_converter tool.
+ */
+template <typename KeyType>
+class IndexedSnapshot {
+ public:
+  using HashTable = FlatHashTable<KeyType>;
+
+  static const char MAGIC[8];
+  static const uint32_t VERSION = 1;
+  static const size_t PAGE_SIZE = 4096;
+
+  /**
+   * Whether the file begins like an indexed snapshot.
+   */
+  static bool is_indexed_snapshot(const std::string& path);
+
+  /**
+   * Read and check the header.
+   */
+  static IndexedSnapshotHeader read_header(const std::string& path);
+
+  /**
+   * Read the key index into the hash table.
+   */
+  static void load_index(const std::string& path, const IndexedSnapshotHeader& header,
+                         HashTable& hash_table);
+
+  /**
+   * Write the keys of the hash table, and their embedding vectors from the rows of an
+   * embedding_file given by their offsets, as an indexed snapshot. The rows of the
+   * embedding_file are in storage_precision, and are written in fp32.
+   */
+  static void write(const std::string& snapshot_path, const std::string& embedding_table_path,
+                    size_t embedding_vec_size, bool has_slot_id, const HashTable& hash_table,
+                    StoragePrecision_t storage_precision = StoragePrecision_t::FP32);
+
+  /**
+   * Convert a snapshot of rows <key, (slot_id,) embedding_vector>.
+   */
+  static void convert_from_snapshot(const std::string& src_path, const std::string& dst_path,
+                                    size_t embedding_vec_size, bool has_slot_id);
+
+  /**
+   * Convert to a snapshot of rows <key, (slot_id,) embedding_vector>, in the order of the keys.
+   */
+  static void convert_to_snapshot(const std::string& src_path, const std::string& dst_path);
+};
+
+}  // namespace HugeCTR
@@ -21,6 +21,7 @@
 #include "HugeCTR/include/model_oversubscriber/parameter_server_manager.hpp"
 #include "HugeCTR/include/model_oversubscriber/model_oversubscriber_impl.hpp"
 
+#include <map>
 #include <memory>
 #include <vector>
 
@@ -67,6 +68,18 @@ public:
   void update(std::string& keyset_file) {
     impl_base_->update(keyset_file);
   }
+
+  void prefetch(std::vector<std::string>& keyset_file_list) {
+    impl_base_->prefetch(keyset_file_list);
+  }
+
+  void prefetch(std::string& keyset_file) {
+    impl_base_->prefetch(keyset_file);
+  }
+
+  std::map<std::string, double> get_timings() const {
+    return impl_base_->get_timings();
+  }
 };
 
 }  // namespace HugeCTR
@@ -22,7 +22,10 @@
 #include "HugeCTR/include/embeddings/distributed_slot_sparse_embedding_hash.hpp"
 #include "HugeCTR/include/model_oversubscriber/parameter_server_manager.hpp"
 
+#include <exception>
+#include <map>
 #include <memory>
+#include <thread>
 #include <vector>
 #include <typeinfo>
 
@@ -33,6 +36,9 @@ public:
   virtual void store(std::vector<std::string> snapshot_file_list) = 0;
   virtual void update(std::vector<std::string>& keyset_file_list) = 0;
   virtual void update(std::string& keyset_file) = 0;
+  virtual void prefetch(std::vector<std::string>& keyset_file_list) = 0;
+  virtual void prefetch(std::string& keyset_file) = 0;
+  virtual std::map<std::string, double> get_timings() const = 0;
   virtual ~ModelOversubscriberImplBase() {}
 };
 
@@ -42,6 +48,14 @@ class ModelOversubscriberImpl : public ModelOversubscriberImplBase {
   std::vector<std::shared_ptr<IEmbedding>> embeddings_;
   ParameterServerManager<TypeHashKey, TypeEmbeddingComp> ps_manager_;
 
+  std::thread prefetch_thread_;
+  std::exception_ptr prefetch_error_;
+  double prefetch_ms_{0};   /**< written by prefetch_thread_ only */
+  bool prefetched_{false};  /**< the staged buffer bags hold prefetched_keyset_file_list_ */
+  std::vector<std::string> prefetched_keyset_file_list_;
+  std::vector<size_t> staged_sizes_;
+  std::map<std::string, double> timings_; /**< milliseconds of each phase */
+
   size_t get_max_embedding_size_() {
     size_t max_embedding_size = 0;
     for (auto &one_embedding : embeddings_) {
@@ -58,6 +72,16 @@ class ModelOversubscriberImpl : public ModelOversubscriberImplBase {
    */
   void load_(std::vector<std::string>& keyset_file_list);
 
+  /**
+   * @brief      Wait for the prefetch in flight, if any.
+   */
+  void wait_prefetch_();
+
+  /**
+   * @brief      store() without resetting the timings.
+   */
+  void store_(std::vector<std::string>& snapshot_file_list);
+
 public:
   ModelOversubscriberImpl(
       std::vector<std::shared_ptr<IEmbedding>>& embeddings,
@@ -68,12 +92,18 @@ public:
   ModelOversubscriberImpl(const ModelOversubscriberImpl&) = delete;
   ModelOversubscriberImpl& operator=(const ModelOversubscriberImpl&) = delete;
 
-  ~ModelOversubscriberImpl() {}
+  ~ModelOversubscriberImpl() {
+    if (prefetch_thread_.joinable()) {
+      prefetch_thread_.join();
+    }
+  }
 
   /**
    * @brief      Store the embedding table or a snapshot file downloaded from device to SSD.
    *             If snapshot_file_list.size() is 0, update the embedding_file in SSD;
-   *             Or, wirte out a snapshot.
+   *             Or, wirte out a snapshot. Only the embedding vectors updated since they were
+   *             loaded are downloaded and written to the embedding_file, and into the
+   *             buffers staged by prefetch() if they are also in the next keyset.
    * @param      snapshot_file_list The file list where snapshot will be written, its size 
    *                                equals the number of embeddings.
    */
@@ -81,7 +111,9 @@ public:
 
   /**
    * @brief      Updates the embedding_file using embeddings from device memory, then
-   *             load embeddings to device memory according to the new keyset.
+   *             load embeddings to device memory according to the new keyset. If the keyset
+   *             was prefetched, the embeddings are loaded from the staged buffers instead of
+   *             the embedding_file.
    * @param      keyset_file_list  The keyset file list storing keyset.
    */
   void update(std::vector<std::string>& keyset_file_list) override;
@@ -92,6 +124,28 @@ public:
    * @param      keyset_file  A single keyset file storing keysets for all embeddings.
    */
   void update(std::string& keyset_file) override;
+
+  /**
+   * @brief      Start to load the embedding vectors of the next keyset from the
+   *             embedding_file into host buffers in background, while the current one is
+   *             trained. The next update() with the same keyset waits for it, refreshes the
+   *             staged vectors which store() writes back, and loads them to device memory.
+   * @param      keyset_file_list  The keyset file list storing the next keyset.
+   */
+  void prefetch(std::vector<std::string>& keyset_file_list) override;
+
+  /**
+   * @brief      prefetch() with a single keyset file for all embeddings.
+   * @param      keyset_file  A single keyset file storing keysets for all embeddings.
+   */
+  void prefetch(std::string& keyset_file) override;
+
+  /**
+   * @brief      Milliseconds taken by each phase of the last store() or update():
+   *             "prefetch" (in background), "prefetch_wait", "store", "refresh", "reset"
+   *             and "load". Only the phases which ran are present.
+   */
+  std::map<std::string, double> get_timings() const override { return timings_; }
 };
 
 }  // namespace HugeCTR
@@ -0,0 +1,86 @@
+/*
+ * Copyright (c) 2020, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <omp.h>
+#include <algorithm>
+#include <cstddef>
+#include <exception>
+#include <thread>
+#include <vector>
+
+namespace HugeCTR {
+
+/**
+ * Run func(i) for i in [0, n) on num_threads OpenMP threads, one i at a time per thread.
+ * Once func throws, the i not started yet are skipped, and the first error is rethrown after.
+ */
+template <typename Func>
+void parallel_for_each(size_t n, int num_threads, Func func) {
+  std::exception_ptr error;
+#pragma omp parallel for schedule(dynamic, 1) num_threads(num_threads)
+  for (size_t i = 0; i < n; i++) {
+    bool failed = false;
+#pragma omp critical(parallel_for_each_error)
+    failed = error != nullptr;
+    if (failed) continue;
+    try {
+      func(i);
+    } catch (...) {
+#pragma omp critical(parallel_for_each_error)
+      if (!error) error = std::current_exception();
+    }
+  }
+  if (error) {
+    std::rethrow_exception(error);
+  }
+}
+
+/**
+ * Run func(i) for i in [0, n) at once, each on its own thread with its share of the OpenMP
+ * threads. Unlike parallel_for_each, the OpenMP regions inside func are not nested, as every
+ * thread starts its own team. The first error is rethrown once all of them are done.
+ */
+template <typename Func>
+void thread_for_each(size_t n, Func func) {
+  if (n == 1) {
+    func(0);
+    return;
+  }
+  const int num_threads = std::max(1, static_cast<int>(omp_get_max_threads() / n));
+  std::vector<std::exception_ptr> errors(n);
+  std::vector<std::thread> threads;
+  threads.reserve(n);
+  for (size_t i = 0; i < n; i++) {
+    threads.emplace_back([&func, &errors, num_threads, i]() {
+      omp_set_num_threads(num_threads);
+      try {
+        func(i);
+      } catch (...) {
+        errors[i] = std::current_exception();
+      }
+    });
+  }
+  for (auto& t : threads) {
+    t.join();
+  }
+  for (auto& error : errors) {
+    if (error) std::rethrow_exception(error);
+  }
+}
+
+}  // namespace HugeCTR
@@ -18,34 +18,83 @@
 
 #include <tensor2.hpp>
 #include <embedding.hpp>
+#include <model_oversubscriber/host_row_cache.hpp>
+#include <model_oversubscriber/indexed_snapshot.hpp>
 #include <model_oversubscriber/parameter_server_delegate.hpp>
 #include <model_oversubscriber/localized_parameter_server_delegate.hpp>
 #include <model_oversubscriber/distributed_parameter_server_delegate.hpp>
+#include <model_oversubscriber/row_codec.hpp>
 
 #include <algorithm>
+#include <cstring>
+#include <exception>
 #include <memory>
-#include <unordered_map>
+#include <thread>
 #include <vector>
 
 namespace HugeCTR {
 
 template <typename TypeHashKey, typename TypeEmbeddingComp>
 class ParameterServer {
+  using HashTable = typename ParameterServerDelegate<TypeHashKey>::HashTable;
+
   SparseEmbeddingHashParams<TypeEmbeddingComp> embedding_params_;
+  RowCodec codec_; /**< the embedding vectors in the embedding_file, to and from fp32 */
   std::string embedding_table_path_;
   bool is_distributed_;
   std::unique_ptr<ParameterServerDelegate<TypeHashKey>> parameter_server_delegate_;
-  std::unordered_map<TypeHashKey, std::pair<size_t, size_t>> hash_table_; // <key, <slot_id, offset>>
+  HashTable hash_table_; // <key, <slot_id, offset>>
   std::vector<TypeHashKey> keyset_;
+  std::vector<uint8_t> dirty_rows_; /**< per row of embedding_file, written since clear_dirty() */
+  HashTable staged_index_; /**< <key, <slot_id, row in the staged buffer or NOT_STAGED>> */
+  std::unique_ptr<HostRowCache> host_cache_; /**< nullptr if no rows are cached */
+  size_t num_rows_{0};              /**< rows of embedding_file, live or free */
+  std::vector<size_t> free_rows_;   /**< rows of erased keys, reused by the next dump */
+
+  // an indexed snapshot opened in place: the rows [0, num_base_rows_) are read from its value
+  // block until they are written to the embedding_file, which is sparse until then
+  void* base_map_{nullptr};
+  size_t base_map_size_in_byte_{0};
+  const float* base_table_{nullptr};
+  size_t num_base_rows_{0};
+  std::vector<uint8_t> in_embedding_file_; /**< per base row, written to embedding_file */
+
+  std::thread compaction_thread_;
+  std::exception_ptr compaction_error_;
+  std::vector<typename HashTable::Entry> compaction_order_; /**< live entries by key */
 
   size_t file_size_in_byte_; /**< Size of embedding file in bytes */
-  float* mmaped_table_;      /**< Memory mapped file pointer */
+  char* mmaped_table_;       /**< Memory mapped file pointer */
   int fd_;                   /**< File descriptor for mapped file */
   bool maped_to_memory_;
   
   void map_embedding_to_memory_();
   void unmap_embedding_from_memory_();
 
+  /**
+   * Use the indexed snapshot in place of a copy in the embedding_file.
+   */
+  void open_indexed_snapshot_(const std::string& snapshot_file);
+  void release_base_table_();
+
+  /**
+   * Read the embedding vector of a row in fp32, from the embedding_file (which must be mapped)
+   * or the indexed snapshot opened in place.
+   */
+  void read_row_(size_t row, float* dst) const {
+    const size_t embedding_vec_size = embedding_params_.embedding_vec_size;
+    if (row < num_base_rows_ && !in_embedding_file_[row]) {
+      memcpy(dst, base_table_ + row * embedding_vec_size, sizeof(float) * embedding_vec_size);
+    } else {
+      codec_.decode(mmaped_table_ + row * codec_.row_size_in_byte(), dst);
+    }
+  }
+
+  /**
+   * Wait for the compaction in flight, if any, and switch to the compacted embedding_file.
+   */
+  void wait_compaction_();
+
   static std::unique_ptr<ParameterServerDelegate<TypeHashKey>> get_parameter_server_delegate_(
       const Embedding_t embedding_type) {
     if (embedding_type == Embedding_t::DistributedSlotSparseEmbeddingHash) {
@@ -63,13 +112,23 @@ public:
    *             initialize hash_table_ and a temporary embedding_file.
    * @param      embedding_params  The embedding parameters for initializetion.
    * @param      snapshot_src_file The source file used to initialize hash_table_
-   *             and embedding_file.
+   *             and embedding_file. An IndexedSnapshot is opened in place instead: its
+   *             index is read as hash_table_, and its embedding vectors are read from it until
+   *             they are written, so it must not change while the ParameterServer is alive.
+   * @param      host_cache_capacity The number of embedding vectors cached in host memory
+   *             in front of the embedding_file, 0 to disable the cache.
+   * @param      host_cache_policy The eviction policy of the cache.
+   * @param      storage_precision The precision of the embedding vectors in the
+   *             embedding_file. The snapshots and the buffer bags are in fp32 anyway.
    */
   ParameterServer(
       const SparseEmbeddingHashParams<TypeEmbeddingComp>& embedding_params,
       const std::string& snapshot_src_file,
       const std::string& temp_embedding_dir,
-      const Embedding_t embedding_type);
+      const Embedding_t embedding_type,
+      size_t host_cache_capacity = 0,
+      CachePolicy_t host_cache_policy = CachePolicy_t::LRU,
+      StoragePrecision_t storage_precision = StoragePrecision_t::FP32);
 
   ParameterServer(const ParameterServer&) = delete;
   ParameterServer& operator=(const ParameterServer&) = delete;
@@ -92,12 +151,56 @@ public:
   void load_param_from_embedding_file(BufferBag &buf_bag, size_t& hit_size);
 
   /**
-   * @brief      Dumps the embedding table to the embedding file.
+   * @brief      Load embedding vectors like load_param_from_embedding_file(), for the keys of
+   *             keyset instead of keyset_.
+   * @param      keyset    The keys to look up, num_keys of them.
+   * @param      keys      The hit keys, in the order of their rows in the embedding_file.
+   * @param      slot_id   Their slot_id, or nullptr for DistributedSlotSparseEmbeddingHash.
+   * @param      hash_table_val  Their embedding vectors.
+   * @return     The number of hit keys.
+   */
+  size_t load_param(const TypeHashKey* keyset, size_t num_keys, TypeHashKey* keys,
+                    size_t* slot_id, float* hash_table_val);
+
+  /**
+   * @brief      Load embedding vectors like load_param_from_embedding_file(), and remember
+   *             where each key of keyset_ is staged, for refresh_staged_param(). It can run
+   *             in background while the embedding is trained, as long as nothing is dumped
+   *             to the embedding file meanwhile.
+   * @param      buf_bag      The buffer bag to stage keys, slot_id, and hash_table_val into.
+   * @param      staged_size  The number of keys staged.
+   */
+  void stage_param_from_embedding_file(BufferBag &buf_bag, size_t& staged_size);
+
+  /**
+   * @brief      Bring the staged embedding vectors up to date with the ones just dumped by
+   *             dump_param_to_embedding_file(): the dumped vectors of staged keys are copied
+   *             over, and those of the keys in keyset_ which were not in the embedding file
+   *             when staging are appended.
+   * @param      dump_bag     The buffer bag which was dumped.
+   * @param      dump_size    The number of keys dumped.
+   * @param      staged_bag   The buffer bag filled by stage_param_from_embedding_file().
+   * @param      staged_size  The number of keys staged, updated in place.
+   * @return     The number of embedding vectors copied or appended.
+   */
+  size_t refresh_staged_param(BufferBag &dump_bag, const size_t dump_size,
+                              BufferBag &staged_bag, size_t& staged_size);
+
+  /**
+   * @brief      Dumps the embedding table to the embedding file. The new keys take the free
+   *             rows first, and the file is extended at once for the others.
    * @param      buf_bag    The buffer bag for keys, slot_id, and hash_table_val.
    * @param      dump_size  The size of keys in buffer keys or vectors in embedding_table.
    */
   void dump_param_to_embedding_file(BufferBag &buf_bag, const size_t dump_size);
 
+  /**
+   * @brief      Dump like dump_param_to_embedding_file(), from plain arrays of dump_size rows.
+   *             slot_id is ignored for DistributedSlotSparseEmbeddingHash, and may be nullptr.
+   */
+  void dump_param(const TypeHashKey* keys, const size_t* slot_id, const float* hash_table_val,
+                  const size_t dump_size);
+
   /**
    * @brief      Dump to snapshot_dst_file in a format of <key embedding_vector> for
    *             DistributedSlotSparseEmbedding, or <key slot embedding_vector> for
@@ -105,10 +208,83 @@ public:
    */
   void dump_to_snapshot(const std::string& snapshot_dst_file);
 
+  /**
+   * @brief      Dump to snapshot_dst_file as an IndexedSnapshot, which can be opened in place
+   *             by the next ParameterServer.
+   */
+  void dump_to_indexed_snapshot(const std::string& snapshot_dst_file);
+
   /**
    * @brief      A function for debugging purpose, returning the keys from hash_table.
    */
   std::vector<TypeHashKey> get_keys_from_hash_table() const;
+
+  /**
+   * @brief      The keys whose embedding vectors in the embedding_file were written by
+   *             dump_param_to_embedding_file() since the ParameterServer was created or
+   *             clear_dirty() was called, in no particular order.
+   */
+  std::vector<TypeHashKey> get_dirty_keys() const;
+
+  /**
+   * @brief      The number of keys returned by get_dirty_keys().
+   */
+  size_t get_num_dirty() const;
+
+  /**
+   * @brief      Whether the key is returned by get_dirty_keys().
+   */
+  bool is_dirty(TypeHashKey key) const;
+
+  /**
+   * @brief      Forget the dirty keys, e.g. after the embedding_file is dumped to a snapshot.
+   */
+  void clear_dirty();
+
+  /**
+   * @brief      The host memory cache of the embedding_file with its hit counters, or nullptr
+   *             if it is disabled.
+   */
+  const HostRowCache* get_host_cache() const { return host_cache_.get(); }
+
+  /**
+   * @brief      Remove keys from hash_table_. Their rows of the embedding_file are put on the
+   *             free list, to be reused by the next dump_param_to_embedding_file().
+   * @return     The number of keys removed.
+   */
+  size_t erase_keys(const std::vector<TypeHashKey>& keys);
+
+  /**
+   * @brief      The path of the embedding_file.
+   */
+  const std::string& get_embedding_file_path() const { return embedding_table_path_; }
+
+  /**
+   * @brief      The number of rows of the embedding_file, live or free.
+   */
+  size_t get_num_rows() const { return num_rows_; }
+
+  /**
+   * @brief      The number of free rows of the embedding_file.
+   */
+  size_t get_num_free_rows() const { return free_rows_.size(); }
+
+  /**
+   * @brief      Whether more than a quarter of the embedding_file is free.
+   */
+  bool needs_compaction() const { return free_rows_.size() * 4 > num_rows_; }
+
+  /**
+   * @brief      Start to rewrite the live rows of the embedding_file into a new file in the
+   *             order of their keys, in background. Meanwhile, embedding vectors can be loaded
+   *             from the old file, and the next call which changes it switches to the new one.
+   */
+  void start_compaction();
+
+  /**
+   * @brief      Rewrite the embedding_file like start_compaction(), and wait for it.
+   */
+  void compact();
 };
 
 }  // namespace HugeCTR
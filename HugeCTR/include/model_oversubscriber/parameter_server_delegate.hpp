@@ -17,8 +17,9 @@
 #pragma once
 
 
-#include <unordered_map>
-#include <fstream>
+#include <string>
+#include <common.hpp>
+#include <model_oversubscriber/flat_hash_table.hpp>
 
 namespace HugeCTR {
 
@@ -26,19 +27,27 @@ namespace HugeCTR {
 template <typename KeyType>
 class ParameterServerDelegate {
  public:
-  using HashTable = std::unordered_map<KeyType, std::pair<size_t, size_t>>; // in case of its replacement
-
-  virtual void load_from_snapshot(std::ofstream& embeding_table,
-                                  std::ifstream& snapshot,
-                                  const size_t file_size_in_byte,
+  using HashTable = FlatHashTable<KeyType>; // <key, <slot_id, offset>>
+
+  /**
+   * Write the embedding vectors of the snapshot to the embedding_file in storage_precision, and
+   * index their keys in the hash table by the rows of the embedding_file.
+   */
+  virtual void load_from_snapshot(const std::string& embedding_table_path,
+                                  const std::string& snapshot_path,
                                   const size_t embedding_vec_size,
+                                  const StoragePrecision_t storage_precision,
                                   HashTable& hash_table) = 0;
 
-  virtual void store_to_snapshot(std::ofstream& snapshot,
-                                 std::ifstream& embedding_table,
-                                 const size_t file_size_in_byte,
+  /**
+   * Write the embedding_file in storage_precision to the snapshot, with the keys of its rows in
+   * the hash table.
+   */
+  virtual void store_to_snapshot(const std::string& snapshot_path,
+                                 const std::string& embedding_table_path,
                                  const size_t embedding_vec_size,
-                                 HashTable& hash_table) = 0;
+                                 const StoragePrecision_t storage_precision,
+                                 const HashTable& hash_table) = 0;
 };
 
 }  // namespace HugeCTR
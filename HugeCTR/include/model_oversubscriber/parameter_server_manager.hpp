@@ -29,6 +29,9 @@ template <typename TypeHashKey, typename TypeEmbeddingComp>
 class ParameterServerManager {
   std::vector<std::shared_ptr<ParameterServer<TypeHashKey, TypeEmbeddingComp>>> ps_;
   BufferBag buf_bag_;
+  std::vector<BufferBag> staged_buf_bags_; /**< one per parameter server, allocated on demand */
+  std::vector<size_t> embedding_vec_sizes_;
+  size_t buffer_size_;
 
 public:
   ParameterServerManager(
@@ -54,6 +57,13 @@ public:
   size_t get_size() { return ps_.size(); }
 
   BufferBag& get_buffer_bag() { return buf_bag_; }
+
+  /**
+   * @brief      Gets the buffer bag to stage the next keyset of the ith parameter server in,
+   *             which is allocated at the first call.
+   * @param      i     index of parameter server.
+   */
+  BufferBag& get_staged_buffer_bag(int i);
 };
 
 }  // namespace HugeCTR
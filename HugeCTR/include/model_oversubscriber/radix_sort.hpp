@@ -0,0 +1,81 @@
+/*
+ * Copyright (c) 2020, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <omp.h>
+
+#include <algorithm>
+#include <vector>
+
+namespace HugeCTR {
+
+/**
+ * Sort the entries of FlatHashTable by their offset, with a parallel LSD radix sort.
+ * Only the digits of 8 bits up to the highest one of "max_offset" are sorted, so a table of
+ * N keys takes ceil(log2(N) / 8) passes. The sort is stable.
+ * @param entries the entries to sort, in place
+ * @param max_offset the largest offset of the entries
+ * @param num_threads the number of OpenMP threads to sort with
+ */
+template <typename Entry>
+void radix_sort_by_offset(std::vector<Entry>& entries, size_t max_offset, int num_threads) {
+  const int DIGIT_BITS = 8;
+  const size_t NUM_DIGITS = 1 << DIGIT_BITS;
+  const size_t size = entries.size();
+  int bits = 0;
+  while (bits < 64 && (max_offset >> bits) > 0) {
+    bits += DIGIT_BITS;
+  }
+  if (size < 2 || bits == 0) {
+    return;
+  }
+  std::vector<Entry> buffer(size);
+  std::vector<size_t> histograms(num_threads * NUM_DIGITS);
+  for (int shift = 0; shift < bits; shift += DIGIT_BITS) {
+#pragma omp parallel num_threads(num_threads)
+    {
+      const size_t tid = omp_get_thread_num();
+      const size_t thread_num = omp_get_num_threads();
+      const size_t begin = size * tid / thread_num;
+      const size_t end = size * (tid + 1) / thread_num;
+      size_t* histogram = &histograms[tid * NUM_DIGITS];
+      std::fill(histogram, histogram + NUM_DIGITS, 0);
+      for (size_t i = begin; i < end; i++) {
+        histogram[(entries[i].offset() >> shift) & (NUM_DIGITS - 1)]++;
+      }
+#pragma omp barrier
+#pragma omp single
+      {
+        // where each thread starts to put each digit
+        size_t sum = 0;
+        for (size_t digit = 0; digit < NUM_DIGITS; digit++) {
+          for (size_t t = 0; t < thread_num; t++) {
+            const size_t count = histograms[t * NUM_DIGITS + digit];
+            histograms[t * NUM_DIGITS + digit] = sum;
+            sum += count;
+          }
+        }
+      }
+      for (size_t i = begin; i < end; i++) {
+        buffer[histogram[(entries[i].offset() >> shift) & (NUM_DIGITS - 1)]++] = entries[i];
+      }
+    }
+    entries.swap(buffer);
+  }
+}
+
+}  // namespace HugeCTR
@@ -0,0 +1,74 @@
+/*
+ * Copyright (c) 2020, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <common.hpp>
+
+#include <cstddef>
+
+namespace HugeCTR {
+
+/**
+ * @brief The format of the rows of the embedding_file of ParameterServer, which hold the
+ * embedding vectors with a lower precision than the fp32 ones of the BufferBag and the
+ * snapshots, to read and write fewer bytes.
+ *
+ * - FP32: as is.
+ * - FP16: IEEE half, rounded to nearest even. A magnitude above 65504 becomes infinite.
+ * - BF16: the upper half of the fp32 bits, rounded to nearest even.
+ * - INT8: a float scale, max|x| / 127, followed by round(x / scale) as int8.
+ *
+ * The conversions use SSE2, and F16C for FP16 where the CPU has it, with scalar code for the
+ * rest of a vector and elsewhere. They give the same results either way, but for the payload of
+ * a NaN.
+ */
+class RowCodec {
+ public:
+  using EncodeFunc = void (*)(const float* src, char* dst, size_t embedding_vec_size);
+  using DecodeFunc = void (*)(const char* src, float* dst, size_t embedding_vec_size);
+
+ private:
+  StoragePrecision_t precision_;
+  size_t embedding_vec_size_;
+  size_t row_size_in_byte_;
+  EncodeFunc encode_;
+  DecodeFunc decode_;
+
+ public:
+  RowCodec(StoragePrecision_t precision, size_t embedding_vec_size);
+
+  /**
+   * The size of a row of embedding_vec_size floats stored with the precision.
+   */
+  static size_t row_size_in_byte(StoragePrecision_t precision, size_t embedding_vec_size);
+
+  StoragePrecision_t get_precision() const { return precision_; }
+  size_t get_embedding_vec_size() const { return embedding_vec_size_; }
+  size_t row_size_in_byte() const { return row_size_in_byte_; }
+
+  /**
+   * Convert an embedding vector to a row of row_size_in_byte() bytes.
+   */
+  void encode(const float* src, char* dst) const { encode_(src, dst, embedding_vec_size_); }
+
+  /**
+   * Convert a row back to an embedding vector.
+   */
+  void decode(const char* src, float* dst) const { decode_(src, dst, embedding_vec_size_); }
+};
+
+}  // namespace HugeCTR
@@ -0,0 +1,90 @@
+/*
+ * Copyright (c) 2020, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <model_oversubscriber/flat_hash_table.hpp>
+#include <model_oversubscriber/row_codec.hpp>
+
+#include <string>
+
+namespace HugeCTR {
+
+/**
+ * @brief The conversion between a snapshot of rows <key, (slot_id,) embedding_vector> and the
+ * embedding_file of a ParameterServer, which holds the embedding vectors only, in the same order,
+ * converted to its StoragePrecision_t by a RowCodec.
+ *
+ * Both files are split into blocks of rows, which are read with pread() and written with
+ * pwrite() at their own offsets by a pool of OpenMP threads, so the reads and the writes of
+ * distinct blocks overlap. The keys of each block are collected on the way, bucketed by the
+ * hash of the key into one shard per thread. Once all the blocks are copied, the shards are
+ * deduplicated in parallel, and the kept keys are inserted into the hash table by all the threads
+ * at once, with the offsets in the order of the rows.
+ */
+template <typename KeyType>
+class SnapshotPipeline {
+ public:
+  using HashTable = FlatHashTable<KeyType>;
+
+ private:
+  const size_t embedding_vec_size_;
+  const bool has_slot_id_;
+  const RowCodec codec_;
+  const size_t block_size_in_byte_;
+  const int num_threads_;
+
+  size_t vector_size_in_byte() const { return sizeof(float) * embedding_vec_size_; }
+  size_t row_size_in_byte() const {
+    return sizeof(KeyType) + (has_slot_id_ ? sizeof(size_t) : 0) + vector_size_in_byte();
+  }
+  size_t rows_per_block() const;
+
+ public:
+  /**
+   * @param embedding_vec_size the number of floats of an embedding vector.
+   * @param has_slot_id whether the rows of the snapshot have a slot_id after the key, as the
+   *        ones of LocalizedSlotSparseEmbeddingHash.
+   * @param storage_precision the precision of the embedding vectors in the embedding_file.
+   * @param block_size_in_byte the size of the snapshot read or written at once by a thread.
+   * @param num_threads the number of threads, or 0 for at least 4 of them, since they mostly
+   *        wait for the disk.
+   */
+  SnapshotPipeline(size_t embedding_vec_size, bool has_slot_id,
+                   StoragePrecision_t storage_precision = StoragePrecision_t::FP32,
+                   size_t block_size_in_byte = size_t(32) << 20, int num_threads = 0);
+
+  /**
+   * Write the embedding vectors of a snapshot to the embedding_file, and insert the keys into
+   * the hash table with the rows as their offsets. A key repeated in the snapshot keeps its
+   * first row, and its other rows are left out of the embedding_file.
+   * @param snapshot_path the snapshot to read, or empty to create an empty embedding_file.
+   * @param embedding_table_path the embedding_file to create or truncate.
+   */
+  void import_snapshot(const std::string& snapshot_path, const std::string& embedding_table_path,
+                       HashTable& hash_table) const;
+
+  /**
+   * Write the rows of the embedding_file to a snapshot, with the keys from the hash table.
+   * Every row of the embedding_file must be the offset of one key.
+   * @param embedding_table_path the embedding_file to read.
+   * @param snapshot_path the snapshot to create or truncate.
+   */
+  void export_snapshot(const std::string& embedding_table_path, const std::string& snapshot_path,
+                       const HashTable& hash_table) const;
+};
+
+}  // namespace HugeCTR
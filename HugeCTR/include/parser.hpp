@@ -72,6 +72,9 @@ struct SolverParser {
   std::string export_predictions_prefix;
   bool use_model_oversubscriber;
   std::string temp_embedding_dir;
+  size_t host_cache_size_in_mb{0};          /**< host memory cache of the temp embedding files */
+  CachePolicy_t host_cache_policy{CachePolicy_t::LRU};
+  StoragePrecision_t temp_embedding_precision{StoragePrecision_t::FP32};
   SolverParser(const std::string& file);
   SolverParser() {}
 };
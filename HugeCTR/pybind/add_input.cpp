@@ -48,6 +48,29 @@ void add_input(Input& input,
   const int num_workers = format == DataReaderType_t::Parquet ? resource_manager->get_local_gpu_count() : input.num_workers;
 #endif
   MESSAGE_("num of DataReader workers: " + std::to_string(num_workers));
+  const int prefetch_depth = input.prefetch_depth;
+  if (prefetch_depth <= 0) {
+    CK_THROW_(Error_t::WrongInput, "prefetch_depth <= 0");
+  }
+  if (input.num_parse_threads <= 0) {
+    CK_THROW_(Error_t::WrongInput, "num_parse_threads <= 0");
+  }
+  if (input.num_parse_threads > 1 && !input.use_mmap) {
+    CK_THROW_(Error_t::WrongInput, "num_parse_threads > 1 requires use_mmap");
+  }
+  if (input.shuffle_buffer_size < 0) {
+    CK_THROW_(Error_t::WrongInput, "shuffle_buffer_size < 0");
+  }
+  if (input.shuffle_block_size < 0) {
+    CK_THROW_(Error_t::WrongInput, "shuffle_block_size < 0");
+  }
+  if (input.async_io_depth < 0) {
+    CK_THROW_(Error_t::WrongInput, "async_io_depth < 0");
+  }
+  if (input.async_io_depth > 0 && (input.use_mmap || input.shuffle_block_size > 0)) {
+    CK_THROW_(Error_t::WrongInput,
+              "async_io_depth can't be used with use_mmap or shuffle_block_size");
+  }
 
   for (unsigned int i = 0; i < input.sparse_names.size(); i++) {
     DataReaderSparseParam param = input.data_reader_sparse_param_array[i];
@@ -58,11 +81,13 @@ void add_input(Input& input,
 
   DataReader<TypeKey>* data_reader_tk = new DataReader<TypeKey>(
       batch_size, label_dim, dense_dim, input.data_reader_sparse_param_array, resource_manager,
-      repeat_dataset, num_workers, use_mixed_precision, false);
+      repeat_dataset, num_workers, use_mixed_precision, false, prefetch_depth,
+      input.lock_free_heap);
   train_data_reader.reset(data_reader_tk);
   DataReader<TypeKey>* data_reader_eval_tk = new DataReader<TypeKey>(
       batch_size_eval, label_dim, dense_dim, input.data_reader_sparse_param_array, resource_manager,
-      repeat_dataset, num_workers, use_mixed_precision, cache_eval_data);
+      repeat_dataset, num_workers, use_mixed_precision, cache_eval_data,
+      prefetch_depth, input.lock_free_heap);
   evaluate_data_reader.reset(data_reader_eval_tk);
 
   long long slot_sum = 0;
@@ -75,15 +100,23 @@ void add_input(Input& input,
   switch (format) {
     case DataReaderType_t::Norm: {
       bool start_right_now = repeat_dataset;
-      train_data_reader->create_drwg_norm(source_data, check_type, start_right_now);
-      evaluate_data_reader->create_drwg_norm(eval_source, check_type, start_right_now);
+      // the evaluation data is always read in order
+      train_data_reader->create_drwg_norm(source_data, check_type, start_right_now,
+                                          input.use_mmap, input.num_parse_threads,
+                                          input.shuffle_buffer_size, input.shuffle_files,
+                                          input.async_io_depth);
+      evaluate_data_reader->create_drwg_norm(eval_source, check_type, start_right_now,
+                                             input.use_mmap, input.num_parse_threads, 0, false,
+                                             input.async_io_depth);
       break;
     }
     case DataReaderType_t::Raw: {
       train_data_reader->create_drwg_raw(source_data, num_samples, slot_offset, float_label_dense,
-                                         true, false);
+                                         true, false, input.shuffle_block_size,
+                                         input.async_io_depth);
       evaluate_data_reader->create_drwg_raw(eval_source, eval_num_samples, slot_offset,
-                                            float_label_dense, false, false);
+                                            float_label_dense, false, false, 0,
+                                            input.async_io_depth);
       MESSAGE_("Vocabulary size: " + std::to_string(slot_sum));
       break;
     }
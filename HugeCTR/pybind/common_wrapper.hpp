@@ -122,6 +122,17 @@ void CommonPybind(pybind11::module& m) {
       .value("L1", HugeCTR::Regularizer_t::L1)
       .value("L2", HugeCTR::Regularizer_t::L2)
       .export_values();
+  pybind11::enum_<HugeCTR::CachePolicy_t>(m, "CachePolicy_t")
+      .value("LRU", HugeCTR::CachePolicy_t::LRU)
+      .value("LFU", HugeCTR::CachePolicy_t::LFU)
+      .value("CLOCK", HugeCTR::CachePolicy_t::CLOCK)
+      .export_values();
+  pybind11::enum_<HugeCTR::StoragePrecision_t>(m, "StoragePrecision_t")
+      .value("FP32", HugeCTR::StoragePrecision_t::FP32)
+      .value("FP16", HugeCTR::StoragePrecision_t::FP16)
+      .value("BF16", HugeCTR::StoragePrecision_t::BF16)
+      .value("INT8", HugeCTR::StoragePrecision_t::INT8)
+      .export_values();
 }
 
 }  // namespace python_lib
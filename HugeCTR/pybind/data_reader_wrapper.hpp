@@ -65,19 +65,23 @@ void DataReaderPybind(pybind11::module& m) {
   pybind11::class_<HugeCTR::IDataReader, std::shared_ptr<HugeCTR::IDataReader>>(m, "IDataReader");
   pybind11::class_<HugeCTR::DataReader<long long>, std::shared_ptr<HugeCTR::DataReader<long long>>, HugeCTR::IDataReader>(m, "DataReader64")
       .def(pybind11::init<int, size_t, int, std::vector<DataReaderSparseParam>&,
-                          const std::shared_ptr<ResourceManager>&, bool, int, bool, int>(),
+                          const std::shared_ptr<ResourceManager>&, bool, int, bool, int, int, bool>(),
            pybind11::arg("batchsize"), pybind11::arg("label_dim"), pybind11::arg("dense_dim"),
            pybind11::arg("params"), pybind11::arg("resource_manager"),
            pybind11::arg("repeat"),
            pybind11::arg("num_chunk_threads"), pybind11::arg("use_mixed_precision"),
-           pybind11::arg("cache_num_iters"))
+           pybind11::arg("cache_num_iters"), pybind11::arg("prefetch_depth") = 1,
+           pybind11::arg("lock_free_heap") = false)
       .def("create_drwg_norm", &HugeCTR::DataReader<long long>::create_drwg_norm,
            pybind11::arg("file_list"), pybind11::arg("Check_t"),
-           pybind11::arg("start_reading_from_beginning") = true)
+           pybind11::arg("start_reading_from_beginning") = true, pybind11::arg("use_mmap") = false,
+           pybind11::arg("num_parse_threads") = 1, pybind11::arg("shuffle_buffer_size") = 0,
+           pybind11::arg("shuffle_files") = false, pybind11::arg("async_io_depth") = 0)
       .def("create_drwg_raw", &HugeCTR::DataReader<long long>::create_drwg_raw,
            pybind11::arg("file_name"), pybind11::arg("num_samples"), pybind11::arg("slot_offset"),
            pybind11::arg("float_label_dense"), pybind11::arg("data_shuffle") = false,
-           pybind11::arg("start_reading_from_beginning") = true)
+           pybind11::arg("start_reading_from_beginning") = true,
+           pybind11::arg("shuffle_block_size") = 0, pybind11::arg("async_io_depth") = 0)
       .def("create_drwg_parquet", &HugeCTR::DataReader<long long>::create_drwg_parquet,
            pybind11::arg("file_list"), pybind11::arg("slot_offset"),
            pybind11::arg("start_reading_from_beginning") = true)
@@ -107,19 +111,23 @@ void DataReaderPybind(pybind11::module& m) {
 
   pybind11::class_<HugeCTR::DataReader<unsigned int>, std::shared_ptr<HugeCTR::DataReader<unsigned int>>, HugeCTR::IDataReader>(m, "DataReader32")
       .def(pybind11::init<int, size_t, int, std::vector<DataReaderSparseParam>&,
-                          const std::shared_ptr<ResourceManager>&, bool, int, bool, int>(),
+                          const std::shared_ptr<ResourceManager>&, bool, int, bool, int, int, bool>(),
            pybind11::arg("batchsize"), pybind11::arg("label_dim"), pybind11::arg("dense_dim"),
            pybind11::arg("params"), pybind11::arg("resource_manager"),
            pybind11::arg("repeat"),
            pybind11::arg("num_chunk_threads"), pybind11::arg("use_mixed_precision"),
-           pybind11::arg("cache_num_iters"))
+           pybind11::arg("cache_num_iters"), pybind11::arg("prefetch_depth") = 1,
+           pybind11::arg("lock_free_heap") = false)
       .def("create_drwg_norm", &HugeCTR::DataReader<unsigned int>::create_drwg_norm,
            pybind11::arg("file_list"), pybind11::arg("Check_t"),
-           pybind11::arg("start_reading_from_beginning") = true)
+           pybind11::arg("start_reading_from_beginning") = true, pybind11::arg("use_mmap") = false,
+           pybind11::arg("num_parse_threads") = 1, pybind11::arg("shuffle_buffer_size") = 0,
+           pybind11::arg("shuffle_files") = false, pybind11::arg("async_io_depth") = 0)
       .def("create_drwg_raw", &HugeCTR::DataReader<unsigned int>::create_drwg_raw,
            pybind11::arg("file_name"), pybind11::arg("num_samples"), pybind11::arg("slot_offset"),
            pybind11::arg("float_label_dense"), pybind11::arg("data_shuffle") = false,
-           pybind11::arg("start_reading_from_beginning") = true)
+           pybind11::arg("start_reading_from_beginning") = true,
+           pybind11::arg("shuffle_block_size") = 0, pybind11::arg("async_io_depth") = 0)
       .def("create_drwg_parquet", &HugeCTR::DataReader<unsigned int>::create_drwg_parquet,
            pybind11::arg("file_list"), pybind11::arg("slot_offset"),
            pybind11::arg("start_reading_from_beginning") = true)
@@ -26,12 +26,14 @@ namespace python_lib {
   
 std::shared_ptr<parameter_server_base> CreateParameterServer(const std::vector<std::string>& model_config_path,
                                                           const std::vector<std::string>& model_name,
-                                                          bool i64_input_key) {
+                                                          bool i64_input_key,
+                                                          size_t update_memory_budget_in_mb) {
   std::shared_ptr<parameter_server_base> ps;
+  const size_t update_memory_budget_in_byte = update_memory_budget_in_mb << 20;
   if (i64_input_key) {
-    ps.reset(new parameter_server<long long>("Other", model_config_path, model_name));
+    ps.reset(new parameter_server<long long>("Other", model_config_path, model_name, update_memory_budget_in_byte));
   } else {
-    ps.reset(new parameter_server<unsigned int>("Other", model_config_path, model_name));
+    ps.reset(new parameter_server<unsigned int>("Other", model_config_path, model_name, update_memory_budget_in_byte));
   }
   return ps;
 }
@@ -44,10 +46,19 @@ std::shared_ptr<embedding_interface> CreateEmbeddingCache(std::shared_ptr<parame
                                                         const std::string& model_name,
                                                         bool i64_input_key) {
   std::shared_ptr<embedding_interface> ec;
+  // HugectrUtility is the second base of parameter_server, so the pointer is adjusted
   if (i64_input_key) {
-    ec.reset(new embedding_cache<long long>(reinterpret_cast<HugectrUtility<long long>*>(parameter_server.get()), cuda_dev_id, use_gpu_embedding_cache, cache_size_percentage, model_config_path, model_name));
+    HugectrUtility<long long>* ps = dynamic_cast<HugectrUtility<long long>*>(parameter_server.get());
+    if (!ps) {
+      CK_THROW_(Error_t::WrongInput, "Error: the parameter server doesn't have i64 input keys");
+    }
+    ec.reset(new embedding_cache<long long>(ps, cuda_dev_id, use_gpu_embedding_cache, cache_size_percentage, model_config_path, model_name));
   } else {
-    ec.reset(new embedding_cache<unsigned int>(reinterpret_cast<HugectrUtility<unsigned int>*>(parameter_server.get()), cuda_dev_id, use_gpu_embedding_cache, cache_size_percentage, model_config_path, model_name));
+    HugectrUtility<unsigned int>* ps = dynamic_cast<HugectrUtility<unsigned int>*>(parameter_server.get());
+    if (!ps) {
+      CK_THROW_(Error_t::WrongInput, "Error: the parameter server has i64 input keys");
+    }
+    ec.reset(new embedding_cache<unsigned int>(ps, cuda_dev_id, use_gpu_embedding_cache, cache_size_percentage, model_config_path, model_name));
   }
   return ec;
 }
@@ -138,12 +149,21 @@ void InferencePybind(pybind11::module &m) {
     .value("Triton", HugeCTR::INFER_TYPE::TRITON)
     .value("Other", HugeCTR::INFER_TYPE::OTHER)
     .export_values();
-  pybind11::class_<HugeCTR::parameter_server_base, std::shared_ptr<HugeCTR::parameter_server_base>>(infer, "ParameterServerBase");
+  pybind11::class_<HugeCTR::parameter_server_base, std::shared_ptr<HugeCTR::parameter_server_base>>(infer, "ParameterServerBase")
+    .def("update_model", &HugeCTR::parameter_server_base::update_model,
+      pybind11::arg("model_name"),
+      pybind11::arg("sparse_model_files"))
+    .def("wait_for_update", &HugeCTR::parameter_server_base::wait_for_update)
+    .def("apply_delta", &HugeCTR::parameter_server_base::apply_delta,
+      pybind11::arg("model_name"),
+      pybind11::arg("embedding_table_id"),
+      pybind11::arg("delta_file"));
   pybind11::class_<HugeCTR::embedding_interface, std::shared_ptr<HugeCTR::embedding_interface>>(infer, "EmbeddingCacheInterface");
   infer.def("CreateParameterServer", &HugeCTR::python_lib::CreateParameterServer,
     pybind11::arg("model_config_path"),
     pybind11::arg("model_name"),
-    pybind11::arg("i64_input_key"));
+    pybind11::arg("i64_input_key"),
+    pybind11::arg("update_memory_budget_in_mb") = 0);
   infer.def("CreateEmbeddingCache", &HugeCTR::python_lib::CreateEmbeddingCache,
     pybind11::arg("parameter_server"),
     pybind11::arg("cuda_dev_id"),
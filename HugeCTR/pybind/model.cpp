@@ -104,12 +104,24 @@ Input::Input(DataReaderType_t data_reader_type,
        int num_workers,
        std::vector<long long>& slot_size_array,
        std::vector<DataReaderSparseParam>& data_reader_sparse_param_array,
-       std::vector<std::string>& sparse_names)
+       std::vector<std::string>& sparse_names,
+       int prefetch_depth,
+       bool lock_free_heap,
+       bool use_mmap,
+       int num_parse_threads,
+       int shuffle_buffer_size,
+       bool shuffle_files,
+       long long shuffle_block_size,
+       int async_io_depth)
     : data_reader_type(data_reader_type), source(source), eval_source(eval_source),
       check_type(check_type), cache_eval_data(cache_eval_data), label_dim(label_dim),
       label_name(label_name), dense_dim(dense_dim), dense_name(dense_name),
       num_samples(num_samples), eval_num_samples(eval_num_samples), float_label_dense(float_label_dense),
-      num_workers(num_workers), slot_size_array(slot_size_array),
+      num_workers(num_workers), prefetch_depth(prefetch_depth),
+      lock_free_heap(lock_free_heap), use_mmap(use_mmap),
+      num_parse_threads(num_parse_threads), shuffle_buffer_size(shuffle_buffer_size),
+      shuffle_files(shuffle_files), shuffle_block_size(shuffle_block_size),
+      async_io_depth(async_io_depth), slot_size_array(slot_size_array),
       data_reader_sparse_param_array(data_reader_sparse_param_array), sparse_names(sparse_names) {
   if (data_reader_sparse_param_array.size() != sparse_names.size()) {
     CK_THROW_(Error_t::WrongInput, "Inconsistent size of sparse hyperparameters and sparse names!");
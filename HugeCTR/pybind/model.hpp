@@ -44,6 +44,14 @@ struct Input {
   long eval_num_samples;
   bool float_label_dense;
   int num_workers;
+  int prefetch_depth;
+  bool lock_free_heap;
+  bool use_mmap;
+  int num_parse_threads;
+  int shuffle_buffer_size;
+  bool shuffle_files;
+  long long shuffle_block_size;
+  int async_io_depth;
   std::vector<long long> slot_size_array;
   std::vector<DataReaderSparseParam> data_reader_sparse_param_array;
   std::vector<std::string> sparse_names;
@@ -62,7 +70,15 @@ struct Input {
        int num_workers,
        std::vector<long long>& slot_size_array,
        std::vector<DataReaderSparseParam>& data_reader_sparse_param_array,
-       std::vector<std::string>& sparse_names);
+       std::vector<std::string>& sparse_names,
+       int prefetch_depth = 1,
+       bool lock_free_heap = false,
+       bool use_mmap = false,
+       int num_parse_threads = 1,
+       int shuffle_buffer_size = 0,
+       bool shuffle_files = false,
+       long long shuffle_block_size = 0,
+       int async_io_depth = 0);
 };
 
 
@@ -28,7 +28,12 @@ void ModelOversubscriberPybind(pybind11::module &m) {
     .def("update", pybind11::overload_cast<std::string&>(&HugeCTR::ModelOversubscriber::update),
          pybind11::arg("keyset_file"))
     .def("update", pybind11::overload_cast<std::vector<std::string>&>(&HugeCTR::ModelOversubscriber::update),
-         pybind11::arg("keyset_file_list"));
+         pybind11::arg("keyset_file_list"))
+    .def("prefetch", pybind11::overload_cast<std::string&>(&HugeCTR::ModelOversubscriber::prefetch),
+         pybind11::arg("keyset_file"))
+    .def("prefetch", pybind11::overload_cast<std::vector<std::string>&>(&HugeCTR::ModelOversubscriber::prefetch),
+         pybind11::arg("keyset_file_list"))
+    .def("get_timings", &HugeCTR::ModelOversubscriber::get_timings);
 }
 
 }  //  namespace python_lib
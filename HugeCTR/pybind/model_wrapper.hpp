@@ -28,7 +28,7 @@ void ModelPybind(pybind11::module &m) {
        std::string, std::string, Check_t,
        int, int, std::string, int, std::string,
        long long, long long, bool, int, std::vector<long long>&,
-       std::vector<DataReaderSparseParam>&, std::vector<std::string>&>(),
+       std::vector<DataReaderSparseParam>&, std::vector<std::string>&, int, bool, bool, int, int, bool, long long, int>(),
 	     pybind11::arg("data_reader_type"),
        pybind11::arg("source"),
        pybind11::arg("eval_source"),
@@ -44,7 +44,15 @@ void ModelPybind(pybind11::module &m) {
        pybind11::arg("num_workers") = 12,
        pybind11::arg("slot_size_array") = std::vector<long long>(),
        pybind11::arg("data_reader_sparse_param_array"),
-       pybind11::arg("sparse_names"));
+       pybind11::arg("sparse_names"),
+       pybind11::arg("prefetch_depth") = 1,
+       pybind11::arg("lock_free_heap") = false,
+       pybind11::arg("use_mmap") = false,
+       pybind11::arg("num_parse_threads") = 1,
+       pybind11::arg("shuffle_buffer_size") = 0,
+       pybind11::arg("shuffle_files") = false,
+       pybind11::arg("shuffle_block_size") = 0,
+       pybind11::arg("async_io_depth") = 0);
   pybind11::class_<HugeCTR::SparseEmbedding, std::shared_ptr<HugeCTR::SparseEmbedding>>(m, "SparseEmbedding")
     .def(pybind11::init<Embedding_t,
        size_t, size_t, int, std::string, std::string, std::vector<size_t>&>(),
@@ -29,7 +29,9 @@ std::unique_ptr<SolverParser> solver_parser_helper(
     bool use_mixed_precision, bool enable_tf32_compute, float scaler, bool i64_input_key,
     bool use_algorithm_search, bool use_cuda_graph, bool repeat_dataset,
     int max_iter, int num_epochs, int display, int snapshot, int eval_interval,
-    bool use_model_oversubscriber, std::string temp_embedding_dir) {
+    bool use_model_oversubscriber, std::string temp_embedding_dir,
+    size_t host_cache_size_in_mb, CachePolicy_t host_cache_policy,
+    StoragePrecision_t temp_embedding_precision) {
   std::unique_ptr<SolverParser> solver_config(new SolverParser());
   solver_config->seed = seed;
   solver_config->max_eval_batches = max_eval_batches;
@@ -49,6 +51,9 @@ std::unique_ptr<SolverParser> solver_parser_helper(
   solver_config->lr_policy = LrPolicy_t::fixed;
   solver_config->use_model_oversubscriber = use_model_oversubscriber;
   solver_config->temp_embedding_dir = temp_embedding_dir;
+  solver_config->host_cache_size_in_mb = host_cache_size_in_mb;
+  solver_config->host_cache_policy = host_cache_policy;
+  solver_config->temp_embedding_precision = temp_embedding_precision;
   solver_config->display = display;
   solver_config->max_iter = repeat_dataset?(max_iter>0?max_iter:10000):0;
   solver_config->num_epochs = repeat_dataset?0:(num_epochs>0?num_epochs:1);
@@ -83,7 +88,10 @@ void SolverParserPybind(pybind11::module& m) {
       .def_readonly("scaler", &HugeCTR::SolverParser::scaler)
       .def_readonly("i64_input_key", &HugeCTR::SolverParser::i64_input_key)
       .def_readonly("use_algorithm_search", &HugeCTR::SolverParser::use_algorithm_search)
-      .def_readonly("use_cuda_graph", &HugeCTR::SolverParser::use_cuda_graph);
+      .def_readonly("use_cuda_graph", &HugeCTR::SolverParser::use_cuda_graph)
+      .def_readonly("host_cache_size_in_mb", &HugeCTR::SolverParser::host_cache_size_in_mb)
+      .def_readonly("host_cache_policy", &HugeCTR::SolverParser::host_cache_policy)
+      .def_readonly("temp_embedding_precision", &HugeCTR::SolverParser::temp_embedding_precision);
   m.def("solver_parser_helper", &HugeCTR::python_lib::solver_parser_helper,
        pybind11::arg("seed") = 0,
        pybind11::arg("max_eval_batches") = 100,
@@ -107,7 +115,10 @@ void SolverParserPybind(pybind11::module& m) {
        pybind11::arg("snapshot") = 10000,
        pybind11::arg("eval_interval") = 1000,
        pybind11::arg("use_model_oversubscriber") = false,
-       pybind11::arg("temp_embedding_dir") = "./");
+       pybind11::arg("temp_embedding_dir") = "./",
+       pybind11::arg("host_cache_size_in_mb") = 0,
+       pybind11::arg("host_cache_policy") = HugeCTR::CachePolicy_t::LRU,
+       pybind11::arg("temp_embedding_precision") = HugeCTR::StoragePrecision_t::FP32);
 }
 
 }  // namespace python_lib
@@ -0,0 +1,99 @@
+/*
+ * Copyright (c) 2020, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "data_readers/byte_sum.hpp"
+#include <cstdint>
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
+namespace HugeCTR {
+
+char byte_sum_scalar(const char* data, size_t size) {
+  char accum = 0;
+  for (size_t i = 0; i < size; i++) {
+    accum += data[i];
+  }
+  return accum;
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+
+namespace {
+
+// _mm_sad_epu8 against zero adds up each group of 8 bytes into a 64-bit lane.
+// Only the lowest 8 bits of the total are needed, so the lanes can't overflow.
+__attribute__((target("sse2"))) char byte_sum_sse2(const char* data, size_t size) {
+  const __m128i zero = _mm_setzero_si128();
+  __m128i accum = _mm_setzero_si128();
+  size_t i = 0;
+  for (; i + 16 <= size; i += 16) {
+    __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+    accum = _mm_add_epi64(accum, _mm_sad_epu8(v, zero));
+  }
+  uint64_t lanes[2];
+  _mm_storeu_si128(reinterpret_cast<__m128i*>(lanes), accum);
+  return static_cast<char>(lanes[0] + lanes[1]) + byte_sum_scalar(data + i, size - i);
+}
+
+__attribute__((target("avx2"))) char byte_sum_avx2(const char* data, size_t size) {
+  const __m256i zero = _mm256_setzero_si256();
+  __m256i accum0 = _mm256_setzero_si256();
+  __m256i accum1 = _mm256_setzero_si256();
+  size_t i = 0;
+  for (; i + 64 <= size; i += 64) {
+    __m256i v0 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i));
+    __m256i v1 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i + 32));
+    accum0 = _mm256_add_epi64(accum0, _mm256_sad_epu8(v0, zero));
+    accum1 = _mm256_add_epi64(accum1, _mm256_sad_epu8(v1, zero));
+  }
+  for (; i + 32 <= size; i += 32) {
+    __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i));
+    accum0 = _mm256_add_epi64(accum0, _mm256_sad_epu8(v, zero));
+  }
+  uint64_t lanes[4];
+  _mm256_storeu_si256(reinterpret_cast<__m256i*>(lanes), _mm256_add_epi64(accum0, accum1));
+  return static_cast<char>(lanes[0] + lanes[1] + lanes[2] + lanes[3]) +
+         byte_sum_scalar(data + i, size - i);
+}
+
+using ByteSumFunc = char (*)(const char*, size_t);
+
+ByteSumFunc select_byte_sum() {
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx2")) {
+    return byte_sum_avx2;
+  }
+  if (__builtin_cpu_supports("sse2")) {
+    return byte_sum_sse2;
+  }
+  return byte_sum_scalar;
+}
+
+}  // namespace
+
+char byte_sum(const char* data, size_t size) {
+  static const ByteSumFunc func = select_byte_sum();
+  return func(data, size);
+}
+
+#else
+
+char byte_sum(const char* data, size_t size) { return byte_sum_scalar(data, size); }
+
+#endif
+
+}  // namespace HugeCTR
@@ -0,0 +1,163 @@
+/*
+ * Copyright (c) 2020, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "data_readers/raw_transform.hpp"
+#include <cmath>
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
+namespace HugeCTR {
+
+namespace {
+
+template <typename T>
+void add_slot_offset_scalar(const int* keys, const T* slot_offset, T* out, size_t n) {
+  for (size_t i = 0; i < n; i++) {
+    out[i] = keys[i] + slot_offset[i];
+  }
+}
+
+void log1p_transform_scalar(const int* in, float* out, size_t n) {
+  for (size_t i = 0; i < n; i++) {
+    out[i] = log(in[i] + 1.f);
+  }
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+
+__attribute__((target("avx2"))) void add_slot_offset_avx2(const int* keys,
+                                                          const long long* slot_offset,
+                                                          long long* out, size_t n) {
+  size_t i = 0;
+  for (; i + 4 <= n; i += 4) {
+    __m256i k = _mm256_cvtepi32_epi64(_mm_loadu_si128(reinterpret_cast<const __m128i*>(keys + i)));
+    __m256i o = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(slot_offset + i));
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i), _mm256_add_epi64(k, o));
+  }
+  add_slot_offset_scalar(keys + i, slot_offset + i, out + i, n - i);
+}
+
+__attribute__((target("avx2"))) void add_slot_offset_avx2(const int* keys,
+                                                          const unsigned int* slot_offset,
+                                                          unsigned int* out, size_t n) {
+  size_t i = 0;
+  for (; i + 8 <= n; i += 8) {
+    __m256i k = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(keys + i));
+    __m256i o = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(slot_offset + i));
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i), _mm256_add_epi32(k, o));
+  }
+  add_slot_offset_scalar(keys + i, slot_offset + i, out + i, n - i);
+}
+
+// natural logarithm of 8 positive normal floats, after the Cephes logf
+__attribute__((target("avx2"))) __m256 log_avx2(__m256 x) {
+  const __m256 one = _mm256_set1_ps(1.f);
+  const __m256 half = _mm256_set1_ps(0.5f);
+  __m256i exponent = _mm256_sub_epi32(_mm256_srli_epi32(_mm256_castps_si256(x), 23),
+                                      _mm256_set1_epi32(0x7f));
+  // mantissa in [0.5, 1)
+  x = _mm256_or_ps(_mm256_and_ps(x, _mm256_castsi256_ps(_mm256_set1_epi32(~0x7f800000))), half);
+  __m256 e = _mm256_add_ps(_mm256_cvtepi32_ps(exponent), one);
+  // if x < sqrt(1/2), use 2x - 1 and e - 1
+  __m256 mask = _mm256_cmp_ps(x, _mm256_set1_ps(0.707106781186547524f), _CMP_LT_OS);
+  __m256 tmp = _mm256_and_ps(x, mask);
+  x = _mm256_sub_ps(x, one);
+  e = _mm256_sub_ps(e, _mm256_and_ps(one, mask));
+  x = _mm256_add_ps(x, tmp);
+
+  __m256 z = _mm256_mul_ps(x, x);
+  __m256 y = _mm256_set1_ps(7.0376836292E-2f);
+  y = _mm256_add_ps(_mm256_mul_ps(y, x), _mm256_set1_ps(-1.1514610310E-1f));
+  y = _mm256_add_ps(_mm256_mul_ps(y, x), _mm256_set1_ps(1.1676998740E-1f));
+  y = _mm256_add_ps(_mm256_mul_ps(y, x), _mm256_set1_ps(-1.2420140846E-1f));
+  y = _mm256_add_ps(_mm256_mul_ps(y, x), _mm256_set1_ps(1.4249322787E-1f));
+  y = _mm256_add_ps(_mm256_mul_ps(y, x), _mm256_set1_ps(-1.6668057665E-1f));
+  y = _mm256_add_ps(_mm256_mul_ps(y, x), _mm256_set1_ps(2.0000714765E-1f));
+  y = _mm256_add_ps(_mm256_mul_ps(y, x), _mm256_set1_ps(-2.4999993993E-1f));
+  y = _mm256_add_ps(_mm256_mul_ps(y, x), _mm256_set1_ps(3.3333331174E-1f));
+  y = _mm256_mul_ps(_mm256_mul_ps(y, x), z);
+  y = _mm256_add_ps(y, _mm256_mul_ps(e, _mm256_set1_ps(-2.12194440e-4f)));
+  y = _mm256_sub_ps(y, _mm256_mul_ps(z, half));
+  x = _mm256_add_ps(x, y);
+  return _mm256_add_ps(x, _mm256_mul_ps(e, _mm256_set1_ps(0.693359375f)));
+}
+
+__attribute__((target("avx2"))) void log1p_transform_avx2(const int* in, float* out, size_t n) {
+  const __m256 one = _mm256_set1_ps(1.f);
+  const __m256 min_normal = _mm256_set1_ps(1.17549435e-38f);
+  size_t i = 0;
+  for (; i + 8 <= n; i += 8) {
+    __m256 x = _mm256_add_ps(
+        _mm256_cvtepi32_ps(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(in + i))), one);
+    // non-positive inputs take the scalar path to get the same -inf and NaN as std::log
+    if (_mm256_movemask_ps(_mm256_cmp_ps(x, min_normal, _CMP_LT_OQ)) != 0) {
+      log1p_transform_scalar(in + i, out + i, 8);
+    } else {
+      _mm256_storeu_ps(out + i, log_avx2(x));
+    }
+  }
+  log1p_transform_scalar(in + i, out + i, n - i);
+}
+
+bool has_avx2() {
+  __builtin_cpu_init();
+  return __builtin_cpu_supports("avx2");
+}
+
+#else
+
+bool has_avx2() { return false; }
+
+#endif
+
+}  // namespace
+
+void add_slot_offset(const int* keys, const long long* slot_offset, long long* out, size_t n) {
+  static const bool avx2 = has_avx2();
+#if defined(__x86_64__) || defined(__i386__)
+  if (avx2) {
+    add_slot_offset_avx2(keys, slot_offset, out, n);
+    return;
+  }
+#endif
+  add_slot_offset_scalar(keys, slot_offset, out, n);
+}
+
+void add_slot_offset(const int* keys, const unsigned int* slot_offset, unsigned int* out,
+                     size_t n) {
+  static const bool avx2 = has_avx2();
+#if defined(__x86_64__) || defined(__i386__)
+  if (avx2) {
+    add_slot_offset_avx2(keys, slot_offset, out, n);
+    return;
+  }
+#endif
+  add_slot_offset_scalar(keys, slot_offset, out, n);
+}
+
+void log1p_transform(const int* in, float* out, size_t n) {
+  static const bool avx2 = has_avx2();
+#if defined(__x86_64__) || defined(__i386__)
+  if (avx2) {
+    log1p_transform_avx2(in, out, n);
+    return;
+  }
+#endif
+  log1p_transform_scalar(in, out, n);
+}
+
+}  // namespace HugeCTR
@@ -164,6 +164,11 @@ DistributedSlotSparseEmbeddingHash<TypeHashKey, TypeEmbeddingComp>::
         buf->reserve({1, Base::get_batch_size(true) * Base::get_max_feature_num()}, &tensor);
         hash_value_flag_sumed_tensors_.push_back(tensor);
       }
+      {
+        Tensor2<char> tensor;
+        buf->reserve({1, max_vocabulary_size_per_gpu_}, &tensor);
+        dirty_flag_tensors_.push_back(tensor);
+      }
       {
         Tensor2<uint32_t> tensor;
         buf->reserve({1, 1}, &tensor);
@@ -217,6 +222,10 @@ DistributedSlotSparseEmbeddingHash<TypeHashKey, TypeEmbeddingComp>::
     for (size_t id = 0; id < Base::get_resource_manager().get_local_gpu_count(); id++) {
       context.set_device(Base::get_local_gpu(id).get_device_id());
 
+      CK_CUDA_THROW_(cudaMemsetAsync(dirty_flag_tensors_[id].get_ptr(), 0,
+                                     dirty_flag_tensors_[id].get_size_in_bytes(),
+                                     Base::get_local_gpu(id).get_stream()));
+
       const OptParams<TypeEmbeddingComp> &source_opt_param = Base::get_opt_params();
       OptParams<TypeEmbeddingComp> &target_opt_param = Base::get_opt_params(id);
 
@@ -596,6 +605,28 @@ void DistributedSlotSparseEmbeddingHash<TypeHashKey, TypeEmbeddingComp>::dump_pa
                   hash_table_value_tensors_, hash_tables_);
 }
 
+template <typename TypeHashKey, typename TypeEmbeddingComp>
+void DistributedSlotSparseEmbeddingHash<TypeHashKey, TypeEmbeddingComp>::dump_dirty_parameters(
+    BufferBag &buf_bag, size_t *num) {
+  if (Base::get_update_type() == Update_t::Global) {
+    dump_parameters(buf_bag, num);
+    return;
+  }
+  Tensor2<float> &embeddings = buf_bag.embedding;
+  Tensor2<TypeHashKey> keys = Tensor2<TypeHashKey>::stretch_from(buf_bag.keys);
+  dump_parameters(keys, embeddings, num, max_vocabulary_size_, Base::get_embedding_vec_size(),
+                  hash_table_value_tensors_, hash_tables_, &dirty_flag_tensors_);
+
+  CudaDeviceContext context;
+  for (size_t id = 0; id < Base::get_resource_manager().get_local_gpu_count(); id++) {
+    context.set_device(Base::get_local_gpu(id).get_device_id());
+    CK_CUDA_THROW_(cudaMemsetAsync(dirty_flag_tensors_[id].get_ptr(), 0,
+                                   dirty_flag_tensors_[id].get_size_in_bytes(),
+                                   Base::get_local_gpu(id).get_stream()));
+  }
+  functors_.sync_all_gpus(Base::get_resource_manager());
+}
+
 template <typename TypeHashKey, typename TypeEmbeddingComp>
 void DistributedSlotSparseEmbeddingHash<TypeHashKey, TypeEmbeddingComp>::dump_parameters(
     std::ofstream &weight_stream, size_t vocabulary_size, size_t embedding_vec_size,
@@ -772,7 +803,8 @@ template <typename TypeHashKey, typename TypeEmbeddingComp>
 void DistributedSlotSparseEmbeddingHash<TypeHashKey, TypeEmbeddingComp>::dump_parameters(
     Tensor2<TypeHashKey> &keys, Tensor2<float> &embeddings, size_t *num, size_t vocabulary_size,
     size_t embedding_vec_size, const Tensors2<float> &embedding_tensors,
-    const std::vector<std::shared_ptr<HashTable<TypeHashKey, size_t>>> &hash_tables) const {
+    const std::vector<std::shared_ptr<HashTable<TypeHashKey, size_t>>> &hash_tables,
+    const Tensors2<char> *dirty_flag_tensors) const {
   TypeHashKey *key_ptr = keys.get_ptr();
   float *embedding_ptr = embeddings.get_ptr();
 
@@ -808,6 +840,11 @@ void DistributedSlotSparseEmbeddingHash<TypeHashKey, TypeEmbeddingComp>::dump_pa
   std::unique_ptr<float *[]> h_hash_table_value(new float *[local_gpu_count]);
   std::unique_ptr<float *[]> d_hash_table_value(new float *[local_gpu_count]);
   std::unique_ptr<size_t *[]> d_dump_counter(new size_t *[local_gpu_count]);
+  std::unique_ptr<TypeHashKey *[]> d_dirty_key(new TypeHashKey *[local_gpu_count]);
+  std::unique_ptr<size_t *[]> d_dirty_value_index(new size_t *[local_gpu_count]);
+  std::unique_ptr<size_t *[]> d_num_dirty(new size_t *[local_gpu_count]);
+  // count[] is reduced to the dirty rows below
+  std::vector<size_t> alloc_count(count.get(), count.get() + local_gpu_count);
   for (size_t id = 0; id < local_gpu_count; id++) {
     if (count[id] == 0) {
       continue;
@@ -821,6 +858,11 @@ void DistributedSlotSparseEmbeddingHash<TypeHashKey, TypeEmbeddingComp>::dump_pa
     CK_CUDA_THROW_(cudaMallocHost(&h_hash_table_value[id], count[id] * embedding_vec_size * sizeof(float)));
     CK_CUDA_THROW_(cudaMalloc(&d_hash_table_value[id], count[id] * embedding_vec_size * sizeof(float)));
     CK_CUDA_THROW_(cudaMalloc(&d_dump_counter[id], count[id] * sizeof(size_t)));
+    if (dirty_flag_tensors != nullptr) {
+      CK_CUDA_THROW_(cudaMalloc(&d_dirty_key[id], count[id] * sizeof(TypeHashKey)));
+      CK_CUDA_THROW_(cudaMalloc(&d_dirty_value_index[id], count[id] * sizeof(size_t)));
+      CK_CUDA_THROW_(cudaMalloc(&d_num_dirty[id], sizeof(size_t)));
+    }
   }
 
   // dump hash table from GPUs
@@ -836,6 +878,19 @@ void DistributedSlotSparseEmbeddingHash<TypeHashKey, TypeEmbeddingComp>::dump_pa
     hash_tables[id]->dump(d_hash_table_key[id], d_hash_table_value_index[id], d_dump_counter[id],
                           Base::get_local_gpu(id).get_stream());
 
+    if (dirty_flag_tensors != nullptr) {
+      // only the rows updated since the last dump are downloaded
+      functors_.select_dirty(count[id], (*dirty_flag_tensors)[id].get_ptr(), d_hash_table_key[id],
+                             d_hash_table_value_index[id], d_dirty_key[id],
+                             d_dirty_value_index[id], d_num_dirty[id],
+                             Base::get_local_gpu(id).get_stream());
+      CK_CUDA_THROW_(cudaMemcpyAsync(&count[id], d_num_dirty[id], sizeof(size_t),
+                                     cudaMemcpyDeviceToHost, Base::get_local_gpu(id).get_stream()));
+      CK_CUDA_THROW_(cudaStreamSynchronize(Base::get_local_gpu(id).get_stream()));
+      std::swap(d_hash_table_key[id], d_dirty_key[id]);
+      std::swap(d_hash_table_value_index[id], d_dirty_value_index[id]);
+    }
+
     CK_CUDA_THROW_(cudaMemcpyAsync(h_hash_table_key[id], d_hash_table_key[id],
                                    count[id] * sizeof(TypeHashKey), cudaMemcpyDeviceToHost,
                                    Base::get_local_gpu(id).get_stream()));
@@ -875,7 +930,7 @@ void DistributedSlotSparseEmbeddingHash<TypeHashKey, TypeEmbeddingComp>::dump_pa
   // MESSAGE_("Done");
 
   for (size_t id = 0; id < local_gpu_count; id++) {
-    if (count[id] == 0) {
+    if (alloc_count[id] == 0) {
       continue;
     }
 
@@ -887,6 +942,11 @@ void DistributedSlotSparseEmbeddingHash<TypeHashKey, TypeEmbeddingComp>::dump_pa
     CK_CUDA_THROW_(cudaFreeHost(h_hash_table_value[id]));
     CK_CUDA_THROW_(cudaFree(d_hash_table_value[id]));
     CK_CUDA_THROW_(cudaFree(d_dump_counter[id]));
+    if (dirty_flag_tensors != nullptr) {
+      CK_CUDA_THROW_(cudaFree(d_dirty_key[id]));
+      CK_CUDA_THROW_(cudaFree(d_dirty_value_index[id]));
+      CK_CUDA_THROW_(cudaFree(d_num_dirty[id]));
+    }
   }
 
   return;
@@ -991,6 +1051,9 @@ void DistributedSlotSparseEmbeddingHash<TypeHashKey, TypeEmbeddingComp>::reset()
   for (size_t i = 0; i < Base::get_resource_manager().get_local_gpu_count(); i++) {
     context.set_device(Base::get_local_gpu(i).get_device_id());
     hash_tables_[i]->clear(Base::get_local_gpu(i).get_stream());
+    CK_CUDA_THROW_(cudaMemsetAsync(dirty_flag_tensors_[i].get_ptr(), 0,
+                                   dirty_flag_tensors_[i].get_size_in_bytes(),
+                                   Base::get_local_gpu(i).get_stream()));
     HugeCTR::UniformGenerator::fill(hash_table_value_tensors_[i], -0.05f, 0.05f,
                                     Base::get_local_gpu(i).get_sm_count(),
                                     Base::get_local_gpu(i).get_replica_variant_curand_generator(),
@@ -56,6 +56,32 @@ __global__ void get_hash_value_kernel(long long count, int embedding_vec_size,
   }
 }
 
+// flag the rows of value_index
+__global__ void mark_dirty_kernel(size_t nnz, const size_t *value_index, char *dirty_flags) {
+  size_t gid = blockIdx.x * blockDim.x + threadIdx.x;
+
+  if (gid < nnz) {
+    dirty_flags[value_index[gid]] = 1;
+  }
+}
+
+// compact the keys and value_index of the flagged rows
+template <typename TypeHashKey>
+__global__ void select_dirty_kernel(size_t count, const char *dirty_flags, const TypeHashKey *keys,
+                                    const size_t *value_index, TypeHashKey *dirty_keys,
+                                    size_t *dirty_value_index, size_t *num_dirty) {
+  size_t gid = blockIdx.x * blockDim.x + threadIdx.x;
+
+  if (gid < count) {
+    size_t index = value_index[gid];
+    if (dirty_flags[index]) {
+      size_t pos = atomicAdd(reinterpret_cast<unsigned long long *>(num_dirty), 1ull);
+      dirty_keys[pos] = keys[gid];
+      dirty_value_index[pos] = index;
+    }
+  }
+}
+
 }  // namespace
 
 template <typename Type>
@@ -86,6 +112,33 @@ void SparseEmbeddingFunctors::get_hash_value(size_t count, size_t embedding_vec_
       count, embedding_vec_size, value_index, hash_table_value, value_retrieved);
 }
 
+void SparseEmbeddingFunctors::mark_dirty(size_t nnz, const size_t *value_index, char *dirty_flags,
+                                         cudaStream_t stream) const {
+  if (nnz == 0) {
+    return;
+  }
+  const size_t block_size = 256;
+  const size_t grid_size = (nnz + block_size - 1) / block_size;
+
+  mark_dirty_kernel<<<grid_size, block_size, 0, stream>>>(nnz, value_index, dirty_flags);
+}
+
+template <typename TypeHashKey>
+void SparseEmbeddingFunctors::select_dirty(size_t count, const char *dirty_flags,
+                                           const TypeHashKey *keys, const size_t *value_index,
+                                           TypeHashKey *dirty_keys, size_t *dirty_value_index,
+                                           size_t *num_dirty, cudaStream_t stream) const {
+  CK_CUDA_THROW_(cudaMemsetAsync(num_dirty, 0, sizeof(size_t), stream));
+  if (count == 0) {
+    return;
+  }
+  const size_t block_size = 256;
+  const size_t grid_size = (count + block_size - 1) / block_size;
+
+  select_dirty_kernel<<<grid_size, block_size, 0, stream>>>(
+      count, dirty_flags, keys, value_index, dirty_keys, dirty_value_index, num_dirty);
+}
+
 template void SparseEmbeddingFunctors::memset_liner<unsigned int>(unsigned int *data,
                                                                   unsigned int start_value,
                                                                   unsigned int stride_value,
@@ -101,4 +154,14 @@ template void SparseEmbeddingFunctors::memset_liner<size_t>(size_t *data, size_t
                                                             size_t stride_value, size_t n,
                                                             cudaStream_t stream) const;
 
+template void SparseEmbeddingFunctors::select_dirty<unsigned int>(
+    size_t count, const char *dirty_flags, const unsigned int *keys, const size_t *value_index,
+    unsigned int *dirty_keys, size_t *dirty_value_index, size_t *num_dirty,
+    cudaStream_t stream) const;
+
+template void SparseEmbeddingFunctors::select_dirty<long long>(
+    size_t count, const char *dirty_flags, const long long *keys, const size_t *value_index,
+    long long *dirty_keys, size_t *dirty_value_index, size_t *num_dirty,
+    cudaStream_t stream) const;
+
 }  // namespace HugeCTR
\ No newline at end of file
@@ -15,6 +15,7 @@
  */
 
 #include <inference/embedding_cache.hpp>
+#include <algorithm>
 
 namespace HugeCTR {
 
@@ -166,6 +167,34 @@ embedding_cache<TypeHashKey>::embedding_cache(HugectrUtility<TypeHashKey>* param
       gpu_emb_caches_.emplace_back(new cache_(cache_config_.num_set_in_cache_[i], cache_config_.embedding_vec_size_[i]));
     }
 
+    // Create the stream, the events and the buffers of invalidate_, and free those created if one
+    // of them fails
+    const size_t max_embedding_vec_size = *std::max_element(cache_config_.embedding_vec_size_.begin(), cache_config_.embedding_vec_size_.end());
+    try{
+      CK_CUDA_THROW_(cudaStreamCreate(&refresh_stream_));
+      for(unsigned int i = 0; i < cache_config_.num_emb_table_; i++){
+        cudaEvent_t replace_event;
+        CK_CUDA_THROW_(cudaEventCreateWithFlags(&replace_event, cudaEventDisableTiming));
+        replace_events_.push_back(replace_event);
+      }
+      CK_CUDA_THROW_(cudaMalloc((void**)&d_refresh_keys_, REFRESH_BATCH_SIZE_ * sizeof(TypeHashKey)));
+      CK_CUDA_THROW_(cudaHostAlloc((void**)&h_refresh_keys_, REFRESH_BATCH_SIZE_ * sizeof(TypeHashKey), cudaHostAllocPortable));
+      CK_CUDA_THROW_(cudaMalloc((void**)&d_refresh_vals_, REFRESH_BATCH_SIZE_ * max_embedding_vec_size * sizeof(float)));
+      CK_CUDA_THROW_(cudaHostAlloc((void**)&h_refresh_vals_, REFRESH_BATCH_SIZE_ * max_embedding_vec_size * sizeof(float), cudaHostAllocPortable));
+      CK_CUDA_THROW_(cudaMalloc((void**)&d_dump_counter_, sizeof(size_t)));
+      CK_CUDA_THROW_(cudaHostAlloc((void**)&h_dump_counter_, sizeof(size_t), cudaHostAllocPortable));
+    }
+    catch(...){
+      free_refresh_resources_();
+      throw;
+    }
+
+    // Keep the cached emb_vec coherent with the parameter server when the model is updated
+    invalidation_callback_id_ = parameter_server_ -> register_invalidation_callback(cache_config_.model_name_, 
+        [this](size_t embedding_table_id, const TypeHashKey* keys, size_t length){
+          invalidate_(embedding_table_id, keys, length);
+        });
+
   }
   
 }
@@ -174,10 +203,13 @@ template <typename TypeHashKey>
 embedding_cache<TypeHashKey>::~embedding_cache(){
   // Destruct gpu embedding cache
   if(cache_config_.use_gpu_embedding_cache_){
+    // Wait for the invalidation in progress, if any
+    parameter_server_ -> unregister_invalidation_callback(invalidation_callback_id_);
     // Device Restorer
     CudaDeviceContext dev_restorer;
     // Set CUDA device before destructing gpu embedding cache
     cudaSetDevice(cache_config_.cuda_dev_id_);
+    free_refresh_resources_();
     for(unsigned int i = 0; i < cache_config_.num_emb_table_; i++){
       delete gpu_emb_caches_[i];
     }
@@ -217,6 +249,9 @@ void embedding_cache<TypeHashKey>::look_up(const void* h_embeddingcolumns,
     // Set CUDA device before doing look up
     CK_CUDA_THROW_(cudaSetDevice(cache_config_.cuda_dev_id_));
 
+    // The missing emb_vec read from the parameter server after this are up to date
+    workspace_handler.invalidation_epoch_ = invalidation_epoch_.load();
+
     // Copy the shuffled embeddingcolumns buffer to device
     CK_CUDA_THROW_(cudaMemcpyAsync(workspace_handler.d_shuffled_embeddingcolumns_, 
                                    workspace_handler.h_shuffled_embeddingcolumns_, 
@@ -374,20 +409,110 @@ void embedding_cache<TypeHashKey>::update(embedding_cache_workspace& workspace_h
     CudaDeviceContext dev_restorer;
     // Set CUDA device before doing update
     CK_CUDA_THROW_(cudaSetDevice(cache_config_.cuda_dev_id_));
+    // The missing emb_vec may be older than the parameter server, which invalidate_ refreshes
+    // only in the cache
+    std::shared_lock<std::shared_timed_mutex> lock(invalidation_mutex_);
+    if(workspace_handler.invalidation_epoch_ != invalidation_epoch_.load()){
+      return;
+    }
+    // The Replace of a table run one after another across the streams, so that its event is
+    // recorded after all of them
+    std::lock_guard<std::mutex> replace_lock(replace_mutex_);
     size_t acc_emb_vec_offset = 0;
     for(unsigned int i = 0; i < cache_config_.num_emb_table_; i++){
       TypeHashKey* d_missing_key_ptr = (TypeHashKey*)(workspace_handler.d_missing_embeddingcolumns_) + workspace_handler.h_shuffled_embedding_offset_[i];
       float* d_vals_retrieved_ptr = workspace_handler.d_missing_emb_vec_ + acc_emb_vec_offset;
       size_t query_length = workspace_handler.h_shuffled_embedding_offset_[i + 1] - workspace_handler.h_shuffled_embedding_offset_[i];
       acc_emb_vec_offset += query_length * cache_config_.embedding_vec_size_[i];
+      CK_CUDA_THROW_(cudaStreamWaitEvent(streams[i], replace_events_[i], 0));
       gpu_emb_caches_[i] -> Replace(d_missing_key_ptr, 
                                     workspace_handler.h_missing_length_[i], 
                                     d_vals_retrieved_ptr, 
                                     streams[i]);
+      CK_CUDA_THROW_(cudaEventRecord(replace_events_[i], streams[i]));
+    }
+  }
+}
+
+template <typename TypeHashKey>
+void embedding_cache<TypeHashKey>::invalidate_(size_t embedding_table_id, 
+                                               const TypeHashKey* keys, 
+                                               size_t length){
+  // The look_up in progress will not update the cache with what they read from the parameter
+  // server before the invalidation
+  {
+    std::unique_lock<std::shared_timed_mutex> lock(invalidation_mutex_);
+    invalidation_epoch_++;
+  }
+
+  // Device Restorer
+  CudaDeviceContext dev_restorer;
+  // Set CUDA device before doing invalidation
+  CK_CUDA_THROW_(cudaSetDevice(cache_config_.cuda_dev_id_));
+  // And the refresh waits for the updates issued before, so that the emb_vec refreshed are not
+  // overwritten. The streams of the look_up are not stalled
+  CK_CUDA_THROW_(cudaStreamWaitEvent(refresh_stream_, replace_events_[embedding_table_id], 0));
+
+  cache_* cache = gpu_emb_caches_[embedding_table_id];
+  const size_t embedding_vec_size = cache_config_.embedding_vec_size_[embedding_table_id];
+  cudaStream_t stream = refresh_stream_;
+  TypeHashKey* d_keys = d_refresh_keys_;
+  TypeHashKey* h_keys = h_refresh_keys_;
+  float* d_vals = d_refresh_vals_;
+  float* h_vals = h_refresh_vals_;
+  size_t* d_dump_counter = d_dump_counter_;
+  size_t* h_dump_counter = h_dump_counter_;
+
+  // Overwrite the emb_vec of the keys (on host) which are in the cache with those of the
+  // parameter server
+  auto refresh = [&](const TypeHashKey* h_refresh_keys, size_t refresh_len){
+    parameter_server_ -> look_up(h_refresh_keys, refresh_len, h_vals, cache_config_.model_name_, embedding_table_id);
+    CK_CUDA_THROW_(cudaMemcpyAsync(d_keys, h_refresh_keys, refresh_len * sizeof(TypeHashKey), cudaMemcpyHostToDevice, stream));
+    CK_CUDA_THROW_(cudaMemcpyAsync(d_vals, h_vals, refresh_len * embedding_vec_size * sizeof(float), cudaMemcpyHostToDevice, stream));
+    cache -> Update(d_keys, refresh_len, d_vals, stream);
+    CK_CUDA_THROW_(cudaStreamSynchronize(stream));
+  };
+
+  if(keys){
+    // Only the keys which changed, most of them likely not in the cache
+    for(size_t begin = 0; begin < length; begin += REFRESH_BATCH_SIZE_){
+      refresh(keys + begin, std::min(REFRESH_BATCH_SIZE_, length - begin));
+    }
+  }
+  else{
+    // All the keys in the cache, a few slabsets at a time
+    const size_t num_set_per_batch = REFRESH_BATCH_SIZE_ / (SET_ASSOCIATIVITY * SLAB_SIZE);
+    const size_t num_set = cache -> get_capacity_in_set();
+    for(size_t start_set = 0; start_set < num_set; start_set += num_set_per_batch){
+      const size_t end_set = std::min(start_set + num_set_per_batch, num_set);
+      CK_CUDA_THROW_(cudaMemsetAsync(d_dump_counter, 0, sizeof(size_t), stream));
+      cache -> Dump(d_keys, d_dump_counter, start_set, end_set, stream);
+      CK_CUDA_THROW_(cudaMemcpyAsync(h_dump_counter, d_dump_counter, sizeof(size_t), cudaMemcpyDeviceToHost, stream));
+      CK_CUDA_THROW_(cudaStreamSynchronize(stream));
+      CK_CUDA_THROW_(cudaMemcpyAsync(h_keys, d_keys, *h_dump_counter * sizeof(TypeHashKey), cudaMemcpyDeviceToHost, stream));
+      CK_CUDA_THROW_(cudaStreamSynchronize(stream));
+      refresh(h_keys, *h_dump_counter);
     }
   }
 }
 
+template <typename TypeHashKey>
+void embedding_cache<TypeHashKey>::free_refresh_resources_(){
+  // cudaFree and cudaFreeHost do nothing on nullptr
+  cudaFreeHost(h_dump_counter_);
+  cudaFree(d_dump_counter_);
+  cudaFreeHost(h_refresh_vals_);
+  cudaFree(d_refresh_vals_);
+  cudaFreeHost(h_refresh_keys_);
+  cudaFree(d_refresh_keys_);
+  for(cudaEvent_t replace_event : replace_events_){
+    cudaEventDestroy(replace_event);
+  }
+  if(refresh_stream_){
+    cudaStreamDestroy(refresh_stream_);
+  }
+}
+
 template <typename TypeHashKey>
 void embedding_cache<TypeHashKey>::create_workspace(embedding_cache_workspace& workspace_handler){
   size_t max_query_len_per_batch = 0;
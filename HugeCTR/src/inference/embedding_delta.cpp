@@ -0,0 +1,143 @@
+/*
+ * Copyright (c) 2020, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <inference/embedding_delta.hpp>
+#include <model_oversubscriber/file_descriptor.hpp>
+#include <cstring>
+#include <iostream>
+
+namespace HugeCTR {
+
+template <typename TypeHashKey>
+const char embedding_delta<TypeHashKey>::MAGIC[8] = {'H', 'C', 'T', 'R', 'D', 'L', 'T', '\0'};
+template <typename TypeHashKey>
+const uint32_t embedding_delta<TypeHashKey>::VERSION;
+
+template <typename TypeHashKey>
+embedding_delta<TypeHashKey>::embedding_delta(size_t embedding_vec_size)
+    : embedding_vec_size_(embedding_vec_size) {}
+
+template <typename TypeHashKey>
+embedding_delta<TypeHashKey>::embedding_delta(const std::string& file_name,
+                                              size_t embedding_vec_size)
+    : embedding_vec_size_(embedding_vec_size) {
+  try {
+    FileDescriptor file(file_name, O_RDONLY);
+    const size_t file_size = file.size();
+    embedding_delta_header header;
+    if (file_size < sizeof(header)) {
+      CK_THROW_(Error_t::BrokenFile, "Not a delta file: " + file_name);
+    }
+    file.pread_full(reinterpret_cast<char*>(&header), sizeof(header), 0);
+    if (memcmp(header.magic, MAGIC, sizeof(MAGIC))) {
+      CK_THROW_(Error_t::BrokenFile, "Not a delta file: " + file_name);
+    }
+    if (header.version != VERSION) {
+      CK_THROW_(Error_t::UnSupportedFormat,
+                "Unsupported delta file version " + std::to_string(header.version));
+    }
+    if (header.key_size_in_byte != sizeof(TypeHashKey) ||
+        header.embedding_vec_size != embedding_vec_size_) {
+      CK_THROW_(Error_t::WrongInput,
+                "Error: the delta file " + file_name + " doesn't match the embedding table");
+    }
+    const size_t vector_size_in_byte = sizeof(float) * embedding_vec_size_;
+    const size_t row_size = sizeof(TypeHashKey) + vector_size_in_byte;
+    const size_t upserts_size_in_byte = header.num_upserts * row_size;
+    const size_t deletes_size_in_byte = header.num_deletes * sizeof(TypeHashKey);
+    if (header.num_upserts > file_size / row_size ||
+        header.num_deletes > file_size / sizeof(TypeHashKey) ||
+        sizeof(header) + upserts_size_in_byte + deletes_size_in_byte != file_size) {
+      CK_THROW_(Error_t::BrokenFile, "Truncated or inconsistent delta file: " + file_name);
+    }
+
+    // A delta is as large as the change, so it is read at once
+    std::vector<char> rows(upserts_size_in_byte);
+    file.pread_full(rows.data(), upserts_size_in_byte, sizeof(header));
+    upsert_keys_.resize(header.num_upserts);
+    upsert_vectors_.resize(header.num_upserts * embedding_vec_size_);
+    const char* src = rows.data();
+    for (size_t row = 0; row < header.num_upserts; row++, src += row_size) {
+      memcpy(&upsert_keys_[row], src, sizeof(TypeHashKey));
+      memcpy(&upsert_vectors_[row * embedding_vec_size_], src + sizeof(TypeHashKey),
+             vector_size_in_byte);
+    }
+    delete_keys_.resize(header.num_deletes);
+    file.pread_full(reinterpret_cast<char*>(delete_keys_.data()), deletes_size_in_byte,
+                    sizeof(header) + upserts_size_in_byte);
+  } catch (const internal_runtime_error& rt_err) {
+    std::cerr << rt_err.what() << std::endl;
+    throw;
+  } catch (const std::exception& err) {
+    std::cerr << err.what() << std::endl;
+    throw;
+  }
+}
+
+template <typename TypeHashKey>
+void embedding_delta<TypeHashKey>::upsert(TypeHashKey key, const float* embedding_vector) {
+  upsert_keys_.push_back(key);
+  upsert_vectors_.insert(upsert_vectors_.end(), embedding_vector,
+                         embedding_vector + embedding_vec_size_);
+}
+
+template <typename TypeHashKey>
+void embedding_delta<TypeHashKey>::erase(TypeHashKey key) {
+  delete_keys_.push_back(key);
+}
+
+template <typename TypeHashKey>
+void embedding_delta<TypeHashKey>::write(const std::string& file_name) const {
+  try {
+    embedding_delta_header header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, MAGIC, sizeof(MAGIC));
+    header.version = VERSION;
+    header.key_size_in_byte = sizeof(TypeHashKey);
+    header.embedding_vec_size = embedding_vec_size_;
+    header.num_upserts = upsert_keys_.size();
+    header.num_deletes = delete_keys_.size();
+
+    const size_t vector_size_in_byte = sizeof(float) * embedding_vec_size_;
+    const size_t row_size = sizeof(TypeHashKey) + vector_size_in_byte;
+    std::vector<char> buffer(sizeof(header) + upsert_keys_.size() * row_size +
+                             delete_keys_.size() * sizeof(TypeHashKey));
+    char* dst = buffer.data();
+    memcpy(dst, &header, sizeof(header));
+    dst += sizeof(header);
+    for (size_t row = 0; row < upsert_keys_.size(); row++, dst += row_size) {
+      memcpy(dst, &upsert_keys_[row], sizeof(TypeHashKey));
+      memcpy(dst + sizeof(TypeHashKey), &upsert_vectors_[row * embedding_vec_size_],
+             vector_size_in_byte);
+    }
+    if (!delete_keys_.empty()) {
+      memcpy(dst, delete_keys_.data(), delete_keys_.size() * sizeof(TypeHashKey));
+    }
+
+    FileDescriptor file(file_name, O_WRONLY | O_CREAT | O_TRUNC);
+    file.pwrite_full(buffer.data(), buffer.size(), 0);
+  } catch (const internal_runtime_error& rt_err) {
+    std::cerr << rt_err.what() << std::endl;
+    throw;
+  } catch (const std::exception& err) {
+    std::cerr << err.what() << std::endl;
+    throw;
+  }
+}
+
+template class embedding_delta<unsigned int>;
+template class embedding_delta<long long>;
+}  // namespace HugeCTR
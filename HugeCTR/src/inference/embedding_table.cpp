@@ -0,0 +1,300 @@
+/*
+ * Copyright (c) 2020, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <inference/embedding_table.hpp>
+#include <model_oversubscriber/indexed_snapshot.hpp>
+#include <model_oversubscriber/file_descriptor.hpp>
+#include <model_oversubscriber/parallel_for_each.hpp>
+#include <omp.h>
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+#include <vector>
+#include <sys/mman.h>
+
+namespace HugeCTR {
+
+template <typename TypeHashKey>
+cpu_embedding_table<TypeHashKey>::cpu_embedding_table(const std::string& file_name,
+                                                      size_t embedding_vec_size,
+                                                      bool has_slot_id,
+                                                      float default_emb_vec_value)
+    : embedding_vec_size_(embedding_vec_size),
+      default_vector_(embedding_vec_size, default_emb_vec_value) {
+  try {
+    if (IndexedSnapshot<TypeHashKey>::is_indexed_snapshot(file_name)) {
+      map_(file_name, has_slot_id);
+    } else {
+      load_(file_name, has_slot_id);
+    }
+  } catch (const std::exception& err) {
+    std::cerr << err.what() << std::endl;
+    if (mapping_) {
+      munmap(mapping_, mapping_size_in_byte_);
+    }
+    throw;
+  }
+}
+
+template <typename TypeHashKey>
+cpu_embedding_table<TypeHashKey>::cpu_embedding_table(
+    std::shared_ptr<const cpu_embedding_table> table, const embedding_delta<TypeHashKey>& delta)
+    : embedding_vec_size_(table->embedding_vec_size_),
+      base_(table->base_ ? table->base_ : table),
+      default_vector_(table->default_vector_) {
+  try {
+    if (delta.get_embedding_vec_size() != embedding_vec_size_) {
+      CK_THROW_(Error_t::WrongInput, "Error: the delta doesn't match the embedding table");
+    }
+    apply_(*table, delta);
+  } catch (const std::exception& err) {
+    std::cerr << err.what() << std::endl;
+    if (mapping_) {
+      munmap(mapping_, mapping_size_in_byte_);
+    }
+    throw;
+  }
+}
+
+template <typename TypeHashKey>
+cpu_embedding_table<TypeHashKey>::~cpu_embedding_table() {
+  if (mapping_) {
+    munmap(mapping_, mapping_size_in_byte_);
+  }
+}
+
+template <typename TypeHashKey>
+float* cpu_embedding_table<TypeHashKey>::allocate_(size_t num_rows) {
+  if (num_rows == 0) {
+    return nullptr;
+  }
+  // An anonymous mapping takes no memory until it is written, and may use huge pages
+  mapping_size_in_byte_ = num_rows * sizeof(float) * embedding_vec_size_;
+  mapping_ = mmap(NULL, mapping_size_in_byte_, PROT_READ | PROT_WRITE,
+                  MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (mapping_ == MAP_FAILED) {
+    mapping_ = nullptr;
+    CK_THROW_(Error_t::OutOfMemory, "Cannot allocate an embedding table of " +
+                                        std::to_string(num_rows) + " rows");
+  }
+#ifdef MADV_HUGEPAGE
+  madvise(mapping_, mapping_size_in_byte_, MADV_HUGEPAGE);
+#endif
+  return static_cast<float*>(mapping_);
+}
+
+template <typename TypeHashKey>
+void cpu_embedding_table<TypeHashKey>::load_(const std::string& file_name, bool has_slot_id) {
+  FileDescriptor file(file_name, O_RDONLY);
+  const size_t file_size = file.size();
+  const size_t vector_size_in_byte = sizeof(float) * embedding_vec_size_;
+  const size_t row_size =
+      sizeof(TypeHashKey) + (has_slot_id ? sizeof(size_t) : 0) + vector_size_in_byte;
+  if (file_size % row_size != 0) {
+    CK_THROW_(Error_t::WrongInput, "Error: embeddings file size is not correct");
+  }
+  const size_t num_rows = file_size / row_size;
+  float* values = allocate_(num_rows);
+
+  // The blocks of rows are split into keys and vectors in parallel
+  std::vector<TypeHashKey> keys(num_rows);
+  const size_t block_rows = std::max<size_t>(1, BLOCK_SIZE_IN_BYTE_ / row_size);
+  const size_t num_blocks = (num_rows + block_rows - 1) / block_rows;
+  std::vector<std::vector<char>> buffers(omp_get_max_threads());
+  parallel_for_each(num_blocks, omp_get_max_threads(), [&](size_t block) {
+    const size_t begin = block * block_rows;
+    const size_t end = std::min(begin + block_rows, num_rows);
+    std::vector<char>& rows = buffers[omp_get_thread_num()];
+    rows.resize(block_rows * row_size);
+    file.pread_full(rows.data(), (end - begin) * row_size, begin * row_size);
+    const char* src = rows.data();
+    for (size_t row = begin; row < end; row++, src += row_size) {
+      memcpy(&keys[row], src, sizeof(TypeHashKey));
+      memcpy(values + row * embedding_vec_size_, src + row_size - vector_size_in_byte,
+             vector_size_in_byte);
+    }
+  });
+
+  // The index is built in the order of the file, so that the first row of a key wins
+  const size_t prefetch_distance = 8;
+  index_.reserve(num_rows);
+  for (size_t row = 0; row < num_rows; row++) {
+    if (row + prefetch_distance < num_rows) {
+      index_.prefetch(keys[row + prefetch_distance]);
+    }
+    index_.insert(keys[row], 0, row);
+  }
+
+  values_ = values;
+  num_rows_ = num_rows;
+  index_ctrl_ = index_.get_ctrl();
+  index_entries_ = index_.get_entries();
+  index_capacity_ = index_.capacity();
+  size_ = index_.size();
+}
+
+template <typename TypeHashKey>
+void cpu_embedding_table<TypeHashKey>::map_(const std::string& file_name, bool has_slot_id) {
+  const IndexedSnapshotHeader header = IndexedSnapshot<TypeHashKey>::read_header(file_name);
+  if (header.embedding_vec_size != embedding_vec_size_ ||
+      static_cast<bool>(header.has_slot_id) != has_slot_id) {
+    CK_THROW_(Error_t::WrongInput,
+              "Error: the indexed snapshot " + file_name + " doesn't match the embedding table");
+  }
+
+  // Nothing is read until it is looked up, and then only its pages, without read-ahead
+  FileDescriptor file(file_name, O_RDONLY);
+  mapping_size_in_byte_ = file.size();
+  mapping_ = mmap(NULL, mapping_size_in_byte_, PROT_READ, MAP_SHARED, file.get(), 0);
+  if (mapping_ == MAP_FAILED) {
+    mapping_ = nullptr;
+    CK_THROW_(Error_t::WrongInput, "Cannot map the indexed snapshot " + file_name);
+  }
+  madvise(mapping_, mapping_size_in_byte_, MADV_RANDOM);
+
+  const char* base = static_cast<const char*>(mapping_);
+  values_ = reinterpret_cast<const float*>(base + header.values_offset);
+  num_rows_ = header.num_rows;
+  index_ctrl_ = reinterpret_cast<const int8_t*>(base + header.index_offset);
+  index_entries_ = reinterpret_cast<const typename FlatHashTable<TypeHashKey>::Entry*>(
+      base + header.index_offset + header.index_capacity);
+  index_capacity_ = header.index_capacity;
+  size_ = header.num_rows;
+  mapped_ = true;
+}
+
+template <typename TypeHashKey>
+void cpu_embedding_table<TypeHashKey>::apply_(const cpu_embedding_table& table,
+                                              const embedding_delta<TypeHashKey>& delta) {
+  const size_t vector_size_in_byte = sizeof(float) * embedding_vec_size_;
+  const std::vector<TypeHashKey>& upsert_keys = delta.get_upsert_keys();
+  const std::vector<TypeHashKey>& delete_keys = delta.get_delete_keys();
+  // The rows of the previous deltas, if the table applies some
+  const FlatHashTable<TypeHashKey>* previous = table.base_ ? &table.index_ : nullptr;
+  const size_t num_previous = previous ? previous->size() : 0;
+  float* values = allocate_(upsert_keys.size() + num_previous);
+  index_.reserve(delete_keys.size() + upsert_keys.size() + num_previous);
+
+  // The first insert of a key wins: a deletion wins over an upsert of the same delta, and the
+  // delta over the previous ones
+  for (const auto& key : delete_keys) {
+    index_.insert(key, 0, DELETED_ROW_);
+  }
+  size_t num_rows = 0;
+  for (size_t i = 0; i < upsert_keys.size(); i++) {
+    if (index_.insert(upsert_keys[i], 0, num_rows)) {
+      memcpy(values + num_rows * embedding_vec_size_,
+             delta.get_upsert_vectors().data() + i * embedding_vec_size_, vector_size_in_byte);
+      num_rows++;
+    }
+  }
+  if (previous) {
+    previous->for_each([&](const typename FlatHashTable<TypeHashKey>::Entry& entry) {
+      if (entry.offset() == DELETED_ROW_) {
+        // a key which the loaded table doesn't have needs no deletion anymore
+        if (base_->find(entry.key)) {
+          index_.insert(entry.key, 0, DELETED_ROW_);
+        }
+      } else if (index_.insert(entry.key, 0, num_rows)) {
+        memcpy(values + num_rows * embedding_vec_size_,
+               table.values_ + entry.offset() * embedding_vec_size_, vector_size_in_byte);
+        num_rows++;
+      }
+    });
+  }
+
+  // The keys of the loaded table, less those deleted, and the new ones
+  size_ = base_->size();
+  index_.for_each([&](const typename FlatHashTable<TypeHashKey>::Entry& entry) {
+    const bool in_base = base_->find(entry.key) != nullptr;
+    if (entry.offset() == DELETED_ROW_) {
+      size_ -= in_base;
+    } else {
+      size_ += !in_base;
+    }
+  });
+
+  values_ = values;
+  num_rows_ = num_rows;
+  index_ctrl_ = index_.get_ctrl();
+  index_entries_ = index_.get_entries();
+  index_capacity_ = index_.capacity();
+}
+
+template <typename TypeHashKey>
+size_t cpu_embedding_table<TypeHashKey>::estimate_memory_usage(const std::string& file_name,
+                                                               size_t embedding_vec_size,
+                                                               bool has_slot_id) {
+  if (IndexedSnapshot<TypeHashKey>::is_indexed_snapshot(file_name)) {
+    return 0;
+  }
+  const size_t vector_size_in_byte = sizeof(float) * embedding_vec_size;
+  const size_t row_size =
+      sizeof(TypeHashKey) + (has_slot_id ? sizeof(size_t) : 0) + vector_size_in_byte;
+  const size_t num_rows = FileDescriptor(file_name, O_RDONLY).size() / row_size;
+  const size_t block_size_in_byte = std::min(num_rows * row_size, size_t(BLOCK_SIZE_IN_BYTE_));
+  // the arena, the index, and the keys and the blocks of rows read while it is built
+  return num_rows * (vector_size_in_byte + sizeof(TypeHashKey)) +
+         FlatHashTable<TypeHashKey>::memory_usage_for(num_rows) +
+         block_size_in_byte * omp_get_max_threads();
+}
+
+template <typename TypeHashKey>
+void cpu_embedding_table<TypeHashKey>::prefetch_(TypeHashKey key) const {
+  FlatHashTable<TypeHashKey>::prefetch_in_place(index_ctrl_, index_entries_, index_capacity_,
+                                                key);
+  if (base_) {
+    base_->prefetch_(key);
+  }
+}
+
+template <typename TypeHashKey>
+void cpu_embedding_table<TypeHashKey>::look_up_batch_(const TypeHashKey* keys, size_t length,
+                                                      float* embedding_vectors) const {
+  const size_t vector_size_in_byte = sizeof(float) * embedding_vec_size_;
+  const float* rows[LOOK_UP_BATCH_SIZE_];
+  for (size_t i = 0; i < length; i++) {
+    prefetch_(keys[i]);
+  }
+  for (size_t i = 0; i < length; i++) {
+    const float* row = find(keys[i]);
+    rows[i] = row ? row : default_vector_.data();
+    for (size_t line = 0; line < vector_size_in_byte; line += 64) {
+      __builtin_prefetch(reinterpret_cast<const char*>(rows[i]) + line);
+    }
+  }
+  for (size_t i = 0; i < length; i++) {
+    memcpy(embedding_vectors + i * embedding_vec_size_, rows[i], vector_size_in_byte);
+  }
+}
+
+template <typename TypeHashKey>
+void cpu_embedding_table<TypeHashKey>::look_up(const TypeHashKey* keys, size_t length,
+                                               float* embedding_vectors, int num_threads) const {
+  const size_t num_batches = (length + LOOK_UP_BATCH_SIZE_ - 1) / LOOK_UP_BATCH_SIZE_;
+  num_threads = static_cast<int>(
+      std::max<size_t>(1, std::min<size_t>(num_threads, length / MIN_KEYS_PER_THREAD_)));
+#pragma omp parallel for schedule(static) num_threads(num_threads)
+  for (size_t batch = 0; batch < num_batches; batch++) {
+    const size_t begin = batch * LOOK_UP_BATCH_SIZE_;
+    const size_t end = std::min(begin + LOOK_UP_BATCH_SIZE_, length);
+    look_up_batch_(keys + begin, end - begin, embedding_vectors + begin * embedding_vec_size_);
+  }
+}
+
+template class cpu_embedding_table<unsigned int>;
+template class cpu_embedding_table<long long>;
+}  // namespace HugeCTR
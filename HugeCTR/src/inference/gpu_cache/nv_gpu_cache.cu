@@ -909,6 +909,268 @@ __global__ void insert_replace_kernel(const key_type* d_keys,
   }
 }
 #endif
+
+#ifdef LIBCUDACXX_VERSION
+// Kernel to overwrite the values of the <k,v> pairs whose key is in the cache
+// The other keys are not inserted, and the locality information is left as is
+template<typename key_type,  
+         typename slabset, 
+         typename mutex,
+         typename set_hasher,
+         typename slab_hasher,
+         key_type empty_key,
+         int set_associativity,
+         int warp_size>
+__global__ void update_kernel(const key_type* d_keys, 
+                              const size_t len, 
+                              const float* d_values, 
+                              const size_t embedding_vec_size, 
+                              const size_t capacity_in_set, 
+                              const slabset* keys, 
+                              float* vals,
+                              mutex* set_mutex){
+  // Lane(thread) global ID
+  const size_t idx = blockIdx.x * blockDim.x + threadIdx.x;
+  // Lane(thread) ID within a warp_tile
+  cg::thread_block_tile<warp_size> warp_tile = cg::tiled_partition<warp_size>(cg::this_thread_block());
+  const size_t lane_idx = warp_tile.thread_rank();
+  // The assigned key for this lane(thread)
+  key_type key;
+  // The dst slabset and the dst slab inside this set
+  size_t src_set;
+  size_t src_slab;
+  // Active flag: whether current lane(thread) has unfinished task
+  bool active = false;
+  if( idx < len ){
+    active = true;
+    key = d_keys[idx];
+    src_set = set_hasher::hash(key) % capacity_in_set; 
+    src_slab = slab_hasher::hash(key) % set_associativity;
+  }
+
+  // Lane participate in warp_tile ballot to produce warp-level work queue
+  unsigned active_mask = warp_tile.ballot(active);
+
+  // The warp-level outer loop: finish all the tasks within the work queue
+  while(active_mask != 0){
+
+    // Next task in the work quere, start from lower index lane(thread)
+    int next_lane = __ffs(active_mask) - 1;
+    // Broadcast the task, the global index and the src slabset and slab to all lane in a warp_tile
+    key_type next_key = warp_tile.shfl(key, next_lane);
+    size_t next_idx = warp_tile.shfl(idx, next_lane);
+    size_t next_set = warp_tile.shfl(src_set, next_lane);
+    size_t next_slab = warp_tile.shfl(src_slab, next_lane);
+
+    // Counter to record how many slab have been searched
+    size_t counter = 0;
+
+    // Working queue before task started
+    const unsigned old_active_mask = active_mask;
+
+    // Lock the slabset before operating the slabset
+    warp_lock_mutex<mutex, warp_size>(warp_tile, set_mutex[next_set]);
+
+    // The warp-level inner loop: finish a single task in the work queue
+    while(active_mask == old_active_mask){
+
+      // When all the slabs inside a slabset have been searched, the key is not in the cache, the task is completed
+      if(counter >= set_associativity){
+
+        if(lane_idx == (size_t)next_lane){
+          active = false;
+        }
+
+        active_mask = warp_tile.ballot(active);
+        break;
+
+      }
+
+      // The warp_tile read out the slab
+      key_type read_key = keys[next_set].set_[next_slab].slab_[lane_idx];
+
+      // Compare the slab data with the target key
+      int found_lane = __ffs(warp_tile.ballot(read_key == next_key)) - 1;
+
+      // If found, overwrite the value, the task is completed
+      if(found_lane >= 0){
+        size_t found_offset = (next_set * set_associativity + next_slab) * warp_size + found_lane;
+
+        warp_tile_copy<warp_size>(lane_idx, embedding_vec_size, vals + found_offset * embedding_vec_size, d_values + next_idx * embedding_vec_size);
+
+        if(lane_idx == (size_t)next_lane){
+          active = false;
+        }
+
+        active_mask = warp_tile.ballot(active);
+        break;
+      }
+
+      // Compare the slab data with empty key, if found empty key, the key is not in the cache, the task is completed
+      if(warp_tile.ballot(read_key == empty_key) != 0){
+
+        if(lane_idx == (size_t)next_lane){
+          active = false;
+        }
+
+        active_mask = warp_tile.ballot(active);
+        break;
+
+      }
+
+      // Not found in this slab, the task is not completed, goto searching next slab
+      counter++;
+      next_slab = (next_slab + 1) % set_associativity;
+
+    }
+
+    // Unlock the slabset after operating the slabset
+    warp_unlock_mutex<mutex, warp_size>(warp_tile, set_mutex[next_set]);
+
+  }
+}
+#else
+// Kernel to overwrite the values of the <k,v> pairs whose key is in the cache
+// The other keys are not inserted, and the locality information is left as is
+template<typename key_type,  
+         typename slabset, 
+         typename set_hasher,
+         typename slab_hasher,
+         key_type empty_key,
+         int set_associativity,
+         int warp_size>
+__global__ void update_kernel(const key_type* d_keys, 
+                              const size_t len, 
+                              const float* d_values, 
+                              const size_t embedding_vec_size, 
+                              const size_t capacity_in_set, 
+                              volatile slabset* keys, 
+                              volatile float* vals,
+                              volatile int* set_mutex){
+  // Lane(thread) global ID
+  const size_t idx = blockIdx.x * blockDim.x + threadIdx.x;
+  // Lane(thread) ID within a warp_tile
+  cg::thread_block_tile<warp_size> warp_tile = cg::tiled_partition<warp_size>(cg::this_thread_block());
+  const size_t lane_idx = warp_tile.thread_rank();
+  // The assigned key for this lane(thread)
+  key_type key;
+  // The dst slabset and the dst slab inside this set
+  size_t src_set;
+  size_t src_slab;
+  // Active flag: whether current lane(thread) has unfinished task
+  bool active = false;
+  if( idx < len ){
+    active = true;
+    key = d_keys[idx];
+    src_set = set_hasher::hash(key) % capacity_in_set; 
+    src_slab = slab_hasher::hash(key) % set_associativity;
+  }
+
+  // Lane participate in warp_tile ballot to produce warp-level work queue
+  unsigned active_mask = warp_tile.ballot(active);
+
+  // The warp-level outer loop: finish all the tasks within the work queue
+  while(active_mask != 0){
+
+    // Next task in the work quere, start from lower index lane(thread)
+    int next_lane = __ffs(active_mask) - 1;
+    // Broadcast the task, the global index and the src slabset and slab to all lane in a warp_tile
+    key_type next_key = warp_tile.shfl(key, next_lane);
+    size_t next_idx = warp_tile.shfl(idx, next_lane);
+    size_t next_set = warp_tile.shfl(src_set, next_lane);
+    size_t next_slab = warp_tile.shfl(src_slab, next_lane);
+
+    // Counter to record how many slab have been searched
+    size_t counter = 0;
+
+    // Working queue before task started
+    const unsigned old_active_mask = active_mask;
+
+    // Lock the slabset before operating the slabset
+    warp_lock_mutex<warp_size>(warp_tile, set_mutex[next_set]);
+
+    // The warp-level inner loop: finish a single task in the work queue
+    while(active_mask == old_active_mask){
+
+      // When all the slabs inside a slabset have been searched, the key is not in the cache, the task is completed
+      if(counter >= set_associativity){
+
+        if(lane_idx == (size_t)next_lane){
+          active = false;
+        }
+
+        active_mask = warp_tile.ballot(active);
+        break;
+
+      }
+
+      // The warp_tile read out the slab
+      key_type read_key = ((volatile key_type*)(keys[next_set].set_[next_slab].slab_))[lane_idx];
+
+      // Compare the slab data with the target key
+      int found_lane = __ffs(warp_tile.ballot(read_key == next_key)) - 1;
+
+      // If found, overwrite the value, the task is completed
+      if(found_lane >= 0){
+        size_t found_offset = (next_set * set_associativity + next_slab) * warp_size + found_lane;
+
+        warp_tile_copy<warp_size>(lane_idx, embedding_vec_size, (volatile float*)(vals + found_offset * embedding_vec_size), (volatile float*)(d_values + next_idx * embedding_vec_size));
+
+        if(lane_idx == (size_t)next_lane){
+          active = false;
+        }
+
+        active_mask = warp_tile.ballot(active);
+        break;
+      }
+
+      // Compare the slab data with empty key, if found empty key, the key is not in the cache, the task is completed
+      if(warp_tile.ballot(read_key == empty_key) != 0){
+
+        if(lane_idx == (size_t)next_lane){
+          active = false;
+        }
+
+        active_mask = warp_tile.ballot(active);
+        break;
+
+      }
+
+      // Not found in this slab, the task is not completed, goto searching next slab
+      counter++;
+      next_slab = (next_slab + 1) % set_associativity;
+
+    }
+
+    // Unlock the slabset after operating the slabset
+    warp_unlock_mutex<warp_size>(warp_tile, set_mutex[next_set]);
+
+  }
+}
+#endif
+
+// Kernel to dump the keys in the slabsets [start_set_index, end_set_index) of the cache
+// Each CUDA thread checks one slot, and appends its key if the slot is used
+template<typename key_type, 
+         typename slabset, 
+         key_type empty_key, 
+         int set_associativity, 
+         int warp_size>
+__global__ void dump_kernel(key_type* d_keys, 
+                            size_t* d_dump_counter, 
+                            const slabset* keys, 
+                            const size_t start_set_index, 
+                            const size_t end_set_index){
+  const size_t idx = blockIdx.x * blockDim.x + threadIdx.x;
+  const size_t num_slot = (end_set_index - start_set_index) * set_associativity * warp_size;
+  if( idx < num_slot ){
+    // Flatten the slabsets
+    const key_type read_key = ((const volatile key_type*)(keys + start_set_index))[idx];
+    if(read_key != empty_key){
+      d_keys[atomicAdd(d_dump_counter, (size_t)1)] = read_key;
+    }
+  }
+}
 ///////////////////////////////////////////////////////////////////////////////////////////////////
 
 #ifdef LIBCUDACXX_VERSION
@@ -1236,6 +1498,112 @@ Replace(const key_type* d_keys,
 }
 #endif
 
+#ifdef LIBCUDACXX_VERSION
+template<typename key_type,  
+         typename ref_counter_type, 
+         key_type empty_key, 
+         int set_associativity, 
+         int warp_size,
+         typename set_hasher, 
+         typename slab_hasher>
+void gpu_cache<key_type, ref_counter_type, empty_key, set_associativity, warp_size, set_hasher, slab_hasher>::
+Update(const key_type* d_keys, 
+       const size_t len, 
+       const float* d_values, 
+       cudaStream_t stream){
+  
+  // Check if it is a valid update
+  if(len == 0){
+    return;
+  }
+
+  // Device Restorer
+  CudaDeviceContext dev_restorer;
+  // Set to the device of this cache
+  CK_CUDA_THROW_(cudaSetDevice(dev_));
+
+  // Overwrite the values of the keys which are in the cache
+  update_kernel<key_type, slabset, mutex, set_hasher, slab_hasher, empty_key, set_associativity, warp_size>
+  <<<((len-1)/BLOCK_SIZE_)+1, BLOCK_SIZE_, 0, stream>>>
+  (d_keys, len, d_values, embedding_vec_size_, capacity_in_set_, keys_, vals_, set_mutex_);
+
+  // Check for GPU error before return
+  CK_CUDA_THROW_(cudaGetLastError());
+
+}
+#else
+template<typename key_type,  
+         typename ref_counter_type, 
+         key_type empty_key, 
+         int set_associativity, 
+         int warp_size,
+         typename set_hasher, 
+         typename slab_hasher>
+void gpu_cache<key_type, ref_counter_type, empty_key, set_associativity, warp_size, set_hasher, slab_hasher>::
+Update(const key_type* d_keys, 
+       const size_t len, 
+       const float* d_values, 
+       cudaStream_t stream){
+  
+  // Check if it is a valid update
+  if(len == 0){
+    return;
+  }
+
+  // Device Restorer
+  CudaDeviceContext dev_restorer;
+  // Set to the device of this cache
+  CK_CUDA_THROW_(cudaSetDevice(dev_));
+
+  // Overwrite the values of the keys which are in the cache
+  update_kernel<key_type, slabset, set_hasher, slab_hasher, empty_key, set_associativity, warp_size>
+  <<<((len-1)/BLOCK_SIZE_)+1, BLOCK_SIZE_, 0, stream>>>
+  (d_keys, len, d_values, embedding_vec_size_, capacity_in_set_, keys_, vals_, set_mutex_);
+
+  // Check for GPU error before return
+  CK_CUDA_THROW_(cudaGetLastError());
+
+}
+#endif
+
+template<typename key_type,  
+         typename ref_counter_type, 
+         key_type empty_key, 
+         int set_associativity, 
+         int warp_size,
+         typename set_hasher, 
+         typename slab_hasher>
+void gpu_cache<key_type, ref_counter_type, empty_key, set_associativity, warp_size, set_hasher, slab_hasher>::
+Dump(key_type* d_keys, 
+     size_t* d_dump_counter, 
+     const size_t start_set_index, 
+     const size_t end_set_index, 
+     cudaStream_t stream){
+
+  // Check if it is a valid dump
+  if(start_set_index > end_set_index || end_set_index > capacity_in_set_){
+    CK_THROW_(Error_t::WrongInput, "Error: Invalid value for start_set_index or end_set_index");
+  }
+  if(start_set_index == end_set_index){
+    return;
+  }
+
+  // Device Restorer
+  CudaDeviceContext dev_restorer;
+  // Set to the device of this cache
+  CK_CUDA_THROW_(cudaSetDevice(dev_));
+
+  // Append the used keys of the slabsets to d_keys
+  const size_t num_slot = (end_set_index - start_set_index) * set_associativity * warp_size;
+  dump_kernel<key_type, slabset, empty_key, set_associativity, warp_size>
+  <<<((num_slot-1)/BLOCK_SIZE_)+1, BLOCK_SIZE_, 0, stream>>>
+  (d_keys, d_dump_counter, keys_, start_set_index, end_set_index);
+
+  // Check for GPU error before return
+  CK_CUDA_THROW_(cudaGetLastError());
+
+}
+
 template class gpu_cache<unsigned int, uint64_t, std::numeric_limits<unsigned int>::max(), SET_ASSOCIATIVITY, SLAB_SIZE>;
 template class gpu_cache<long long, uint64_t, std::numeric_limits<long long>::max(), SET_ASSOCIATIVITY, SLAB_SIZE>;
 } // namespace gpu_cache
@@ -15,6 +15,8 @@
  */
 
 #include <inference/parameter_server.hpp>
+#include <inference/embedding_delta.hpp>
+#include <omp.h>
 
 namespace HugeCTR {
 
@@ -23,7 +25,9 @@ parameter_server_base::~parameter_server_base() {}
 template <typename TypeHashKey>
 parameter_server<TypeHashKey>::parameter_server(const std::string& framework_name, 
                                                 const std::vector<std::string>& model_config_path, 
-                                                const std::vector<std::string>& model_name){
+                                                const std::vector<std::string>& model_name,
+                                                size_t update_memory_budget_in_byte)
+    : update_memory_budget_in_byte_(update_memory_budget_in_byte) {
   // Store the configuration
   framework_name_ = framework_name;
   if(model_config_path.size() != model_name.size()){
@@ -90,78 +94,43 @@ parameter_server<TypeHashKey>::parameter_server(const std::string& framework_nam
     CK_THROW_(Error_t::WrongInput, "Wrong input: The size of parameter server parameters are not correct.");
   }
 
-  // Load embeddings for each embedding table from each model
+  // Load embeddings for each embedding table from each model, as the first version of the model
   for(unsigned int i = 0; i < model_config_path.size(); i++){
-    size_t num_emb_table = (ps_config_.emb_file_name_[i]).size();
-    // Temp vector of embedding table for this model
-    std::vector<std::unordered_map<TypeHashKey, std::vector<float>>> model_emb_table;
-    for(unsigned int j = 0; j < num_emb_table; j++){
-      // Create input file stream to read the embedding file
-      std::ifstream emb_file(ps_config_.emb_file_name_[i][j]);
-      // Check if file is opened successfully
-      if (!emb_file.is_open()){
-        CK_THROW_(Error_t::WrongInput, "Error: embeddings file not open for reading");
-      }
-      emb_file.seekg(0, emb_file.end);
-      size_t file_size = emb_file.tellg();
-      emb_file.seekg(0, emb_file.beg);
-
-      // The temp embedding table
-      std::unordered_map<TypeHashKey, std::vector<float>> emb_table;
-
-      if(ps_config_.distributed_emb_[i][j]){
-        size_t row_size = sizeof(TypeHashKey) + sizeof(float) * ps_config_.embedding_vec_size_[i][j];
-        size_t row_num = file_size / row_size;
-        if (file_size % row_size != 0) {
-          CK_THROW_(Error_t::WrongInput, "Error: embeddings file size is not correct");
-        }
-
-        TypeHashKey read_key;
-        std::vector<float> read_emb_vec(ps_config_.embedding_vec_size_[i][j]);
-        for(size_t pair = 0; pair < row_num; pair++){
-          // Read out the emb_id and emb_vec
-          emb_file.read(reinterpret_cast<char *>(&read_key), sizeof(TypeHashKey));
-          emb_file.read(reinterpret_cast<char *>(read_emb_vec.data()),
-                        sizeof(float) * ps_config_.embedding_vec_size_[i][j]);
-
-          // Insert into CPU embedding table
-          emb_table.emplace(read_key, read_emb_vec);
-        }
-      }
-      else{
-        size_t row_size = sizeof(TypeHashKey) + sizeof(size_t) + sizeof(float) * ps_config_.embedding_vec_size_[i][j];
-        size_t row_num = file_size / row_size;
-        if (file_size % row_size != 0){
-          CK_THROW_(Error_t::WrongInput, "Error: embeddings file size is not correct");
-        }
+    cpu_embedding_table_.emplace_back(new versioned_ptr<embedding_tables>(
+        load_embedding_tables_(i, ps_config_.emb_file_name_[i])));
+  }
+}
 
-        TypeHashKey read_key;
-        size_t read_slod_id;
-        std::vector<float> read_emb_vec(ps_config_.embedding_vec_size_[i][j]);
-        for(size_t pair = 0; pair < row_num; pair++){
-          // Read out the emb_id, slot_id and emb_vec
-          emb_file.read(reinterpret_cast<char *>(&read_key), sizeof(TypeHashKey));
-          emb_file.read(reinterpret_cast<char *>(&read_slod_id), sizeof(size_t));
-          emb_file.read(reinterpret_cast<char *>(read_emb_vec.data()),
-                        sizeof(float) * ps_config_.embedding_vec_size_[i][j]);
-
-          // Insert into CPU embedding table
-          emb_table.emplace(read_key, read_emb_vec);
-        }
-      }
+template <typename TypeHashKey>
+parameter_server<TypeHashKey>::~parameter_server(){
+  if (update_thread_.joinable()) {
+    update_thread_.join();
+  }
+}
 
-      // Insert temp embedding table into temp model embedding table
-      model_emb_table.emplace_back(emb_table);
-      // Close embedding file
-      emb_file.close();
-    }
-    // Insert temp model embedding table into parameter server
-    cpu_embedding_table_.emplace_back(model_emb_table);
+template <typename TypeHashKey>
+size_t parameter_server<TypeHashKey>::get_model_id_(const std::string& model_name) const {
+  auto model_id_iter = ps_config_.model_name_id_map_.find(model_name);
+  if (model_id_iter == ps_config_.model_name_id_map_.end()) {
+    CK_THROW_(Error_t::WrongInput, "Error: parameter server unknown model name.");
   }
+  return model_id_iter->second;
 }
 
 template <typename TypeHashKey>
-parameter_server<TypeHashKey>::~parameter_server(){}
+std::unique_ptr<typename parameter_server<TypeHashKey>::embedding_tables>
+parameter_server<TypeHashKey>::load_embedding_tables_(
+    size_t model_id, const std::vector<std::string>& sparse_model_files) const {
+  std::unique_ptr<embedding_tables> tables(new embedding_tables());
+  for (size_t j = 0; j < sparse_model_files.size(); j++) {
+    // Read the rows of the embedding file into the table, which checks the file size
+    tables->emplace_back(new cpu_embedding_table<TypeHashKey>(
+        sparse_model_files[j], ps_config_.embedding_vec_size_[model_id][j],
+        !ps_config_.distributed_emb_[model_id][j],
+        ps_config_.default_emb_vec_value_[model_id][j]));
+  }
+  return tables;
+}
 
 template <typename TypeHashKey>
 void parameter_server<TypeHashKey>::look_up(const TypeHashKey* h_embeddingcolumns, 
@@ -170,30 +139,154 @@ void parameter_server<TypeHashKey>::look_up(const TypeHashKey* h_embeddingcolumn
                                             const std::string& model_name, 
                                             size_t embedding_table_id){
   // Translate from model name to model id
-  size_t model_id;
-  auto model_id_iter = ps_config_.model_name_id_map_.find(model_name);
-  if(model_id_iter != ps_config_.model_name_id_map_.end()){
-    model_id = model_id_iter -> second;
+  const size_t model_id = get_model_id_(model_name);
+
+  // Search for the embedding ids in the corresponding embedding table of the current version,
+  // with the default vector for the ids which are not in it
+  typename versioned_ptr<embedding_tables>::read_guard tables(*cpu_embedding_table_[model_id]);
+  (*tables)[embedding_table_id]->look_up(h_embeddingcolumns, length, h_embeddingoutputvector,
+                                         omp_get_max_threads());
+}
+
+template <typename TypeHashKey>
+void parameter_server<TypeHashKey>::update_model(
+    const std::string& model_name, const std::vector<std::string>& sparse_model_files) {
+  try {
+    std::lock_guard<std::mutex> lock(update_mutex_);
+    wait_for_update_();
+
+    const size_t model_id = get_model_id_(model_name);
+    const size_t num_emb_table = ps_config_.emb_file_name_[model_id].size();
+    if (sparse_model_files.size() != num_emb_table) {
+      CK_THROW_(Error_t::WrongInput, "Error: model " + model_name + " has " +
+                                         std::to_string(num_emb_table) + " embedding tables");
+    }
+    // Refuse an update which would not fit, before anything is loaded
+    size_t memory_usage = 0;
+    for (size_t j = 0; j < sparse_model_files.size(); j++) {
+      memory_usage += cpu_embedding_table<TypeHashKey>::estimate_memory_usage(
+          sparse_model_files[j], ps_config_.embedding_vec_size_[model_id][j],
+          !ps_config_.distributed_emb_[model_id][j]);
+    }
+    if (update_memory_budget_in_byte_ && memory_usage > update_memory_budget_in_byte_) {
+      CK_THROW_(Error_t::OutOfMemory, "Error: the update of model " + model_name + " takes " +
+                                          std::to_string(memory_usage) +
+                                          " bytes, over the budget of " +
+                                          std::to_string(update_memory_budget_in_byte_));
+    }
+
+    update_thread_ = std::thread([this, model_id, sparse_model_files]() {
+      try {
+        std::unique_ptr<embedding_tables> tables(
+            load_embedding_tables_(model_id, sparse_model_files));
+        // The old version is freed here, once the look_up calls which use it are done
+        cpu_embedding_table_[model_id]->update(std::move(tables)).reset();
+        // Any key of the embedding caches may have changed
+        for (size_t j = 0; j < sparse_model_files.size(); j++) {
+          invalidate_(model_id, j, nullptr, 0);
+        }
+      } catch (...) {
+        update_error_ = std::current_exception();
+      }
+    });
+  } catch (const internal_runtime_error& rt_err) {
+    std::cerr << rt_err.what() << std::endl;
+    throw;
+  } catch (const std::exception& err) {
+    std::cerr << err.what() << std::endl;
+    throw;
   }
-  else{
-    CK_THROW_(Error_t::WrongInput, "Error: parameter server unknown model name.");
+}
+
+template <typename TypeHashKey>
+void parameter_server<TypeHashKey>::wait_for_update() {
+  std::lock_guard<std::mutex> lock(update_mutex_);
+  wait_for_update_();
+}
+
+template <typename TypeHashKey>
+void parameter_server<TypeHashKey>::wait_for_update_() {
+  if (!update_thread_.joinable()) {
+    return;
   }
+  update_thread_.join();
+  if (update_error_) {
+    std::exception_ptr err = update_error_;
+    update_error_ = nullptr;
+    std::rethrow_exception(err);
+  }
+}
 
-  // Search for the embedding ids in the corresponding embedding table
-  for(size_t i = 0; i < length; i++){
-    // Look-up the id in the table
-    auto result = cpu_embedding_table_[model_id][embedding_table_id].find(h_embeddingcolumns[i]);
-    // Check if the key is existed in embedding table
-    if(result != cpu_embedding_table_[model_id][embedding_table_id].end()){
-      // Find the embedding id
-      size_t emb_vec_offset = i * ps_config_.embedding_vec_size_[model_id][embedding_table_id];
-      memcpy(h_embeddingoutputvector + emb_vec_offset, (result -> second).data(), sizeof(float) * ps_config_.embedding_vec_size_[model_id][embedding_table_id]);
+template <typename TypeHashKey>
+void parameter_server<TypeHashKey>::apply_delta(const std::string& model_name,
+                                                size_t embedding_table_id,
+                                                const std::string& delta_file) {
+  try {
+    // Held until the caches are refreshed, so that two deltas neither copy the same version, which
+    // would drop one of them, nor refresh the caches out of order
+    std::lock_guard<std::mutex> lock(update_mutex_);
+    wait_for_update_();
+
+    const size_t model_id = get_model_id_(model_name);
+    const size_t num_emb_table = ps_config_.emb_file_name_[model_id].size();
+    if (embedding_table_id >= num_emb_table) {
+      CK_THROW_(Error_t::WrongInput, "Error: model " + model_name + " has " +
+                                         std::to_string(num_emb_table) + " embedding tables");
     }
-    else{
-      // Cannot find the embedding id
-      size_t emb_vec_offset = i * ps_config_.embedding_vec_size_[model_id][embedding_table_id];
-      std::vector<float> default_emb_vec(ps_config_.embedding_vec_size_[model_id][embedding_table_id], ps_config_.default_emb_vec_value_[model_id][embedding_table_id]);
-      memcpy(h_embeddingoutputvector + emb_vec_offset, default_emb_vec.data(), sizeof(float) * ps_config_.embedding_vec_size_[model_id][embedding_table_id]);
+    const embedding_delta<TypeHashKey> delta(
+        delta_file, ps_config_.embedding_vec_size_[model_id][embedding_table_id]);
+
+    // The new version shares the tables of the current one
+    std::unique_ptr<embedding_tables> tables;
+    {
+      typename versioned_ptr<embedding_tables>::read_guard current(*cpu_embedding_table_[model_id]);
+      tables.reset(new embedding_tables(*current));
+    }
+    (*tables)[embedding_table_id] = std::make_shared<const cpu_embedding_table<TypeHashKey>>(
+        (*tables)[embedding_table_id], delta);
+    cpu_embedding_table_[model_id]->update(std::move(tables)).reset();
+
+    if (!delta.get_upsert_keys().empty()) {
+      invalidate_(model_id, embedding_table_id, delta.get_upsert_keys().data(),
+                  delta.get_upsert_keys().size());
+    }
+    if (!delta.get_delete_keys().empty()) {
+      invalidate_(model_id, embedding_table_id, delta.get_delete_keys().data(),
+                  delta.get_delete_keys().size());
+    }
+  } catch (const internal_runtime_error& rt_err) {
+    std::cerr << rt_err.what() << std::endl;
+    throw;
+  } catch (const std::exception& err) {
+    std::cerr << err.what() << std::endl;
+    throw;
+  }
+}
+
+template <typename TypeHashKey>
+size_t parameter_server<TypeHashKey>::register_invalidation_callback(
+    const std::string& model_name,
+    typename HugectrUtility<TypeHashKey>::invalidation_callback callback) {
+  const size_t model_id = get_model_id_(model_name);
+  std::lock_guard<std::mutex> lock(callback_mutex_);
+  invalidation_callbacks_.emplace(next_callback_id_, std::make_pair(model_id, std::move(callback)));
+  return next_callback_id_++;
+}
+
+template <typename TypeHashKey>
+void parameter_server<TypeHashKey>::unregister_invalidation_callback(size_t callback_id) {
+  // A callback in progress is done once the lock is taken
+  std::lock_guard<std::mutex> lock(callback_mutex_);
+  invalidation_callbacks_.erase(callback_id);
+}
+
+template <typename TypeHashKey>
+void parameter_server<TypeHashKey>::invalidate_(size_t model_id, size_t embedding_table_id,
+                                                const TypeHashKey* keys, size_t length) {
+  std::lock_guard<std::mutex> lock(callback_mutex_);
+  for (auto& callback : invalidation_callbacks_) {
+    if (callback.second.first == model_id) {
+      callback.second.second(embedding_table_id, keys, length);
     }
   }
 }
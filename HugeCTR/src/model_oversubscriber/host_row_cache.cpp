@@ -0,0 +1,228 @@
+/*
+ * Copyright (c) 2020, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <model_oversubscriber/host_row_cache.hpp>
+
+namespace HugeCTR {
+
+const uint32_t HostRowCache::NO_SLOT;
+
+HostRowCache::HostRowCache(size_t capacity, size_t embedding_vec_size, CachePolicy_t policy)
+    : capacity_(capacity), embedding_vec_size_(embedding_vec_size), policy_(policy) {
+  if (capacity_ >= NO_SLOT) {
+    CK_THROW_(Error_t::OutOfBound, "HostRowCache capacity is too large: " +
+                                       std::to_string(capacity_));
+  }
+  rows_.resize(capacity_ * embedding_vec_size_);
+  slot_row_.resize(capacity_);
+  // the slots are kept in the offset of the entries, and the table as large as the cache
+  row_slot_.reserve(capacity_);
+  pinned_.resize(capacity_, 0);
+  switch (policy_) {
+    case CachePolicy_t::LRU:
+      prev_.resize(capacity_, NO_SLOT);
+      next_.resize(capacity_, NO_SLOT);
+      break;
+    case CachePolicy_t::LFU:
+      heap_.reserve(capacity_);
+      heap_pos_.resize(capacity_, NO_SLOT);
+      frequency_.resize(capacity_, 0);
+      tick_.resize(capacity_, 0);
+      break;
+    case CachePolicy_t::CLOCK:
+      referenced_.resize(capacity_, 0);
+      break;
+  }
+}
+
+void HostRowCache::lru_unlink_(uint32_t slot) {
+  if (prev_[slot] != NO_SLOT) next_[prev_[slot]] = next_[slot];
+  if (next_[slot] != NO_SLOT) prev_[next_[slot]] = prev_[slot];
+  if (head_ == slot) head_ = next_[slot];
+  if (tail_ == slot) tail_ = prev_[slot];
+  prev_[slot] = next_[slot] = NO_SLOT;
+}
+
+void HostRowCache::lru_push_front_(uint32_t slot) {
+  next_[slot] = head_;
+  if (head_ != NO_SLOT) prev_[head_] = slot;
+  head_ = slot;
+  if (tail_ == NO_SLOT) tail_ = slot;
+}
+
+void HostRowCache::heap_swap_(size_t i, size_t j) {
+  std::swap(heap_[i], heap_[j]);
+  heap_pos_[heap_[i]] = i;
+  heap_pos_[heap_[j]] = j;
+}
+
+void HostRowCache::heap_sift_up_(size_t i) {
+  while (i > 0 && heap_less_(heap_[i], heap_[(i - 1) / 2])) {
+    heap_swap_(i, (i - 1) / 2);
+    i = (i - 1) / 2;
+  }
+}
+
+void HostRowCache::heap_sift_down_(size_t i) {
+  while (true) {
+    size_t min = i;
+    for (size_t child = 2 * i + 1; child <= 2 * i + 2 && child < heap_.size(); child++) {
+      if (heap_less_(heap_[child], heap_[min])) min = child;
+    }
+    if (min == i) return;
+    heap_swap_(i, min);
+    i = min;
+  }
+}
+
+void HostRowCache::heap_push_(uint32_t slot) {
+  heap_.push_back(slot);
+  heap_pos_[slot] = heap_.size() - 1;
+  heap_sift_up_(heap_.size() - 1);
+}
+
+void HostRowCache::heap_erase_(uint32_t slot) {
+  const size_t i = heap_pos_[slot];
+  if (i == NO_SLOT) return;
+  heap_swap_(i, heap_.size() - 1);
+  heap_.pop_back();
+  heap_pos_[slot] = NO_SLOT;
+  if (i < heap_.size()) {
+    heap_sift_up_(i);
+    heap_sift_down_(i);
+  }
+}
+
+void HostRowCache::touch_(uint32_t slot) {
+  switch (policy_) {
+    case CachePolicy_t::LRU:
+      lru_unlink_(slot);
+      lru_push_front_(slot);
+      break;
+    case CachePolicy_t::LFU:
+      // out of the heap while pinned, back with the new frequency in end_batch()
+      heap_erase_(slot);
+      frequency_[slot]++;
+      tick_[slot] = now_++;
+      break;
+    case CachePolicy_t::CLOCK:
+      referenced_[slot] = 1;
+      break;
+  }
+  if (!pinned_[slot]) {
+    pinned_[slot] = 1;
+    pinned_slots_.push_back(slot);
+  }
+}
+
+uint32_t HostRowCache::evict_() {
+  uint32_t slot = NO_SLOT;
+  if (pinned_slots_.size() == capacity_) {
+    return slot;
+  }
+  switch (policy_) {
+    case CachePolicy_t::LRU:
+      // the pinned slots were moved to the front, so they are all pinned if the tail is
+      if (tail_ != NO_SLOT && !pinned_[tail_]) {
+        slot = tail_;
+        lru_unlink_(slot);
+      }
+      break;
+    case CachePolicy_t::LFU:
+      if (!heap_.empty()) {
+        slot = heap_[0];
+        heap_erase_(slot);
+        frequency_[slot] = 0;
+      }
+      break;
+    case CachePolicy_t::CLOCK:
+      // two rounds clear every reference bit, and some slot is not pinned
+      for (size_t step = 0; step < 2 * capacity_; step++) {
+        const size_t cur = hand_;
+        hand_ = (hand_ + 1) % capacity_;
+        if (pinned_[cur]) continue;
+        if (referenced_[cur]) {
+          referenced_[cur] = 0;
+          continue;
+        }
+        slot = cur;
+        break;
+      }
+      break;
+  }
+  if (slot != NO_SLOT) {
+    row_slot_.erase(static_cast<long long>(slot_row_[slot]));
+    evictions_++;
+  }
+  return slot;
+}
+
+uint32_t HostRowCache::acquire(size_t row, bool& hit) {
+  const auto* entry = row_slot_.find(static_cast<long long>(row));
+  hit = entry != nullptr;
+  if (hit) {
+    const uint32_t slot = entry->offset();
+    hits_++;
+    touch_(slot);
+    return slot;
+  }
+
+  misses_++;
+  uint32_t slot;
+  if (capacity_ == 0) {
+    bypasses_++;
+    return NO_SLOT;
+  }
+  if (size_ < capacity_) {
+    slot = size_++;
+  } else {
+    slot = evict_();
+    if (slot == NO_SLOT) {
+      bypasses_++;
+      return NO_SLOT;
+    }
+  }
+  slot_row_[slot] = row;
+  row_slot_.insert(static_cast<long long>(row), 0, slot);
+  touch_(slot);
+  return slot;
+}
+
+void HostRowCache::end_batch() {
+  for (uint32_t slot : pinned_slots_) {
+    pinned_[slot] = 0;
+    if (policy_ == CachePolicy_t::LFU) {
+      heap_push_(slot);
+    }
+  }
+  pinned_slots_.clear();
+}
+
+void HostRowCache::clear() {
+  end_batch();
+  row_slot_.clear();
+  size_ = 0;
+  head_ = tail_ = NO_SLOT;
+  std::fill(prev_.begin(), prev_.end(), NO_SLOT);
+  std::fill(next_.begin(), next_.end(), NO_SLOT);
+  heap_.clear();
+  std::fill(heap_pos_.begin(), heap_pos_.end(), NO_SLOT);
+  std::fill(frequency_.begin(), frequency_.end(), 0);
+  std::fill(referenced_.begin(), referenced_.end(), 0);
+  hand_ = 0;
+}
+
+}  // namespace HugeCTR
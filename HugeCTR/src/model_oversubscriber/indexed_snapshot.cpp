@@ -0,0 +1,320 @@
+/*
+ * Copyright (c) 2020, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <model_oversubscriber/indexed_snapshot.hpp>
+#include <model_oversubscriber/file_descriptor.hpp>
+#include <model_oversubscriber/snapshot_pipeline.hpp>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+#include <sys/mman.h>
+
+namespace HugeCTR {
+
+namespace {
+
+const size_t block_size_in_byte = size_t(32) << 20;
+
+size_t round_up(size_t value, size_t alignment) {
+  return (value + alignment - 1) / alignment * alignment;
+}
+
+// a read-only mapping of a range of a file, unmapped when it goes out of scope
+class ReadOnlyMapping {
+  void* addr_{nullptr};
+  size_t length_{0};
+
+ public:
+  ReadOnlyMapping(const FileDescriptor& fd, size_t offset, size_t length) : length_(length) {
+    if (length_ == 0) {
+      return;
+    }
+    addr_ = mmap(NULL, length_, PROT_READ, MAP_SHARED, fd.get(), offset);
+    if (addr_ == MAP_FAILED) {
+      addr_ = nullptr;
+      CK_THROW_(Error_t::WrongInput, "Mmap failed at " + std::to_string(offset));
+    }
+  }
+  ReadOnlyMapping(const ReadOnlyMapping&) = delete;
+  ReadOnlyMapping& operator=(const ReadOnlyMapping&) = delete;
+  ~ReadOnlyMapping() {
+    if (addr_) munmap(addr_, length_);
+  }
+
+  const char* get() const { return static_cast<const char*>(addr_); }
+};
+
+}  // namespace
+
+template <typename KeyType>
+const char IndexedSnapshot<KeyType>::MAGIC[8] = {'H', 'C', 'T', 'R', 'I', 'D', 'X', '\0'};
+template <typename KeyType>
+const uint32_t IndexedSnapshot<KeyType>::VERSION;
+template <typename KeyType>
+const size_t IndexedSnapshot<KeyType>::PAGE_SIZE;
+
+template <typename KeyType>
+bool IndexedSnapshot<KeyType>::is_indexed_snapshot(const std::string& path) {
+  if (path.empty()) {
+    return false;
+  }
+  int fd = open(path.c_str(), O_RDONLY);
+  if (fd == -1) {
+    return false;
+  }
+  char magic[sizeof(MAGIC)];
+  const bool is_indexed =
+      pread(fd, magic, sizeof(magic), 0) == sizeof(magic) && !memcmp(magic, MAGIC, sizeof(magic));
+  close(fd);
+  return is_indexed;
+}
+
+template <typename KeyType>
+IndexedSnapshotHeader IndexedSnapshot<KeyType>::read_header(const std::string& path) {
+  try {
+    FileDescriptor fd(path, O_RDONLY);
+    IndexedSnapshotHeader header;
+    if (fd.size() < sizeof(header)) {
+      CK_THROW_(Error_t::BrokenFile, "Not an indexed snapshot: " + path);
+    }
+    fd.pread_full(reinterpret_cast<char*>(&header), sizeof(header), 0);
+    if (memcmp(header.magic, MAGIC, sizeof(MAGIC))) {
+      CK_THROW_(Error_t::BrokenFile, "Not an indexed snapshot: " + path);
+    }
+    if (header.version != VERSION) {
+      CK_THROW_(Error_t::UnSupportedFormat,
+                "Unsupported indexed snapshot version " + std::to_string(header.version));
+    }
+    if (header.key_size_in_byte != sizeof(KeyType)) {
+      CK_THROW_(Error_t::WrongInput, "The keys of " + path + " are of " +
+                                         std::to_string(header.key_size_in_byte) + " bytes");
+    }
+    const size_t values_end =
+        header.values_offset + header.num_rows * header.embedding_vec_size * sizeof(float);
+    const size_t index_end =
+        header.index_offset + header.index_capacity * (1 + sizeof(typename HashTable::Entry));
+    if (header.values_offset % PAGE_SIZE || header.index_offset % PAGE_SIZE ||
+        values_end > header.index_offset || index_end > fd.size() ||
+        !HashTable::is_valid_capacity(header.index_capacity)) {
+      CK_THROW_(Error_t::BrokenFile, "Truncated or inconsistent indexed snapshot: " + path);
+    }
+    return header;
+  } catch (const internal_runtime_error& rt_err) {
+    std::cerr << rt_err.what() << std::endl;
+    throw;
+  } catch (const std::exception& err) {
+    std::cerr << err.what() << std::endl;
+    throw;
+  }
+}
+
+template <typename KeyType>
+void IndexedSnapshot<KeyType>::load_index(const std::string& path,
+                                          const IndexedSnapshotHeader& header,
+                                          HashTable& hash_table) {
+  try {
+    FileDescriptor fd(path, O_RDONLY);
+    const size_t capacity = header.index_capacity;
+    ReadOnlyMapping index(fd, header.index_offset,
+                          capacity * (1 + sizeof(typename HashTable::Entry)));
+    hash_table.load(reinterpret_cast<const int8_t*>(index.get()),
+                    reinterpret_cast<const typename HashTable::Entry*>(index.get() + capacity),
+                    capacity);
+    if (hash_table.size() != header.num_rows) {
+      CK_THROW_(Error_t::BrokenFile, "The index of " + path + " has " +
+                                         std::to_string(hash_table.size()) + " keys for " +
+                                         std::to_string(header.num_rows) + " rows");
+    }
+    // and each of them has a row of its own
+    std::vector<uint8_t> used_rows(header.num_rows, 0);
+    bool broken = false;
+    hash_table.for_each([&](const typename HashTable::Entry& entry) {
+      if (entry.offset() >= header.num_rows || used_rows[entry.offset()]) {
+        broken = true;
+      } else {
+        used_rows[entry.offset()] = 1;
+      }
+    });
+    if (broken) {
+      CK_THROW_(Error_t::BrokenFile, "The index of " + path + " has a key out of its " +
+                                         std::to_string(header.num_rows) +
+                                         " rows or sharing one");
+    }
+  } catch (const internal_runtime_error& rt_err) {
+    std::cerr << rt_err.what() << std::endl;
+    throw;
+  } catch (const std::exception& err) {
+    std::cerr << err.what() << std::endl;
+    throw;
+  }
+}
+
+template <typename KeyType>
+void IndexedSnapshot<KeyType>::write(const std::string& snapshot_path,
+                                     const std::string& embedding_table_path,
+                                     size_t embedding_vec_size, bool has_slot_id,
+                                     const HashTable& hash_table,
+                                     StoragePrecision_t storage_precision) {
+  try {
+    using Entry = typename HashTable::Entry;
+    const size_t vector_size_in_byte = sizeof(float) * embedding_vec_size;
+    const RowCodec codec(storage_precision, embedding_vec_size);
+    const size_t src_row_size_in_byte = codec.row_size_in_byte();
+
+    std::vector<Entry> entries;
+    entries.reserve(hash_table.size());
+    hash_table.for_each([&entries](const Entry& entry) { entries.push_back(entry); });
+    std::sort(entries.begin(), entries.end(),
+              [](const Entry& a, const Entry& b) { return a.key < b.key; });
+
+    FileDescriptor src(embedding_table_path, O_RDONLY);
+    const size_t num_src_rows = src.size() / src_row_size_in_byte;
+    for (const auto& entry : entries) {
+      if (entry.offset() >= num_src_rows) {
+        CK_THROW_(Error_t::OutOfBound, "A key is out of the rows of " + embedding_table_path);
+      }
+    }
+    ReadOnlyMapping src_rows(src, 0, num_src_rows * src_row_size_in_byte);
+
+    // the index of the rows in the order of the keys
+    HashTable index;
+    index.reserve(entries.size());
+    for (size_t row = 0; row < entries.size(); row++) {
+      index.insert(entries[row].key, entries[row].slot_id(), row);
+    }
+
+    IndexedSnapshotHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, MAGIC, sizeof(MAGIC));
+    header.version = VERSION;
+    header.key_size_in_byte = sizeof(KeyType);
+    header.has_slot_id = has_slot_id;
+    header.embedding_vec_size = embedding_vec_size;
+    header.num_rows = entries.size();
+    header.values_offset = PAGE_SIZE;
+    header.index_offset =
+        round_up(header.values_offset + entries.size() * vector_size_in_byte, PAGE_SIZE);
+    header.index_capacity = index.capacity();
+
+    FileDescriptor dst(snapshot_path, O_WRONLY | O_CREAT | O_TRUNC);
+    dst.resize(header.index_offset + index.capacity() * (1 + sizeof(Entry)));
+    std::vector<char> page(PAGE_SIZE, 0);
+    memcpy(page.data(), &header, sizeof(header));
+    dst.pwrite_full(page.data(), PAGE_SIZE, 0);
+
+    const size_t block_rows = std::max<size_t>(1, block_size_in_byte / vector_size_in_byte);
+    std::vector<char> block(block_rows * vector_size_in_byte);
+    for (size_t begin = 0; begin < entries.size(); begin += block_rows) {
+      const size_t end = std::min(begin + block_rows, entries.size());
+      for (size_t row = begin; row < end; row++) {
+        codec.decode(src_rows.get() + entries[row].offset() * src_row_size_in_byte,
+                     reinterpret_cast<float*>(&block[(row - begin) * vector_size_in_byte]));
+      }
+      dst.pwrite_full(block.data(), (end - begin) * vector_size_in_byte,
+                      header.values_offset + begin * vector_size_in_byte);
+    }
+
+    dst.pwrite_full(reinterpret_cast<const char*>(index.get_ctrl()), index.capacity(),
+                    header.index_offset);
+    dst.pwrite_full(reinterpret_cast<const char*>(index.get_entries()),
+                    index.capacity() * sizeof(Entry), header.index_offset + index.capacity());
+  } catch (const internal_runtime_error& rt_err) {
+    std::cerr << rt_err.what() << std::endl;
+    throw;
+  } catch (const std::exception& err) {
+    std::cerr << err.what() << std::endl;
+    throw;
+  }
+}
+
+template <typename KeyType>
+void IndexedSnapshot<KeyType>::convert_from_snapshot(const std::string& src_path,
+                                                     const std::string& dst_path,
+                                                     size_t embedding_vec_size,
+                                                     bool has_slot_id) {
+  try {
+    // the embedding vectors are split from the keys first, then gathered in the order of keys
+    const std::string embedding_table_path = dst_path + ".values";
+    HashTable hash_table;
+    SnapshotPipeline<KeyType>(embedding_vec_size, has_slot_id)
+        .import_snapshot(src_path, embedding_table_path, hash_table);
+    try {
+      write(dst_path, embedding_table_path, embedding_vec_size, has_slot_id, hash_table);
+    } catch (...) {
+      std::remove(embedding_table_path.c_str());
+      throw;
+    }
+    std::remove(embedding_table_path.c_str());
+  } catch (const internal_runtime_error& rt_err) {
+    std::cerr << rt_err.what() << std::endl;
+    throw;
+  } catch (const std::exception& err) {
+    std::cerr << err.what() << std::endl;
+    throw;
+  }
+}
+
+template <typename KeyType>
+void IndexedSnapshot<KeyType>::convert_to_snapshot(const std::string& src_path,
+                                                   const std::string& dst_path) {
+  try {
+    using Entry = typename HashTable::Entry;
+    const IndexedSnapshotHeader header = read_header(src_path);
+    HashTable hash_table;
+    load_index(src_path, header, hash_table);
+    std::vector<Entry> row_entries(header.num_rows);
+    hash_table.for_each([&row_entries](const Entry& entry) {
+      if (entry.offset() < row_entries.size()) row_entries[entry.offset()] = entry;
+    });
+
+    const size_t vector_size_in_byte = sizeof(float) * header.embedding_vec_size;
+    const size_t slot_id_size_in_byte = header.has_slot_id ? sizeof(size_t) : 0;
+    const size_t row_size_in_byte = sizeof(KeyType) + slot_id_size_in_byte + vector_size_in_byte;
+    FileDescriptor src(src_path, O_RDONLY);
+    ReadOnlyMapping values(src, header.values_offset, header.num_rows * vector_size_in_byte);
+
+    FileDescriptor dst(dst_path, O_WRONLY | O_CREAT | O_TRUNC);
+    const size_t block_rows = std::max<size_t>(1, block_size_in_byte / row_size_in_byte);
+    std::vector<char> block(block_rows * row_size_in_byte);
+    for (size_t begin = 0; begin < header.num_rows; begin += block_rows) {
+      const size_t end = std::min<size_t>(begin + block_rows, header.num_rows);
+      char* dst_row = block.data();
+      for (size_t row = begin; row < end; row++, dst_row += row_size_in_byte) {
+        memcpy(dst_row, &row_entries[row].key, sizeof(KeyType));
+        if (header.has_slot_id) {
+          const size_t slot_id = row_entries[row].slot_id();
+          memcpy(dst_row + sizeof(KeyType), &slot_id, sizeof(size_t));
+        }
+        memcpy(dst_row + sizeof(KeyType) + slot_id_size_in_byte,
+               values.get() + row * vector_size_in_byte, vector_size_in_byte);
+      }
+      dst.pwrite_full(block.data(), (end - begin) * row_size_in_byte, begin * row_size_in_byte);
+    }
+  } catch (const internal_runtime_error& rt_err) {
+    std::cerr << rt_err.what() << std::endl;
+    throw;
+  } catch (const std::exception& err) {
+    std::cerr << err.what() << std::endl;
+    throw;
+  }
+}
+
+template class IndexedSnapshot<unsigned int>;
+template class IndexedSnapshot<long long>;
+
+}  // namespace HugeCTR
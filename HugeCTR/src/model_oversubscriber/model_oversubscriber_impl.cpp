@@ -15,6 +15,8 @@
  */
 
 #include "HugeCTR/include/model_oversubscriber/model_oversubscriber_impl.hpp"
+#include "HugeCTR/include/model_oversubscriber/parallel_for_each.hpp"
+#include "HugeCTR/include/utils.hpp"
 
 namespace HugeCTR {
 
@@ -35,10 +37,11 @@ void ModelOversubscriberImpl<TypeHashKey, TypeEmbeddingComp>::load_(
       CK_THROW_(Error_t::WrongInput, "num of keyset_file and num of embeddings don't equal");
     }
 
-    for (int i = 0; i < static_cast<int>(ps_manager_.get_size()); i++) {
+    thread_for_each(ps_manager_.get_size(), [&](size_t i) {
       ps_manager_.get_parameter_server(i)->load_keyset_from_file(keyset_file_list[i]);
-    }
+    });
 
+    // the parameter servers share a single buffer bag to load through
     for (int i = 0; i < static_cast<int>(ps_manager_.get_size()); i++) {
       auto ptr_ps = ps_manager_.get_parameter_server(i);
 
@@ -56,23 +59,132 @@ void ModelOversubscriberImpl<TypeHashKey, TypeEmbeddingComp>::load_(
 }
 
 template <typename TypeHashKey, typename TypeEmbeddingComp>
-void ModelOversubscriberImpl<TypeHashKey, TypeEmbeddingComp>::store(
-    std::vector<std::string> snapshot_file_list) {
+void ModelOversubscriberImpl<TypeHashKey, TypeEmbeddingComp>::wait_prefetch_() {
+  if (!prefetch_thread_.joinable()) {
+    return;
+  }
+  Timer timer;
+  timer.start();
+  prefetch_thread_.join();
+  timer.stop();
+  timings_["prefetch_wait"] = timer.elapsedMilliseconds();
+  timings_["prefetch"] = prefetch_ms_;
+
+  prefetched_ = !prefetch_error_;
+  if (prefetch_error_) {
+    std::exception_ptr err = prefetch_error_;
+    prefetch_error_ = nullptr;
+    std::rethrow_exception(err);
+  }
+}
+
+template <typename TypeHashKey, typename TypeEmbeddingComp>
+void ModelOversubscriberImpl<TypeHashKey, TypeEmbeddingComp>::prefetch(
+    std::vector<std::string>& keyset_file_list) {
   try {
-    if (snapshot_file_list.size() && snapshot_file_list.size() != embeddings_.size()) {
-      CK_THROW_(Error_t::WrongInput, "num of snapshot_file and num of embeddings don't equal");
+    if (keyset_file_list.size() != embeddings_.size()) {
+      CK_THROW_(Error_t::WrongInput, "num of keyset_file and num of embeddings don't equal");
     }
 
-    for (int i = 0; i < static_cast<int>(embeddings_.size()); i++) {
-      auto ptr_ps = ps_manager_.get_parameter_server(i);
+    // nothing may be dumped to the embedding_file until the prefetch is done, so the one in
+    // flight is waited for and dropped
+    wait_prefetch_();
+    prefetched_ = false;
 
-      size_t dump_size = 0;
-      embeddings_[i]->dump_parameters(ps_manager_.get_buffer_bag(), &dump_size);
-      ptr_ps->dump_param_to_embedding_file(ps_manager_.get_buffer_bag(), dump_size);
+    // the staged buffer bags are allocated here rather than in background
+    for (int i = 0; i < static_cast<int>(ps_manager_.get_size()); i++) {
+      ps_manager_.get_staged_buffer_bag(i);
+    }
+    prefetched_keyset_file_list_ = keyset_file_list;
+    staged_sizes_.assign(ps_manager_.get_size(), 0);
+
+    prefetch_thread_ = std::thread([this]() {
+      try {
+        Timer timer;
+        timer.start();
+        // every parameter server stages into its own buffer bag
+        thread_for_each(ps_manager_.get_size(), [this](size_t i) {
+          auto ptr_ps = ps_manager_.get_parameter_server(i);
+          ptr_ps->load_keyset_from_file(prefetched_keyset_file_list_[i]);
+          ptr_ps->stage_param_from_embedding_file(ps_manager_.get_staged_buffer_bag(i),
+                                                  staged_sizes_[i]);
+        });
+        timer.stop();
+        prefetch_ms_ = timer.elapsedMilliseconds();
+      } catch (...) {
+        prefetch_error_ = std::current_exception();
+      }
+    });
+  } catch (const internal_runtime_error& rt_err) {
+    std::cerr << rt_err.what() << std::endl;
+    throw rt_err;
+  } catch (const std::exception& err) {
+    std::cerr << err.what() << std::endl;
+    throw err;
+  }
+}
 
-      if (!snapshot_file_list.size()) continue;
-      ptr_ps->dump_to_snapshot(snapshot_file_list[i]);
+template <typename TypeHashKey, typename TypeEmbeddingComp>
+void ModelOversubscriberImpl<TypeHashKey, TypeEmbeddingComp>::prefetch(
+  std::string& keyset_file) {
+  try {
+    std::vector<std::string> keyset_file_list(embeddings_.size(), keyset_file);
+    prefetch(keyset_file_list);
+  } catch (const internal_runtime_error& rt_err) {
+    std::cerr << rt_err.what() << std::endl;
+    throw rt_err;
+  } catch (const std::exception& err) {
+    std::cerr << err.what() << std::endl;
+    throw err;
+  }
+}
+
+template <typename TypeHashKey, typename TypeEmbeddingComp>
+void ModelOversubscriberImpl<TypeHashKey, TypeEmbeddingComp>::store_(
+    std::vector<std::string>& snapshot_file_list) {
+  if (snapshot_file_list.size() && snapshot_file_list.size() != embeddings_.size()) {
+    CK_THROW_(Error_t::WrongInput, "num of snapshot_file and num of embeddings don't equal");
+  }
+
+  wait_prefetch_();
+
+  Timer timer, refresh_timer;
+  timer.start();
+  double refresh_ms = 0;
+  for (int i = 0; i < static_cast<int>(embeddings_.size()); i++) {
+    auto ptr_ps = ps_manager_.get_parameter_server(i);
+
+    // only the rows updated since they were loaded are written back
+    size_t dump_size = 0;
+    embeddings_[i]->dump_dirty_parameters(ps_manager_.get_buffer_bag(), &dump_size);
+    ptr_ps->dump_param_to_embedding_file(ps_manager_.get_buffer_bag(), dump_size);
+
+    // and the same rows are the only ones staged by prefetch() which can be out of date
+    if (prefetched_) {
+      refresh_timer.start();
+      ptr_ps->refresh_staged_param(ps_manager_.get_buffer_bag(), dump_size,
+                                   ps_manager_.get_staged_buffer_bag(i), staged_sizes_[i]);
+      refresh_timer.stop();
+      refresh_ms += refresh_timer.elapsedMilliseconds();
     }
+  }
+  // the snapshots don't go through the buffer bag, so they are written together
+  if (snapshot_file_list.size()) {
+    thread_for_each(embeddings_.size(), [&](size_t i) {
+      ps_manager_.get_parameter_server(i)->dump_to_snapshot(snapshot_file_list[i]);
+    });
+  }
+  timer.stop();
+  timings_["store"] = timer.elapsedMilliseconds();
+  if (prefetched_) timings_["refresh"] = refresh_ms;
+}
+
+template <typename TypeHashKey, typename TypeEmbeddingComp>
+void ModelOversubscriberImpl<TypeHashKey, TypeEmbeddingComp>::store(
+    std::vector<std::string> snapshot_file_list) {
+  try {
+    timings_.clear();
+    store_(snapshot_file_list);
   } catch (const internal_runtime_error& rt_err) {
     std::cerr << rt_err.what() << std::endl;
     throw rt_err;
@@ -86,11 +198,29 @@ template <typename TypeHashKey, typename TypeEmbeddingComp>
 void ModelOversubscriberImpl<TypeHashKey, TypeEmbeddingComp>::update(
     std::vector<std::string>& keyset_file_list) {
   try {
-    store();
+    timings_.clear();
+    std::vector<std::string> snapshot_file_list;
+    store_(snapshot_file_list);
+
+    Timer timer;
+    timer.start();
     for (auto& one_embedding : embeddings_) {
       one_embedding->reset();
     }
-    load_(keyset_file_list);
+    timer.stop();
+    timings_["reset"] = timer.elapsedMilliseconds();
+
+    timer.start();
+    if (prefetched_ && keyset_file_list == prefetched_keyset_file_list_) {
+      for (int i = 0; i < static_cast<int>(embeddings_.size()); i++) {
+        embeddings_[i]->load_parameters(ps_manager_.get_staged_buffer_bag(i), staged_sizes_[i]);
+      }
+    } else {
+      load_(keyset_file_list);
+    }
+    prefetched_ = false;
+    timer.stop();
+    timings_["load"] = timer.elapsedMilliseconds();
   } catch (const internal_runtime_error& rt_err) {
     std::cerr << rt_err.what() << std::endl;
     throw rt_err;
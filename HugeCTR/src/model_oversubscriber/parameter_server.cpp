@@ -16,8 +16,8 @@
 
 #include <model_oversubscriber/parameter_server.hpp>
 #include <model_oversubscriber/distributed_parameter_server_delegate.hpp>
+#include <model_oversubscriber/radix_sort.hpp>
 
-#include <map>
 #include <omp.h>
 #include <cstdio>
 #include <algorithm>
@@ -71,6 +71,13 @@ void open_and_get_size(
   stream.seekg(0, stream.beg);
 }
 
+// a row written by dump_param(): its offset in the embedding_file, and its index in the dump
+struct DumpRow {
+  size_t row;
+  size_t index;
+  size_t offset() const { return row; }
+};
+
 } // namespace
 
 template <typename TypeHashKey, typename TypeEmbeddingComp>
@@ -95,7 +102,7 @@ void ParameterServer<TypeHashKey, TypeEmbeddingComp>::map_embedding_to_memory_()
     // handle empty file for trainning from scratch
     // but writting to empty file may cause error because only one page is mapped
     size_t mmaped_file_size = (!file_size_in_byte_) ? 128 : file_size_in_byte_;
-    mmaped_table_ = (float *)mmap(NULL, mmaped_file_size, PROT_READ|PROT_WRITE, MAP_SHARED, fd_, 0);
+    mmaped_table_ = (char *)mmap(NULL, mmaped_file_size, PROT_READ|PROT_WRITE, MAP_SHARED, fd_, 0);
     if (mmaped_table_ == MAP_FAILED) {
       close(fd_);
       fd_ = -1;
@@ -140,13 +147,84 @@ void ParameterServer<TypeHashKey, TypeEmbeddingComp>::unmap_embedding_from_memor
   }
 }
 
+template <typename TypeHashKey, typename TypeEmbeddingComp>
+void ParameterServer<TypeHashKey, TypeEmbeddingComp>::open_indexed_snapshot_(
+    const std::string& snapshot_file) {
+  try {
+    const IndexedSnapshotHeader header =
+        IndexedSnapshot<TypeHashKey>::read_header(snapshot_file);
+    if (header.embedding_vec_size != embedding_params_.embedding_vec_size ||
+        header.has_slot_id != (is_distributed_ ? 0u : 1u)) {
+      CK_THROW_(Error_t::WrongInput, "The indexed snapshot " + snapshot_file +
+                                         " does not match the embedding");
+    }
+    IndexedSnapshot<TypeHashKey>::load_index(snapshot_file, header, hash_table_);
+
+    // the embedding_file takes no space until rows are written to it
+    const size_t embedding_vector_size_in_byte =
+        sizeof(float) * embedding_params_.embedding_vec_size;
+    const size_t row_size_in_byte = codec_.row_size_in_byte();
+    std::ofstream embedding_table_stream(
+        embedding_table_path_, std::ofstream::binary | std::ofstream::trunc);
+    if (!embedding_table_stream.is_open()) {
+      CK_THROW_(Error_t::WrongInput, "Cannot open the file: " + embedding_table_path_);
+    }
+    embedding_table_stream.close();
+    if (truncate(embedding_table_path_.c_str(),
+                 header.num_rows * row_size_in_byte) != 0) {
+      CK_THROW_(Error_t::FileCannotOpen, "Cannot resize the file: " + embedding_table_path_);
+    }
+
+    if (header.num_rows) {
+      int fd = open(snapshot_file.c_str(), O_RDONLY);
+      if (fd == -1) {
+        CK_THROW_(Error_t::FileCannotOpen, "Cannot open the file: " + snapshot_file);
+      }
+      base_map_size_in_byte_ =
+          header.values_offset + header.num_rows * embedding_vector_size_in_byte;
+      base_map_ = mmap(NULL, base_map_size_in_byte_, PROT_READ, MAP_SHARED, fd, 0);
+      close(fd);
+      if (base_map_ == MAP_FAILED) {
+        base_map_ = nullptr;
+        CK_THROW_(Error_t::WrongInput, "Mmap file " + snapshot_file + " failed");
+      }
+      base_table_ = reinterpret_cast<const float*>(static_cast<const char*>(base_map_) +
+                                                   header.values_offset);
+      num_base_rows_ = header.num_rows;
+      in_embedding_file_.assign(num_base_rows_, 0);
+    }
+  } catch (const internal_runtime_error& rt_err) {
+    std::cerr << rt_err.what() << std::endl;
+    throw;
+  } catch (const std::exception& err) {
+    std::cerr << err.what() << std::endl;
+    throw;
+  }
+}
+
+template <typename TypeHashKey, typename TypeEmbeddingComp>
+void ParameterServer<TypeHashKey, TypeEmbeddingComp>::release_base_table_() {
+  if (base_map_) {
+    munmap(base_map_, base_map_size_in_byte_);
+  }
+  base_map_ = nullptr;
+  base_map_size_in_byte_ = 0;
+  base_table_ = nullptr;
+  num_base_rows_ = 0;
+  std::vector<uint8_t>().swap(in_embedding_file_);
+}
+
 template <typename TypeHashKey, typename TypeEmbeddingComp>
 ParameterServer<TypeHashKey, TypeEmbeddingComp>::ParameterServer(
     const SparseEmbeddingHashParams<TypeEmbeddingComp>& embedding_params,
     const std::string& snapshot_src_file,
     const std::string& temp_embedding_dir,
-    const Embedding_t embedding_type)
+    const Embedding_t embedding_type,
+    size_t host_cache_capacity,
+    CachePolicy_t host_cache_policy,
+    StoragePrecision_t storage_precision)
   : embedding_params_(embedding_params),
+    codec_(storage_precision, embedding_params.embedding_vec_size),
     embedding_table_path_(temp_embedding_dir + "/" + generate_random_file_name()),
     is_distributed_(embedding_type == Embedding_t::DistributedSlotSparseEmbeddingHash
                     ? true : false),
@@ -156,23 +234,36 @@ ParameterServer<TypeHashKey, TypeEmbeddingComp>::ParameterServer(
     fd_{-1},
     maped_to_memory_{false} {
   try {
-    std::ifstream snapshot_stream;
-    size_t file_size_in_byte = 0;
-    open_and_get_size(snapshot_src_file, snapshot_stream, file_size_in_byte);
-
-    std::ofstream embedding_table_stream(
-        embedding_table_path_, std::ofstream::binary | std::ofstream::trunc);
-    if (!embedding_table_stream.is_open()) {
-      CK_THROW_(Error_t::WrongInput, "Cannot open the file: " + embedding_table_path_);
+    if (IndexedSnapshot<TypeHashKey>::is_indexed_snapshot(snapshot_src_file)) {
+      open_indexed_snapshot_(snapshot_src_file);
+    } else {
+      // let the delegate fill the hash table and the embedding file
+      parameter_server_delegate_->load_from_snapshot(embedding_table_path_,
+                                                     snapshot_src_file,
+                                                     embedding_params_.embedding_vec_size,
+                                                     codec_.get_precision(),
+                                                     hash_table_);
+    }
+    // a row of the embedding_file without a key is free
+    struct stat embedding_table_stat;
+    if (stat(embedding_table_path_.c_str(), &embedding_table_stat) != 0) {
+      CK_THROW_(Error_t::FileCannotOpen, "Cannot open the file: " + embedding_table_path_);
+    }
+    num_rows_ = embedding_table_stat.st_size / codec_.row_size_in_byte();
+    if (num_rows_ > hash_table_.size()) {
+      std::vector<uint8_t> used_rows(num_rows_, 0);
+      hash_table_.for_each(
+          [&used_rows](const typename HashTable::Entry& e) { used_rows[e.offset()] = 1; });
+      for (size_t row = num_rows_; row-- > 0;) {
+        if (!used_rows[row]) free_rows_.push_back(row);
+      }
     }
 
-    // let the delegate fill the hash table
-    parameter_server_delegate_->load_from_snapshot(embedding_table_stream,
-                                                   snapshot_stream,
-                                                   file_size_in_byte,
-                                                   embedding_params_.embedding_vec_size,
-                                                   hash_table_);
-
+    if (host_cache_capacity) {
+      host_cache_.reset(new HostRowCache(host_cache_capacity,
+                                         embedding_params_.embedding_vec_size,
+                                         host_cache_policy));
+    }
   }
   catch (const internal_runtime_error& rt_err) {
     std::cerr << rt_err.what() << std::endl;
@@ -186,6 +277,11 @@ ParameterServer<TypeHashKey, TypeEmbeddingComp>::ParameterServer(
 
 template <typename TypeHashKey, typename TypeEmbeddingComp>
 ParameterServer<TypeHashKey, TypeEmbeddingComp>::~ParameterServer() {
+  if (compaction_thread_.joinable()) {
+    compaction_thread_.join();
+    std::remove((embedding_table_path_ + ".compact").c_str());
+  }
+  release_base_table_();
   if (maped_to_memory_) {
     unmap_embedding_from_memory_();
   }
@@ -225,67 +321,133 @@ void ParameterServer<TypeHashKey, TypeEmbeddingComp>::load_param_from_embedding_
     }
 
     TypeHashKey* keys = Tensor2<TypeHashKey>::stretch_from(buf_bag.keys).get_ptr();
-    float* hash_table_val = buf_bag.embedding.get_ptr();
+    size_t* slot_id =
+        is_distributed_ ? nullptr : Tensor2<size_t>::stretch_from(buf_bag.slot_id).get_ptr();
+    hit_size = load_param(keyset_.data(), keyset_.size(), keys, slot_id,
+                          buf_bag.embedding.get_ptr());
+  } catch (const internal_runtime_error& rt_err) {
+    std::cerr << rt_err.what() << std::endl;
+    throw;
+  } catch (const std::exception& err) {
+    std::cerr << err.what() << std::endl;
+    throw;
+  }
+}
 
-    std::vector<size_t> idx_exist;
-    size_t cnt_hit_keys = 0;
+template <typename TypeHashKey, typename TypeEmbeddingComp>
+size_t ParameterServer<TypeHashKey, TypeEmbeddingComp>::load_param(
+     const TypeHashKey* keyset, size_t num_keys, TypeHashKey* keys, size_t* slot_id,
+     float* hash_table_val) {
+  try {
+    if (num_keys == 0) {
+      return 0;
+    }
 
-    if (is_distributed_) {
-      std::map<size_t, TypeHashKey> pair_exist;
-      for (size_t cnt = 0; cnt < keyset_.size(); cnt++) {
-        auto iter = hash_table_.find(keyset_[cnt]);
-        if (iter == hash_table_.end()) continue;
-        pair_exist.insert({iter->second.second, iter->first});
-      }
+    const int num_threads = omp_get_max_threads();
+    const size_t prefetch_distance = 8;
 
-      idx_exist.reserve(pair_exist.size());
-      for (auto& pair : pair_exist) {
-        keys[cnt_hit_keys++] = pair.second;
-        idx_exist.push_back(pair.first);
-      }
-    } else {
-      size_t* slot_id = Tensor2<size_t>::stretch_from(buf_bag.slot_id).get_ptr();
-      std::map<size_t, std::pair<TypeHashKey, size_t>> pair_exist;
-      for (size_t cnt = 0; cnt < keyset_.size(); cnt++) {
-        auto iter = hash_table_.find(keyset_[cnt]);
-        if (iter == hash_table_.end()) continue;
-        pair_exist.insert({iter->second.second, {iter->first, iter->second.first}});
+    // look the keys up in parallel, and sort the hits by their offsets in the embedding file
+    // to read it sequentially
+    std::vector<std::vector<typename HashTable::Entry>> thread_hits(num_threads);
+  #pragma omp parallel num_threads(num_threads)
+    {
+      const size_t tid = omp_get_thread_num();
+      const size_t thread_num = omp_get_num_threads();
+      const size_t begin = num_keys * tid / thread_num;
+      const size_t end = num_keys * (tid + 1) / thread_num;
+      auto& hits = thread_hits[tid];
+      hits.reserve(end - begin);
+      for (size_t cnt = begin; cnt < end; cnt++) {
+        if (cnt + prefetch_distance < end) {
+          hash_table_.prefetch(keyset[cnt + prefetch_distance]);
+        }
+        auto entry = hash_table_.find(keyset[cnt]);
+        if (entry != nullptr) hits.push_back(*entry);
       }
+    }
 
-      idx_exist.reserve(pair_exist.size());
-      for (auto& pair : pair_exist) {
-        keys[cnt_hit_keys] = pair.second.first;
-        slot_id[cnt_hit_keys] = pair.second.second;
-        idx_exist.push_back(pair.first);
-        cnt_hit_keys++;
-      }
+    std::vector<typename HashTable::Entry> hits;
+    size_t num_hits = 0;
+    for (auto& thread_hit : thread_hits) num_hits += thread_hit.size();
+    hits.reserve(num_hits);
+    for (auto& thread_hit : thread_hits) {
+      hits.insert(hits.end(), thread_hit.begin(), thread_hit.end());
+      std::vector<typename HashTable::Entry>().swap(thread_hit);
+    }
+    radix_sort_by_offset(hits, num_rows_, num_threads);
+    // a key repeated in the keyset
+    hits.erase(std::unique(hits.begin(), hits.end(),
+                           [](const typename HashTable::Entry& a,
+                              const typename HashTable::Entry& b) {
+                             return a.offset() == b.offset();
+                           }),
+               hits.end());
+
+    const size_t cnt_hit_keys = hits.size();
+    std::vector<size_t> idx_exist(cnt_hit_keys);
+    if (is_distributed_) slot_id = nullptr;
+  #pragma omp parallel for num_threads(num_threads)
+    for (size_t cnt = 0; cnt < cnt_hit_keys; cnt++) {
+      keys[cnt] = hits[cnt].key;
+      idx_exist[cnt] = hits[cnt].offset();
+      if (slot_id) slot_id[cnt] = hits[cnt].slot_id();
     }
 
     const size_t embedding_vec_size = embedding_params_.embedding_vec_size;
     const size_t embedding_vector_size_in_byte = sizeof(float) * embedding_vec_size;
 
-    if (!maped_to_memory_) {
-      map_embedding_to_memory_();
-    }
+    if (host_cache_) {
+      // the slots are resolved serially, and the rows copied in parallel; the embedding file
+      // is touched only by the misses
+      std::vector<uint32_t> slots(cnt_hit_keys);
+      std::vector<uint8_t> cached(cnt_hit_keys);
+      bool all_cached = true;
+      for (size_t cnt = 0; cnt < cnt_hit_keys; cnt++) {
+        bool hit = false;
+        slots[cnt] = host_cache_->acquire(idx_exist[cnt], hit);
+        cached[cnt] = hit;
+        all_cached = all_cached && hit;
+      }
+      if (!all_cached && !maped_to_memory_) {
+        map_embedding_to_memory_();
+      }
 
-  #pragma omp parallel num_threads(8)
-    {
-      const size_t tid = omp_get_thread_num();
-      const size_t thread_num = omp_get_num_threads();
-      size_t sub_chunk_size = idx_exist.size() / thread_num;
-      size_t res_chunk_size = idx_exist.size() % thread_num;
-      const size_t idx = tid * sub_chunk_size;
+  #pragma omp parallel for num_threads(num_threads)
+      for (size_t cnt = 0; cnt < cnt_hit_keys; cnt++) {
+        float* dst = &hash_table_val[cnt * embedding_vec_size];
+        if (cached[cnt]) {
+          memcpy(dst, host_cache_->get_row(slots[cnt]), embedding_vector_size_in_byte);
+        } else {
+          read_row_(idx_exist[cnt], dst);
+          if (slots[cnt] != HostRowCache::NO_SLOT) {
+            memcpy(host_cache_->get_row(slots[cnt]), dst, embedding_vector_size_in_byte);
+          }
+        }
+      }
+      host_cache_->end_batch();
+    } else {
+      if (!maped_to_memory_) {
+        map_embedding_to_memory_();
+      }
+
+  #pragma omp parallel num_threads(num_threads)
+      {
+        const size_t tid = omp_get_thread_num();
+        const size_t thread_num = omp_get_num_threads();
+        size_t sub_chunk_size = idx_exist.size() / thread_num;
+        size_t res_chunk_size = idx_exist.size() % thread_num;
+        const size_t idx = tid * sub_chunk_size;
 
-      if (tid == thread_num - 1) sub_chunk_size += res_chunk_size;
+        if (tid == thread_num - 1) sub_chunk_size += res_chunk_size;
 
-      for (size_t i = 0; i < sub_chunk_size; i++) {
-        size_t src_idx = idx_exist[idx + i] * embedding_vec_size;
-        size_t dst_idx = (idx + i) * embedding_vec_size;
-        memcpy(&hash_table_val[dst_idx], &mmaped_table_[src_idx], embedding_vector_size_in_byte);
+        for (size_t i = 0; i < sub_chunk_size; i++) {
+          size_t dst_idx = (idx + i) * embedding_vec_size;
+          read_row_(idx_exist[idx + i], &hash_table_val[dst_idx]);
+        }
       }
     }
 
-    hit_size = cnt_hit_keys;
+    return cnt_hit_keys;
 
   } catch (const internal_runtime_error& rt_err) {
     std::cerr << rt_err.what() << std::endl;
@@ -297,86 +459,172 @@ void ParameterServer<TypeHashKey, TypeEmbeddingComp>::load_param_from_embedding_
 }
   
 template <typename TypeHashKey, typename TypeEmbeddingComp>
-void ParameterServer<TypeHashKey, TypeEmbeddingComp>::dump_param_to_embedding_file(
-     BufferBag &buf_bag, const size_t dump_size) {
+void ParameterServer<TypeHashKey, TypeEmbeddingComp>::stage_param_from_embedding_file(
+     BufferBag &buf_bag, size_t& staged_size) {
   try {
+    load_param_from_embedding_file(buf_bag, staged_size);
 
+    // the keys of keyset_ missing in the embedding file are kept too, so that they are found
+    // once a dump adds them
+    const size_t NOT_STAGED = (size_t(1) << HashTable::OFFSET_BITS) - 1;
     const TypeHashKey* keys = Tensor2<TypeHashKey>::stretch_from(buf_bag.keys).get_ptr();
-    const float* hash_table_val = buf_bag.embedding.get_ptr();
-
-    size_t cnt_new_keys = 0;
-    const size_t hash_table_size = hash_table_.size();
-
-    std::vector<size_t> idx_exist_src, idx_exist_dst, idx_miss_src;
-    std::map<size_t, size_t> idx_exist;
-    if (is_distributed_) {
-      for (size_t cnt = 0; cnt < dump_size; cnt++) {
-        auto iter = hash_table_.find(keys[cnt]);
-        if (iter == hash_table_.end()) {
-          hash_table_.insert({keys[cnt], {0, hash_table_size + cnt_new_keys}});
-          idx_miss_src.push_back(cnt);
-          cnt_new_keys++;
-        } else {
-          idx_exist.insert({iter->second.second, cnt});
-        }
-      }
-    } else {
-      const size_t* slot_id = Tensor2<size_t>::stretch_from(buf_bag.slot_id).get_ptr();
-      for (size_t cnt = 0; cnt < dump_size; cnt++) {
-        auto iter = hash_table_.find(keys[cnt]);
-        if (iter == hash_table_.end()) {
-          hash_table_.insert({keys[cnt], {slot_id[cnt], hash_table_size + cnt_new_keys}});
-          idx_miss_src.push_back(cnt);
-          cnt_new_keys++;
-        } else {
-          idx_exist.insert({iter->second.second, cnt});
-        }
-      }
+    staged_index_.clear();
+    staged_index_.reserve(keyset_.size());
+    for (size_t cnt = 0; cnt < staged_size; cnt++) {
+      staged_index_.insert(keys[cnt], 0, cnt);
     }
-
-    idx_exist_src.reserve(idx_exist.size());
-    idx_exist_dst.reserve(idx_exist.size());
-    for (auto& pair : idx_exist) {
-      idx_exist_src.push_back(pair.second);
-      idx_exist_dst.push_back(pair.first);
+    for (auto key : keyset_) {
+      staged_index_.insert(key, 0, NOT_STAGED);
     }
+  } catch (const internal_runtime_error& rt_err) {
+    std::cerr << rt_err.what() << std::endl;
+    throw;
+  } catch (const std::exception& err) {
+    std::cerr << err.what() << std::endl;
+    throw;
+  }
+}
 
+template <typename TypeHashKey, typename TypeEmbeddingComp>
+size_t ParameterServer<TypeHashKey, TypeEmbeddingComp>::refresh_staged_param(
+     BufferBag &dump_bag, const size_t dump_size, BufferBag &staged_bag, size_t& staged_size) {
+  try {
+    const size_t NOT_STAGED = (size_t(1) << HashTable::OFFSET_BITS) - 1;
     const size_t embedding_vec_size = embedding_params_.embedding_vec_size;
     const size_t embedding_vector_size_in_byte = sizeof(float) * embedding_vec_size;
+    const TypeHashKey* dump_keys = Tensor2<TypeHashKey>::stretch_from(dump_bag.keys).get_ptr();
+    const float* dump_val = dump_bag.embedding.get_ptr();
+    Tensor2<TypeHashKey> staged_keys_tensor = Tensor2<TypeHashKey>::stretch_from(staged_bag.keys);
+    TypeHashKey* staged_keys = staged_keys_tensor.get_ptr();
+    float* staged_val = staged_bag.embedding.get_ptr();
+    const size_t* dump_slot_id = nullptr;
+    size_t* staged_slot_id = nullptr;
+    if (!is_distributed_) {
+      dump_slot_id = Tensor2<size_t>::stretch_from(dump_bag.slot_id).get_ptr();
+      staged_slot_id = Tensor2<size_t>::stretch_from(staged_bag.slot_id).get_ptr();
+    }
 
-    // update existed embedding
-    if (!maped_to_memory_) {
-      map_embedding_to_memory_();
+    // the staged rows are overwritten in parallel, the new ones are appended after
+    std::vector<size_t> idx_new;
+    size_t cnt_copied = 0;
+  #pragma omp parallel for reduction(+ : cnt_copied)
+    for (size_t cnt = 0; cnt < dump_size; cnt++) {
+      auto entry = staged_index_.find(dump_keys[cnt]);
+      if (entry == nullptr) continue;
+      if (entry->offset() == NOT_STAGED) {
+  #pragma omp critical
+        idx_new.push_back(cnt);
+        continue;
+      }
+      memcpy(&staged_val[entry->offset() * embedding_vec_size],
+             &dump_val[cnt * embedding_vec_size], embedding_vector_size_in_byte);
+      cnt_copied++;
     }
 
-#pragma omp parallel num_threads(8)
-    {
-      const size_t tid = omp_get_thread_num();
-      const size_t thread_num = omp_get_num_threads();
-      size_t sub_chunk_size = idx_exist_src.size() / thread_num;
-      size_t res_chunk_size = idx_exist_src.size() % thread_num;
-      const size_t idx = tid * sub_chunk_size;
+    std::sort(idx_new.begin(), idx_new.end());
+    if (staged_size + idx_new.size() > staged_keys_tensor.get_num_elements()) {
+      CK_THROW_(Error_t::OutOfBound, "The staged keys exceed the size of the buffer bag");
+    }
+    for (size_t cnt : idx_new) {
+      staged_keys[staged_size] = dump_keys[cnt];
+      if (staged_slot_id) staged_slot_id[staged_size] = dump_slot_id[cnt];
+      memcpy(&staged_val[staged_size * embedding_vec_size], &dump_val[cnt * embedding_vec_size],
+             embedding_vector_size_in_byte);
+      staged_size++;
+    }
+    return cnt_copied + idx_new.size();
+  } catch (const internal_runtime_error& rt_err) {
+    std::cerr << rt_err.what() << std::endl;
+    throw;
+  } catch (const std::exception& err) {
+    std::cerr << err.what() << std::endl;
+    throw;
+  }
+}
+
+template <typename TypeHashKey, typename TypeEmbeddingComp>
+void ParameterServer<TypeHashKey, TypeEmbeddingComp>::dump_param_to_embedding_file(
+     BufferBag &buf_bag, const size_t dump_size) {
+  try {
+    const TypeHashKey* keys = Tensor2<TypeHashKey>::stretch_from(buf_bag.keys).get_ptr();
+    const size_t* slot_id =
+        is_distributed_ ? nullptr : Tensor2<size_t>::stretch_from(buf_bag.slot_id).get_ptr();
+    dump_param(keys, slot_id, buf_bag.embedding.get_ptr(), dump_size);
+  } catch (const internal_runtime_error& rt_err) {
+    std::cerr << rt_err.what() << std::endl;
+    throw;
+  } catch (const std::exception& err) {
+    std::cerr << err.what() << std::endl;
+    throw;
+  }
+}
 
-      if (tid == thread_num - 1) sub_chunk_size += res_chunk_size;
+template <typename TypeHashKey, typename TypeEmbeddingComp>
+void ParameterServer<TypeHashKey, TypeEmbeddingComp>::dump_param(
+     const TypeHashKey* keys, const size_t* slot_id, const float* hash_table_val,
+     const size_t dump_size) {
+  try {
 
-      for (size_t i = 0; i < sub_chunk_size; i++) {
-        size_t src_idx = idx_exist_src[idx + i] * embedding_vec_size;
-        size_t dst_idx = idx_exist_dst[idx + i] * embedding_vec_size;
-        memcpy(&mmaped_table_[dst_idx], &hash_table_val[src_idx], embedding_vector_size_in_byte);
+    wait_compaction_();
+    if (is_distributed_) slot_id = nullptr;
+
+    // the new keys take the free rows first, and the rest are appended to the file; all the
+    // rows are then written through the mapping in the order of their offsets
+    const int num_threads = omp_get_max_threads();
+    std::vector<DumpRow> rows;
+    rows.reserve(dump_size);
+    for (size_t cnt = 0; cnt < dump_size; cnt++) {
+      auto entry = hash_table_.find(keys[cnt]);
+      if (entry == nullptr) {
+        size_t offset = num_rows_;
+        if (free_rows_.empty()) {
+          num_rows_++;
+        } else {
+          offset = free_rows_.back();
+          free_rows_.pop_back();
+        }
+        hash_table_.insert(keys[cnt], slot_id ? slot_id[cnt] : 0, offset);
+        rows.push_back({offset, cnt});
+      } else {
+        rows.push_back({entry->offset(), cnt});
       }
     }
-    unmap_embedding_from_memory_();
+    if (rows.empty()) {
+      return;
+    }
+    // the sort is stable, so a key repeated in the dump keeps its first row
+    radix_sort_by_offset(rows, num_rows_, num_threads);
+    rows.erase(std::unique(rows.begin(), rows.end(),
+                           [](const DumpRow& a, const DumpRow& b) { return a.row == b.row; }),
+               rows.end());
 
-    // append new embedding to file
-    std::ofstream embedding_file;
-    embedding_file.open(embedding_table_path_, std::ofstream::binary | std::ofstream::app);
-    if (!embedding_file.is_open()) {
-      CK_THROW_(Error_t::WrongInput, "Cannot open the file: " + embedding_table_path_);
+    const size_t embedding_vec_size = embedding_params_.embedding_vec_size;
+    const size_t row_size_in_byte = codec_.row_size_in_byte();
+
+    dirty_rows_.resize(num_rows_, 0);
+
+    // the appended rows are allocated at once, instead of being written one by one
+    const size_t new_file_size_in_byte = num_rows_ * row_size_in_byte;
+    if (maped_to_memory_ && file_size_in_byte_ != new_file_size_in_byte) {
+      unmap_embedding_from_memory_();
+    }
+    if (!maped_to_memory_) {
+      if (truncate(embedding_table_path_.c_str(), new_file_size_in_byte) != 0) {
+        CK_THROW_(Error_t::FileCannotOpen, "Cannot resize the file: " + embedding_table_path_);
+      }
+      map_embedding_to_memory_();
     }
-    for (size_t cnt = 0; cnt < cnt_new_keys; cnt++) {
-      size_t src_idx = idx_miss_src[cnt] * embedding_vec_size;
-      embedding_file.write((char*)(&hash_table_val[src_idx]), embedding_vector_size_in_byte);
+
+#pragma omp parallel for num_threads(num_threads)
+    for (size_t i = 0; i < rows.size(); i++) {
+      const size_t src_idx = rows[i].index * embedding_vec_size;
+      const size_t dst_idx = rows[i].row * row_size_in_byte;
+      codec_.encode(&hash_table_val[src_idx], &mmaped_table_[dst_idx]);
+      if (host_cache_) host_cache_->update(rows[i].row, &hash_table_val[src_idx]);
+      if (rows[i].row < num_base_rows_) in_embedding_file_[rows[i].row] = 1;
+      dirty_rows_[rows[i].row] = 1;
     }
+    unmap_embedding_from_memory_();
 
   } catch (const internal_runtime_error& rt_err) {
     std::cerr << rt_err.what() << std::endl;
@@ -392,20 +640,16 @@ template <typename TypeHashKey, typename TypeEmbeddingComp>
 void ParameterServer<TypeHashKey, TypeEmbeddingComp>::dump_to_snapshot(
   const std::string& snapshot_dst_file) {
   try {
-    std::ofstream snapshot(
-        snapshot_dst_file, std::ofstream::binary | std::ofstream::trunc);
-    if (!snapshot.is_open()) {
-      CK_THROW_(Error_t::WrongInput, "Cannot open the file: " + snapshot_dst_file);
+    // the delegates expect the rows of the embedding_file to be all live and in it
+    wait_compaction_();
+    if (!free_rows_.empty() || base_table_) {
+      compact();
     }
 
-    std::ifstream embedding_table;
-    size_t file_size_in_byte = 0;
-    open_and_get_size(embedding_table_path_, embedding_table, file_size_in_byte);
-
-    parameter_server_delegate_->store_to_snapshot(snapshot,
-                                                  embedding_table,
-                                                  file_size_in_byte,
+    parameter_server_delegate_->store_to_snapshot(snapshot_dst_file,
+                                                  embedding_table_path_,
                                                   embedding_params_.embedding_vec_size,
+                                                  codec_.get_precision(),
                                                   hash_table_);
   }
   catch (const internal_runtime_error& rt_err) {
@@ -418,15 +662,218 @@ void ParameterServer<TypeHashKey, TypeEmbeddingComp>::dump_to_snapshot(
   }
 }
 
+template <typename TypeHashKey, typename TypeEmbeddingComp>
+void ParameterServer<TypeHashKey, TypeEmbeddingComp>::dump_to_indexed_snapshot(
+    const std::string& snapshot_dst_file) {
+  try {
+    // the rows are gathered from the embedding_file, so none may be left in a snapshot opened
+    // in place, which may also be the one to overwrite
+    wait_compaction_();
+    if (base_table_) {
+      compact();
+    }
+    IndexedSnapshot<TypeHashKey>::write(snapshot_dst_file, embedding_table_path_,
+                                        embedding_params_.embedding_vec_size, !is_distributed_,
+                                        hash_table_, codec_.get_precision());
+  } catch (const internal_runtime_error& rt_err) {
+    std::cerr << rt_err.what() << std::endl;
+    throw;
+  } catch (const std::exception& err) {
+    std::cerr << err.what() << std::endl;
+    throw;
+  }
+}
+
 template <typename TypeHashKey, typename TypeEmbeddingComp>
 std::vector<TypeHashKey>
 ParameterServer<TypeHashKey, TypeEmbeddingComp>::get_keys_from_hash_table() const {
-  auto get_key_op = [](auto e){ return e.first; };
-  std::vector<TypeHashKey> keys(hash_table_.size());
-  transform(hash_table_.begin(), hash_table_.end(), keys.begin(), get_key_op);
+  std::vector<TypeHashKey> keys;
+  keys.reserve(hash_table_.size());
+  hash_table_.for_each([&keys](const typename HashTable::Entry& e) { keys.push_back(e.key); });
+  return keys;
+}
+
+template <typename TypeHashKey, typename TypeEmbeddingComp>
+std::vector<TypeHashKey> ParameterServer<TypeHashKey, TypeEmbeddingComp>::get_dirty_keys() const {
+  std::vector<TypeHashKey> keys;
+  keys.reserve(get_num_dirty());
+  hash_table_.for_each([this, &keys](const typename HashTable::Entry& e) {
+    if (e.offset() < dirty_rows_.size() && dirty_rows_[e.offset()]) keys.push_back(e.key);
+  });
   return keys;
 }
 
+template <typename TypeHashKey, typename TypeEmbeddingComp>
+size_t ParameterServer<TypeHashKey, TypeEmbeddingComp>::get_num_dirty() const {
+  return std::count(dirty_rows_.begin(), dirty_rows_.end(), 1);
+}
+
+template <typename TypeHashKey, typename TypeEmbeddingComp>
+bool ParameterServer<TypeHashKey, TypeEmbeddingComp>::is_dirty(TypeHashKey key) const {
+  auto entry = hash_table_.find(key);
+  return entry != nullptr && entry->offset() < dirty_rows_.size() && dirty_rows_[entry->offset()];
+}
+
+template <typename TypeHashKey, typename TypeEmbeddingComp>
+void ParameterServer<TypeHashKey, TypeEmbeddingComp>::clear_dirty() {
+  std::fill(dirty_rows_.begin(), dirty_rows_.end(), 0);
+}
+
+template <typename TypeHashKey, typename TypeEmbeddingComp>
+size_t ParameterServer<TypeHashKey, TypeEmbeddingComp>::erase_keys(
+    const std::vector<TypeHashKey>& keys) {
+  try {
+    wait_compaction_();
+
+    size_t cnt_erased = 0;
+    for (auto key : keys) {
+      auto entry = hash_table_.find(key);
+      if (entry == nullptr) continue;
+      const size_t offset = entry->offset();
+      hash_table_.erase(key);
+      free_rows_.push_back(offset);
+      if (offset < dirty_rows_.size()) dirty_rows_[offset] = 0;
+      cnt_erased++;
+    }
+    return cnt_erased;
+  } catch (const internal_runtime_error& rt_err) {
+    std::cerr << rt_err.what() << std::endl;
+    throw;
+  } catch (const std::exception& err) {
+    std::cerr << err.what() << std::endl;
+    throw;
+  }
+}
+
+template <typename TypeHashKey, typename TypeEmbeddingComp>
+void ParameterServer<TypeHashKey, TypeEmbeddingComp>::start_compaction() {
+  try {
+    wait_compaction_();
+
+    compaction_order_.clear();
+    compaction_order_.reserve(hash_table_.size());
+    hash_table_.for_each(
+        [this](const typename HashTable::Entry& e) { compaction_order_.push_back(e); });
+    std::sort(compaction_order_.begin(), compaction_order_.end(),
+              [](const typename HashTable::Entry& a, const typename HashTable::Entry& b) {
+                return a.key < b.key;
+              });
+
+    const size_t num_rows = num_rows_;
+    compaction_thread_ = std::thread([this, num_rows]() {
+      const std::string src_path = embedding_table_path_;
+      const std::string dst_path = embedding_table_path_ + ".compact";
+      const size_t row_size_in_byte = codec_.row_size_in_byte();
+      const size_t src_size_in_byte = num_rows * row_size_in_byte;
+      int src_fd = -1, dst_fd = -1;
+      char* src = nullptr;
+      try {
+        // the old file is read through a mapping of its own, and the new one is written in
+        // chunks of rows
+        src_fd = open(src_path.c_str(), O_RDONLY);
+        dst_fd = open(dst_path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, S_IRUSR | S_IWUSR);
+        if (src_fd == -1 || dst_fd == -1) {
+          CK_THROW_(Error_t::FileCannotOpen, "Cannot open the file: " + dst_path);
+        }
+        if (src_size_in_byte) {
+          src = (char*)mmap(NULL, src_size_in_byte, PROT_READ, MAP_SHARED, src_fd, 0);
+          if (src == MAP_FAILED) {
+            src = nullptr;
+            CK_THROW_(Error_t::WrongInput, "Mmap file " + src_path + " failed");
+          }
+        }
+
+        const size_t chunk_rows = std::max<size_t>(1, (size_t(64) << 20) / row_size_in_byte);
+        std::vector<char> chunk(chunk_rows * row_size_in_byte);
+        for (size_t begin = 0; begin < compaction_order_.size(); begin += chunk_rows) {
+          const size_t end = std::min(begin + chunk_rows, compaction_order_.size());
+          for (size_t cnt = begin; cnt < end; cnt++) {
+            const size_t row = compaction_order_[cnt].offset();
+            char* dst_row = &chunk[(cnt - begin) * row_size_in_byte];
+            if (row < num_base_rows_ && !in_embedding_file_[row]) {
+              // the indexed snapshot is in fp32
+              codec_.encode(base_table_ + row * embedding_params_.embedding_vec_size, dst_row);
+            } else {
+              memcpy(dst_row, src + row * row_size_in_byte, row_size_in_byte);
+            }
+          }
+          const size_t chunk_size_in_byte = (end - begin) * row_size_in_byte;
+          for (size_t written = 0; written < chunk_size_in_byte;) {
+            const ssize_t ret = write(dst_fd, &chunk[written], chunk_size_in_byte - written);
+            if (ret < 0) {
+              CK_THROW_(Error_t::BrokenFile, "Cannot write the file: " + dst_path);
+            }
+            written += ret;
+          }
+        }
+      } catch (...) {
+        compaction_error_ = std::current_exception();
+      }
+      if (src) munmap(src, src_size_in_byte);
+      if (src_fd != -1) close(src_fd);
+      if (dst_fd != -1) close(dst_fd);
+    });
+  } catch (const internal_runtime_error& rt_err) {
+    std::cerr << rt_err.what() << std::endl;
+    throw;
+  } catch (const std::exception& err) {
+    std::cerr << err.what() << std::endl;
+    throw;
+  }
+}
+
+template <typename TypeHashKey, typename TypeEmbeddingComp>
+void ParameterServer<TypeHashKey, TypeEmbeddingComp>::wait_compaction_() {
+  if (!compaction_thread_.joinable()) {
+    return;
+  }
+  compaction_thread_.join();
+
+  const std::string compact_path = embedding_table_path_ + ".compact";
+  if (compaction_error_) {
+    std::exception_ptr err = compaction_error_;
+    compaction_error_ = nullptr;
+    compaction_order_.clear();
+    std::remove(compact_path.c_str());
+    std::rethrow_exception(err);
+  }
+
+  if (maped_to_memory_) {
+    unmap_embedding_from_memory_();
+  }
+  if (std::rename(compact_path.c_str(), embedding_table_path_.c_str()) != 0) {
+    CK_THROW_(Error_t::FileCannotOpen, "Cannot rename the file: " + compact_path);
+  }
+
+  // the keys are in the rows of the new file in the order of compaction_order_
+  std::vector<uint8_t> dirty_rows(compaction_order_.size(), 0);
+  for (size_t cnt = 0; cnt < compaction_order_.size(); cnt++) {
+    const auto& entry = compaction_order_[cnt];
+    if (entry.offset() < dirty_rows_.size()) dirty_rows[cnt] = dirty_rows_[entry.offset()];
+    hash_table_.assign(entry.key, entry.slot_id(), cnt);
+  }
+  dirty_rows_.swap(dirty_rows);
+  release_base_table_();
+  num_rows_ = compaction_order_.size();
+  free_rows_.clear();
+  if (host_cache_) host_cache_->clear();
+  std::vector<typename HashTable::Entry>().swap(compaction_order_);
+}
+
+template <typename TypeHashKey, typename TypeEmbeddingComp>
+void ParameterServer<TypeHashKey, TypeEmbeddingComp>::compact() {
+  try {
+    start_compaction();
+    wait_compaction_();
+  } catch (const internal_runtime_error& rt_err) {
+    std::cerr << rt_err.what() << std::endl;
+    throw;
+  } catch (const std::exception& err) {
+    std::cerr << err.what() << std::endl;
+    throw;
+  }
+}
+
 template class ParameterServer<long long, __half>;
 template class ParameterServer<long long, float>;
 template class ParameterServer<unsigned, __half>;
@@ -24,7 +24,8 @@ ParameterServerManager<TypeHashKey, TypeEmbeddingComp>::ParameterServerManager(
     const Embedding_t embedding_type,
     const SolverParser& solver_config,
     const std::string& temp_embedding_dir,
-    size_t buffer_size) {
+    size_t buffer_size)
+    : staged_buf_bags_(embedding_params.size()), buffer_size_(buffer_size) {
   try {
     if (!solver_config.embedding_files.size()) {
       MESSAGE_("Traning from scratch, no snapshot file specified");
@@ -37,13 +38,22 @@ ParameterServerManager<TypeHashKey, TypeEmbeddingComp>::ParameterServerManager(
     for (int i = 0; i < static_cast<int>(embedding_params.size()); i++) {
       size_t ith_vec_size = embedding_params[i].embedding_vec_size;
       max_vec_size = (ith_vec_size > max_vec_size) ? ith_vec_size : max_vec_size;
+      embedding_vec_sizes_.push_back(ith_vec_size);
+
+      // the host cache is split evenly among the embeddings
+      size_t host_cache_capacity = (solver_config.host_cache_size_in_mb << 20) /
+                                   embedding_params.size() / (sizeof(float) * ith_vec_size);
 
       if (!solver_config.embedding_files.size()) {
         ps_.push_back(std::make_shared<ParameterServer<TypeHashKey, TypeEmbeddingComp>>
-          (embedding_params[i], std::string(), temp_embedding_dir, embedding_type));
+          (embedding_params[i], std::string(), temp_embedding_dir, embedding_type,
+           host_cache_capacity, solver_config.host_cache_policy,
+           solver_config.temp_embedding_precision));
       } else {
         ps_.push_back(std::make_shared<ParameterServer<TypeHashKey, TypeEmbeddingComp>>
-          (embedding_params[i], solver_config.embedding_files[i], temp_embedding_dir, embedding_type));
+          (embedding_params[i], solver_config.embedding_files[i], temp_embedding_dir, embedding_type,
+           host_cache_capacity, solver_config.host_cache_policy,
+           solver_config.temp_embedding_precision));
       }
     }
 
@@ -70,6 +80,27 @@ ParameterServerManager<TypeHashKey, TypeEmbeddingComp>::ParameterServerManager(
   }
 }
 
+template <typename TypeHashKey, typename TypeEmbeddingComp>
+BufferBag& ParameterServerManager<TypeHashKey, TypeEmbeddingComp>::get_staged_buffer_bag(int i) {
+  BufferBag& buf_bag = staged_buf_bags_[i];
+  if (!buf_bag.embedding.allocated()) {
+    std::shared_ptr<GeneralBuffer2<CudaHostAllocator>> blobs_buff =
+      GeneralBuffer2<CudaHostAllocator>::create();
+
+    Tensor2<TypeHashKey> tensor_keys;
+    Tensor2<size_t> tensor_slot_id;
+    blobs_buff->reserve({buffer_size_}, &tensor_keys);
+    blobs_buff->reserve({buffer_size_}, &tensor_slot_id);
+
+    blobs_buff->reserve({buffer_size_, embedding_vec_sizes_[i]}, &(buf_bag.embedding));
+    blobs_buff->allocate();
+
+    buf_bag.keys = tensor_keys.shrink();
+    buf_bag.slot_id = tensor_slot_id.shrink();
+  }
+  return buf_bag;
+}
+
 template class ParameterServerManager<long long, __half>;
 template class ParameterServerManager<long long, float>;
 template class ParameterServerManager<unsigned, __half>;
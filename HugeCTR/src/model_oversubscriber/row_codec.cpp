@@ -0,0 +1,292 @@
+/*
+ * Copyright (c) 2020, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <model_oversubscriber/row_codec.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define ROW_CODEC_F16C
+#endif
+
+namespace HugeCTR {
+
+namespace {
+
+uint32_t bits_of(float value) {
+  uint32_t bits;
+  memcpy(&bits, &value, sizeof(bits));
+  return bits;
+}
+
+float float_of(uint32_t bits) {
+  float value;
+  memcpy(&value, &bits, sizeof(value));
+  return value;
+}
+
+// fp32 to fp16, rounded to nearest even, the denormals by a float addition
+uint16_t float_to_half(float value) {
+  const uint32_t f32_infinity = 255u << 23;
+  const uint32_t f16_overflow = (127u + 16) << 23;
+  const uint32_t denormal_magic = ((127u - 15) + (23 - 10) + 1) << 23;
+  uint32_t bits = bits_of(value);
+  const uint32_t sign = bits & 0x80000000u;
+  bits ^= sign;
+  uint16_t half;
+  if (bits >= f16_overflow) {
+    half = bits > f32_infinity ? 0x7e00 : 0x7c00;
+  } else if (bits < (113u << 23)) {
+    half = static_cast<uint16_t>(bits_of(float_of(bits) + float_of(denormal_magic)) -
+                                 denormal_magic);
+  } else {
+    const uint32_t mantissa_odd = (bits >> 13) & 1;
+    bits += ((15u - 127) << 23) + 0xfff + mantissa_odd;
+    half = static_cast<uint16_t>(bits >> 13);
+  }
+  return half | static_cast<uint16_t>(sign >> 16);
+}
+
+float half_to_float(uint16_t half) {
+  const uint32_t shifted_exponent = 0x7c00u << 13;
+  uint32_t bits = (half & 0x7fffu) << 13;
+  const uint32_t exponent = bits & shifted_exponent;
+  bits += (127u - 15) << 23;
+  if (exponent == shifted_exponent) {
+    bits += (128u - 16) << 23;
+  } else if (exponent == 0) {
+    bits += 1u << 23;
+    bits = bits_of(float_of(bits) - float_of(113u << 23));
+  }
+  return float_of(bits | (static_cast<uint32_t>(half & 0x8000u) << 16));
+}
+
+uint16_t float_to_bfloat(float value) {
+  const uint32_t bits = bits_of(value);
+  if (std::isnan(value)) {
+    return static_cast<uint16_t>((bits >> 16) | 0x40);
+  }
+  return static_cast<uint16_t>((bits + 0x7fff + ((bits >> 16) & 1)) >> 16);
+}
+
+float bfloat_to_float(uint16_t bfloat) { return float_of(static_cast<uint32_t>(bfloat) << 16); }
+
+void encode_fp32(const float* src, char* dst, size_t n) { memcpy(dst, src, n * sizeof(float)); }
+
+void decode_fp32(const char* src, float* dst, size_t n) { memcpy(dst, src, n * sizeof(float)); }
+
+void encode_fp16(const float* src, char* dst, size_t n) {
+  for (size_t i = 0; i < n; i++) {
+    const uint16_t half = float_to_half(src[i]);
+    memcpy(dst + i * sizeof(half), &half, sizeof(half));
+  }
+}
+
+void decode_fp16(const char* src, float* dst, size_t n) {
+  for (size_t i = 0; i < n; i++) {
+    uint16_t half;
+    memcpy(&half, src + i * sizeof(half), sizeof(half));
+    dst[i] = half_to_float(half);
+  }
+}
+
+#ifdef ROW_CODEC_F16C
+__attribute__((target("avx,f16c"))) void encode_fp16_f16c(const float* src, char* dst,
+                                                          size_t n) {
+  size_t i = 0;
+  for (; i + 8 <= n; i += 8) {
+    const __m128i half = _mm256_cvtps_ph(_mm256_loadu_ps(src + i), _MM_FROUND_TO_NEAREST_INT);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i * 2), half);
+  }
+  // the compiler doesn't clear the upper halves of the ymm registers here, and the SSE code run
+  // after would be slowed down by them
+  _mm256_zeroupper();
+  encode_fp16(src + i, dst + i * 2, n - i);
+}
+
+__attribute__((target("avx,f16c"))) void decode_fp16_f16c(const char* src, float* dst,
+                                                          size_t n) {
+  size_t i = 0;
+  for (; i + 8 <= n; i += 8) {
+    const __m128i half = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i * 2));
+    _mm256_storeu_ps(dst + i, _mm256_cvtph_ps(half));
+  }
+  _mm256_zeroupper();
+  decode_fp16(src + i * 2, dst + i, n - i);
+}
+#endif
+
+void encode_bf16(const float* src, char* dst, size_t n) {
+  size_t i = 0;
+#ifdef __SSE2__
+  const __m128i one = _mm_set1_epi32(1);
+  const __m128i bias = _mm_set1_epi32(0x7fff);
+  auto round = [&](const float* p) {
+    const __m128 value = _mm_loadu_ps(p);
+    const __m128i bits = _mm_castps_si128(value);
+    const __m128i lsb = _mm_and_si128(_mm_srli_epi32(bits, 16), one);
+    const __m128i rounded = _mm_add_epi32(_mm_add_epi32(bits, bias), lsb);
+    const __m128i nan = _mm_castps_si128(_mm_cmpunord_ps(value, value));
+    const __m128i quiet = _mm_or_si128(bits, _mm_set1_epi32(0x400000));
+    // the arithmetic shift keeps the upper halves in the range of int16 for the pack
+    return _mm_srai_epi32(
+        _mm_or_si128(_mm_and_si128(nan, quiet), _mm_andnot_si128(nan, rounded)), 16);
+  };
+  for (; i + 8 <= n; i += 8) {
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i * 2),
+                     _mm_packs_epi32(round(src + i), round(src + i + 4)));
+  }
+#endif
+  for (; i < n; i++) {
+    const uint16_t bfloat = float_to_bfloat(src[i]);
+    memcpy(dst + i * sizeof(bfloat), &bfloat, sizeof(bfloat));
+  }
+}
+
+void decode_bf16(const char* src, float* dst, size_t n) {
+  size_t i = 0;
+#ifdef __SSE2__
+  const __m128i zero = _mm_setzero_si128();
+  for (; i + 8 <= n; i += 8) {
+    const __m128i bfloat = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i * 2));
+    _mm_storeu_ps(dst + i, _mm_castsi128_ps(_mm_unpacklo_epi16(zero, bfloat)));
+    _mm_storeu_ps(dst + i + 4, _mm_castsi128_ps(_mm_unpackhi_epi16(zero, bfloat)));
+  }
+#endif
+  for (; i < n; i++) {
+    uint16_t bfloat;
+    memcpy(&bfloat, src + i * sizeof(bfloat), sizeof(bfloat));
+    dst[i] = bfloat_to_float(bfloat);
+  }
+}
+
+void encode_int8(const float* src, char* dst, size_t n) {
+  size_t i = 0;
+  float max_abs = 0.f;
+#ifdef __SSE2__
+  const __m128 abs_mask = _mm_castsi128_ps(_mm_set1_epi32(0x7fffffff));
+  __m128 max4 = _mm_setzero_ps();
+  for (; i + 4 <= n; i += 4) {
+    max4 = _mm_max_ps(max4, _mm_and_ps(_mm_loadu_ps(src + i), abs_mask));
+  }
+  float lanes[4];
+  _mm_storeu_ps(lanes, max4);
+  max_abs = std::max(std::max(lanes[0], lanes[1]), std::max(lanes[2], lanes[3]));
+#endif
+  for (; i < n; i++) {
+    max_abs = std::max(max_abs, std::fabs(src[i]));
+  }
+
+  const float scale = max_abs / 127.f;
+  const float inv_scale = max_abs > 0.f ? 127.f / max_abs : 0.f;
+  memcpy(dst, &scale, sizeof(scale));
+  int8_t* q = reinterpret_cast<int8_t*>(dst + sizeof(scale));
+  i = 0;
+#ifdef __SSE2__
+  // _mm_cvtps_epi32 rounds to nearest even, like nearbyint() below
+  const __m128 inv4 = _mm_set1_ps(inv_scale);
+  auto quantize = [&](const float* p) {
+    return _mm_cvtps_epi32(_mm_mul_ps(_mm_loadu_ps(p), inv4));
+  };
+  for (; i + 16 <= n; i += 16) {
+    const __m128i lo = _mm_packs_epi32(quantize(src + i), quantize(src + i + 4));
+    const __m128i hi = _mm_packs_epi32(quantize(src + i + 8), quantize(src + i + 12));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(q + i), _mm_packs_epi16(lo, hi));
+  }
+#endif
+  for (; i < n; i++) {
+    q[i] = static_cast<int8_t>(std::nearbyint(src[i] * inv_scale));
+  }
+}
+
+void decode_int8(const char* src, float* dst, size_t n) {
+  float scale;
+  memcpy(&scale, src, sizeof(scale));
+  const int8_t* q = reinterpret_cast<const int8_t*>(src + sizeof(scale));
+  size_t i = 0;
+#ifdef __SSE2__
+  const __m128 scale4 = _mm_set1_ps(scale);
+  auto dequantize = [&](__m128i q16, float* p) {
+    const __m128i lo = _mm_srai_epi32(_mm_unpacklo_epi16(q16, q16), 16);
+    const __m128i hi = _mm_srai_epi32(_mm_unpackhi_epi16(q16, q16), 16);
+    _mm_storeu_ps(p, _mm_mul_ps(_mm_cvtepi32_ps(lo), scale4));
+    _mm_storeu_ps(p + 4, _mm_mul_ps(_mm_cvtepi32_ps(hi), scale4));
+  };
+  for (; i + 16 <= n; i += 16) {
+    const __m128i q8 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(q + i));
+    dequantize(_mm_srai_epi16(_mm_unpacklo_epi8(q8, q8), 8), dst + i);
+    dequantize(_mm_srai_epi16(_mm_unpackhi_epi8(q8, q8), 8), dst + i + 8);
+  }
+#endif
+  for (; i < n; i++) {
+    dst[i] = q[i] * scale;
+  }
+}
+
+}  // namespace
+
+RowCodec::RowCodec(StoragePrecision_t precision, size_t embedding_vec_size)
+    : precision_(precision),
+      embedding_vec_size_(embedding_vec_size),
+      row_size_in_byte_(row_size_in_byte(precision, embedding_vec_size)) {
+  switch (precision) {
+    case StoragePrecision_t::FP32:
+      encode_ = encode_fp32;
+      decode_ = decode_fp32;
+      break;
+    case StoragePrecision_t::FP16:
+      encode_ = encode_fp16;
+      decode_ = decode_fp16;
+#ifdef ROW_CODEC_F16C
+      // every CPU with AVX2 has F16C
+      if (__builtin_cpu_supports("avx2")) {
+        encode_ = encode_fp16_f16c;
+        decode_ = decode_fp16_f16c;
+      }
+#endif
+      break;
+    case StoragePrecision_t::BF16:
+      encode_ = encode_bf16;
+      decode_ = decode_bf16;
+      break;
+    case StoragePrecision_t::INT8:
+      encode_ = encode_int8;
+      decode_ = decode_int8;
+      break;
+    default:
+      CK_THROW_(Error_t::WrongInput, "Unknown storage precision");
+  }
+}
+
+size_t RowCodec::row_size_in_byte(StoragePrecision_t precision, size_t embedding_vec_size) {
+  switch (precision) {
+    case StoragePrecision_t::FP32:
+      return embedding_vec_size * sizeof(float);
+    case StoragePrecision_t::FP16:
+    case StoragePrecision_t::BF16:
+      return embedding_vec_size * sizeof(uint16_t);
+    case StoragePrecision_t::INT8:
+      return sizeof(float) + embedding_vec_size * sizeof(int8_t);
+    default:
+      CK_THROW_(Error_t::WrongInput, "Unknown storage precision");
+  }
+  return 0;
+}
+
+}  // namespace HugeCTR
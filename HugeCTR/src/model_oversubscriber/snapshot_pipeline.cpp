@@ -0,0 +1,252 @@
+/*
+ * Copyright (c) 2020, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <model_oversubscriber/snapshot_pipeline.hpp>
+#include <model_oversubscriber/file_descriptor.hpp>
+#include <model_oversubscriber/parallel_for_each.hpp>
+
+#include <omp.h>
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <vector>
+#include <fcntl.h>
+
+namespace HugeCTR {
+
+template <typename KeyType>
+SnapshotPipeline<KeyType>::SnapshotPipeline(size_t embedding_vec_size, bool has_slot_id,
+                                            StoragePrecision_t storage_precision,
+                                            size_t block_size_in_byte, int num_threads)
+    : embedding_vec_size_(embedding_vec_size),
+      has_slot_id_(has_slot_id),
+      codec_(storage_precision, embedding_vec_size),
+      block_size_in_byte_(block_size_in_byte),
+      num_threads_(num_threads > 0 ? num_threads : std::max(omp_get_max_threads(), 4)) {
+  if (embedding_vec_size_ == 0) {
+    CK_THROW_(Error_t::WrongInput, "embedding_vec_size must be positive");
+  }
+}
+
+namespace {
+
+// spreads the keys evenly over the shards, whatever their low bits are
+template <typename KeyType>
+size_t shard_of(KeyType key, size_t num_shards) {
+  return ((static_cast<uint64_t>(key) * 0x9e3779b97f4a7c15ULL) >> 32) % num_shards;
+}
+
+}  // namespace
+
+template <typename KeyType>
+size_t SnapshotPipeline<KeyType>::rows_per_block() const {
+  // a row is indexed within its block by 32 bits
+  return std::min<size_t>(std::max<size_t>(1, block_size_in_byte_ / row_size_in_byte()),
+                          std::numeric_limits<uint32_t>::max());
+}
+
+template <typename KeyType>
+void SnapshotPipeline<KeyType>::import_snapshot(const std::string& snapshot_path,
+                                                const std::string& embedding_table_path,
+                                                HashTable& hash_table) const {
+  try {
+    FileDescriptor embedding_table(embedding_table_path, O_RDWR | O_CREAT | O_TRUNC);
+    if (snapshot_path.empty()) {
+      return;
+    }
+    FileDescriptor snapshot(snapshot_path, O_RDONLY);
+
+    // a partial row at the end is ignored
+    const size_t row_size = row_size_in_byte();
+    const size_t vector_size = vector_size_in_byte();
+    const size_t stored_size = codec_.row_size_in_byte();
+    const size_t num_rows = snapshot.size() / row_size;
+    const size_t block_rows = rows_per_block();
+    const size_t num_blocks = (num_rows + block_rows - 1) / block_rows;
+    embedding_table.resize(num_rows * stored_size);
+
+    // the rows of each block are bucketed by the shard of their keys on the way
+    const size_t num_shards = num_threads_;
+    std::vector<KeyType> keys(num_rows);
+    std::vector<size_t> slot_ids(has_slot_id_ ? num_rows : 0);
+    std::vector<std::vector<std::vector<uint32_t>>> shard_rows(
+        num_blocks, std::vector<std::vector<uint32_t>>(num_shards));
+    std::vector<std::vector<char>> row_buffers(num_threads_), vector_buffers(num_threads_);
+    parallel_for_each(num_blocks, num_threads_, [&](size_t block) {
+      const int thread = omp_get_thread_num();
+      const size_t begin = block * block_rows;
+      const size_t end = std::min(begin + block_rows, num_rows);
+      std::vector<char>& rows = row_buffers[thread];
+      std::vector<char>& vectors = vector_buffers[thread];
+      rows.resize(block_rows * row_size);
+      vectors.resize(block_rows * stored_size);
+      snapshot.pread_full(rows.data(), (end - begin) * row_size, begin * row_size);
+      const char* src = rows.data();
+      for (size_t row = begin; row < end; row++, src += row_size) {
+        memcpy(&keys[row], src, sizeof(KeyType));
+        shard_rows[block][shard_of(keys[row], num_shards)].push_back(row - begin);
+        if (has_slot_id_) memcpy(&slot_ids[row], src + sizeof(KeyType), sizeof(size_t));
+        codec_.encode(reinterpret_cast<const float*>(src + row_size - vector_size),
+                      vectors.data() + (row - begin) * stored_size);
+      }
+      embedding_table.pwrite_full(vectors.data(), (end - begin) * stored_size,
+                                  begin * stored_size);
+    });
+
+    // a key is kept at its first row unless it is already in the table. The shards are
+    // deduplicated in parallel, each by a table of its own filled in the order of the rows
+    std::vector<uint8_t> kept(num_rows);
+    parallel_for_each(num_shards, num_threads_, [&](size_t shard) {
+      HashTable shard_table;
+      for (size_t block = 0; block < num_blocks; block++) {
+        const size_t begin = block * block_rows;
+        for (uint32_t row_in_block : shard_rows[block][shard]) {
+          const size_t row = begin + row_in_block;
+          kept[row] = hash_table.find(keys[row]) == nullptr && shard_table.insert(keys[row], 0, 0);
+        }
+        std::vector<uint32_t>().swap(shard_rows[block][shard]);
+      }
+    });
+
+    // the kept rows take the offsets in their order, and are inserted by all the threads at once
+    std::vector<size_t> block_offsets(num_blocks + 1, 0);
+    parallel_for_each(num_blocks, num_threads_, [&](size_t block) {
+      const size_t begin = block * block_rows;
+      const size_t end = std::min(begin + block_rows, num_rows);
+      block_offsets[block + 1] = std::count(kept.begin() + begin, kept.begin() + end, 1);
+    });
+    for (size_t block = 0; block < num_blocks; block++) {
+      block_offsets[block + 1] += block_offsets[block];
+    }
+    const size_t num_kept = block_offsets[num_blocks];
+    hash_table.reserve_distinct(num_kept);
+    parallel_for_each(num_blocks, num_threads_, [&](size_t block) {
+      const size_t begin = block * block_rows;
+      const size_t end = std::min(begin + block_rows, num_rows);
+      size_t offset = block_offsets[block];
+      for (size_t row = begin; row < end; row++) {
+        if (kept[row]) {
+          hash_table.insert_distinct(keys[row], has_slot_id_ ? slot_ids[row] : 0, offset++);
+        }
+      }
+    });
+    if (num_kept == num_rows) {
+      return;
+    }
+
+    // those rows are dropped from the embedding_file, so that every row has a key. The kept
+    // rows only move down, so the blocks are moved in order, each read before it is written
+    std::vector<char> vectors(block_rows * stored_size);
+    size_t dst_row = 0;
+    for (size_t block = 0; block < num_blocks; block++) {
+      const size_t begin = block * block_rows;
+      const size_t end = std::min(begin + block_rows, num_rows);
+      embedding_table.pread_full(vectors.data(), (end - begin) * stored_size,
+                                 begin * stored_size);
+      size_t block_kept = 0;
+      for (size_t row = begin; row < end; row++) {
+        if (!kept[row]) continue;
+        if (row - begin != block_kept) {
+          memmove(vectors.data() + block_kept * stored_size,
+                  vectors.data() + (row - begin) * stored_size, stored_size);
+        }
+        block_kept++;
+      }
+      embedding_table.pwrite_full(vectors.data(), block_kept * stored_size,
+                                  dst_row * stored_size);
+      dst_row += block_kept;
+    }
+    embedding_table.resize(num_kept * stored_size);
+  } catch (const internal_runtime_error& rt_err) {
+    std::cerr << rt_err.what() << std::endl;
+    throw;
+  } catch (const std::exception& err) {
+    std::cerr << err.what() << std::endl;
+    throw;
+  }
+}
+
+template <typename KeyType>
+void SnapshotPipeline<KeyType>::export_snapshot(const std::string& embedding_table_path,
+                                                const std::string& snapshot_path,
+                                                const HashTable& hash_table) const {
+  try {
+    FileDescriptor embedding_table(embedding_table_path, O_RDONLY);
+    FileDescriptor snapshot(snapshot_path, O_WRONLY | O_CREAT | O_TRUNC);
+
+    const size_t row_size = row_size_in_byte();
+    const size_t vector_size = vector_size_in_byte();
+    const size_t stored_size = codec_.row_size_in_byte();
+    const size_t num_rows = embedding_table.size() / stored_size;
+    if (hash_table.size() != num_rows) {
+      CK_THROW_(Error_t::BrokenFile, "The embedding file has " + std::to_string(num_rows) +
+                                         " rows for " + std::to_string(hash_table.size()) +
+                                         " keys");
+    }
+
+    std::vector<typename HashTable::Entry> row_entries(num_rows);
+    bool out_of_bound = false;
+    hash_table.for_each([&](const typename HashTable::Entry& entry) {
+      if (entry.offset() < num_rows) {
+        row_entries[entry.offset()] = entry;
+      } else {
+        out_of_bound = true;
+      }
+    });
+    if (out_of_bound) {
+      CK_THROW_(Error_t::OutOfBound, "A key is out of the rows of the embedding file");
+    }
+
+    const size_t block_rows = rows_per_block();
+    const size_t num_blocks = (num_rows + block_rows - 1) / block_rows;
+    snapshot.resize(num_rows * row_size);
+    std::vector<std::vector<char>> row_buffers(num_threads_), vector_buffers(num_threads_);
+    parallel_for_each(num_blocks, num_threads_, [&](size_t block) {
+      const int thread = omp_get_thread_num();
+      const size_t begin = block * block_rows;
+      const size_t end = std::min(begin + block_rows, num_rows);
+      std::vector<char>& rows = row_buffers[thread];
+      std::vector<char>& vectors = vector_buffers[thread];
+      rows.resize(block_rows * row_size);
+      vectors.resize(block_rows * stored_size);
+      embedding_table.pread_full(vectors.data(), (end - begin) * stored_size,
+                                 begin * stored_size);
+      char* dst = rows.data();
+      for (size_t row = begin; row < end; row++, dst += row_size) {
+        const auto& entry = row_entries[row];
+        memcpy(dst, &entry.key, sizeof(KeyType));
+        if (has_slot_id_) {
+          const size_t slot_id = entry.slot_id();
+          memcpy(dst + sizeof(KeyType), &slot_id, sizeof(size_t));
+        }
+        codec_.decode(vectors.data() + (row - begin) * stored_size,
+                      reinterpret_cast<float*>(dst + row_size - vector_size));
+      }
+      snapshot.pwrite_full(rows.data(), (end - begin) * row_size, begin * row_size);
+    });
+  } catch (const internal_runtime_error& rt_err) {
+    std::cerr << rt_err.what() << std::endl;
+    throw;
+  } catch (const std::exception& err) {
+    std::cerr << err.what() << std::endl;
+    throw;
+  }
+}
+
+template class SnapshotPipeline<unsigned int>;
+template class SnapshotPipeline<long long>;
+
+}  // namespace HugeCTR
@@ -80,6 +80,38 @@ void create_datareader<TypeKey>::operator()(
 #endif
   MESSAGE_("num of DataReader workers: " + std::to_string(num_workers));
 
+  const int prefetch_depth = get_value_from_json_soft<int>(j, "prefetch_depth", 1);
+  if (prefetch_depth <= 0) {
+    CK_THROW_(Error_t::WrongInput, "prefetch_depth <= 0");
+  }
+  const bool lock_free_heap = get_value_from_json_soft<bool>(j, "lock_free_heap", false);
+  const bool use_mmap = get_value_from_json_soft<bool>(j, "use_mmap", false);
+  const int num_parse_threads = get_value_from_json_soft<int>(j, "num_parse_threads", 1);
+  if (num_parse_threads <= 0) {
+    CK_THROW_(Error_t::WrongInput, "num_parse_threads <= 0");
+  }
+  if (num_parse_threads > 1 && !use_mmap) {
+    CK_THROW_(Error_t::WrongInput, "num_parse_threads > 1 requires use_mmap");
+  }
+  const int shuffle_buffer_size = get_value_from_json_soft<int>(j, "shuffle_buffer_size", 0);
+  if (shuffle_buffer_size < 0) {
+    CK_THROW_(Error_t::WrongInput, "shuffle_buffer_size < 0");
+  }
+  const bool shuffle_files = get_value_from_json_soft<bool>(j, "shuffle_files", false);
+  const long long shuffle_block_size =
+      get_value_from_json_soft<long long>(j, "shuffle_block_size", 0);
+  if (shuffle_block_size < 0) {
+    CK_THROW_(Error_t::WrongInput, "shuffle_block_size < 0");
+  }
+  const int async_io_depth = get_value_from_json_soft<int>(j, "async_io_depth", 0);
+  if (async_io_depth < 0) {
+    CK_THROW_(Error_t::WrongInput, "async_io_depth < 0");
+  }
+  if (async_io_depth > 0 && (use_mmap || shuffle_block_size > 0)) {
+    CK_THROW_(Error_t::WrongInput,
+              "async_io_depth can't be used with use_mmap or shuffle_block_size");
+  }
+
   std::vector<DataReaderSparseParam> data_reader_sparse_param_array;
 
   const std::map<std::string, DataReaderSparse_t> DATA_TYPE_MAP = {
@@ -114,11 +146,13 @@ void create_datareader<TypeKey>::operator()(
 
   DataReader<TypeKey>* data_reader_tk = new DataReader<TypeKey>(
       batch_size, label_dim, dense_dim, data_reader_sparse_param_array, resource_manager,
-      repeat_dataset_, num_workers, use_mixed_precision, false);
+      repeat_dataset_, num_workers, use_mixed_precision, false, prefetch_depth,
+      lock_free_heap);
   train_data_reader.reset(data_reader_tk);
   DataReader<TypeKey>* data_reader_eval_tk = new DataReader<TypeKey>(
       batch_size_eval, label_dim, dense_dim, data_reader_sparse_param_array, resource_manager,
-      repeat_dataset_, num_workers, use_mixed_precision, cache_eval_data);
+      repeat_dataset_, num_workers, use_mixed_precision, cache_eval_data,
+      prefetch_depth, lock_free_heap);
   evaluate_data_reader.reset(data_reader_eval_tk);
 
   auto f = [&j]() -> std::vector<long long> {
@@ -142,8 +176,12 @@ void create_datareader<TypeKey>::operator()(
   switch (format) {
     case DataReaderType_t::Norm: {
       bool start_right_now = repeat_dataset_;
-      train_data_reader->create_drwg_norm(source_data, check_type, start_right_now);
-      evaluate_data_reader->create_drwg_norm(eval_source, check_type, start_right_now);
+      // the evaluation data is always read in order
+      train_data_reader->create_drwg_norm(source_data, check_type, start_right_now, use_mmap,
+                                          num_parse_threads, shuffle_buffer_size, shuffle_files,
+                                          async_io_depth);
+      evaluate_data_reader->create_drwg_norm(eval_source, check_type, start_right_now, use_mmap,
+                                             num_parse_threads, 0, false, async_io_depth);
       break;
     }
     case DataReaderType_t::Raw: {
@@ -152,9 +190,9 @@ void create_datareader<TypeKey>::operator()(
       std::vector<long long> slot_offset = f();
       bool float_label_dense = get_value_from_json_soft<bool>(j, "float_label_dense", false);
       train_data_reader->create_drwg_raw(source_data, num_samples, slot_offset, float_label_dense,
-                                         true, false);
+                                         true, false, shuffle_block_size, async_io_depth);
       evaluate_data_reader->create_drwg_raw(eval_source, eval_num_samples, slot_offset,
-                                            float_label_dense, false, false);
+                                            float_label_dense, false, false, 0, async_io_depth);
 
       break;
     }
@@ -15,8 +15,13 @@
  */
 
 #include "HugeCTR/include/data_readers/check_sum.hpp"
+#include <random>
 #include "HugeCTR/include/common.hpp"
+#include "HugeCTR/include/data_generator.hpp"
+#include "HugeCTR/include/data_readers/byte_sum.hpp"
+#include "HugeCTR/include/data_readers/check_sum_block.hpp"
 #include "HugeCTR/include/data_readers/file_source.hpp"
+#include "HugeCTR/include/data_readers/file_source_mmap.hpp"
 #include "gtest/gtest.h"
 
 using namespace HugeCTR;
@@ -64,3 +69,109 @@ TEST(checker, CheckSum) {
   // }
   EXPECT_EQ(strncmp(tmp1, str, NUM_CHAR), 0);
 }
+
+TEST(checker, CheckSumMmap) {
+  const int NUM_CHAR = 7;
+  const char str[] = {"abcdefg"};
+  {
+    int count = NUM_CHAR;
+    char sum = 0;
+    for (int i = 0; i < count; i++) {
+      sum += str[i];
+    }
+    char bad_sum = sum + 1;
+    std::ofstream out_stream("file_mmap.txt", std::ofstream::binary);
+    out_stream.write(reinterpret_cast<char*>(&count), sizeof(int));
+    out_stream.write(str, count);
+    out_stream.write(reinterpret_cast<char*>(&sum), sizeof(char));
+    out_stream.write(reinterpret_cast<char*>(&count), sizeof(int));
+    out_stream.write(str, count);
+    out_stream.write(reinterpret_cast<char*>(&bad_sum), sizeof(char));
+    out_stream.close();
+
+    out_stream.open("file_list_mmap.txt", std::ofstream::out);
+    out_stream << "1\n"
+               << "file_mmap.txt";
+    out_stream.close();
+  }
+
+  MmapFileSource file_source(0, 1, "file_list_mmap.txt", false);
+  EXPECT_TRUE(file_source.is_zero_copy());
+  CheckSum check_sum(file_source);
+  EXPECT_EQ(check_sum.next_source(), Error_t::Success);
+
+  // the first record is split into two reads
+  const char* ptr = nullptr;
+  EXPECT_EQ(check_sum.read_ptr(&ptr, 3), Error_t::Success);
+  EXPECT_EQ(strncmp(ptr, str, 3), 0);
+  EXPECT_EQ(check_sum.read_ptr(&ptr, NUM_CHAR - 3), Error_t::Success);
+  EXPECT_EQ(strncmp(ptr, str + 3, NUM_CHAR - 3), 0);
+
+  // the second record has a wrong checksum
+  EXPECT_EQ(check_sum.read_ptr(&ptr, NUM_CHAR), Error_t::DataCheckError);
+  EXPECT_EQ(check_sum.read_ptr(&ptr, NUM_CHAR), Error_t::OutOfBound);
+
+  // no repeat
+  EXPECT_EQ(check_sum.next_source(), Error_t::EndOfFile);
+  EXPECT_FALSE(check_sum.is_open());
+}
+
+TEST(checker, byte_sum) {
+  std::mt19937 gen(0);
+  std::uniform_int_distribution<int> dis(-128, 127);
+  std::vector<char> data(1000);
+  for (auto& c : data) {
+    c = static_cast<char>(dis(gen));
+  }
+  for (size_t offset : {0, 1, 3}) {
+    for (size_t size : {0, 1, 15, 16, 17, 31, 32, 33, 63, 64, 65, 127, 997}) {
+      EXPECT_EQ(byte_sum(data.data() + offset, size),
+                byte_sum_scalar(data.data() + offset, size));
+    }
+  }
+}
+
+TEST(checker, CheckSumBlock) {
+  const int NUM_CHAR = 7;
+  const char str[] = {"abcdefg"};
+  {
+    int count = NUM_CHAR;
+    char sum = byte_sum_scalar(str, NUM_CHAR);
+    char bad_sum = sum + 1;
+    std::ofstream out_stream("file_block.txt", std::ofstream::binary);
+    for (char check_bit : {sum, bad_sum, sum}) {
+      out_stream.write(reinterpret_cast<char*>(&count), sizeof(int));
+      out_stream.write(str, count);
+      out_stream.write(&check_bit, sizeof(char));
+    }
+    out_stream.close();
+
+    out_stream.open("file_list_block.txt", std::ofstream::out);
+    out_stream << "1\n"
+               << "file_block.txt";
+    out_stream.close();
+  }
+
+  FileSource file_source(0, 1, "file_list_block.txt", false);
+  MmapFileSource mmap_source(0, 1, "file_list_block.txt", false);
+  for (Source* source : std::vector<Source*>{&file_source, &mmap_source}) {
+    CheckSumBlock check_sum(*source);
+    EXPECT_TRUE(check_sum.is_zero_copy());
+    EXPECT_EQ(check_sum.next_source(), Error_t::Success);
+
+    char tmp[NUM_CHAR];
+    EXPECT_EQ(check_sum.read(tmp, 3), Error_t::Success);
+    const char* ptr = nullptr;
+    EXPECT_EQ(check_sum.read_ptr(&ptr, NUM_CHAR - 3), Error_t::Success);
+    EXPECT_EQ(strncmp(tmp, str, 3), 0);
+    EXPECT_EQ(strncmp(ptr, str + 3, NUM_CHAR - 3), 0);
+
+    // the broken record is dropped as a whole
+    EXPECT_EQ(check_sum.read(tmp, 1), Error_t::DataCheckError);
+    EXPECT_EQ(check_sum.read(tmp, NUM_CHAR), Error_t::Success);
+    EXPECT_EQ(strncmp(tmp, str, NUM_CHAR), 0);
+
+    EXPECT_EQ(check_sum.read(tmp, 1), Error_t::OutOfBound);
+    EXPECT_EQ(check_sum.next_source(), Error_t::EndOfFile);
+  }
+}
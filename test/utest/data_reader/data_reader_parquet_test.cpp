@@ -171,7 +171,7 @@ TEST(data_reader_parquet_worker, data_reader_parquet_worker_distributed_test) {
 
   constexpr size_t buffer_length = max_nnz;
   std::shared_ptr<HeapEx<CSRChunk<T>>> csr_heap(
-      new HeapEx<CSRChunk<T>>(1, num_devices, batchsize, label_dim + dense_dim, params));
+      new HeapEx<CSRChunk<T>>(1, 1, num_devices, batchsize, label_dim + dense_dim, params));
 
   std::vector<long long> slot_offset(slot_size.size(), 0);
   for (unsigned int i = 1; i < slot_size.size(); i++) {
@@ -209,7 +209,7 @@ TEST(data_reader_parquet_worker, data_reader_parquet_worker_localized_test) {
 
   constexpr size_t buffer_length = max_nnz;
   std::shared_ptr<HeapEx<CSRChunk<T>>> csr_heap(
-      new HeapEx<CSRChunk<T>>(1, num_devices, batchsize, label_dim + dense_dim, params));
+      new HeapEx<CSRChunk<T>>(1, 1, num_devices, batchsize, label_dim + dense_dim, params));
 
   std::vector<long long> slot_offset(slot_size.size(), 0);
   for (unsigned int i = 1; i < slot_size.size(); i++) {
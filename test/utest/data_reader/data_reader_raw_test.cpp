@@ -15,6 +15,7 @@
  */
 
 #include "HugeCTR/include/data_readers/data_reader.hpp"
+#include <algorithm>
 #include <fstream>
 #include <thread>
 #include "HugeCTR/include/data_generator.hpp"
@@ -57,7 +58,7 @@ void data_reader_worker_raw_test_impl(bool float_label_dense) {
   params.push_back(param);
 
   std::shared_ptr<HeapEx<CSRChunk<T>>> csr_heap(
-      new HeapEx<CSRChunk<T>>(1, num_devices, batchsize, label_dim + dense_dim, params));
+      new HeapEx<CSRChunk<T>>(1, 1, num_devices, batchsize, label_dim + dense_dim, params));
 
   // setup a data reader
   auto file_offset_list = std::make_shared<MmapOffsetList>(
@@ -126,7 +127,305 @@ void data_reader_raw_test_impl(bool float_label_dense) {
     print_tensor(data_reader.get_row_offsets_tensors()[1], 0, 10); */
 }
 
+// checks a chunk against the keys pushed row by row, as a CSR is filled sample by sample
+void check_raw_chunk(CSRChunk<T>* csr_chunk, const char* samples, long long current_batchsize,
+                     const std::vector<DataReaderSparseParam>& params, bool float_label_dense) {
+  const int num_devices = csr_chunk->get_num_devices();
+  const int batchsize = csr_chunk->get_batchsize();
+  const int label_dense_dim = label_dim + dense_dim;
+  const size_t sample_length = (label_dense_dim + slot_num) * sizeof(int);
+  const int samples_per_buffer = batchsize / num_devices;
+  ASSERT_EQ(csr_chunk->get_current_batchsize(), current_batchsize);
+
+  std::vector<std::vector<T>> row_offsets(num_devices * params.size());
+  std::vector<std::vector<T>> values(num_devices * params.size());
+  for (int i = 0; i < batchsize; i++) {
+    const char* sample = samples + sample_length * i;
+    if (i < current_batchsize) {
+      const float* label_dense = csr_chunk->get_label_buffers()[i / samples_per_buffer].get_ptr() +
+                                 (i % samples_per_buffer) * label_dense_dim;
+      for (int j = 0; j < label_dense_dim; j++) {
+        if (float_label_dense) {
+          ASSERT_EQ(label_dense[j], reinterpret_cast<const float*>(sample)[j]);
+        } else {
+          int x = reinterpret_cast<const int*>(sample)[j];
+          float expected = j < label_dim ? x : std::log(x + 1.f);
+          ASSERT_NEAR(label_dense[j], expected, 1e-6f * std::abs(expected));
+        }
+      }
+    }
+    const int* keys = reinterpret_cast<const int*>(sample + label_dense_dim * sizeof(int));
+    int slot_id = 0;
+    for (size_t param_id = 0; param_id < params.size(); param_id++) {
+      for (int k = 0; k < params[param_id].slot_num; k++, slot_id++) {
+        T key = keys[slot_id] + slot_offset[slot_id];
+        if (params[param_id].type == DataReaderSparse_t::Distributed) {
+          for (int dev_id = 0; dev_id < num_devices; dev_id++) {
+            auto& values_dev = values[dev_id * params.size() + param_id];
+            row_offsets[dev_id * params.size() + param_id].push_back(values_dev.size());
+          }
+          if (i < current_batchsize) {
+            values[std::abs(static_cast<int>(key % num_devices)) * params.size() + param_id]
+                .push_back(key);
+          }
+        } else {
+          int dev_id = k % num_devices;
+          row_offsets[dev_id * params.size() + param_id].push_back(
+              values[dev_id * params.size() + param_id].size());
+          if (i < current_batchsize) {
+            values[dev_id * params.size() + param_id].push_back(key);
+          }
+        }
+      }
+    }
+  }
+  for (size_t buf_id = 0; buf_id < values.size(); buf_id++) {
+    row_offsets[buf_id].push_back(values[buf_id].size());
+    CSR<T>& csr = csr_chunk->get_csr_buffer(buf_id);
+    ASSERT_EQ(csr.get_num_values(), values[buf_id].size());
+    ASSERT_EQ(csr.get_num_rows() + 1, row_offsets[buf_id].size());
+    ASSERT_TRUE(std::equal(row_offsets[buf_id].begin(), row_offsets[buf_id].end(),
+                           csr.get_row_offset_tensor().get_ptr()));
+    ASSERT_TRUE(std::equal(values[buf_id].begin(), values[buf_id].end(),
+                           csr.get_value_tensor().get_ptr()));
+  }
+}
+
+void data_reader_worker_raw_columnar_test_impl(bool float_label_dense, int async_io_depth = 0) {
+  const std::string columnar_file_name = "./train_data_columnar.bin";
+  const int batchsize = 1000;
+  const long long columnar_num_samples = batchsize * 2 + 300;
+  data_generation_for_raw(columnar_file_name, columnar_num_samples, label_dim, dense_dim, slot_num,
+                          float_label_dense, slot_size);
+  std::vector<std::vector<DataReaderSparseParam>> params_list = {
+      {{DataReaderSparse_t::Localized, slot_num, 1, slot_num}},
+      {{DataReaderSparse_t::Distributed, slot_num, 1, slot_num}},
+      {{DataReaderSparse_t::Distributed, 10, 1, 10}, {DataReaderSparse_t::Localized, 16, 1, 16}}};
+  for (int num_devices : {1, 2, 4}) {
+    for (auto& params : params_list) {
+      std::shared_ptr<HeapEx<CSRChunk<T>>> csr_heap(
+          new HeapEx<CSRChunk<T>>(1, 1, num_devices, batchsize, label_dim + dense_dim, params));
+      auto file_offset_list = std::make_shared<MmapOffsetList>(
+          columnar_file_name, columnar_num_samples,
+          (label_dim + dense_dim + slot_num) * sizeof(int), batchsize, false, 1, true);
+      DataReaderWorkerRaw<T> data_reader(0, 1, file_offset_list, csr_heap, true, params,
+                                         slot_offset, label_dim, float_label_dense,
+                                         async_io_depth);
+      for (int iter = 0; iter < 3; iter++) {
+        data_reader.read_a_batch();
+        MmapOffset offset = file_offset_list->get_offset(iter, 0);
+        CSRChunk<T>* csr_chunk = csr_heap->checkout_data_chunk();
+        check_raw_chunk(csr_chunk, offset.offset, offset.samples, params, float_label_dense);
+        csr_heap->return_free_chunk();
+      }
+    }
+  }
+}
+
+void data_reader_worker_raw_columnar_overflow_test_impl() {
+  const std::string columnar_file_name = "./train_data_columnar_overflow.bin";
+  const int batchsize = 1000;
+  data_generation_for_raw(columnar_file_name, batchsize, label_dim, dense_dim, slot_num, true,
+                          slot_size);
+  // the value buffers have room for one key less than the slots of a sample
+  const std::vector<DataReaderSparseParam> params = {
+      {DataReaderSparse_t::Distributed, slot_num - 1, 1, slot_num}};
+  std::shared_ptr<HeapEx<CSRChunk<T>>> csr_heap(
+      new HeapEx<CSRChunk<T>>(1, 1, 1, batchsize, label_dim + dense_dim, params));
+  auto file_offset_list = std::make_shared<MmapOffsetList>(
+      columnar_file_name, batchsize, (label_dim + dense_dim + slot_num) * sizeof(int), batchsize,
+      false, 1, true);
+  DataReaderWorkerRaw<T> data_reader(0, 1, file_offset_list, csr_heap, true, params, slot_offset,
+                                     label_dim, true);
+  EXPECT_THROW(data_reader.read_a_batch(), internal_runtime_error);
+  std::remove(columnar_file_name.c_str());
+}
+
+void mmap_offset_list_gather_test_impl(long long shuffle_block_size) {
+  // every sample is its own index repeated, so that it can be located after the shuffle
+  const std::string gather_file_name = "./train_data_gather.bin";
+  const int sample_ints = 6;
+  const long long gather_num_samples = 1000;
+  const int batchsize = 64;
+  const int num_workers = 2;
+  {
+    std::ofstream out(gather_file_name, std::ofstream::binary);
+    for (int i = 0; i < gather_num_samples; i++) {
+      std::vector<int> sample(sample_ints, i);
+      out.write(reinterpret_cast<const char*>(sample.data()), sizeof(int) * sample_ints);
+    }
+  }
+  const long long num_batches = (gather_num_samples + batchsize - 1) / batchsize;
+  std::vector<char> buffer(batchsize * sample_ints * sizeof(int));
+  std::vector<std::vector<int>> epochs;
+  {
+    MmapOffsetList list(gather_file_name, gather_num_samples, sample_ints * sizeof(int), batchsize,
+                        true, num_workers, true, shuffle_block_size);
+    ASSERT_TRUE(list.is_gathered());
+    for (int epoch = 0; epoch < 3; epoch++) {
+      std::vector<int> order;
+      for (long long pos = epoch * num_batches; pos < (epoch + 1) * num_batches; pos++) {
+        long long samples = list.gather(pos / num_workers, pos % num_workers, buffer.data());
+        ASSERT_EQ(samples, std::min<long long>(batchsize, gather_num_samples -
+                                                             (pos % num_batches) * batchsize));
+        const int* data = reinterpret_cast<const int*>(buffer.data());
+        for (int i = 0; i < samples; i++) {
+          for (int j = 1; j < sample_ints; j++) {
+            ASSERT_EQ(data[i * sample_ints + j], data[i * sample_ints]);
+          }
+          order.push_back(data[i * sample_ints]);
+        }
+      }
+      // the samples of a block stay together
+      const long long full_blocks_end = gather_num_samples / shuffle_block_size * shuffle_block_size;
+      for (size_t i = 0; i + 1 < order.size(); i++) {
+        if (order[i] < full_blocks_end && order[i] % shuffle_block_size != shuffle_block_size - 1) {
+          ASSERT_EQ(order[i + 1], order[i] + 1);
+        }
+      }
+      std::vector<int> sorted_order(order);
+      std::sort(sorted_order.begin(), sorted_order.end());
+      for (int i = 0; i < gather_num_samples; i++) {
+        ASSERT_EQ(sorted_order[i], i);
+      }
+      epochs.push_back(order);
+    }
+  }
+  ASSERT_NE(epochs[0], epochs[1]);
+  ASSERT_NE(epochs[1], epochs[2]);
+
+  // no repeat
+  MmapOffsetList list(gather_file_name, gather_num_samples, sample_ints * sizeof(int), batchsize,
+                      true, num_workers, false, shuffle_block_size);
+  for (long long pos = 0; pos < num_batches; pos++) {
+    list.gather(pos / num_workers, pos % num_workers, buffer.data());
+  }
+  for (long long pos = num_batches; pos < num_batches + num_workers; pos++) {
+    try {
+      list.gather(pos / num_workers, pos % num_workers, buffer.data());
+      FAIL();
+    } catch (const internal_runtime_error& rt_err) {
+      ASSERT_EQ(rt_err.get_error(), Error_t::EndOfFile);
+    }
+  }
+}
+
+// copy a Raw file into the compressed format, in frames of about "block_bytes"
+void compress_raw_file(const std::string& in_name, const std::string& out_name,
+                       long long num_samples, Compression_t compression, size_t block_bytes) {
+  const size_t stride = (label_dim + dense_dim + slot_num) * sizeof(int);
+  std::ifstream in(in_name, std::ifstream::binary);
+  std::ofstream out(out_name, std::ofstream::binary);
+  write_raw_compressed_header(out, num_samples, label_dim, dense_dim, slot_num, compression);
+  BlockWriter block_writer(out, compression, block_bytes);
+  std::vector<char> sample(stride);
+  for (long long i = 0; i < num_samples; i++) {
+    in.read(sample.data(), stride);
+    block_writer.write(sample.data(), stride);
+    block_writer.end_record();
+  }
+  block_writer.flush();
+}
+
+void mmap_offset_list_compressed_test_impl(bool float_label_dense, Compression_t compression) {
+  const std::string raw_file_name = "./train_data_uncompressed.bin";
+  const std::string compressed_file_name = "./train_data_compressed.bin";
+  const int batchsize = 1000;
+  const long long compressed_num_samples = batchsize * 5 + 300;
+  const size_t stride = (label_dim + dense_dim + slot_num) * sizeof(int);
+  const int num_workers = 2;
+  data_generation_for_raw(raw_file_name, compressed_num_samples, label_dim, dense_dim, slot_num,
+                          float_label_dense, slot_size);
+  // the frames are smaller than a batch and don't line up with the batches
+  compress_raw_file(raw_file_name, compressed_file_name, compressed_num_samples, compression,
+                    stride * 333);
+
+  MmapOffsetList raw_list(raw_file_name, compressed_num_samples, stride, batchsize, false,
+                          num_workers, true);
+  MmapOffsetList compressed_list(compressed_file_name, compressed_num_samples, stride, batchsize,
+                                 false, num_workers, true);
+  ASSERT_FALSE(raw_list.is_compressed());
+  ASSERT_TRUE(compressed_list.is_compressed());
+  std::vector<char> buffer(batchsize * stride);
+  std::vector<MmapOffsetList::FrameCache> caches(num_workers);
+  const long long num_batches = (compressed_num_samples + batchsize - 1) / batchsize;
+  for (long long pos = 0; pos < num_batches * 2; pos++) {
+    const long long round = pos / num_workers;
+    const int worker_id = pos % num_workers;
+    MmapOffset expected = raw_list.get_offset(round, worker_id);
+    long long samples =
+        compressed_list.decompress(round, worker_id, buffer.data(), &caches[worker_id]);
+    ASSERT_EQ(samples, expected.samples);
+    ASSERT_EQ(memcmp(buffer.data(), expected.offset, samples * stride), 0);
+  }
+
+  // the reader parses the decompressed batches as they are
+  const std::vector<DataReaderSparseParam> params = {
+      {DataReaderSparse_t::Distributed, slot_num, 1, slot_num}};
+  std::shared_ptr<HeapEx<CSRChunk<T>>> csr_heap(
+      new HeapEx<CSRChunk<T>>(1, 1, 1, batchsize, label_dim + dense_dim, params));
+  auto file_offset_list = std::make_shared<MmapOffsetList>(
+      compressed_file_name, compressed_num_samples, stride, batchsize, false, 1, true);
+  DataReaderWorkerRaw<T> data_reader(0, 1, file_offset_list, csr_heap, true, params, slot_offset,
+                                     label_dim, float_label_dense);
+  MmapOffsetList expected_list(raw_file_name, compressed_num_samples, stride, batchsize, false, 1,
+                               true);
+  for (int iter = 0; iter < num_batches + 1; iter++) {
+    data_reader.read_a_batch();
+    MmapOffset offset = expected_list.get_offset(iter, 0);
+    CSRChunk<T>* csr_chunk = csr_heap->checkout_data_chunk();
+    check_raw_chunk(csr_chunk, offset.offset, offset.samples, params, float_label_dense);
+    csr_heap->return_free_chunk();
+  }
+
+  // a corrupted frame is reported instead of read out of bounds
+  {
+    std::fstream file(compressed_file_name,
+                      std::fstream::in | std::fstream::out | std::fstream::binary);
+    const long long payload = sizeof(RAW_COMPRESSED_MAGIC) + sizeof(DataSetHeader) +
+                              sizeof(BlockFrameHeader);
+    file.seekp(payload);
+    std::vector<char> garbage(64, static_cast<char>(0xf0));
+    file.write(garbage.data(), garbage.size());
+  }
+  MmapOffsetList broken_list(compressed_file_name, compressed_num_samples, stride, batchsize, false,
+                             1, true);
+  MmapOffsetList::FrameCache cache;
+  ASSERT_THROW(broken_list.decompress(0, 0, buffer.data(), &cache), internal_runtime_error);
+}
+
 TEST(data_reader_raw, data_reader_worker_raw_float_test) { data_reader_worker_raw_test_impl(true); }
 TEST(data_reader_raw, data_reader_raw_float_test) { data_reader_raw_test_impl(true); }
 TEST(data_reader_raw, data_reader_worker_raw_int_test) { data_reader_worker_raw_test_impl(false); }
 TEST(data_reader_raw, data_reader_raw_int_test) { data_reader_raw_test_impl(false); }
+TEST(data_reader_raw, data_reader_worker_raw_columnar_float_test) {
+  data_reader_worker_raw_columnar_test_impl(true);
+}
+TEST(data_reader_raw, data_reader_worker_raw_columnar_int_test) {
+  data_reader_worker_raw_columnar_test_impl(false);
+}
+TEST(data_reader_raw, data_reader_worker_raw_columnar_overflow_test) {
+  data_reader_worker_raw_columnar_overflow_test_impl();
+}
+TEST(data_reader_raw, data_reader_worker_raw_async_io_test) {
+  data_reader_worker_raw_columnar_test_impl(true, 2);
+}
+TEST(data_reader_raw, mmap_offset_list_gather_test) {
+  mmap_offset_list_gather_test_impl(1);
+  mmap_offset_list_gather_test_impl(7);
+}
+TEST(data_reader_raw, mmap_offset_list_compressed_test) {
+  std::vector<Compression_t> codecs;
+#ifdef ENABLE_LZ4
+  codecs.push_back(Compression_t::LZ4);
+#endif
+#ifdef ENABLE_ZSTD
+  codecs.push_back(Compression_t::Zstd);
+#endif
+  if (codecs.empty()) {
+    GTEST_SKIP() << "HugeCTR is built without ENABLE_LZ4 and ENABLE_ZSTD";
+  }
+  for (Compression_t compression : codecs) {
+    mmap_offset_list_compressed_test_impl(true, compression);
+  }
+}
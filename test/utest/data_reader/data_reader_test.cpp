@@ -15,6 +15,7 @@
  */
 
 #include "HugeCTR/include/data_readers/data_reader.hpp"
+#include <algorithm>
 #include <fstream>
 #include <thread>
 #include "HugeCTR/include/data_generator.hpp"
@@ -56,7 +57,7 @@ TEST(data_reader_worker, data_reader_worker_test) {
 
   constexpr size_t buffer_length = max_nnz;
   std::shared_ptr<HeapEx<CSRChunk<T>>> csr_heap(
-      new HeapEx<CSRChunk<T>>(1, num_devices, batchsize, label_dim + dense_dim, params));
+      new HeapEx<CSRChunk<T>>(1, 1, num_devices, batchsize, label_dim + dense_dim, params));
 
   // setup a data reader
   DataReaderWorker<T> data_reader(0, 1, csr_heap, file_list_name, buffer_length, true, CHK, params);
@@ -65,6 +66,439 @@ TEST(data_reader_worker, data_reader_worker_test) {
   data_reader.read_a_batch();
 }
 
+TEST(data_reader_worker, data_reader_worker_mmap_test) {
+  test::mpi_init();
+  HugeCTR::data_generation_for_test<T, CHK>(file_list_name, prefix, num_files, num_records,
+                                            slot_num, vocabulary_size, label_dim, dense_dim,
+                                            max_nnz);
+
+  const int num_devices = 1;
+  const int batchsize = 2048;
+  const DataReaderSparseParam param = {DataReaderSparse_t::Distributed, max_nnz * slot_num, max_nnz,
+                                       slot_num};
+  std::vector<DataReaderSparseParam> params;
+  params.push_back(param);
+
+  constexpr size_t buffer_length = max_nnz;
+  std::shared_ptr<HeapEx<CSRChunk<T>>> stream_heap(
+      new HeapEx<CSRChunk<T>>(1, 1, num_devices, batchsize, label_dim + dense_dim, params));
+  std::shared_ptr<HeapEx<CSRChunk<T>>> mmap_heap(
+      new HeapEx<CSRChunk<T>>(1, 1, num_devices, batchsize, label_dim + dense_dim, params));
+
+  DataReaderWorker<T> stream_reader(0, 1, stream_heap, file_list_name, buffer_length, true, CHK,
+                                    params);
+  DataReaderWorker<T> mmap_reader(0, 1, mmap_heap, file_list_name, buffer_length, true, CHK,
+                                  params, true);
+
+  // more than one file is crossed
+  const int num_batches = num_records / batchsize * 2 + 1;
+  for (int iter = 0; iter < num_batches; iter++) {
+    stream_reader.read_a_batch();
+    mmap_reader.read_a_batch();
+    CSRChunk<T>* expected = stream_heap->checkout_data_chunk();
+    CSRChunk<T>* actual = mmap_heap->checkout_data_chunk();
+
+    Tensor2<float>& expected_label = expected->get_label_buffers()[0];
+    Tensor2<float>& actual_label = actual->get_label_buffers()[0];
+    ASSERT_EQ(memcmp(expected_label.get_ptr(), actual_label.get_ptr(),
+                     expected_label.get_size_in_bytes()),
+              0);
+    CSR<T>& expected_csr = expected->get_csr_buffer(0, 0);
+    CSR<T>& actual_csr = actual->get_csr_buffer(0, 0);
+    ASSERT_EQ(expected_csr.get_num_values(), actual_csr.get_num_values());
+    ASSERT_EQ(memcmp(expected_csr.get_row_offset_tensor().get_ptr(),
+                     actual_csr.get_row_offset_tensor().get_ptr(),
+                     expected_csr.get_row_offset_tensor().get_size_in_bytes()),
+              0);
+    ASSERT_EQ(memcmp(expected_csr.get_value_tensor().get_ptr(),
+                     actual_csr.get_value_tensor().get_ptr(),
+                     expected_csr.get_num_values() * sizeof(T)),
+              0);
+
+    stream_heap->return_free_chunk();
+    mmap_heap->return_free_chunk();
+  }
+}
+
+TEST(data_reader_worker, data_reader_worker_parallel_parsing_test) {
+  test::mpi_init();
+  HugeCTR::data_generation_for_test<T, CHK>(file_list_name, prefix, num_files, num_records,
+                                            slot_num, vocabulary_size, label_dim, dense_dim,
+                                            max_nnz);
+
+  const int num_devices = 2;
+  const int batchsize = 1000;
+  const DataReaderSparseParam param = {DataReaderSparse_t::Distributed, max_nnz * slot_num, max_nnz,
+                                       slot_num};
+  std::vector<DataReaderSparseParam> params;
+  params.push_back(param);
+
+  constexpr size_t buffer_length = max_nnz;
+  for (int num_parse_threads : {2, 3}) {
+    std::shared_ptr<HeapEx<CSRChunk<T>>> sequential_heap(
+        new HeapEx<CSRChunk<T>>(1, 1, num_devices, batchsize, label_dim + dense_dim, params));
+    std::shared_ptr<HeapEx<CSRChunk<T>>> parallel_heap(
+        new HeapEx<CSRChunk<T>>(1, 1, num_devices, batchsize, label_dim + dense_dim, params));
+
+    DataReaderWorker<T> sequential_reader(0, 1, sequential_heap, file_list_name, buffer_length,
+                                          true, CHK, params);
+    DataReaderWorker<T> parallel_reader(0, 1, parallel_heap, file_list_name, buffer_length, true,
+                                        CHK, params, true, num_parse_threads);
+
+    // batches cross the file boundaries
+    const int num_batches = num_records / batchsize * 3;
+    for (int iter = 0; iter < num_batches; iter++) {
+      sequential_reader.read_a_batch();
+      parallel_reader.read_a_batch();
+      CSRChunk<T>* expected = sequential_heap->checkout_data_chunk();
+      CSRChunk<T>* actual = parallel_heap->checkout_data_chunk();
+      ASSERT_EQ(expected->get_current_batchsize(), actual->get_current_batchsize());
+      for (int dev_id = 0; dev_id < num_devices; dev_id++) {
+        Tensor2<float>& expected_label = expected->get_label_buffers()[dev_id];
+        Tensor2<float>& actual_label = actual->get_label_buffers()[dev_id];
+        ASSERT_EQ(memcmp(expected_label.get_ptr(), actual_label.get_ptr(),
+                         expected_label.get_size_in_bytes()),
+                  0);
+        CSR<T>& expected_csr = expected->get_csr_buffer(0, dev_id);
+        CSR<T>& actual_csr = actual->get_csr_buffer(0, dev_id);
+        ASSERT_EQ(expected_csr.get_num_values(), actual_csr.get_num_values());
+        ASSERT_EQ(memcmp(expected_csr.get_row_offset_tensor().get_ptr(),
+                         actual_csr.get_row_offset_tensor().get_ptr(),
+                         expected_csr.get_row_offset_tensor().get_size_in_bytes()),
+                  0);
+        ASSERT_EQ(memcmp(expected_csr.get_value_tensor().get_ptr(),
+                         actual_csr.get_value_tensor().get_ptr(),
+                         expected_csr.get_num_values() * sizeof(T)),
+                  0);
+      }
+      sequential_heap->return_free_chunk();
+      parallel_heap->return_free_chunk();
+    }
+  }
+}
+
+TEST(data_reader_worker, data_reader_worker_async_io_test) {
+  test::mpi_init();
+  HugeCTR::data_generation_for_test<T, CHK>(file_list_name, prefix, num_files, num_records,
+                                            slot_num, vocabulary_size, label_dim, dense_dim,
+                                            max_nnz);
+
+  const int num_devices = 1;
+  const int batchsize = 2048;
+  const DataReaderSparseParam param = {DataReaderSparse_t::Distributed, max_nnz * slot_num, max_nnz,
+                                       slot_num};
+  std::vector<DataReaderSparseParam> params;
+  params.push_back(param);
+
+  constexpr size_t buffer_length = max_nnz;
+  std::shared_ptr<HeapEx<CSRChunk<T>>> stream_heap(
+      new HeapEx<CSRChunk<T>>(1, 1, num_devices, batchsize, label_dim + dense_dim, params));
+  std::shared_ptr<HeapEx<CSRChunk<T>>> async_heap(
+      new HeapEx<CSRChunk<T>>(1, 1, num_devices, batchsize, label_dim + dense_dim, params));
+
+  DataReaderWorker<T> stream_reader(0, 1, stream_heap, file_list_name, buffer_length, true, CHK,
+                                    params);
+  DataReaderWorker<T> async_reader(0, 1, async_heap, file_list_name, buffer_length, true, CHK,
+                                   params, false, 1, 0, false, 0, 4);
+
+  // more than one file is crossed
+  const int num_batches = num_records / batchsize * 2 + 1;
+  for (int iter = 0; iter < num_batches; iter++) {
+    stream_reader.read_a_batch();
+    async_reader.read_a_batch();
+    CSRChunk<T>* expected = stream_heap->checkout_data_chunk();
+    CSRChunk<T>* actual = async_heap->checkout_data_chunk();
+
+    Tensor2<float>& expected_label = expected->get_label_buffers()[0];
+    Tensor2<float>& actual_label = actual->get_label_buffers()[0];
+    ASSERT_EQ(memcmp(expected_label.get_ptr(), actual_label.get_ptr(),
+                     expected_label.get_size_in_bytes()),
+              0);
+    CSR<T>& expected_csr = expected->get_csr_buffer(0, 0);
+    CSR<T>& actual_csr = actual->get_csr_buffer(0, 0);
+    ASSERT_EQ(expected_csr.get_num_values(), actual_csr.get_num_values());
+    ASSERT_EQ(memcmp(expected_csr.get_row_offset_tensor().get_ptr(),
+                     actual_csr.get_row_offset_tensor().get_ptr(),
+                     expected_csr.get_row_offset_tensor().get_size_in_bytes()),
+              0);
+    ASSERT_EQ(memcmp(expected_csr.get_value_tensor().get_ptr(),
+                     actual_csr.get_value_tensor().get_ptr(),
+                     expected_csr.get_num_values() * sizeof(T)),
+              0);
+
+    stream_heap->return_free_chunk();
+    async_heap->return_free_chunk();
+  }
+}
+
+TEST(data_reader_worker, file_list_shuffle_test) {
+  test::mpi_init();
+  HugeCTR::data_generation_for_test<T, CHK>(file_list_name, prefix, num_files, num_records,
+                                            slot_num, vocabulary_size, label_dim, dense_dim,
+                                            max_nnz);
+  const unsigned int seed = 1234;
+  FileList file_list(file_list_name, true, seed);
+  FileList another_file_list(file_list_name, true, seed);
+  std::vector<std::vector<std::string>> epochs(3);
+  for (unsigned int id = 0; id < num_files * epochs.size(); id++) {
+    std::string file_name = file_list.get_a_file_with_id(id, true);
+    // the workers agree on the order of an epoch
+    ASSERT_EQ(file_name, another_file_list.get_a_file_with_id(id, true));
+    epochs[id / num_files].push_back(file_name);
+  }
+  FileList ordered_file_list(file_list_name);
+  std::vector<std::string> all_files;
+  for (int id = 0; id < num_files; id++) {
+    all_files.push_back(ordered_file_list.get_a_file_with_id(id, false));
+  }
+  std::sort(all_files.begin(), all_files.end());
+  for (auto& epoch : epochs) {
+    std::vector<std::string> sorted_epoch(epoch);
+    std::sort(sorted_epoch.begin(), sorted_epoch.end());
+    ASSERT_EQ(sorted_epoch, all_files);
+  }
+  ASSERT_NE(epochs[0], epochs[1]);
+  ASSERT_NE(epochs[1], epochs[2]);
+  // the first epoch without repeat is the same as the one with repeat
+  for (int id = 0; id < num_files; id++) {
+    ASSERT_EQ(file_list.get_a_file_with_id(id, false), epochs[0][id]);
+  }
+  ASSERT_TRUE(file_list.get_a_file_with_id(num_files, false).empty());
+}
+
+namespace {
+
+// label_dense followed by the keys of every slot, which identifies a sample
+void collect_samples(CSRChunk<T>* csr_chunk, std::vector<std::vector<float>>& samples) {
+  const int label_dense_dim = csr_chunk->get_label_dense_dim();
+  const float* label_dense = csr_chunk->get_label_buffers()[0].get_ptr();
+  CSR<T>& csr = csr_chunk->get_csr_buffer(0, 0);
+  const T* row_offset = csr.get_row_offset_tensor().get_ptr();
+  const T* value = csr.get_value_tensor().get_ptr();
+  for (int i = 0; i < csr_chunk->get_current_batchsize(); i++) {
+    std::vector<float> sample(label_dense + i * label_dense_dim,
+                              label_dense + (i + 1) * label_dense_dim);
+    for (int k = 0; k < slot_num; k++) {
+      sample.push_back(-1.f);
+      for (T j = row_offset[i * slot_num + k]; j < row_offset[i * slot_num + k + 1]; j++) {
+        sample.push_back(value[j]);
+      }
+    }
+    samples.push_back(sample);
+  }
+}
+
+// copy a Norm file with Check_t::Sum into the compressed format, in frames of about "block_bytes"
+void compress_norm_file(const std::string& in_name, const std::string& out_name,
+                        Compression_t compression, size_t block_bytes) {
+  std::ifstream in(in_name, std::ifstream::binary);
+  std::ofstream out(out_name, std::ofstream::binary);
+  int length;
+  DataSetHeader header;
+  char check_bit;
+  in.read(reinterpret_cast<char*>(&length), sizeof(int));
+  in.read(reinterpret_cast<char*>(&header), sizeof(DataSetHeader));
+  in.read(&check_bit, 1);
+  header.reserved[0] = static_cast<long long>(compression);
+  DataWriter<CHK> header_writer(out);
+  header_writer.append(reinterpret_cast<char*>(&header), sizeof(DataSetHeader));
+  header_writer.write_header();
+  BlockWriter block_writer(out, compression, block_bytes);
+  std::vector<char> record;
+  while (in.read(reinterpret_cast<char*>(&length), sizeof(int))) {
+    record.resize(length + 1);
+    in.read(record.data(), length + 1);
+    block_writer.write(reinterpret_cast<char*>(&length), sizeof(int));
+    block_writer.write(record.data(), length + 1);
+    block_writer.end_record();
+  }
+  block_writer.flush();
+}
+
+// the codecs which HugeCTR is built with
+std::vector<Compression_t> built_in_codecs() {
+  std::vector<Compression_t> codecs;
+#ifdef ENABLE_LZ4
+  codecs.push_back(Compression_t::LZ4);
+#endif
+#ifdef ENABLE_ZSTD
+  codecs.push_back(Compression_t::Zstd);
+#endif
+  return codecs;
+}
+
+}  // namespace
+
+TEST(data_reader_worker, block_codec_test) {
+  if (built_in_codecs().empty()) {
+    GTEST_SKIP() << "HugeCTR is built without ENABLE_LZ4 and ENABLE_ZSTD";
+  }
+  std::mt19937 gen(1234);
+  std::uniform_int_distribution<int> dis(0, 255);
+  std::vector<std::vector<char>> blocks;
+  blocks.push_back(std::vector<char>());
+  blocks.push_back(std::vector<char>(7, 'a'));
+  blocks.push_back(std::vector<char>(100000, 'a'));  // long matches overlapping their copies
+  std::vector<char> random_block(100000);
+  for (auto& c : random_block) {
+    c = static_cast<char>(dis(gen));
+  }
+  blocks.push_back(random_block);
+  std::vector<char> mixed_block;
+  for (int i = 0; i < 20000; i++) {
+    int value = i % 100 == 0 ? dis(gen) : i % 7;
+    mixed_block.insert(mixed_block.end(), reinterpret_cast<char*>(&value),
+                       reinterpret_cast<char*>(&value) + sizeof(int));
+  }
+  blocks.push_back(mixed_block);
+
+  for (Compression_t codec : built_in_codecs()) {
+    for (auto& block : blocks) {
+      std::vector<char> compressed;
+      compress_block(codec, block.data(), block.size(), &compressed);
+      ASSERT_LE(compressed.size(), compress_bound(codec, block.size()));
+      std::vector<char> decompressed(block.size());
+      ASSERT_EQ(decompress_block(codec, compressed.data(), compressed.size(), decompressed.data(),
+                                 decompressed.size()),
+                Error_t::Success);
+      ASSERT_EQ(decompressed, block);
+      if (&block == &blocks[2]) {
+        ASSERT_LT(compressed.size(), block.size() / 100);
+      }
+      if (block.size() > 0) {
+        // a wrong size or a truncated block is an error
+        ASSERT_EQ(decompress_block(codec, compressed.data(), compressed.size(),
+                                   decompressed.data(), decompressed.size() - 1),
+                  Error_t::BrokenFile);
+        ASSERT_EQ(decompress_block(codec, compressed.data(), compressed.size() - 1,
+                                   decompressed.data(), decompressed.size()),
+                  Error_t::BrokenFile);
+      }
+    }
+  }
+}
+
+TEST(data_reader_worker, data_reader_worker_compressed_test) {
+  const std::vector<Compression_t> codecs = built_in_codecs();
+  if (codecs.empty()) {
+    GTEST_SKIP() << "HugeCTR is built without ENABLE_LZ4 and ENABLE_ZSTD";
+  }
+  test::mpi_init();
+  HugeCTR::data_generation_for_test<T, CHK>(file_list_name, prefix, num_files, num_records,
+                                            slot_num, vocabulary_size, label_dim, dense_dim,
+                                            max_nnz);
+  const std::string compressed_file_list_name("data_reader_compressed_file_list.txt");
+  {
+    std::ifstream file_list(file_list_name);
+    std::ofstream compressed_file_list(compressed_file_list_name);
+    int n;
+    file_list >> n;
+    compressed_file_list << n << std::endl;
+    for (int i = 0; i < n; i++) {
+      std::string name;
+      file_list >> name;
+      // the built-in codecs take turns over the files
+      Compression_t codec = codecs[i % codecs.size()];
+      std::string compressed_name = name + (codec == Compression_t::LZ4 ? ".lz4" : ".zst");
+      compress_norm_file(name, compressed_name, codec, 100000);
+      compressed_file_list << compressed_name << std::endl;
+    }
+  }
+
+  const int num_devices = 1;
+  const int batchsize = 2048;
+  const DataReaderSparseParam param = {DataReaderSparse_t::Distributed, max_nnz * slot_num, max_nnz,
+                                       slot_num};
+  std::vector<DataReaderSparseParam> params;
+  params.push_back(param);
+
+  constexpr size_t buffer_length = max_nnz;
+  std::shared_ptr<HeapEx<CSRChunk<T>>> expected_heap(
+      new HeapEx<CSRChunk<T>>(1, 1, num_devices, batchsize, label_dim + dense_dim, params));
+  DataReaderWorker<T> expected_reader(0, 1, expected_heap, file_list_name, buffer_length, true,
+                                      CHK, params);
+  // the stream, memory mapped (zero-copy) and asynchronous sources
+  std::vector<std::shared_ptr<HeapEx<CSRChunk<T>>>> heaps;
+  std::vector<std::shared_ptr<DataReaderWorker<T>>> readers;
+  for (int source = 0; source < 3; source++) {
+    heaps.emplace_back(
+        new HeapEx<CSRChunk<T>>(1, 1, num_devices, batchsize, label_dim + dense_dim, params));
+    readers.emplace_back(new DataReaderWorker<T>(0, 1, heaps.back(), compressed_file_list_name,
+                                                 buffer_length, true, CHK, params, source == 1, 1,
+                                                 0, false, 0, source == 2 ? 4 : 0));
+  }
+
+  // more than one file is crossed
+  const int num_batches = num_records / batchsize * 2 + 1;
+  for (int iter = 0; iter < num_batches; iter++) {
+    expected_reader.read_a_batch();
+    CSRChunk<T>* expected = expected_heap->checkout_data_chunk();
+    std::vector<std::vector<float>> expected_samples;
+    collect_samples(expected, expected_samples);
+    for (size_t i = 0; i < readers.size(); i++) {
+      readers[i]->read_a_batch();
+      std::vector<std::vector<float>> samples;
+      collect_samples(heaps[i]->checkout_data_chunk(), samples);
+      ASSERT_EQ(samples, expected_samples);
+      heaps[i]->return_free_chunk();
+    }
+    expected_heap->return_free_chunk();
+  }
+}
+
+TEST(data_reader_worker, data_reader_worker_shuffle_test) {
+  test::mpi_init();
+  HugeCTR::data_generation_for_test<T, CHK>(file_list_name, prefix, num_files, num_records,
+                                            slot_num, vocabulary_size, label_dim, dense_dim,
+                                            max_nnz);
+
+  const int num_devices = 1;
+  const int batchsize = 2048;
+  const DataReaderSparseParam param = {DataReaderSparse_t::Distributed, max_nnz * slot_num, max_nnz,
+                                       slot_num};
+  std::vector<DataReaderSparseParam> params;
+  params.push_back(param);
+
+  constexpr size_t buffer_length = max_nnz;
+  const int num_batches = num_files * num_records / batchsize;
+  std::vector<std::vector<float>> expected_samples;
+  {
+    std::shared_ptr<HeapEx<CSRChunk<T>>> csr_heap(
+        new HeapEx<CSRChunk<T>>(1, 1, num_devices, batchsize, label_dim + dense_dim, params));
+    DataReaderWorker<T> data_reader(0, 1, csr_heap, file_list_name, buffer_length, false, CHK,
+                                    params);
+    for (int iter = 0; iter < num_batches; iter++) {
+      data_reader.read_a_batch();
+      collect_samples(csr_heap->checkout_data_chunk(), expected_samples);
+      csr_heap->return_free_chunk();
+    }
+  }
+
+  // in the no-repeat mode, an epoch has every sample once in a different order
+  for (int num_parse_threads : {1, 2}) {
+    std::shared_ptr<HeapEx<CSRChunk<T>>> csr_heap(
+        new HeapEx<CSRChunk<T>>(1, 1, num_devices, batchsize, label_dim + dense_dim, params));
+    DataReaderWorker<T> data_reader(0, 1, csr_heap, file_list_name, buffer_length, false, CHK,
+                                    params, num_parse_threads > 1, num_parse_threads, 1000, true,
+                                    5678);
+    std::vector<std::vector<float>> samples;
+    for (int iter = 0; iter < num_batches; iter++) {
+      data_reader.read_a_batch();
+      CSRChunk<T>* csr_chunk = csr_heap->checkout_data_chunk();
+      ASSERT_EQ(csr_chunk->get_current_batchsize(), batchsize);
+      collect_samples(csr_chunk, samples);
+      csr_heap->return_free_chunk();
+    }
+    ASSERT_EQ(samples.size(), expected_samples.size());
+    ASSERT_NE(samples, expected_samples);
+    std::vector<std::vector<float>> sorted_samples(samples);
+    std::vector<std::vector<float>> sorted_expected_samples(expected_samples);
+    std::sort(sorted_samples.begin(), sorted_samples.end());
+    std::sort(sorted_expected_samples.begin(), sorted_expected_samples.end());
+    ASSERT_EQ(sorted_samples, sorted_expected_samples);
+  }
+}
+
 TEST(data_reader_test, data_reader_simple_test) {
   const int batchsize = 2048;
 
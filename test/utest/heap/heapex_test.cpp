@@ -15,21 +15,29 @@
  */
 
 #include "HugeCTR/include/data_readers/heapex.hpp"
+#include <atomic>
+#include <chrono>
 #include <future>
-#include <random>
+#include <thread>
+#include <vector>
 #include "HugeCTR/include/data_readers/csr_chunk.hpp"
+#include "HugeCTR/include/data_readers/lock_free_heap.hpp"
 #include "gtest/gtest.h"
 
 using namespace HugeCTR;
 
 TEST(heapex, head_alloc_exceed_boundary) {
-  EXPECT_THROW({ HeapEx<float> heap(33, 0.0f); }, internal_runtime_error);
+  EXPECT_THROW({ HeapEx<float> heap(33, 1, 0.0f); }, internal_runtime_error);
+}
+
+TEST(heapex, head_alloc_zero_depth) {
+  EXPECT_THROW({ HeapEx<float> heap(4, 0, 0.0f); }, internal_runtime_error);
 }
 
 TEST(heapex, heapex_basic_test) {
   float* chunks[5];
 
-  HeapEx<float> heapex(3, 0.0f);
+  HeapEx<float> heapex(3, 1, 0.0f);
   chunks[0] = heapex.checkout_free_chunk(0);
   chunks[1] = heapex.checkout_free_chunk(1);
   EXPECT_NE(chunks[0], chunks[1]);
@@ -56,8 +64,141 @@ TEST(heapex, heapex_csr_chunk_test) {
   std::vector<DataReaderSparseParam> params;
   params.push_back(param);
 
-  HeapEx<CSRChunk<long long>> csr_heapex(32, num_devices, batchsize, label_dim, params);
+  HeapEx<CSRChunk<long long>> csr_heapex(32, 1, num_devices, batchsize, label_dim, params);
   CSRChunk<long long>* chunk_tmp = nullptr;
   chunk_tmp = csr_heapex.checkout_free_chunk(0);
   chunk_tmp->get_csr_buffer(0).reset();
 }
+
+TEST(heapex, heapex_prefetch_depth_order_test) {
+  const int num_workers = 2;
+  const int depth = 3;
+  HeapEx<float> heapex(num_workers, depth, 0.0f);
+  EXPECT_EQ(heapex.get_num_chunks_per_worker(), depth);
+
+  // every worker can fill all of its chunks without any consumer
+  std::vector<float*> chunks;
+  for (int j = 0; j < depth; j++) {
+    for (int w = 0; w < num_workers; w++) {
+      float* chunk = heapex.checkout_free_chunk(w);
+      for (auto c : chunks) {
+        EXPECT_NE(c, chunk);
+      }
+      chunks.push_back(chunk);
+      *chunk = static_cast<float>(j * num_workers + w);
+      heapex.commit_data_chunk(w, false);
+    }
+  }
+  // the batches must be delivered in the round-robin order of the workers
+  for (int i = 0; i < depth * num_workers; i++) {
+    float* chunk = heapex.checkout_data_chunk();
+    EXPECT_EQ(*chunk, static_cast<float>(i));
+    heapex.return_free_chunk();
+  }
+}
+
+TEST(lock_free_heap, lock_free_heap_basic_test) {
+  float* chunks[5];
+
+  LockFreeHeap<float> heap(3, 1, 0.0f);
+  chunks[0] = heap.checkout_free_chunk(0);
+  chunks[1] = heap.checkout_free_chunk(1);
+  EXPECT_NE(chunks[0], chunks[1]);
+  *chunks[1] = 20.0f;
+  heap.commit_data_chunk(1, false);
+  *chunks[0] = 10.0f;
+  heap.commit_data_chunk(0, false);
+  chunks[2] = heap.checkout_free_chunk(2);
+  chunks[3] = heap.checkout_data_chunk();
+  EXPECT_TRUE(*chunks[3] == 10.0f);
+  heap.return_free_chunk();
+  chunks[4] = heap.checkout_data_chunk();
+  EXPECT_TRUE(*chunks[4] == 20.0f);
+  heap.return_free_chunk();
+  heap.commit_data_chunk(2, false);
+}
+
+TEST(lock_free_heap, lock_free_heap_eof_test) {
+  LockFreeHeap<float> heap(2, 2, 0.0f);
+  float* chunk = heap.checkout_free_chunk(0);
+  *chunk = 1.0f;
+  heap.commit_data_chunk(0, false);
+  // worker 0 faces the EOF while holding a chunk, worker 1 without any chunk
+  heap.checkout_free_chunk(0);
+  heap.commit_data_chunk(0, true);
+  heap.commit_data_chunk(1, true);
+
+  chunk = heap.checkout_data_chunk();
+  EXPECT_EQ(*chunk, 1.0f);
+  heap.return_free_chunk();
+  EXPECT_EQ(heap.checkout_data_chunk(), nullptr);
+  heap.return_free_chunk();
+
+  // after the new source is set, all the chunks are available again
+  heap.reset();
+  float* chunks[2];
+  chunks[0] = heap.checkout_free_chunk(0);
+  chunks[1] = heap.checkout_free_chunk(0);
+  EXPECT_NE(chunks[0], nullptr);
+  EXPECT_NE(chunks[1], nullptr);
+  EXPECT_NE(chunks[0], chunks[1]);
+}
+
+TEST(lock_free_heap, lock_free_heap_reset_running_test) {
+  LockFreeHeap<float> heap(2, 2, 0.0f);
+  heap.commit_data_chunk(1, true);
+  // worker 0 is still reading
+  heap.checkout_free_chunk(0);
+  EXPECT_THROW(heap.reset(), internal_runtime_error);
+  heap.commit_data_chunk(0, true);
+  heap.reset();
+}
+
+TEST(lock_free_heap, lock_free_heap_break_test) {
+  LockFreeHeap<float> heap(2, 1, 0.0f);
+  auto consumer = std::async(std::launch::async, [&heap]() { return heap.checkout_data_chunk(); });
+  std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  heap.break_and_return();
+  EXPECT_EQ(consumer.get(), nullptr);
+}
+
+TEST(lock_free_heap, lock_free_heap_eof_reset_loop_test) {
+  const int num_workers = 8;
+  const int num_epochs = 2000;
+  LockFreeHeap<float> heap(num_workers, 2, 0.0f);
+  // the epoch whose source is set, which the workers wait for after their nop
+  std::atomic<int> source{0};
+  auto worker = [&heap, &source, num_epochs](int worker_id) {
+    for (int epoch = 0; epoch < num_epochs; epoch++) {
+      while (source.load() != epoch) {
+        std::this_thread::yield();
+      }
+      float* chunk = heap.checkout_free_chunk(worker_id);
+      *chunk = static_cast<float>(epoch);
+      heap.commit_data_chunk(worker_id, false);
+      // the EOF is faced while holding a chunk
+      heap.checkout_free_chunk(worker_id);
+      heap.commit_data_chunk(worker_id, true);
+    }
+  };
+  std::vector<std::thread> workers;
+  for (int w = 0; w < num_workers; w++) {
+    workers.emplace_back(worker, w);
+  }
+  for (int epoch = 0; epoch < num_epochs; epoch++) {
+    for (int w = 0; w < num_workers; w++) {
+      float* chunk = heap.checkout_data_chunk();
+      ASSERT_NE(chunk, nullptr);
+      EXPECT_EQ(*chunk, static_cast<float>(epoch));
+      heap.return_free_chunk();
+    }
+    EXPECT_EQ(heap.checkout_data_chunk(), nullptr);
+    heap.return_free_chunk();
+    // right after the EOF, as DataReader::set_source() does
+    EXPECT_NO_THROW(heap.reset());
+    source.store(epoch + 1);
+  }
+  for (auto& t : workers) {
+    t.join();
+  }
+}
@@ -19,9 +19,14 @@
 #include <unordered_set>
 #include <unordered_map>
 #include <algorithm>
+#include <cstdio>
+#include <map>
+#include <memory>
 #include <omp.h>
 #include "HugeCTR/include/inference/session_inference.hpp"
 #include "HugeCTR/include/inference/embedding_interface.hpp"
+#include "HugeCTR/include/inference/embedding_delta.hpp"
+#include "HugeCTR/include/inference/parameter_server.hpp"
 #include "gtest/gtest.h"
 #include "utest/test_utils.h"
 #include <cuda_profiler_api.h>
@@ -420,6 +425,163 @@ h_total_embeddingvector, max_emb_id, default_emb_vector_value) num_threads(num_o
   delete embedding_cache;
 }
 
+const char* coherence_config_file = "embedding_cache_coherence_config.json";
+const char* coherence_sparse_model_file = "embedding_cache_coherence_sparse_model.bin";
+const char* coherence_delta_file = "embedding_cache_coherence_delta.bin";
+const char* coherence_model_name = "coherence";
+
+// The emb_vec of a key in a generation of the model, exact in float
+float coherence_value(size_t generation, size_t key, size_t j) {
+  return static_cast<float>(generation * 65536 + key) + j * 0.125f;
+}
+
+// Write a distributed sparse model of the keys [0, num_rows) in a generation, and the config of
+// a model with this one embedding table
+template<typename TypeHashKey>
+void write_coherence_model(size_t num_rows, size_t embedding_vec_size, size_t max_feature_num, 
+                           size_t generation) {
+  std::ofstream model_file(coherence_sparse_model_file, std::ofstream::binary);
+  std::vector<float> vector(embedding_vec_size);
+  for(size_t key = 0; key < num_rows; key++){
+    TypeHashKey emb_id = static_cast<TypeHashKey>(key);
+    for(size_t j = 0; j < embedding_vec_size; j++){
+      vector[j] = coherence_value(generation, key, j);
+    }
+    model_file.write(reinterpret_cast<const char*>(&emb_id), sizeof(TypeHashKey));
+    model_file.write(reinterpret_cast<const char*>(vector.data()), sizeof(float) * embedding_vec_size);
+  }
+  std::ofstream config_file(coherence_config_file);
+  config_file << "{\"inference\": {\"max_batchsize\": 1, \"sparse_model_file\": \"" 
+              << coherence_sparse_model_file << "\"}, \"layers\": ["
+              << "{\"name\": \"data\", \"type\": \"Data\", \"sparse\": [{\"top\": \"data1\", "
+              << "\"type\": \"DistributedSlot\", \"max_feature_num_per_sample\": " << max_feature_num 
+              << ", \"slot_num\": 1}]}, "
+              << "{\"name\": \"sparse_embedding1\", \"type\": \"DistributedSlotSparseEmbeddingHash\", "
+              << "\"bottom\": \"data1\", \"top\": \"sparse_embedding1\", \"sparse_embedding_hparam\": "
+              << "{\"embedding_vec_size\": " << embedding_vec_size 
+              << ", \"default_emb_vec_value\": 0.5}}]}";
+}
+
+// The cached emb_vec follow apply_delta and update_model, and a look_up which began before an
+// invalidation does not insert the emb_vec it read into the cache
+template<typename TypeHashKey>
+void embedding_cache_coherence_test() {
+  CK_CUDA_THROW_(cudaSetDevice(0));
+  const size_t num_rows = 8192;
+  const size_t embedding_vec_size = 8;
+  const size_t num_keys = 256;
+  const float default_emb_vec_value = 0.5f;
+  write_coherence_model<TypeHashKey>(num_rows, embedding_vec_size, num_keys, 0);
+
+  std::vector<std::string> model_config_path{coherence_config_file};
+  std::vector<std::string> model_name{coherence_model_name};
+  parameter_server<TypeHashKey> ps("TRITON", model_config_path, model_name);
+  // Half of the table fits in the cache, far more than the keys served
+  std::unique_ptr<embedding_interface> cache(embedding_interface::Create_Embedding_Cache<TypeHashKey>(
+      &ps, 0, true, 0.5, coherence_config_file, coherence_model_name));
+  embedding_cache_workspace workspace;
+  cache -> create_workspace(workspace);
+  std::vector<cudaStream_t> query_streams(1), update_streams(1);
+  CK_CUDA_THROW_(cudaStreamCreate(&query_streams[0]));
+  CK_CUDA_THROW_(cudaStreamCreate(&update_streams[0]));
+  float* d_output;
+  CK_CUDA_THROW_(cudaMalloc((void**)&d_output, num_keys * embedding_vec_size * sizeof(float)));
+  std::vector<float> h_output(num_keys * embedding_vec_size);
+  const std::vector<size_t> h_embedding_offset{0, num_keys};
+
+  // The expected generation of each key, or -1 for the default emb_vec of a deleted one
+  std::map<TypeHashKey, int> generation;
+  std::vector<TypeHashKey> served_keys(num_keys), other_keys(num_keys);
+  for(size_t i = 0; i < num_keys; i++){
+    served_keys[i] = static_cast<TypeHashKey>(i);
+    other_keys[i] = static_cast<TypeHashKey>(num_rows / 2 + i);
+    generation[served_keys[i]] = 0;
+    generation[other_keys[i]] = 0;
+  }
+  auto look_up = [&](const std::vector<TypeHashKey>& keys){
+    cache -> look_up(keys.data(), h_embedding_offset, d_output, workspace, query_streams);
+    CK_CUDA_THROW_(cudaMemcpyAsync(h_output.data(), d_output, h_output.size() * sizeof(float), cudaMemcpyDeviceToHost, query_streams[0]));
+    CK_CUDA_THROW_(cudaStreamSynchronize(query_streams[0]));
+    for(size_t i = 0; i < keys.size(); i++){
+      const int key_generation = generation[keys[i]];
+      for(size_t j = 0; j < embedding_vec_size; j++){
+        const float expected = key_generation < 0 ? default_emb_vec_value : coherence_value(key_generation, keys[i], j);
+        ASSERT_EQ(h_output[i * embedding_vec_size + j], expected);
+      }
+    }
+  };
+  auto update = [&](){
+    cache -> update(workspace, update_streams);
+    CK_CUDA_THROW_(cudaStreamSynchronize(update_streams[0]));
+  };
+
+  // The keys are cached by the first look_up
+  look_up(served_keys);
+  update();
+  look_up(served_keys);
+  ASSERT_EQ(workspace.h_hit_rate_[0], 1.0);
+
+  // A delta refreshes the cached keys which it upserts or deletes, which are still hits
+  embedding_delta<TypeHashKey> delta(embedding_vec_size);
+  std::vector<float> vector(embedding_vec_size);
+  for(size_t i = 0; i < num_keys / 2; i++){
+    for(size_t j = 0; j < embedding_vec_size; j++){
+      vector[j] = coherence_value(1, served_keys[i], j);
+    }
+    delta.upsert(served_keys[i], vector.data());
+    generation[served_keys[i]] = 1;
+  }
+  for(size_t i = num_keys / 2; i < num_keys / 2 + num_keys / 8; i++){
+    delta.erase(served_keys[i]);
+    generation[served_keys[i]] = -1;
+  }
+  delta.write(coherence_delta_file);
+  ps.apply_delta(coherence_model_name, 0, coherence_delta_file);
+  look_up(served_keys);
+  ASSERT_EQ(workspace.h_hit_rate_[0], 1.0);
+
+  // A new version of the model refreshes every cached key
+  write_coherence_model<TypeHashKey>(num_rows, embedding_vec_size, num_keys, 2);
+  ps.update_model(coherence_model_name, {coherence_sparse_model_file});
+  ps.wait_for_update();
+  for(auto& key_generation : generation){
+    key_generation.second = 2;
+  }
+  look_up(served_keys);
+  ASSERT_EQ(workspace.h_hit_rate_[0], 1.0);
+
+  // The emb_vec which a look_up read before a delta are not inserted by its update
+  look_up(other_keys);
+  ASSERT_EQ(workspace.h_hit_rate_[0], 0.0);
+  embedding_delta<TypeHashKey> other_delta(embedding_vec_size);
+  for(size_t i = 0; i < num_keys; i++){
+    for(size_t j = 0; j < embedding_vec_size; j++){
+      vector[j] = coherence_value(3, other_keys[i], j);
+    }
+    other_delta.upsert(other_keys[i], vector.data());
+    generation[other_keys[i]] = 3;
+  }
+  other_delta.write(coherence_delta_file);
+  ps.apply_delta(coherence_model_name, 0, coherence_delta_file);
+  update();
+  look_up(other_keys);
+  ASSERT_EQ(workspace.h_hit_rate_[0], 0.0);
+  // And the next update inserts the new ones
+  update();
+  look_up(other_keys);
+  ASSERT_EQ(workspace.h_hit_rate_[0], 1.0);
+
+  CK_CUDA_THROW_(cudaFree(d_output));
+  CK_CUDA_THROW_(cudaStreamDestroy(query_streams[0]));
+  CK_CUDA_THROW_(cudaStreamDestroy(update_streams[0]));
+  cache -> destroy_workspace(workspace);
+  cache.reset();
+  std::remove(coherence_config_file);
+  std::remove(coherence_sparse_model_file);
+  std::remove(coherence_delta_file);
+}
+
+
 }  // namespace
 
 TEST(embedding_cache, embedding_cache_usigned_int_0_0_5_1_enable) {embedding_cache_test<unsigned int>(MODEL_PATH, MODEL_NAME, 0, 0, 5, 1, true); }
@@ -506,4 +668,5 @@ TEST(embedding_cache, embedding_cache_long_long_32_30_5_4_disable) {embedding_ca
 TEST(embedding_cache, embedding_cache_long_long_32_random_5_4_enable) {embedding_cache_test<long long>(MODEL_PATH, MODEL_NAME, 32, -1, 5, 4, true); }
 TEST(embedding_cache, embedding_cache_long_long_32_random_5_4_disable) {embedding_cache_test<long long>(MODEL_PATH, MODEL_NAME, 32, -1, 5, 4, false); }*/
 
-
+TEST(embedding_cache, coherence_unsigned_int) { embedding_cache_coherence_test<unsigned int>(); }
+TEST(embedding_cache, coherence_long_long) { embedding_cache_coherence_test<long long>(); }
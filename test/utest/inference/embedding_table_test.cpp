@@ -0,0 +1,295 @@
+/*
+ * Copyright (c) 2020, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <cstdio>
+#include <fstream>
+#include <random>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+#include "HugeCTR/include/inference/embedding_table.hpp"
+#include "HugeCTR/include/model_oversubscriber/indexed_snapshot.hpp"
+#include "gtest/gtest.h"
+
+using namespace HugeCTR;
+namespace {
+
+const char* sparse_model_file = "embedding_table_test_sparse_model.bin";
+
+// Write rows <key, (slot_id,) embedding_vector> with random keys, some of them repeated, and
+// return the first vector of each key
+template <typename TypeHashKey>
+std::unordered_map<TypeHashKey, std::vector<float>> write_sparse_model(size_t num_rows,
+                                                                       size_t embedding_vec_size,
+                                                                       bool has_slot_id) {
+  std::mt19937 gen(num_rows);
+  std::uniform_int_distribution<TypeHashKey> key_dist(0, num_rows * 2);
+  std::uniform_real_distribution<float> value_dist(-1.f, 1.f);
+  std::unordered_map<TypeHashKey, std::vector<float>> expected;
+  std::ofstream file(sparse_model_file, std::ofstream::binary);
+  std::vector<float> vector(embedding_vec_size);
+  for (size_t row = 0; row < num_rows; row++) {
+    TypeHashKey key = key_dist(gen);
+    size_t slot_id = row % 26;
+    for (auto& value : vector) value = value_dist(gen);
+    file.write(reinterpret_cast<char*>(&key), sizeof(TypeHashKey));
+    if (has_slot_id) file.write(reinterpret_cast<char*>(&slot_id), sizeof(size_t));
+    file.write(reinterpret_cast<char*>(vector.data()), sizeof(float) * embedding_vec_size);
+    expected.emplace(key, vector);
+  }
+  return expected;
+}
+
+template <typename TypeHashKey>
+void embedding_table_test(size_t num_rows, size_t embedding_vec_size, bool has_slot_id) {
+  auto expected = write_sparse_model<TypeHashKey>(num_rows, embedding_vec_size, has_slot_id);
+  cpu_embedding_table<TypeHashKey> table(sparse_model_file, embedding_vec_size, has_slot_id);
+  ASSERT_EQ(table.size(), expected.size());
+  ASSERT_EQ(table.get_embedding_vec_size(), embedding_vec_size);
+  for (TypeHashKey key = 0; key <= static_cast<TypeHashKey>(num_rows * 2 + 1); key++) {
+    const float* vector = table.find(key);
+    auto it = expected.find(key);
+    if (it == expected.end()) {
+      ASSERT_EQ(vector, nullptr);
+    } else {
+      ASSERT_NE(vector, nullptr);
+      ASSERT_EQ(memcmp(vector, it->second.data(), sizeof(float) * embedding_vec_size), 0);
+    }
+  }
+  std::remove(sparse_model_file);
+}
+
+// look up batches of keys, half of them not in the table, with several threads or one
+template <typename TypeHashKey>
+void embedding_table_look_up_test(size_t num_rows, size_t embedding_vec_size, size_t length,
+                                  int num_threads) {
+  auto expected = write_sparse_model<TypeHashKey>(num_rows, embedding_vec_size, false);
+  const float default_emb_vec_value = 0.5f;
+  cpu_embedding_table<TypeHashKey> table(sparse_model_file, embedding_vec_size, false,
+                                         default_emb_vec_value);
+  std::mt19937 gen(length);
+  std::uniform_int_distribution<TypeHashKey> key_dist(0, num_rows * 4);
+  std::vector<TypeHashKey> keys(length);
+  for (auto& key : keys) key = key_dist(gen);
+  std::vector<float> vectors(length * embedding_vec_size, -1.f);
+  table.look_up(keys.data(), length, vectors.data(), num_threads);
+  const std::vector<float> default_vector(embedding_vec_size, default_emb_vec_value);
+  for (size_t i = 0; i < length; i++) {
+    auto it = expected.find(keys[i]);
+    const float* vector = it == expected.end() ? default_vector.data() : it->second.data();
+    ASSERT_EQ(
+        memcmp(&vectors[i * embedding_vec_size], vector, sizeof(float) * embedding_vec_size), 0);
+  }
+  std::remove(sparse_model_file);
+}
+
+// an indexed snapshot of the same rows is mapped, and looked up like the table loaded from them
+template <typename TypeHashKey>
+void embedding_table_mapped_test(size_t num_rows, size_t embedding_vec_size, bool has_slot_id) {
+  const char* indexed_snapshot_file = "embedding_table_test_indexed_snapshot.bin";
+  write_sparse_model<TypeHashKey>(num_rows, embedding_vec_size, has_slot_id);
+  IndexedSnapshot<TypeHashKey>::convert_from_snapshot(sparse_model_file, indexed_snapshot_file,
+                                                      embedding_vec_size, has_slot_id);
+  cpu_embedding_table<TypeHashKey> loaded(sparse_model_file, embedding_vec_size, has_slot_id,
+                                          0.5f);
+  cpu_embedding_table<TypeHashKey> mapped(indexed_snapshot_file, embedding_vec_size, has_slot_id,
+                                          0.5f);
+  ASSERT_FALSE(loaded.is_mapped());
+  ASSERT_TRUE(mapped.is_mapped());
+  ASSERT_EQ(mapped.size(), loaded.size());
+  // a mapped table takes no memory of its own
+  EXPECT_GE(cpu_embedding_table<TypeHashKey>::estimate_memory_usage(
+                sparse_model_file, embedding_vec_size, has_slot_id),
+            loaded.memory_usage());
+  EXPECT_EQ(cpu_embedding_table<TypeHashKey>::estimate_memory_usage(
+                indexed_snapshot_file, embedding_vec_size, has_slot_id),
+            0);
+
+  std::vector<TypeHashKey> keys(num_rows * 2 + 2);
+  for (size_t i = 0; i < keys.size(); i++) keys[i] = static_cast<TypeHashKey>(i);
+  std::vector<float> loaded_vectors(keys.size() * embedding_vec_size);
+  std::vector<float> mapped_vectors(keys.size() * embedding_vec_size);
+  loaded.look_up(keys.data(), keys.size(), loaded_vectors.data(), 4);
+  mapped.look_up(keys.data(), keys.size(), mapped_vectors.data(), 4);
+  ASSERT_EQ(loaded_vectors, mapped_vectors);
+
+  // the embedding_vec_size and the kind of embedding must match those of the snapshot
+  EXPECT_THROW(cpu_embedding_table<TypeHashKey>(indexed_snapshot_file, embedding_vec_size + 1,
+                                                has_slot_id),
+               internal_runtime_error);
+  EXPECT_THROW(cpu_embedding_table<TypeHashKey>(indexed_snapshot_file, embedding_vec_size,
+                                                !has_slot_id),
+               internal_runtime_error);
+
+  // the rows of a corrupted index past the value block are looked up as missing keys, the one
+  // right past it included, instead of read out of the mapping
+  {
+    using Entry = typename FlatHashTable<TypeHashKey>::Entry;
+    const IndexedSnapshotHeader header =
+        IndexedSnapshot<TypeHashKey>::read_header(indexed_snapshot_file);
+    std::fstream file(indexed_snapshot_file,
+                      std::fstream::in | std::fstream::out | std::fstream::binary);
+    std::vector<int8_t> ctrl(header.index_capacity);
+    file.seekg(header.index_offset);
+    file.read(reinterpret_cast<char*>(ctrl.data()), ctrl.size());
+    std::vector<TypeHashKey> corrupted_keys;
+    for (size_t pos = 0; pos < ctrl.size() && corrupted_keys.size() < 2; pos++) {
+      if (ctrl[pos] < 0) continue;
+      const size_t entry_offset =
+          header.index_offset + header.index_capacity + pos * sizeof(Entry);
+      Entry entry;
+      file.seekg(entry_offset);
+      file.read(reinterpret_cast<char*>(&entry), sizeof(Entry));
+      entry.value = header.num_rows + (corrupted_keys.empty() ? 0 : 1000000);
+      file.seekp(entry_offset);
+      file.write(reinterpret_cast<const char*>(&entry), sizeof(Entry));
+      corrupted_keys.push_back(entry.key);
+    }
+    file.close();
+    ASSERT_EQ(corrupted_keys.size(), 2);
+    cpu_embedding_table<TypeHashKey> corrupted(indexed_snapshot_file, embedding_vec_size,
+                                               has_slot_id, 0.5f);
+    std::vector<float> vectors(corrupted_keys.size() * embedding_vec_size);
+    corrupted.look_up(corrupted_keys.data(), corrupted_keys.size(), vectors.data(), 1);
+    for (size_t i = 0; i < corrupted_keys.size(); i++) {
+      EXPECT_EQ(corrupted.find(corrupted_keys[i]), nullptr);
+    }
+    EXPECT_EQ(vectors, std::vector<float>(vectors.size(), 0.5f));
+  }
+  std::remove(sparse_model_file);
+  std::remove(indexed_snapshot_file);
+}
+
+// deltas which upsert and delete keys of the table, and keys not in it, are applied one over the
+// other, and looked up like the table they lead to
+template <typename TypeHashKey>
+void embedding_table_delta_test(size_t num_rows, size_t embedding_vec_size, bool has_slot_id,
+                                bool indexed) {
+  const char* delta_file = "embedding_table_test_delta.bin";
+  const char* indexed_snapshot_file = "embedding_table_test_indexed_snapshot.bin";
+  auto expected = write_sparse_model<TypeHashKey>(num_rows, embedding_vec_size, has_slot_id);
+  if (indexed) {
+    IndexedSnapshot<TypeHashKey>::convert_from_snapshot(
+        sparse_model_file, indexed_snapshot_file, embedding_vec_size, has_slot_id);
+  }
+  const float default_emb_vec_value = 0.5f;
+  std::shared_ptr<const cpu_embedding_table<TypeHashKey>> table(new cpu_embedding_table<TypeHashKey>(
+      indexed ? indexed_snapshot_file : sparse_model_file, embedding_vec_size, has_slot_id,
+      default_emb_vec_value));
+  std::shared_ptr<const cpu_embedding_table<TypeHashKey>> loaded = table;
+
+  std::mt19937 gen(num_rows);
+  std::uniform_int_distribution<TypeHashKey> key_dist(0, num_rows * 4);
+  std::uniform_real_distribution<float> value_dist(-1.f, 1.f);
+  for (size_t generation = 0; generation < 3; generation++) {
+    embedding_delta<TypeHashKey> delta(embedding_vec_size);
+    std::vector<float> vector(embedding_vec_size);
+    std::unordered_set<TypeHashKey> upserted;
+    for (size_t i = 0; i < num_rows / 50; i++) {
+      const TypeHashKey key = key_dist(gen);
+      // a key upserted twice would keep its first vector
+      if (!upserted.insert(key).second) continue;
+      for (auto& value : vector) value = value_dist(gen);
+      delta.upsert(key, vector.data());
+      expected.emplace(key, vector).first->second = vector;
+    }
+    // a key deleted by the delta which upserts it is deleted
+    for (size_t i = 0; i < num_rows / 100; i++) {
+      const TypeHashKey key = i % 2 ? key_dist(gen) : delta.get_upsert_keys()[i];
+      delta.erase(key);
+      expected.erase(key);
+    }
+    delta.write(delta_file);
+    const embedding_delta<TypeHashKey> read_delta(delta_file, embedding_vec_size);
+    ASSERT_EQ(read_delta.get_upsert_keys(), delta.get_upsert_keys());
+    ASSERT_EQ(read_delta.get_upsert_vectors(), delta.get_upsert_vectors());
+    ASSERT_EQ(read_delta.get_delete_keys(), delta.get_delete_keys());
+    table.reset(new cpu_embedding_table<TypeHashKey>(table, read_delta));
+
+    ASSERT_EQ(table->size(), expected.size());
+    ASSERT_EQ(table->is_mapped(), indexed);
+    std::vector<TypeHashKey> keys(num_rows * 4 + 2);
+    for (size_t i = 0; i < keys.size(); i++) keys[i] = static_cast<TypeHashKey>(i);
+    std::vector<float> vectors(keys.size() * embedding_vec_size);
+    table->look_up(keys.data(), keys.size(), vectors.data(), 4);
+    const std::vector<float> default_vector(embedding_vec_size, default_emb_vec_value);
+    for (size_t i = 0; i < keys.size(); i++) {
+      auto it = expected.find(keys[i]);
+      ASSERT_EQ(table->find(keys[i]) == nullptr, it == expected.end());
+      const float* vector = it == expected.end() ? default_vector.data() : it->second.data();
+      ASSERT_EQ(
+          memcmp(&vectors[i * embedding_vec_size], vector, sizeof(float) * embedding_vec_size), 0);
+    }
+  }
+  // the loaded table is shared, not changed
+  EXPECT_EQ(loaded.use_count(), 2);
+  EXPECT_THROW(embedding_delta<TypeHashKey>(delta_file, embedding_vec_size + 1),
+               internal_runtime_error);
+  EXPECT_THROW(cpu_embedding_table<TypeHashKey>(
+                   table, embedding_delta<TypeHashKey>(embedding_vec_size + 1)),
+               internal_runtime_error);
+  std::remove(delta_file);
+  std::remove(sparse_model_file);
+  std::remove(indexed_snapshot_file);
+}
+
+// a file which is not made of whole rows is rejected, and an empty one is an empty table
+void embedding_table_size_test() {
+  {
+    std::ofstream file(sparse_model_file, std::ofstream::binary);
+    std::vector<char> row(sizeof(long long) + sizeof(float) * 16 + 1);
+    file.write(row.data(), row.size());
+  }
+  EXPECT_THROW(cpu_embedding_table<long long>(sparse_model_file, 16, false),
+               internal_runtime_error);
+  { std::ofstream file(sparse_model_file, std::ofstream::binary | std::ofstream::trunc); }
+  cpu_embedding_table<long long> table(sparse_model_file, 16, false);
+  EXPECT_EQ(table.size(), 0);
+  EXPECT_EQ(table.find(0), nullptr);
+  std::remove(sparse_model_file);
+}
+
+}  // namespace
+
+TEST(embedding_table, distributed_long_long) { embedding_table_test<long long>(100000, 16, false); }
+TEST(embedding_table, localized_long_long) { embedding_table_test<long long>(100000, 16, true); }
+TEST(embedding_table, distributed_unsigned) {
+  embedding_table_test<unsigned int>(100000, 7, false);
+}
+TEST(embedding_table, localized_unsigned) { embedding_table_test<unsigned int>(100000, 7, true); }
+TEST(embedding_table, look_up_long_long) {
+  embedding_table_look_up_test<long long>(100000, 16, 100000, 4);
+}
+TEST(embedding_table, look_up_unsigned) {
+  embedding_table_look_up_test<unsigned int>(100000, 7, 12345, 4);
+}
+TEST(embedding_table, look_up_small_batch) {
+  embedding_table_look_up_test<long long>(1000, 16, 63, 4);
+}
+TEST(embedding_table, mapped_distributed) {
+  embedding_table_mapped_test<long long>(100000, 16, false);
+}
+TEST(embedding_table, mapped_localized) {
+  embedding_table_mapped_test<unsigned int>(100000, 7, true);
+}
+TEST(embedding_table, delta_distributed) {
+  embedding_table_delta_test<long long>(100000, 16, false, false);
+}
+TEST(embedding_table, delta_localized) {
+  embedding_table_delta_test<unsigned int>(100000, 7, true, false);
+}
+TEST(embedding_table, delta_mapped) { embedding_table_delta_test<long long>(100000, 16, false, true); }
+TEST(embedding_table, file_size) { embedding_table_size_test(); }
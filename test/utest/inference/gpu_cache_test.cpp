@@ -0,0 +1,209 @@
+/*
+ * Copyright (c) 2020, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <algorithm>
+#include <limits>
+#include <map>
+#include <vector>
+#include "HugeCTR/include/inference/gpu_cache/nv_gpu_cache.hpp"
+#include "gtest/gtest.h"
+
+using namespace HugeCTR;
+namespace {
+
+template <typename TypeHashKey>
+using cache_t = gpu_cache::gpu_cache<TypeHashKey, uint64_t, std::numeric_limits<TypeHashKey>::max(),
+                                     SET_ASSOCIATIVITY, SLAB_SIZE>;
+
+// The device buffers of the calls to the cache, for up to max_len keys
+template <typename TypeHashKey>
+struct device_buffers {
+  TypeHashKey* d_keys;
+  float* d_values;
+  uint64_t* d_missing_index;
+  TypeHashKey* d_missing_keys;
+  size_t* d_counter;
+  device_buffers(size_t max_len, size_t embedding_vec_size) {
+    CK_CUDA_THROW_(cudaMalloc((void**)&d_keys, max_len * sizeof(TypeHashKey)));
+    CK_CUDA_THROW_(cudaMalloc((void**)&d_values, max_len * embedding_vec_size * sizeof(float)));
+    CK_CUDA_THROW_(cudaMalloc((void**)&d_missing_index, max_len * sizeof(uint64_t)));
+    CK_CUDA_THROW_(cudaMalloc((void**)&d_missing_keys, max_len * sizeof(TypeHashKey)));
+    CK_CUDA_THROW_(cudaMalloc((void**)&d_counter, sizeof(size_t)));
+  }
+  ~device_buffers() {
+    cudaFree(d_keys);
+    cudaFree(d_values);
+    cudaFree(d_missing_index);
+    cudaFree(d_missing_keys);
+    cudaFree(d_counter);
+  }
+};
+
+// Write the keys and their vectors to the cache with Replace or Update
+template <typename TypeHashKey>
+void write(cache_t<TypeHashKey>& cache, device_buffers<TypeHashKey>& buffers,
+           const std::vector<TypeHashKey>& keys, const std::vector<float>& values, bool replace,
+           cudaStream_t stream) {
+  CK_CUDA_THROW_(cudaMemcpyAsync(buffers.d_keys, keys.data(), keys.size() * sizeof(TypeHashKey),
+                                 cudaMemcpyHostToDevice, stream));
+  CK_CUDA_THROW_(cudaMemcpyAsync(buffers.d_values, values.data(), values.size() * sizeof(float),
+                                 cudaMemcpyHostToDevice, stream));
+  if (replace) {
+    cache.Replace(buffers.d_keys, keys.size(), buffers.d_values, stream);
+  } else {
+    cache.Update(buffers.d_keys, keys.size(), buffers.d_values, stream);
+  }
+  CK_CUDA_THROW_(cudaStreamSynchronize(stream));
+}
+
+// The vectors of the keys which the cache holds
+template <typename TypeHashKey>
+std::map<TypeHashKey, std::vector<float>> query(cache_t<TypeHashKey>& cache,
+                                                device_buffers<TypeHashKey>& buffers,
+                                                const std::vector<TypeHashKey>& keys,
+                                                size_t embedding_vec_size, cudaStream_t stream) {
+  CK_CUDA_THROW_(cudaMemcpyAsync(buffers.d_keys, keys.data(), keys.size() * sizeof(TypeHashKey),
+                                 cudaMemcpyHostToDevice, stream));
+  cache.Query(buffers.d_keys, keys.size(), buffers.d_values, buffers.d_missing_index,
+              buffers.d_missing_keys, buffers.d_counter, stream);
+  size_t missing_len = 0;
+  CK_CUDA_THROW_(cudaMemcpyAsync(&missing_len, buffers.d_counter, sizeof(size_t),
+                                 cudaMemcpyDeviceToHost, stream));
+  CK_CUDA_THROW_(cudaStreamSynchronize(stream));
+  std::vector<uint64_t> missing_index(missing_len);
+  std::vector<float> values(keys.size() * embedding_vec_size);
+  CK_CUDA_THROW_(cudaMemcpyAsync(missing_index.data(), buffers.d_missing_index,
+                                 missing_len * sizeof(uint64_t), cudaMemcpyDeviceToHost, stream));
+  CK_CUDA_THROW_(cudaMemcpyAsync(values.data(), buffers.d_values, values.size() * sizeof(float),
+                                 cudaMemcpyDeviceToHost, stream));
+  CK_CUDA_THROW_(cudaStreamSynchronize(stream));
+
+  std::vector<bool> missing(keys.size(), false);
+  for (auto index : missing_index) missing[index] = true;
+  std::map<TypeHashKey, std::vector<float>> hits;
+  for (size_t i = 0; i < keys.size(); i++) {
+    if (missing[i]) continue;
+    hits.emplace(keys[i], std::vector<float>(values.begin() + i * embedding_vec_size,
+                                             values.begin() + (i + 1) * embedding_vec_size));
+  }
+  return hits;
+}
+
+// The keys of the slabsets [start_set, end_set) of the cache
+template <typename TypeHashKey>
+std::vector<TypeHashKey> dump(cache_t<TypeHashKey>& cache, device_buffers<TypeHashKey>& buffers,
+                              size_t start_set, size_t end_set, cudaStream_t stream) {
+  CK_CUDA_THROW_(cudaMemsetAsync(buffers.d_counter, 0, sizeof(size_t), stream));
+  cache.Dump(buffers.d_keys, buffers.d_counter, start_set, end_set, stream);
+  size_t dump_len = 0;
+  CK_CUDA_THROW_(cudaMemcpyAsync(&dump_len, buffers.d_counter, sizeof(size_t),
+                                 cudaMemcpyDeviceToHost, stream));
+  CK_CUDA_THROW_(cudaStreamSynchronize(stream));
+  std::vector<TypeHashKey> keys(dump_len);
+  CK_CUDA_THROW_(cudaMemcpyAsync(keys.data(), buffers.d_keys, dump_len * sizeof(TypeHashKey),
+                                 cudaMemcpyDeviceToHost, stream));
+  CK_CUDA_THROW_(cudaStreamSynchronize(stream));
+  std::sort(keys.begin(), keys.end());
+  return keys;
+}
+
+std::vector<float> vectors_of(size_t num_keys, size_t embedding_vec_size, float base) {
+  std::vector<float> values(num_keys * embedding_vec_size);
+  for (size_t i = 0; i < values.size(); i++) values[i] = base + i;
+  return values;
+}
+
+// the keys are inserted with Replace; Update overwrites only those which are in the cache, and
+// Dump returns them, whatever the slabsets they are split into
+template <typename TypeHashKey>
+void gpu_cache_update_dump_test(size_t capacity_in_set, size_t embedding_vec_size) {
+  CK_CUDA_THROW_(cudaSetDevice(0));
+  cudaStream_t stream;
+  CK_CUDA_THROW_(cudaStreamCreate(&stream));
+  const size_t num_slot = capacity_in_set * SET_ASSOCIATIVITY * SLAB_SIZE;
+  // half of the slots, so that most keys are kept, and as many keys never inserted
+  const size_t num_keys = num_slot / 2;
+  {
+    cache_t<TypeHashKey> cache(capacity_in_set, embedding_vec_size);
+    device_buffers<TypeHashKey> buffers(num_keys * 2, embedding_vec_size);
+    std::vector<TypeHashKey> keys(num_keys), absent_keys(num_keys), all_keys;
+    for (size_t i = 0; i < num_keys; i++) {
+      keys[i] = static_cast<TypeHashKey>(i * 3);
+      absent_keys[i] = static_cast<TypeHashKey>(i * 3 + 1);
+    }
+    all_keys = keys;
+    all_keys.insert(all_keys.end(), absent_keys.begin(), absent_keys.end());
+
+    // an empty cache dumps nothing
+    EXPECT_TRUE(dump(cache, buffers, 0, capacity_in_set, stream).empty());
+
+    const std::vector<float> values = vectors_of(num_keys, embedding_vec_size, 0.f);
+    write(cache, buffers, keys, values, true, stream);
+    auto cached = query(cache, buffers, all_keys, embedding_vec_size, stream);
+    ASSERT_GT(cached.size(), num_keys / 2);
+    for (size_t i = 0; i < num_keys; i++) {
+      ASSERT_EQ(cached.count(absent_keys[i]), 0);
+      auto it = cached.find(keys[i]);
+      if (it == cached.end()) continue;
+      ASSERT_EQ(it->second, std::vector<float>(values.begin() + i * embedding_vec_size,
+                                               values.begin() + (i + 1) * embedding_vec_size));
+    }
+
+    // the cached keys get the new vectors, the others are still not cached
+    std::vector<float> new_values = vectors_of(all_keys.size(), embedding_vec_size, 1e6f);
+    write(cache, buffers, all_keys, new_values, false, stream);
+    auto updated = query(cache, buffers, all_keys, embedding_vec_size, stream);
+    ASSERT_EQ(updated.size(), cached.size());
+    for (size_t i = 0; i < all_keys.size(); i++) {
+      auto it = updated.find(all_keys[i]);
+      ASSERT_EQ(it != updated.end(), cached.count(all_keys[i]) == 1);
+      if (it == updated.end()) continue;
+      ASSERT_EQ(it->second,
+                std::vector<float>(new_values.begin() + i * embedding_vec_size,
+                                   new_values.begin() + (i + 1) * embedding_vec_size));
+    }
+
+    // the slabsets dumped in two ranges, or one slabset at a time, hold the cached keys once
+    std::vector<TypeHashKey> expected_keys;
+    for (auto& key_value : cached) expected_keys.push_back(key_value.first);
+    EXPECT_EQ(dump(cache, buffers, 0, capacity_in_set, stream), expected_keys);
+    for (size_t split : {size_t(1), capacity_in_set / 2, capacity_in_set - 1}) {
+      std::vector<TypeHashKey> dumped = dump(cache, buffers, 0, split, stream);
+      std::vector<TypeHashKey> rest = dump(cache, buffers, split, capacity_in_set, stream);
+      dumped.insert(dumped.end(), rest.begin(), rest.end());
+      std::sort(dumped.begin(), dumped.end());
+      EXPECT_EQ(dumped, expected_keys);
+    }
+    std::vector<TypeHashKey> dumped;
+    for (size_t set = 0; set < capacity_in_set; set++) {
+      std::vector<TypeHashKey> set_keys = dump(cache, buffers, set, set + 1, stream);
+      ASSERT_LE(set_keys.size(), size_t(SET_ASSOCIATIVITY * SLAB_SIZE));
+      dumped.insert(dumped.end(), set_keys.begin(), set_keys.end());
+    }
+    std::sort(dumped.begin(), dumped.end());
+    EXPECT_EQ(dumped, expected_keys);
+    EXPECT_TRUE(dump(cache, buffers, 1, 1, stream).empty());
+    EXPECT_THROW(dump(cache, buffers, 2, 1, stream), internal_runtime_error);
+    EXPECT_THROW(dump(cache, buffers, 0, capacity_in_set + 1, stream), internal_runtime_error);
+  }
+  CK_CUDA_THROW_(cudaStreamDestroy(stream));
+}
+
+}  // namespace
+
+TEST(gpu_cache, update_dump_unsigned) { gpu_cache_update_dump_test<unsigned int>(16, 8); }
+TEST(gpu_cache, update_dump_long_long) { gpu_cache_update_dump_test<long long>(16, 8); }
+TEST(gpu_cache, update_dump_two_sets) { gpu_cache_update_dump_test<long long>(2, 3); }
@@ -0,0 +1,91 @@
+/*
+ * Copyright (c) 2020, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <vector>
+#include "HugeCTR/include/inference/versioned_ptr.hpp"
+#include "gtest/gtest.h"
+
+using namespace HugeCTR;
+namespace {
+
+// A version marks itself as freed in a flag which outlives it
+struct version {
+  size_t id;
+  std::atomic<bool>* alive;
+  version(size_t id, std::atomic<bool>* alive) : id(id), alive(alive) { alive->store(true); }
+  ~version() { alive->store(false); }
+};
+
+// readers look the version up while it is updated, and must never see one freed under them, nor
+// an older version than one they saw before
+void versioned_ptr_test(size_t num_readers, size_t num_updates) {
+  std::unique_ptr<std::atomic<bool>[]> alive(new std::atomic<bool>[num_updates + 1]);
+  versioned_ptr<version> ptr(std::unique_ptr<version>(new version(0, &alive[0])));
+  std::atomic<bool> done(false);
+  std::atomic<size_t> num_errors(0);
+  std::atomic<size_t> num_reads(0);
+
+  std::vector<std::thread> readers;
+  for (size_t i = 0; i < num_readers; i++) {
+    readers.emplace_back([&]() {
+      size_t last_id = 0;
+      while (!done.load()) {
+        versioned_ptr<version>::read_guard guard(ptr);
+        const size_t id = guard->id;
+        for (int spin = 0; spin < 100; spin++) {
+          if (!guard->alive->load()) {
+            num_errors++;
+          }
+        }
+        if (id < last_id || guard->id != id) {
+          num_errors++;
+        }
+        last_id = id;
+        num_reads++;
+      }
+    });
+  }
+
+  // the readers are running before the first update
+  while (num_reads.load() < num_readers) {
+    std::this_thread::yield();
+  }
+  for (size_t id = 1; id <= num_updates; id++) {
+    std::unique_ptr<version> old_version =
+        ptr.update(std::unique_ptr<version>(new version(id, &alive[id])));
+    ASSERT_EQ(old_version->id, id - 1);
+    ASSERT_TRUE(old_version->alive->load());
+  }
+  done.store(true);
+  for (auto& reader : readers) {
+    reader.join();
+  }
+  EXPECT_EQ(num_errors.load(), 0);
+  EXPECT_EQ(num_reads.load() > 0, num_readers > 0);
+  for (size_t id = 0; id < num_updates; id++) {
+    ASSERT_FALSE(alive[id].load());
+  }
+  ASSERT_TRUE(alive[num_updates].load());
+}
+
+}  // namespace
+
+TEST(versioned_ptr, no_reader) { versioned_ptr_test(0, 100); }
+TEST(versioned_ptr, one_reader) { versioned_ptr_test(1, 1000); }
+TEST(versioned_ptr, readers) { versioned_ptr_test(8, 1000); }
@@ -0,0 +1,233 @@
+/*
+ * Copyright (c) 2020, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "HugeCTR/include/model_oversubscriber/flat_hash_table.hpp"
+#include "HugeCTR/include/model_oversubscriber/radix_sort.hpp"
+#include "gtest/gtest.h"
+
+#include <algorithm>
+#include <random>
+#include <unordered_map>
+#include <vector>
+
+using namespace HugeCTR;
+
+namespace {
+
+template <typename KeyType>
+void flat_hash_table_test() {
+  const size_t num_keys = 1 << 20;
+  std::mt19937_64 gen(42);
+  // a narrow range to have duplicated keys
+  std::uniform_int_distribution<long long> dis(0, 4 * num_keys);
+
+  FlatHashTable<KeyType> table;
+  std::unordered_map<KeyType, std::pair<size_t, size_t>> ref;
+  EXPECT_EQ(table.find(0), nullptr);
+  for (size_t i = 0; i < num_keys; i++) {
+    KeyType key = static_cast<KeyType>(dis(gen));
+    size_t slot_id = i % 26;
+    bool inserted = ref.insert({key, {slot_id, ref.size()}}).second;
+    ASSERT_EQ(table.insert(key, slot_id, ref.at(key).second), inserted);
+  }
+  ASSERT_EQ(table.size(), ref.size());
+  EXPECT_LE(table.size(), table.capacity() / 8 * 7);
+
+  for (size_t i = 0; i < 4 * num_keys; i++) {
+    KeyType key = static_cast<KeyType>(i);
+    auto entry = table.find(key);
+    auto iter = ref.find(key);
+    if (iter == ref.end()) {
+      ASSERT_EQ(entry, nullptr);
+    } else {
+      ASSERT_NE(entry, nullptr);
+      ASSERT_EQ(entry->key, key);
+      ASSERT_EQ(entry->slot_id(), iter->second.first);
+      ASSERT_EQ(entry->offset(), iter->second.second);
+    }
+  }
+
+  size_t cnt = 0;
+  table.for_each([&](const typename FlatHashTable<KeyType>::Entry& entry) {
+    ASSERT_EQ(ref.at(entry.key).second, entry.offset());
+    cnt++;
+  });
+  EXPECT_EQ(cnt, ref.size());
+
+  // the largest values which can be packed
+  const size_t max_slot_id = (size_t(1) << FlatHashTable<KeyType>::SLOT_ID_BITS) - 1;
+  const size_t max_offset = (size_t(1) << FlatHashTable<KeyType>::OFFSET_BITS) - 1;
+  const KeyType new_key = static_cast<KeyType>(4 * num_keys + 1);
+  ASSERT_TRUE(table.insert(new_key, max_slot_id, max_offset));
+  EXPECT_EQ(table.find(new_key)->slot_id(), max_slot_id);
+  EXPECT_EQ(table.find(new_key)->offset(), max_offset);
+  EXPECT_THROW(table.insert(new_key + 1, max_slot_id + 1, 0), internal_runtime_error);
+  EXPECT_THROW(table.insert(new_key + 1, 0, max_offset + 1), internal_runtime_error);
+
+  table.clear();
+  EXPECT_EQ(table.size(), 0);
+  EXPECT_EQ(table.find(new_key), nullptr);
+  ASSERT_TRUE(table.insert(new_key, 1, 2));
+  EXPECT_EQ(table.find(new_key)->offset(), 2);
+}
+
+// keys inserted, reassigned and erased at random, so that the DELETED entries pile up and are
+// dropped by the rehash
+template <typename KeyType>
+void flat_hash_table_erase_test() {
+  const size_t num_ops = 1 << 21;
+  std::mt19937_64 gen(7);
+  std::uniform_int_distribution<long long> dis(0, 1 << 16);
+
+  FlatHashTable<KeyType> table;
+  std::unordered_map<KeyType, std::pair<size_t, size_t>> ref;
+  for (size_t i = 0; i < num_ops; i++) {
+    KeyType key = static_cast<KeyType>(dis(gen));
+    switch (gen() % 3) {
+      case 0: {
+        bool inserted = ref.insert({key, {i % 26, i}}).second;
+        ASSERT_EQ(table.insert(key, i % 26, i), inserted);
+        break;
+      }
+      case 1: {
+        bool found = ref.count(key) > 0;
+        if (found) ref[key] = {1, i};
+        ASSERT_EQ(table.assign(key, 1, i), found);
+        break;
+      }
+      default:
+        ASSERT_EQ(table.erase(key), ref.erase(key) > 0);
+        break;
+    }
+  }
+  ASSERT_EQ(table.size(), ref.size());
+  // erasing the keys doesn't grow the table, however many DELETED entries there were
+  EXPECT_LE(table.capacity(), 4 * (1 << 16));
+
+  for (long long i = 0; i <= 1 << 16; i++) {
+    KeyType key = static_cast<KeyType>(i);
+    auto entry = table.find(key);
+    auto iter = ref.find(key);
+    if (iter == ref.end()) {
+      ASSERT_EQ(entry, nullptr);
+    } else {
+      ASSERT_NE(entry, nullptr);
+      ASSERT_EQ(entry->slot_id(), iter->second.first);
+      ASSERT_EQ(entry->offset(), iter->second.second);
+    }
+  }
+  size_t cnt = 0;
+  table.for_each([&](const typename FlatHashTable<KeyType>::Entry& entry) {
+    ASSERT_EQ(ref.at(entry.key).second, entry.offset());
+    cnt++;
+  });
+  EXPECT_EQ(cnt, ref.size());
+
+  // a copy loaded from the persisted arrays, DELETED entries included, behaves the same
+  FlatHashTable<KeyType> loaded;
+  loaded.load(table.get_ctrl(), table.get_entries(), table.capacity());
+  ASSERT_EQ(loaded.size(), table.size());
+  for (long long i = 0; i <= 1 << 16; i++) {
+    KeyType key = static_cast<KeyType>(i);
+    auto entry = loaded.find(key);
+    if (ref.count(key)) {
+      ASSERT_NE(entry, nullptr);
+      ASSERT_EQ(entry->offset(), ref[key].second);
+    } else {
+      ASSERT_EQ(entry, nullptr);
+      ASSERT_TRUE(loaded.insert(key, 0, i));
+    }
+  }
+  EXPECT_THROW(loaded.load(table.get_ctrl(), table.get_entries(), 24), internal_runtime_error);
+}
+
+// distinct keys inserted by several threads at once into a table with DELETED entries
+template <typename KeyType>
+void flat_hash_table_insert_distinct_test(int num_threads) {
+  const size_t num_keys = 1 << 20;
+  FlatHashTable<KeyType> table;
+  for (size_t i = 0; i < 1000; i++) {
+    table.insert(static_cast<KeyType>(i), 1, i);
+  }
+  for (size_t i = 0; i < 1000; i += 2) {
+    table.erase(static_cast<KeyType>(i));
+  }
+  table.reserve_distinct(num_keys);
+#pragma omp parallel for num_threads(num_threads)
+  for (size_t i = 0; i < num_keys; i++) {
+    table.insert_distinct(static_cast<KeyType>(1000 + i * 3), i % 26, i);
+  }
+  ASSERT_EQ(table.size(), num_keys + 500);
+  for (size_t i = 0; i < 1000; i++) {
+    auto entry = table.find(static_cast<KeyType>(i));
+    if (i % 2 == 0) {
+      ASSERT_EQ(entry, nullptr);
+    } else {
+      ASSERT_NE(entry, nullptr);
+      ASSERT_EQ(entry->offset(), i);
+    }
+  }
+  for (size_t i = 0; i < num_keys; i++) {
+    auto entry = table.find(static_cast<KeyType>(1000 + i * 3));
+    ASSERT_NE(entry, nullptr);
+    ASSERT_EQ(entry->slot_id(), i % 26);
+    ASSERT_EQ(entry->offset(), i);
+    ASSERT_EQ(table.find(static_cast<KeyType>(1000 + i * 3 + 1)), nullptr);
+  }
+  // the table goes on as usual
+  ASSERT_FALSE(table.insert(static_cast<KeyType>(1000), 0, 0));
+  ASSERT_TRUE(table.insert(static_cast<KeyType>(0), 0, 0));
+}
+
+void radix_sort_test(size_t num_entries, size_t max_offset, int num_threads) {
+  using Entry = FlatHashTable<long long>::Entry;
+  std::mt19937_64 gen(num_entries);
+  std::uniform_int_distribution<size_t> dis(0, max_offset);
+  std::vector<Entry> entries(num_entries);
+  for (size_t i = 0; i < num_entries; i++) {
+    // the key keeps the original order to check the stability
+    entries[i] = {static_cast<long long>(i), dis(gen) | (uint64_t(i % 26) << 40)};
+  }
+  std::vector<Entry> ref(entries);
+  std::stable_sort(ref.begin(), ref.end(), [](const Entry& a, const Entry& b) {
+    return a.offset() < b.offset();
+  });
+  radix_sort_by_offset(entries, max_offset, num_threads);
+  for (size_t i = 0; i < num_entries; i++) {
+    ASSERT_EQ(entries[i].key, ref[i].key);
+    ASSERT_EQ(entries[i].value, ref[i].value);
+  }
+}
+
+}  // namespace
+
+TEST(flat_hash_table, long_long_test) { flat_hash_table_test<long long>(); }
+TEST(flat_hash_table, unsigned_test) { flat_hash_table_test<unsigned>(); }
+TEST(flat_hash_table, long_long_erase_test) { flat_hash_table_erase_test<long long>(); }
+TEST(flat_hash_table, unsigned_erase_test) { flat_hash_table_erase_test<unsigned>(); }
+TEST(flat_hash_table, long_long_insert_distinct_test) {
+  flat_hash_table_insert_distinct_test<long long>(omp_get_max_threads() + 3);
+}
+TEST(flat_hash_table, unsigned_insert_distinct_test) {
+  flat_hash_table_insert_distinct_test<unsigned>(1);
+}
+TEST(flat_hash_table, radix_sort_test) {
+  radix_sort_test(0, 0, 1);
+  radix_sort_test(1000, 0, 2);
+  radix_sort_test(1000, 200, 3);
+  radix_sort_test(1 << 20, (1ul << 40) - 1, 4);
+  radix_sort_test(1 << 20, 1 << 20, omp_get_max_threads());
+}
@@ -0,0 +1,320 @@
+/*
+ * Copyright (c) 2020, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "HugeCTR/include/model_oversubscriber/host_row_cache.hpp"
+#include "HugeCTR/include/model_oversubscriber/parameter_server.hpp"
+#include "HugeCTR/include/general_buffer2.hpp"
+#include "gtest/gtest.h"
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <list>
+#include <map>
+#include <numeric>
+#include <random>
+#include <set>
+#include <vector>
+
+using namespace HugeCTR;
+
+namespace {
+
+const size_t embedding_vec_size = 4;
+
+bool acquire(HostRowCache& cache, size_t row) {
+  bool hit = false;
+  uint32_t slot = cache.acquire(row, hit);
+  if (slot == HostRowCache::NO_SLOT) return false;
+  float* vec = cache.get_row(slot);
+  if (hit) {
+    EXPECT_EQ(vec[0], static_cast<float>(row));
+  } else {
+    std::fill(vec, vec + embedding_vec_size, static_cast<float>(row));
+  }
+  return hit;
+}
+
+void lru_test() {
+  HostRowCache cache(3, embedding_vec_size, CachePolicy_t::LRU);
+  for (size_t row : {0, 1, 2}) {
+    EXPECT_FALSE(acquire(cache, row));
+    cache.end_batch();
+  }
+  EXPECT_TRUE(acquire(cache, 0));
+  cache.end_batch();
+  EXPECT_FALSE(acquire(cache, 3));  // evicts 1
+  cache.end_batch();
+  EXPECT_TRUE(acquire(cache, 0));
+  EXPECT_TRUE(acquire(cache, 2));
+  EXPECT_TRUE(acquire(cache, 3));
+  cache.end_batch();
+  EXPECT_FALSE(acquire(cache, 1));
+  cache.end_batch();
+  EXPECT_EQ(cache.get_hits(), 4);
+  EXPECT_EQ(cache.get_misses(), 5);
+  EXPECT_EQ(cache.get_evictions(), 2);
+}
+
+// the rows are far apart in a large embedding file, and the cache stays as small as its capacity
+void far_rows_test() {
+  HostRowCache cache(2, embedding_vec_size, CachePolicy_t::LRU);
+  const size_t base = size_t(1) << 38;
+  for (size_t round = 0; round < 4; round++) {
+    for (size_t i = 0; i < 3; i++) {
+      EXPECT_FALSE(acquire(cache, base * i + round));
+      cache.end_batch();
+    }
+  }
+  EXPECT_EQ(cache.size(), 2);
+  EXPECT_EQ(cache.get_evictions(), 10);
+  EXPECT_TRUE(acquire(cache, base * 2 + 3));
+  cache.end_batch();
+
+  // a row written through is updated only while it is cached
+  const float vec[embedding_vec_size] = {-1.f, -1.f, -1.f, -1.f};
+  cache.update(base * 2 + 3, vec);
+  cache.update(base * 0 + 3, vec);
+  bool hit = false;
+  EXPECT_EQ(cache.get_row(cache.acquire(base * 2 + 3, hit))[0], -1.f);
+  EXPECT_TRUE(hit);
+  cache.end_batch();
+  EXPECT_FALSE(acquire(cache, base * 0 + 3));
+  cache.end_batch();
+}
+
+void lfu_test() {
+  HostRowCache cache(3, embedding_vec_size, CachePolicy_t::LFU);
+  for (size_t row : {0, 0, 0, 1, 1, 2}) {
+    acquire(cache, row);
+    cache.end_batch();
+  }
+  EXPECT_FALSE(acquire(cache, 3));  // evicts 2, the least frequent
+  cache.end_batch();
+  EXPECT_TRUE(acquire(cache, 0));
+  EXPECT_TRUE(acquire(cache, 1));
+  cache.end_batch();
+  EXPECT_FALSE(acquire(cache, 4));  // evicts 3
+  cache.end_batch();
+  EXPECT_FALSE(acquire(cache, 3));
+  EXPECT_FALSE(acquire(cache, 2));
+  cache.end_batch();
+}
+
+void clock_test() {
+  HostRowCache cache(3, embedding_vec_size, CachePolicy_t::CLOCK);
+  for (size_t row : {0, 1, 2}) {
+    acquire(cache, row);
+  }
+  cache.end_batch();
+  // a full round clears the reference bits, then the hand evicts the slot of 0
+  EXPECT_FALSE(acquire(cache, 3));
+  cache.end_batch();
+  EXPECT_TRUE(acquire(cache, 1));
+  cache.end_batch();
+  EXPECT_FALSE(acquire(cache, 4));  // the hand skips 1, and evicts 2
+  cache.end_batch();
+  EXPECT_TRUE(acquire(cache, 1));
+  EXPECT_TRUE(acquire(cache, 3));
+  EXPECT_TRUE(acquire(cache, 4));
+  cache.end_batch();
+  EXPECT_FALSE(acquire(cache, 2));
+  cache.end_batch();
+}
+
+// the rows acquired in a batch are never evicted by the same batch
+void pinning_test(CachePolicy_t policy) {
+  HostRowCache cache(2, embedding_vec_size, policy);
+  bool hit = false;
+  EXPECT_NE(cache.acquire(0, hit), HostRowCache::NO_SLOT);
+  EXPECT_NE(cache.acquire(1, hit), HostRowCache::NO_SLOT);
+  EXPECT_EQ(cache.acquire(2, hit), HostRowCache::NO_SLOT);
+  EXPECT_FALSE(hit);
+  EXPECT_NE(cache.acquire(0, hit), HostRowCache::NO_SLOT);
+  EXPECT_TRUE(hit);
+  EXPECT_EQ(cache.get_bypasses(), 1);
+  cache.end_batch();
+  EXPECT_NE(cache.acquire(2, hit), HostRowCache::NO_SLOT);
+  EXPECT_FALSE(hit);
+  cache.end_batch();
+  EXPECT_EQ(cache.size(), 2);
+
+  cache.clear();
+  EXPECT_EQ(cache.size(), 0);
+  EXPECT_FALSE(acquire(cache, 2));
+}
+
+// LRU and LFU against plain models of them, with random batches
+void reference_test(CachePolicy_t policy) {
+  const size_t capacity = 64;
+  const size_t num_rows = 256;
+  HostRowCache cache(capacity, embedding_vec_size, policy);
+  std::list<size_t> lru;                              // most recent first
+  std::map<size_t, std::pair<size_t, size_t>> lfu;    // row -> <frequency, tick>
+  size_t tick = 0;
+  std::mt19937 gen(0);
+  std::uniform_int_distribution<size_t> row_dis(0, num_rows - 1);
+  std::uniform_int_distribution<size_t> batch_dis(1, capacity / 2);
+  for (int batch = 0; batch < 2000; batch++) {
+    std::vector<size_t> rows(batch_dis(gen));
+    // a skewed distribution, so that LFU keeps some rows
+    std::generate(rows.begin(), rows.end(), [&]() { return row_dis(gen) % (row_dis(gen) + 1); });
+    std::sort(rows.begin(), rows.end());
+    rows.erase(std::unique(rows.begin(), rows.end()), rows.end());
+    std::set<size_t> pinned;
+    for (size_t row : rows) {
+      bool expected = false;
+      if (policy == CachePolicy_t::LRU) {
+        auto it = std::find(lru.begin(), lru.end(), row);
+        expected = it != lru.end();
+        if (expected) {
+          lru.erase(it);
+        } else if (lru.size() == capacity) {
+          lru.pop_back();
+        }
+        lru.push_front(row);
+      } else {
+        expected = lfu.count(row) > 0;
+        if (!expected && lfu.size() == capacity) {
+          auto victim = lfu.end();
+          for (auto it = lfu.begin(); it != lfu.end(); ++it) {
+            if (pinned.count(it->first)) continue;
+            if (victim == lfu.end() || it->second < victim->second) victim = it;
+          }
+          lfu.erase(victim);
+        }
+        lfu[row].first++;
+        lfu[row].second = tick++;
+      }
+      pinned.insert(row);
+      ASSERT_EQ(acquire(cache, row), expected) << "batch " << batch << " row " << row;
+    }
+    cache.end_batch();
+  }
+  std::cout << "hit ratio " << cache.get_hit_ratio() << std::endl;
+}
+
+BufferBag create_buffer_bag(size_t num_rows) {
+  BufferBag buf_bag;
+  std::shared_ptr<GeneralBuffer2<CudaHostAllocator>> blobs_buff =
+      GeneralBuffer2<CudaHostAllocator>::create();
+  Tensor2<long long> tensor_keys;
+  Tensor2<size_t> tensor_slot_id;
+  blobs_buff->reserve({num_rows}, &tensor_keys);
+  blobs_buff->reserve({num_rows}, &tensor_slot_id);
+  blobs_buff->reserve({num_rows, 64}, &(buf_bag.embedding));
+  blobs_buff->allocate();
+  buf_bag.keys = tensor_keys.shrink();
+  buf_bag.slot_id = tensor_slot_id.shrink();
+  return buf_bag;
+}
+
+/**
+ * Replay a sequence of keysets through ParameterServer, each sharing "overlap" of its keys with
+ * the previous one, and report the hit ratio and the throughput of each cache policy.
+ */
+void replay_test(size_t num_rows, size_t keyset_size, size_t num_keysets, double overlap) {
+  const size_t vec_size = 64;
+  const char* snapshot_file = "host_row_cache_snapshot.bin";
+  {
+    std::ofstream snapshot(snapshot_file, std::ofstream::binary);
+    std::vector<float> vec(vec_size);
+    for (size_t i = 0; i < num_rows; i++) {
+      long long key = static_cast<long long>(i);
+      std::fill(vec.begin(), vec.end(), static_cast<float>(i));
+      snapshot.write(reinterpret_cast<char*>(&key), sizeof(key));
+      snapshot.write(reinterpret_cast<char*>(vec.data()), vec_size * sizeof(float));
+    }
+  }
+  // each keyset is a window of a permutation of the keys, sliding by (1 - overlap)
+  std::vector<long long> perm(num_rows);
+  std::iota(perm.begin(), perm.end(), 0);
+  std::shuffle(perm.begin(), perm.end(), std::mt19937(0));
+  const size_t stride = static_cast<size_t>(keyset_size * (1 - overlap));
+  std::vector<std::string> keyset_files;
+  for (size_t t = 0; t < num_keysets; t++) {
+    keyset_files.push_back("host_row_cache_keyset_" + std::to_string(t) + ".bin");
+    std::ofstream keyset(keyset_files.back(), std::ofstream::binary);
+    for (size_t i = 0; i < keyset_size; i++) {
+      long long key = perm[(t * stride + i) % num_rows];
+      keyset.write(reinterpret_cast<char*>(&key), sizeof(key));
+    }
+  }
+
+  OptHyperParams<float> hyper_params;
+  const OptParams<float> opt_params = {Optimizer_t::SGD, 0.001f, hyper_params, Update_t::Local,
+                                       1.f};
+  const SparseEmbeddingHashParams<float> embedding_params = {
+      1024, 1024, num_rows, {}, vec_size, 26, 26, 0, opt_params};
+  BufferBag buf_bag = create_buffer_bag(keyset_size);
+
+  std::cout << "policy\tcapacity\thit ratio\trows/s" << std::endl;
+  const char* names[] = {"LRU", "LFU", "CLOCK"};
+  for (size_t capacity : {size_t(0), keyset_size / 2, keyset_size * 3 / 2}) {
+    for (CachePolicy_t policy : {CachePolicy_t::LRU, CachePolicy_t::LFU, CachePolicy_t::CLOCK}) {
+      if (capacity == 0 && policy != CachePolicy_t::LRU) continue;
+      ParameterServer<long long, float> parameter_server(
+          embedding_params, snapshot_file, "./", Embedding_t::DistributedSlotSparseEmbeddingHash,
+          capacity, policy);
+      size_t num_loaded = 0;
+      double seconds = 0;
+      for (auto& keyset_file : keyset_files) {
+        parameter_server.load_keyset_from_file(keyset_file);
+        size_t hit_size = 0;
+        auto start = std::chrono::steady_clock::now();
+        parameter_server.load_param_from_embedding_file(buf_bag, hit_size);
+        seconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        ASSERT_EQ(hit_size, keyset_size);
+        num_loaded += hit_size;
+
+        const long long* keys = Tensor2<long long>::stretch_from(buf_bag.keys).get_ptr();
+        const float* vectors = buf_bag.embedding.get_ptr();
+        for (size_t i = 0; i < hit_size; i += 97) {
+          ASSERT_EQ(vectors[i * vec_size + vec_size - 1], static_cast<float>(keys[i]));
+        }
+      }
+      auto cache = parameter_server.get_host_cache();
+      const double hit_ratio = cache ? cache->get_hit_ratio() : 0.0;
+      std::cout << (capacity ? names[static_cast<int>(policy)] : "none") << "\t" << capacity
+                << "\t" << hit_ratio << "\t" << num_loaded / seconds << std::endl;
+      if (capacity >= keyset_size && policy != CachePolicy_t::LFU) {
+        // every key shared with the previous keyset hits, while LFU evicts the keys new to the
+        // previous keyset before the older ones
+        EXPECT_GE(hit_ratio, overlap * (num_keysets - 1) / num_keysets - 0.01);
+      }
+    }
+  }
+  for (auto& keyset_file : keyset_files) {
+    std::remove(keyset_file.c_str());
+  }
+  std::remove(snapshot_file);
+}
+
+}  // namespace
+
+TEST(host_row_cache, lru_test) { lru_test(); }
+TEST(host_row_cache, far_rows_test) { far_rows_test(); }
+TEST(host_row_cache, lfu_test) { lfu_test(); }
+TEST(host_row_cache, clock_test) { clock_test(); }
+TEST(host_row_cache, pinning_test) {
+  pinning_test(CachePolicy_t::LRU);
+  pinning_test(CachePolicy_t::LFU);
+  pinning_test(CachePolicy_t::CLOCK);
+}
+TEST(host_row_cache, lru_reference_test) { reference_test(CachePolicy_t::LRU); }
+TEST(host_row_cache, lfu_reference_test) { reference_test(CachePolicy_t::LFU); }
+TEST(host_row_cache, replay_test) { replay_test(1 << 20, 1 << 17, 10, 0.8); }
@@ -119,7 +119,7 @@ std::unique_ptr<Embedding<KeyType, EmbeddingCompType>> init_embedding(
 
 template <typename KeyType, typename EmbeddingCompType>
 void do_upload_and_download_snapshot(size_t batch_num_train, size_t embedding_vector_size,
-    Embedding_t embedding_type) {
+    Embedding_t embedding_type, bool prefetch = false) {
   const size_t num_total_passes = batch_num_train / pass_size;
   // create a resource manager for a single GPU
   std::vector<std::vector<int>> vvgpu;
@@ -233,8 +233,14 @@ void do_upload_and_download_snapshot(size_t batch_num_train, size_t embedding_ve
   Timer timer_ps;
   timer_ps.start();
 
-  // upload embedding table from disk according to keyset
+  // upload embedding table from disk according to keyset, staged in background if prefetch
+  if (prefetch) {
+    model_oversubscriber->prefetch(keyset_file_list);
+  }
   model_oversubscriber->update(keyset_file_list);
+  for (auto& timing : model_oversubscriber->get_timings()) {
+    MESSAGE_(timing.first + ": " + std::to_string(timing.second) + "ms");
+  }
 
   // transfer the internal embedding table to the snapshot
   model_oversubscriber->store(snapshot_file_list);
@@ -266,6 +272,16 @@ TEST(model_oversubscriber_localized_embedding_test, long_long_float) {
   do_upload_and_download_snapshot<long long, float>(10, 64, loc_embedding);
 }
 
+TEST(model_oversubscriber_distributed_embedding_test, long_long_float_prefetch) {
+  const Embedding_t dis_embedding = Embedding_t::DistributedSlotSparseEmbeddingHash;
+  do_upload_and_download_snapshot<long long, float>(10, 64, dis_embedding, true);
+}
+
+TEST(model_oversubscriber_localized_embedding_test, long_long_float_prefetch) {
+  const Embedding_t loc_embedding = Embedding_t::LocalizedSlotSparseEmbeddingHash;
+  do_upload_and_download_snapshot<long long, float>(10, 64, loc_embedding, true);
+}
+
 TEST(model_oversubscriber_localized_embedding_one_hot_test, long_long_float) {
   const Embedding_t loc_oh_embedding = Embedding_t::LocalizedSlotSparseEmbeddingOneHot;
   do_upload_and_download_snapshot<long long, float>(20, 64, loc_oh_embedding);
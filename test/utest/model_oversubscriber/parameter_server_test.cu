@@ -18,13 +18,22 @@
 #include "HugeCTR/include/data_readers/data_reader.hpp"
 #include "HugeCTR/include/embeddings/localized_slot_sparse_embedding_hash.hpp"
 #include "HugeCTR/include/embeddings/distributed_slot_sparse_embedding_hash.hpp"
+#include "HugeCTR/include/model_oversubscriber/indexed_snapshot.hpp"
 #include "HugeCTR/include/model_oversubscriber/parameter_server.hpp"
 #include "HugeCTR/include/utils.hpp"
 #include "gtest/gtest.h"
 #include "utest/test_utils.h"
 
+#include <algorithm>
+#include <chrono>
+#include <cmath>
 #include <fstream>
+#include <map>
+#include <numeric>
+#include <random>
 #include <set>
+#include <thread>
+#include <sys/stat.h>
 
 using namespace HugeCTR;
 
@@ -256,6 +265,636 @@ void do_upload_and_download_snapshot(size_t batch_num_train, size_t embedding_ve
   ASSERT_TRUE(test::compare_array_approx<char>(vec_src.data(), vec_dst.data(), len_src, 0));
 }
 
+template <typename KeyType>
+BufferBag create_buffer_bag(size_t num_rows, size_t embedding_vector_size) {
+  BufferBag buf_bag;
+  std::shared_ptr<GeneralBuffer2<CudaHostAllocator>> blobs_buff =
+      GeneralBuffer2<CudaHostAllocator>::create();
+
+  Tensor2<KeyType> tensor_keys;
+  Tensor2<size_t> tensor_slot_id;
+  blobs_buff->reserve({num_rows}, &tensor_keys);
+  blobs_buff->reserve({num_rows}, &tensor_slot_id);
+
+  blobs_buff->reserve({num_rows, embedding_vector_size}, &(buf_bag.embedding));
+  blobs_buff->allocate();
+
+  buf_bag.keys = tensor_keys.shrink();
+  buf_bag.slot_id = tensor_slot_id.shrink();
+  return buf_bag;
+}
+
+// remove the files of a test when it returns, even from a failed ASSERT
+struct test_files {
+  std::vector<std::string> names;
+  ~test_files() {
+    for (auto& name : names) std::remove(name.c_str());
+  }
+};
+
+template <typename KeyType>
+std::vector<KeyType> key_range(size_t begin, size_t end) {
+  std::vector<KeyType> keys;
+  for (size_t i = begin; i < end; i++) keys.push_back(static_cast<KeyType>(i));
+  return keys;
+}
+
+// write a snapshot of <key, (slot_id,) embedding_vector>, where the slot_id of a key is
+// key % slot_num, and fill_vector(key, vector) gives its embedding_vector
+template <typename KeyType, typename FillVector>
+void write_snapshot(const char* snapshot_file, const std::vector<KeyType>& keys,
+                    size_t embedding_vector_size, Embedding_t embedding_type,
+                    FillVector fill_vector) {
+  const bool is_distributed = embedding_type == Embedding_t::DistributedSlotSparseEmbeddingHash;
+  std::vector<float> vector(embedding_vector_size);
+  std::ofstream snapshot(snapshot_file, std::ofstream::binary);
+  for (KeyType key : keys) {
+    size_t slot_id = static_cast<size_t>(key) % slot_num;
+    fill_vector(key, vector.data());
+    snapshot.write(reinterpret_cast<char*>(&key), sizeof(KeyType));
+    if (!is_distributed) snapshot.write(reinterpret_cast<char*>(&slot_id), sizeof(size_t));
+    snapshot.write(reinterpret_cast<char*>(vector.data()), embedding_vector_size * sizeof(float));
+  }
+}
+
+template <typename KeyType>
+void write_keyset(const char* keyset_file, const std::vector<KeyType>& keys) {
+  std::ofstream keyset(keyset_file, std::ofstream::binary);
+  keyset.write(reinterpret_cast<const char*>(keys.data()), keys.size() * sizeof(KeyType));
+}
+
+// a ParameterServer of float embedding vectors with room for max_vocabulary_size keys
+template <typename KeyType>
+std::unique_ptr<ParameterServer<KeyType, float>> create_parameter_server(
+    size_t max_vocabulary_size, size_t embedding_vector_size, const char* snapshot_file,
+    Embedding_t embedding_type, StoragePrecision_t storage_precision = StoragePrecision_t::FP32) {
+  OptHyperParams<float> hyper_params;
+  const OptParams<float> opt_params = {Optimizer_t::SGD, 0.001f, hyper_params, update_type,
+                                       scaler};
+  const SparseEmbeddingHashParams<float> embedding_params = {
+      batchsize,       batchsize, max_vocabulary_size, {},        embedding_vector_size,
+      max_feature_num, slot_num,  combiner,            opt_params};
+  return std::unique_ptr<ParameterServer<KeyType, float>>(new ParameterServer<KeyType, float>(
+      embedding_params, snapshot_file, temp_embedding_dir, embedding_type, 0, CachePolicy_t::LRU,
+      storage_precision));
+}
+
+// write back the rows of a part of the keys, as if only they were updated in a pass, and
+// check that the others are left as they are
+template <typename KeyType>
+void do_dirty_write_back(size_t num_rows, size_t embedding_vector_size,
+                         Embedding_t embedding_type) {
+  const bool is_distributed = embedding_type == Embedding_t::DistributedSlotSparseEmbeddingHash;
+  const char* dirty_snapshot_src_file = "dirty_snapshot_src.bin";
+  const char* dirty_snapshot_dst_file = "dirty_snapshot_dst.bin";
+  const char* dirty_keyset_file = "dirty_keyset_file.bin";
+  test_files files{{dirty_snapshot_src_file, dirty_snapshot_dst_file, dirty_keyset_file}};
+
+  std::vector<float> expected(num_rows * embedding_vector_size);
+  {
+    std::mt19937 gen(0);
+    std::uniform_real_distribution<float> dis(-0.05f, 0.05f);
+    std::generate(expected.begin(), expected.end(), [&]() { return dis(gen); });
+    const std::vector<KeyType> keys = key_range<KeyType>(0, num_rows);
+    write_snapshot(dirty_snapshot_src_file, keys, embedding_vector_size, embedding_type,
+                   [&](KeyType key, float* vector) {
+                     std::copy_n(&expected[static_cast<size_t>(key) * embedding_vector_size],
+                                 embedding_vector_size, vector);
+                   });
+    write_keyset(dirty_keyset_file, keys);
+  }
+  auto parameter_server = create_parameter_server<KeyType>(
+      num_rows, embedding_vector_size, dirty_snapshot_src_file, embedding_type);
+
+  BufferBag loaded = create_buffer_bag<KeyType>(num_rows, embedding_vector_size);
+  BufferBag dirty = create_buffer_bag<KeyType>(num_rows, embedding_vector_size);
+  parameter_server->load_keyset_from_file(dirty_keyset_file);
+  size_t hit_size = 0;
+  parameter_server->load_param_from_embedding_file(loaded, hit_size);
+  ASSERT_EQ(hit_size, num_rows);
+  EXPECT_EQ(parameter_server->get_num_dirty(), 0);
+
+  const KeyType* loaded_keys = Tensor2<KeyType>::stretch_from(loaded.keys).get_ptr();
+  const size_t* loaded_slot_id = Tensor2<size_t>::stretch_from(loaded.slot_id).get_ptr();
+  const float* loaded_vectors = loaded.embedding.get_ptr();
+  KeyType* dirty_keys = Tensor2<KeyType>::stretch_from(dirty.keys).get_ptr();
+  size_t* dirty_slot_id = Tensor2<size_t>::stretch_from(dirty.slot_id).get_ptr();
+  float* dirty_vectors = dirty.embedding.get_ptr();
+
+  std::vector<size_t> rows(num_rows);
+  std::iota(rows.begin(), rows.end(), 0);
+  std::shuffle(rows.begin(), rows.end(), std::mt19937(1));
+
+  for (double ratio : {1.0, 0.1, 0.05}) {
+    const size_t num_dirty = static_cast<size_t>(num_rows * ratio);
+    for (size_t i = 0; i < num_dirty; i++) {
+      const size_t row = rows[i];
+      dirty_keys[i] = loaded_keys[row];
+      dirty_slot_id[i] = loaded_slot_id[row];
+      for (size_t j = 0; j < embedding_vector_size; j++) {
+        const float value = loaded_vectors[row * embedding_vector_size + j] + 1.0f;
+        dirty_vectors[i * embedding_vector_size + j] = value;
+        expected[static_cast<size_t>(loaded_keys[row]) * embedding_vector_size + j] = value;
+      }
+    }
+    parameter_server->clear_dirty();
+    parameter_server->dump_param_to_embedding_file(dirty, num_dirty);
+
+    ASSERT_EQ(parameter_server->get_num_dirty(), num_dirty);
+    auto keys = parameter_server->get_dirty_keys();
+    ASSERT_EQ(keys.size(), num_dirty);
+    std::sort(keys.begin(), keys.end());
+    std::vector<KeyType> ref(dirty_keys, dirty_keys + num_dirty);
+    std::sort(ref.begin(), ref.end());
+    ASSERT_TRUE(keys == ref);
+    if (num_dirty < num_rows) {
+      EXPECT_FALSE(parameter_server->is_dirty(loaded_keys[rows[num_dirty]]));
+    }
+    EXPECT_TRUE(parameter_server->is_dirty(dirty_keys[0]));
+  }
+
+  parameter_server->dump_to_snapshot(dirty_snapshot_dst_file);
+  std::ifstream snapshot(dirty_snapshot_dst_file, std::ifstream::binary);
+  std::vector<float> vector(embedding_vector_size);
+  for (size_t i = 0; i < num_rows; i++) {
+    KeyType key;
+    size_t slot_id;
+    snapshot.read(reinterpret_cast<char*>(&key), sizeof(KeyType));
+    if (!is_distributed) snapshot.read(reinterpret_cast<char*>(&slot_id), sizeof(size_t));
+    snapshot.read(reinterpret_cast<char*>(vector.data()), embedding_vector_size * sizeof(float));
+    ASSERT_TRUE(snapshot.good());
+    ASSERT_TRUE(std::equal(vector.begin(), vector.end(),
+                           &expected[static_cast<size_t>(key) * embedding_vector_size]));
+  }
+}
+
+// stage the next keyset in background while the rows of the current pass are not written back
+// yet, then refresh the staged rows with the write-back, and check that they are the ones a
+// synchronous load reads afterwards
+template <typename KeyType>
+void do_staged_refresh(size_t num_rows, size_t embedding_vector_size,
+                       Embedding_t embedding_type) {
+  const bool is_distributed = embedding_type == Embedding_t::DistributedSlotSparseEmbeddingHash;
+  const char* staged_snapshot_src_file = "staged_snapshot_src.bin";
+  const char* staged_keyset_file = "staged_keyset_file.bin";
+  test_files files{{staged_snapshot_src_file, staged_keyset_file}};
+
+  // num_rows is a multiple of 8. The snapshot holds the keys [0, num_rows), and the next
+  // keyset the keys [num_rows / 2, num_rows * 3 / 2)
+  std::mt19937 gen(0);
+  std::uniform_real_distribution<float> dis(-0.05f, 0.05f);
+  write_snapshot(staged_snapshot_src_file, key_range<KeyType>(0, num_rows), embedding_vector_size,
+                 embedding_type, [&](KeyType, float* vector) {
+                   std::generate_n(vector, embedding_vector_size, [&]() { return dis(gen); });
+                 });
+  write_keyset(staged_keyset_file, key_range<KeyType>(num_rows / 2, num_rows * 3 / 2));
+  auto parameter_server = create_parameter_server<KeyType>(
+      2 * num_rows, embedding_vector_size, staged_snapshot_src_file, embedding_type);
+
+  BufferBag staged = create_buffer_bag<KeyType>(2 * num_rows, embedding_vector_size);
+  BufferBag dirty = create_buffer_bag<KeyType>(2 * num_rows, embedding_vector_size);
+  BufferBag loaded = create_buffer_bag<KeyType>(2 * num_rows, embedding_vector_size);
+  size_t staged_size = 0;
+  std::thread prefetch_thread([&]() {
+    parameter_server->load_keyset_from_file(staged_keyset_file);
+    parameter_server->stage_param_from_embedding_file(staged, staged_size);
+  });
+  prefetch_thread.join();
+  ASSERT_EQ(staged_size, num_rows / 2);
+
+  // a pass updated every 4th key of [0, num_rows * 3 / 2): the first third are not in the next
+  // keyset, the second are staged and the last are new in the embedding file
+  KeyType* dirty_keys = Tensor2<KeyType>::stretch_from(dirty.keys).get_ptr();
+  size_t* dirty_slot_id = Tensor2<size_t>::stretch_from(dirty.slot_id).get_ptr();
+  float* dirty_vectors = dirty.embedding.get_ptr();
+  size_t num_dirty = 0;
+  for (size_t i = 0; i < num_rows * 3 / 2; i += 4, num_dirty++) {
+    dirty_keys[num_dirty] = static_cast<KeyType>(i);
+    dirty_slot_id[num_dirty] = i % slot_num;
+    std::fill(&dirty_vectors[num_dirty * embedding_vector_size],
+              &dirty_vectors[(num_dirty + 1) * embedding_vector_size], static_cast<float>(i));
+  }
+  parameter_server->dump_param_to_embedding_file(dirty, num_dirty);
+  const size_t num_refreshed =
+      parameter_server->refresh_staged_param(dirty, num_dirty, staged, staged_size);
+  EXPECT_EQ(num_refreshed, num_rows / 4);
+  ASSERT_EQ(staged_size, num_rows / 2 + num_rows / 8);
+
+  size_t hit_size = 0;
+  parameter_server->load_keyset_from_file(staged_keyset_file);
+  parameter_server->load_param_from_embedding_file(loaded, hit_size);
+  ASSERT_EQ(hit_size, staged_size);
+
+  // the same rows, in any order
+  auto collect = [&](BufferBag& buf_bag, size_t size) {
+    const KeyType* keys = Tensor2<KeyType>::stretch_from(buf_bag.keys).get_ptr();
+    const size_t* slot_id = Tensor2<size_t>::stretch_from(buf_bag.slot_id).get_ptr();
+    const float* vectors = buf_bag.embedding.get_ptr();
+    std::map<KeyType, std::vector<float>> rows;
+    for (size_t i = 0; i < size; i++) {
+      std::vector<float>& row = rows[keys[i]];
+      row.assign(&vectors[i * embedding_vector_size], &vectors[(i + 1) * embedding_vector_size]);
+      if (!is_distributed) row.push_back(static_cast<float>(slot_id[i]));
+    }
+    return rows;
+  };
+  ASSERT_TRUE(collect(staged, staged_size) == collect(loaded, hit_size));
+}
+
+// erase keys to free their rows, reuse them for new keys, and compact the file in background
+// while it is loaded from, checking the rows against the expected ones at each step
+template <typename KeyType>
+void do_free_rows_and_compaction(size_t num_rows, size_t embedding_vector_size,
+                                 Embedding_t embedding_type) {
+  const bool is_distributed = embedding_type == Embedding_t::DistributedSlotSparseEmbeddingHash;
+  const char* compact_snapshot_src_file = "compact_snapshot_src.bin";
+  const char* compact_snapshot_dst_file = "compact_snapshot_dst.bin";
+  const char* compact_keyset_file = "compact_keyset_file.bin";
+  test_files files{{compact_snapshot_src_file, compact_snapshot_dst_file, compact_keyset_file}};
+  const size_t row_size_in_byte = embedding_vector_size * sizeof(float);
+
+  // num_rows is a multiple of 8. The row of a key is filled with the key plus a version
+  std::map<KeyType, float> expected;
+  for (KeyType key : key_range<KeyType>(0, num_rows)) expected[key] = static_cast<float>(key);
+  write_snapshot(compact_snapshot_src_file, key_range<KeyType>(0, num_rows), embedding_vector_size,
+                 embedding_type, [&](KeyType key, float* vector) {
+                   std::fill_n(vector, embedding_vector_size, static_cast<float>(key));
+                 });
+  write_keyset(compact_keyset_file, key_range<KeyType>(0, num_rows * 3 / 2));
+  auto parameter_server = create_parameter_server<KeyType>(
+      2 * num_rows, embedding_vector_size, compact_snapshot_src_file, embedding_type);
+  parameter_server->load_keyset_from_file(compact_keyset_file);
+
+  BufferBag dirty = create_buffer_bag<KeyType>(num_rows, embedding_vector_size);
+  BufferBag loaded = create_buffer_bag<KeyType>(2 * num_rows, embedding_vector_size);
+  auto dump = [&](size_t begin, size_t end, float version) {
+    KeyType* keys = Tensor2<KeyType>::stretch_from(dirty.keys).get_ptr();
+    size_t* slot_id = Tensor2<size_t>::stretch_from(dirty.slot_id).get_ptr();
+    float* vectors = dirty.embedding.get_ptr();
+    for (size_t i = begin; i < end; i++) {
+      keys[i - begin] = static_cast<KeyType>(i);
+      slot_id[i - begin] = i % slot_num;
+      std::fill(&vectors[(i - begin) * embedding_vector_size],
+                &vectors[(i - begin + 1) * embedding_vector_size], i + version);
+      expected[static_cast<KeyType>(i)] = i + version;
+    }
+    parameter_server->dump_param_to_embedding_file(dirty, end - begin);
+  };
+  auto check = [&]() {
+    size_t hit_size = 0;
+    parameter_server->load_param_from_embedding_file(loaded, hit_size);
+    ASSERT_EQ(hit_size, expected.size());
+    const KeyType* keys = Tensor2<KeyType>::stretch_from(loaded.keys).get_ptr();
+    const size_t* slot_id = Tensor2<size_t>::stretch_from(loaded.slot_id).get_ptr();
+    const float* vectors = loaded.embedding.get_ptr();
+    for (size_t i = 0; i < hit_size; i++) {
+      ASSERT_EQ(expected.count(keys[i]), 1);
+      if (!is_distributed) {
+        ASSERT_EQ(slot_id[i], static_cast<size_t>(keys[i]) % slot_num);
+      }
+      ASSERT_EQ(vectors[i * embedding_vector_size], expected[keys[i]]);
+      ASSERT_EQ(vectors[(i + 1) * embedding_vector_size - 1], expected[keys[i]]);
+    }
+  };
+  auto file_rows = [&]() {
+    std::ifstream file(parameter_server->get_embedding_file_path(),
+                       std::ifstream::binary | std::ifstream::ate);
+    return static_cast<size_t>(file.tellg()) / row_size_in_byte;
+  };
+
+  // every other key of the first half is erased, and the new keys take their rows first
+  std::vector<KeyType> erased;
+  for (size_t i = 0; i < num_rows / 2; i += 2) erased.push_back(static_cast<KeyType>(i));
+  EXPECT_EQ(parameter_server->erase_keys(erased), num_rows / 4);
+  EXPECT_EQ(parameter_server->erase_keys(erased), 0);
+  for (auto key : erased) expected.erase(key);
+  EXPECT_EQ(parameter_server->get_num_free_rows(), num_rows / 4);
+  check();
+
+  dump(num_rows, num_rows + num_rows / 8, 0.5f);
+  EXPECT_EQ(parameter_server->get_num_rows(), num_rows);
+  EXPECT_EQ(parameter_server->get_num_free_rows(), num_rows / 8);
+  dump(num_rows + num_rows / 8, num_rows + num_rows * 3 / 8, 0.5f);
+  EXPECT_EQ(parameter_server->get_num_rows(), num_rows + num_rows / 8);
+  EXPECT_EQ(parameter_server->get_num_free_rows(), 0);
+  EXPECT_EQ(file_rows(), num_rows + num_rows / 8);
+  check();
+
+  // half of the rows are freed, and compacted while the file is loaded from
+  erased.clear();
+  for (size_t i = num_rows / 2; i < num_rows; i++) erased.push_back(static_cast<KeyType>(i));
+  EXPECT_EQ(parameter_server->erase_keys(erased), num_rows / 2);
+  for (auto key : erased) expected.erase(key);
+  ASSERT_TRUE(parameter_server->needs_compaction());
+  parameter_server->start_compaction();
+  check();
+  dump(num_rows / 2 - 1, num_rows / 2, 0.25f);
+  EXPECT_FALSE(parameter_server->needs_compaction());
+  EXPECT_EQ(parameter_server->get_num_rows(), expected.size());
+  EXPECT_EQ(parameter_server->get_num_free_rows(), 0);
+  EXPECT_EQ(file_rows(), expected.size());
+  EXPECT_TRUE(parameter_server->is_dirty(static_cast<KeyType>(num_rows)));
+  EXPECT_FALSE(parameter_server->is_dirty(static_cast<KeyType>(1)));
+  check();
+
+  // the rows are in the order of the keys now
+  const KeyType* keys = Tensor2<KeyType>::stretch_from(loaded.keys).get_ptr();
+  EXPECT_TRUE(std::is_sorted(keys, keys + expected.size()));
+
+  // the snapshot is dumped from a compacted file too
+  erased.assign(1, static_cast<KeyType>(1));
+  parameter_server->erase_keys(erased);
+  expected.erase(static_cast<KeyType>(1));
+  parameter_server->dump_to_snapshot(compact_snapshot_dst_file);
+  EXPECT_EQ(parameter_server->get_num_free_rows(), 0);
+  std::ifstream snapshot(compact_snapshot_dst_file, std::ifstream::binary | std::ifstream::ate);
+  const size_t snapshot_row_size_in_byte =
+      sizeof(KeyType) + (is_distributed ? 0 : sizeof(size_t)) + row_size_in_byte;
+  ASSERT_EQ(static_cast<size_t>(snapshot.tellg()), expected.size() * snapshot_row_size_in_byte);
+  snapshot.seekg(0);
+  std::vector<float> vector(embedding_vector_size);
+  for (size_t i = 0; i < expected.size(); i++) {
+    KeyType key;
+    size_t slot_id;
+    snapshot.read(reinterpret_cast<char*>(&key), sizeof(KeyType));
+    if (!is_distributed) snapshot.read(reinterpret_cast<char*>(&slot_id), sizeof(size_t));
+    snapshot.read(reinterpret_cast<char*>(vector.data()), row_size_in_byte);
+    ASSERT_EQ(expected.count(key), 1);
+    ASSERT_EQ(vector.front(), expected[key]);
+    ASSERT_EQ(vector.back(), expected[key]);
+  }
+}
+
+// convert a snapshot to an indexed one and back, open it in place, and check that only the rows
+// written back take space in the embedding_file
+template <typename KeyType>
+void do_indexed_snapshot(size_t num_rows, size_t embedding_vector_size,
+                         Embedding_t embedding_type) {
+  const bool is_distributed = embedding_type == Embedding_t::DistributedSlotSparseEmbeddingHash;
+  const char* plain_snapshot_file = "plain_snapshot.bin";
+  const char* converted_snapshot_file = "converted_snapshot.bin";
+  const char* indexed_snapshot_file = "indexed_snapshot.bin";
+  const char* indexed_keyset_file = "indexed_keyset_file.bin";
+  test_files files{
+      {plain_snapshot_file, converted_snapshot_file, indexed_snapshot_file, indexed_keyset_file}};
+  const size_t row_size_in_byte = embedding_vector_size * sizeof(float);
+
+  // num_rows is a power of 2, and the keys are in no particular order. The row of a key is
+  // filled with the key plus a version
+  std::map<KeyType, float> expected;
+  std::vector<KeyType> keys;
+  for (size_t i = 0; i < num_rows; i++) {
+    keys.push_back(static_cast<KeyType>((i * 7919) % num_rows));
+    expected[keys.back()] = static_cast<float>(keys.back());
+  }
+  write_snapshot(plain_snapshot_file, keys, embedding_vector_size, embedding_type,
+                 [&](KeyType key, float* vector) {
+                   std::fill_n(vector, embedding_vector_size, static_cast<float>(key));
+                 });
+  for (KeyType key : key_range<KeyType>(num_rows, num_rows + num_rows / 8)) keys.push_back(key);
+  write_keyset(indexed_keyset_file, keys);
+
+  // the conversions keep the rows, sorted by key
+  IndexedSnapshot<KeyType>::convert_from_snapshot(plain_snapshot_file, indexed_snapshot_file,
+                                                  embedding_vector_size, !is_distributed);
+  ASSERT_TRUE(IndexedSnapshot<KeyType>::is_indexed_snapshot(indexed_snapshot_file));
+  ASSERT_FALSE(IndexedSnapshot<KeyType>::is_indexed_snapshot(plain_snapshot_file));
+  IndexedSnapshot<KeyType>::convert_to_snapshot(indexed_snapshot_file, converted_snapshot_file);
+  auto check_snapshot = [&](const char* snapshot_file) {
+    std::ifstream snapshot(snapshot_file, std::ifstream::binary);
+    std::vector<float> vector(embedding_vector_size);
+    for (auto& pair : expected) {
+      KeyType key;
+      size_t slot_id;
+      snapshot.read(reinterpret_cast<char*>(&key), sizeof(KeyType));
+      if (!is_distributed) snapshot.read(reinterpret_cast<char*>(&slot_id), sizeof(size_t));
+      snapshot.read(reinterpret_cast<char*>(vector.data()), row_size_in_byte);
+      ASSERT_TRUE(snapshot.good());
+      ASSERT_EQ(key, pair.first);
+      if (!is_distributed) {
+        ASSERT_EQ(slot_id, static_cast<size_t>(key) % slot_num);
+      }
+      ASSERT_EQ(vector.front(), pair.second);
+      ASSERT_EQ(vector.back(), pair.second);
+    }
+    snapshot.peek();
+    ASSERT_TRUE(snapshot.eof());
+  };
+  check_snapshot(converted_snapshot_file);
+
+  auto parameter_server = create_parameter_server<KeyType>(
+      2 * num_rows, embedding_vector_size, indexed_snapshot_file, embedding_type);
+  auto allocated_rows = [&]() {
+    struct stat st;
+    stat(parameter_server->get_embedding_file_path().c_str(), &st);
+    return static_cast<size_t>(st.st_blocks) * 512 / row_size_in_byte;
+  };
+  EXPECT_EQ(parameter_server->get_num_rows(), num_rows);
+  EXPECT_LT(allocated_rows(), num_rows / 100);
+
+  BufferBag dirty = create_buffer_bag<KeyType>(num_rows, embedding_vector_size);
+  BufferBag loaded = create_buffer_bag<KeyType>(2 * num_rows, embedding_vector_size);
+  auto dump = [&](size_t begin, size_t end, size_t step, float version) {
+    KeyType* keys = Tensor2<KeyType>::stretch_from(dirty.keys).get_ptr();
+    size_t* slot_id = Tensor2<size_t>::stretch_from(dirty.slot_id).get_ptr();
+    float* vectors = dirty.embedding.get_ptr();
+    size_t num_dirty = 0;
+    for (size_t i = begin; i < end; i += step, num_dirty++) {
+      keys[num_dirty] = static_cast<KeyType>(i);
+      slot_id[num_dirty] = i % slot_num;
+      std::fill(&vectors[num_dirty * embedding_vector_size],
+                &vectors[(num_dirty + 1) * embedding_vector_size], i + version);
+      expected[static_cast<KeyType>(i)] = i + version;
+    }
+    parameter_server->dump_param_to_embedding_file(dirty, num_dirty);
+  };
+  auto check = [&]() {
+    size_t hit_size = 0;
+    parameter_server->load_keyset_from_file(indexed_keyset_file);
+    parameter_server->load_param_from_embedding_file(loaded, hit_size);
+    ASSERT_EQ(hit_size, expected.size());
+    const KeyType* keys = Tensor2<KeyType>::stretch_from(loaded.keys).get_ptr();
+    const float* vectors = loaded.embedding.get_ptr();
+    for (size_t i = 0; i < hit_size; i++) {
+      ASSERT_EQ(expected.count(keys[i]), 1);
+      ASSERT_EQ(vectors[i * embedding_vector_size], expected[keys[i]]);
+      ASSERT_EQ(vectors[(i + 1) * embedding_vector_size - 1], expected[keys[i]]);
+    }
+  };
+  check();
+
+  // the rows of a 16th of the keys are written back, and a few new keys are appended
+  dump(0, num_rows / 16, 1, 0.5f);
+  dump(num_rows, num_rows + num_rows / 8, 1, 0.5f);
+  EXPECT_LT(allocated_rows(), num_rows / 16 + num_rows / 8 + num_rows / 100);
+  check();
+
+  // the indexed snapshot is overwritten, and opened again
+  parameter_server->dump_to_indexed_snapshot(indexed_snapshot_file);
+  parameter_server = create_parameter_server<KeyType>(2 * num_rows, embedding_vector_size,
+                                                     indexed_snapshot_file, embedding_type);
+  EXPECT_EQ(parameter_server->get_num_rows(), expected.size());
+  check();
+  parameter_server->dump_to_snapshot(converted_snapshot_file);
+  check_snapshot(converted_snapshot_file);
+
+  // an index with the offset of a key out of the rows is refused
+  parameter_server.reset();
+  {
+    using Entry = typename FlatHashTable<KeyType>::Entry;
+    const IndexedSnapshotHeader header =
+        IndexedSnapshot<KeyType>::read_header(indexed_snapshot_file);
+    std::fstream snapshot(indexed_snapshot_file,
+                          std::fstream::binary | std::fstream::in | std::fstream::out);
+    std::vector<int8_t> ctrl(header.index_capacity);
+    snapshot.seekg(header.index_offset);
+    snapshot.read(reinterpret_cast<char*>(ctrl.data()), ctrl.size());
+    const size_t pos =
+        std::find_if(ctrl.begin(), ctrl.end(), [](int8_t c) { return c >= 0; }) - ctrl.begin();
+    const size_t entry_offset = header.index_offset + header.index_capacity + pos * sizeof(Entry);
+    Entry entry;
+    snapshot.seekg(entry_offset);
+    snapshot.read(reinterpret_cast<char*>(&entry), sizeof(Entry));
+    entry.value = (entry.value >> FlatHashTable<KeyType>::OFFSET_BITS
+                                  << FlatHashTable<KeyType>::OFFSET_BITS) |
+                  header.num_rows;
+    snapshot.seekp(entry_offset);
+    snapshot.write(reinterpret_cast<char*>(&entry), sizeof(Entry));
+  }
+  EXPECT_THROW(create_parameter_server<KeyType>(2 * num_rows, embedding_vector_size,
+                                                indexed_snapshot_file, embedding_type),
+               internal_runtime_error);
+}
+
+// keep the embedding_file in a reduced precision: it takes the rows of the codec, and the rows
+// loaded, compacted, and dumped to both kinds of snapshots are the fp32 ones within its rounding
+template <typename KeyType>
+void do_storage_precision(size_t num_rows, size_t embedding_vector_size,
+                          Embedding_t embedding_type, StoragePrecision_t storage_precision,
+                          float tolerance) {
+  const bool is_distributed = embedding_type == Embedding_t::DistributedSlotSparseEmbeddingHash;
+  const char* precision_snapshot_src_file = "precision_snapshot_src.bin";
+  const char* precision_snapshot_dst_file = "precision_snapshot_dst.bin";
+  const char* precision_indexed_snapshot_file = "precision_indexed_snapshot.bin";
+  const char* precision_keyset_file = "precision_keyset_file.bin";
+  test_files files{{precision_snapshot_src_file, precision_snapshot_dst_file,
+                    precision_indexed_snapshot_file, precision_keyset_file}};
+  const size_t row_size_in_byte = embedding_vector_size * sizeof(float);
+  const size_t stored_row_size_in_byte =
+      RowCodec::row_size_in_byte(storage_precision, embedding_vector_size);
+
+  // the elements of a row differ, so that the int8 scale of a row matters. The versions of a key
+  // are kept to compare against
+  auto value = [](KeyType key, size_t j, float version) {
+    return std::sin(static_cast<float>(key) * 0.37f + j * 1.3f) * (1.f + version);
+  };
+  std::map<KeyType, float> expected;
+  for (KeyType key : key_range<KeyType>(0, num_rows)) expected[key] = 0.f;
+  write_snapshot(precision_snapshot_src_file, key_range<KeyType>(0, num_rows),
+                 embedding_vector_size, embedding_type, [&](KeyType key, float* vector) {
+                   for (size_t j = 0; j < embedding_vector_size; j++) vector[j] = value(key, j, 0.f);
+                 });
+  write_keyset(precision_keyset_file, key_range<KeyType>(0, num_rows));
+  std::vector<float> want(embedding_vector_size);
+  auto near = [&](const float* vector, KeyType key) {
+    const float version = expected[key];
+    float max_abs = 0.f;
+    for (size_t j = 0; j < embedding_vector_size; j++) {
+      want[j] = value(key, j, version);
+      max_abs = std::max(max_abs, std::fabs(want[j]));
+    }
+    for (size_t j = 0; j < embedding_vector_size; j++) {
+      if (std::fabs(vector[j] - want[j]) > tolerance * max_abs) return false;
+    }
+    return true;
+  };
+
+  auto parameter_server = create_parameter_server<KeyType>(
+      2 * num_rows, embedding_vector_size, precision_snapshot_src_file, embedding_type,
+      storage_precision);
+  auto file_size = [&]() {
+    std::ifstream file(parameter_server->get_embedding_file_path(),
+                       std::ifstream::binary | std::ifstream::ate);
+    return static_cast<size_t>(file.tellg());
+  };
+  EXPECT_EQ(parameter_server->get_num_rows(), num_rows);
+  EXPECT_EQ(file_size(), num_rows * stored_row_size_in_byte);
+
+  BufferBag dirty = create_buffer_bag<KeyType>(num_rows, embedding_vector_size);
+  BufferBag loaded = create_buffer_bag<KeyType>(num_rows, embedding_vector_size);
+  auto check = [&]() {
+    size_t hit_size = 0;
+    parameter_server->load_keyset_from_file(precision_keyset_file);
+    parameter_server->load_param_from_embedding_file(loaded, hit_size);
+    ASSERT_EQ(hit_size, expected.size());
+    const KeyType* keys = Tensor2<KeyType>::stretch_from(loaded.keys).get_ptr();
+    const float* vectors = loaded.embedding.get_ptr();
+    for (size_t i = 0; i < hit_size; i++) {
+      ASSERT_EQ(expected.count(keys[i]), 1);
+      ASSERT_TRUE(near(&vectors[i * embedding_vector_size], keys[i]));
+    }
+  };
+  check();
+
+  // every other key is written back, and the first quarter of the keys is erased and compacted
+  {
+    KeyType* keys = Tensor2<KeyType>::stretch_from(dirty.keys).get_ptr();
+    size_t* slot_id = Tensor2<size_t>::stretch_from(dirty.slot_id).get_ptr();
+    float* vectors = dirty.embedding.get_ptr();
+    size_t num_dirty = 0;
+    for (size_t i = 0; i < num_rows; i += 2, num_dirty++) {
+      keys[num_dirty] = static_cast<KeyType>(i);
+      slot_id[num_dirty] = i % slot_num;
+      expected[keys[num_dirty]] = 0.5f;
+      for (size_t j = 0; j < embedding_vector_size; j++) {
+        vectors[num_dirty * embedding_vector_size + j] = value(keys[num_dirty], j, 0.5f);
+      }
+    }
+    parameter_server->dump_param_to_embedding_file(dirty, num_dirty);
+  }
+  check();
+  std::vector<KeyType> erased;
+  for (size_t i = 0; i < num_rows / 4; i++) erased.push_back(static_cast<KeyType>(i));
+  EXPECT_EQ(parameter_server->erase_keys(erased), num_rows / 4);
+  for (auto key : erased) expected.erase(key);
+  parameter_server->compact();
+  EXPECT_EQ(file_size(), expected.size() * stored_row_size_in_byte);
+  check();
+
+  // the snapshots are in fp32
+  auto check_snapshot = [&](const char* snapshot_file) {
+    std::ifstream snapshot(snapshot_file, std::ifstream::binary);
+    std::vector<float> vector(embedding_vector_size);
+    size_t num_keys = 0;
+    KeyType key;
+    while (snapshot.read(reinterpret_cast<char*>(&key), sizeof(KeyType))) {
+      size_t slot_id;
+      if (!is_distributed) snapshot.read(reinterpret_cast<char*>(&slot_id), sizeof(size_t));
+      snapshot.read(reinterpret_cast<char*>(vector.data()), row_size_in_byte);
+      ASSERT_EQ(expected.count(key), 1);
+      ASSERT_TRUE(near(vector.data(), key));
+      num_keys++;
+    }
+    ASSERT_EQ(num_keys, expected.size());
+  };
+  parameter_server->dump_to_snapshot(precision_snapshot_dst_file);
+  check_snapshot(precision_snapshot_dst_file);
+
+  // an indexed snapshot opened in place is encoded by the compaction
+  parameter_server->dump_to_indexed_snapshot(precision_indexed_snapshot_file);
+  parameter_server =
+      create_parameter_server<KeyType>(2 * num_rows, embedding_vector_size,
+                                       precision_indexed_snapshot_file, embedding_type,
+                                       storage_precision);
+  check();
+  parameter_server->compact();
+  EXPECT_EQ(file_size(), expected.size() * stored_row_size_in_byte);
+  check();
+  IndexedSnapshot<KeyType>::convert_to_snapshot(precision_indexed_snapshot_file,
+                                                precision_snapshot_dst_file);
+  check_snapshot(precision_snapshot_dst_file);
+}
+
 // void test_wrapper() {
 //   std::vector<size_t> batch_num_train = {10, 20, 30, 40};
 //   std::vector<size_t> embedding_vector_size = {16, 32, 64, 128};
@@ -278,6 +917,54 @@ TEST(parameter_server_localized_embedding_test, long_long_float) {
   do_upload_and_download_snapshot<long long, float>(20, 64, loc_embedding);
 }
 
+TEST(parameter_server_distributed_embedding_test, dirty_write_back) {
+  do_dirty_write_back<long long>(1 << 12, 16, Embedding_t::DistributedSlotSparseEmbeddingHash);
+}
+
+TEST(parameter_server_localized_embedding_test, dirty_write_back) {
+  do_dirty_write_back<unsigned>(1 << 12, 16, Embedding_t::LocalizedSlotSparseEmbeddingHash);
+}
+
+TEST(parameter_server_distributed_embedding_test, staged_refresh) {
+  do_staged_refresh<long long>(1 << 12, 16, Embedding_t::DistributedSlotSparseEmbeddingHash);
+}
+
+TEST(parameter_server_localized_embedding_test, staged_refresh) {
+  do_staged_refresh<unsigned>(1 << 12, 16, Embedding_t::LocalizedSlotSparseEmbeddingHash);
+}
+
+TEST(parameter_server_distributed_embedding_test, free_rows_and_compaction) {
+  do_free_rows_and_compaction<long long>(1 << 12, 16,
+                                         Embedding_t::DistributedSlotSparseEmbeddingHash);
+}
+
+TEST(parameter_server_localized_embedding_test, free_rows_and_compaction) {
+  do_free_rows_and_compaction<unsigned>(1 << 12, 16,
+                                        Embedding_t::LocalizedSlotSparseEmbeddingHash);
+}
+
+TEST(parameter_server_distributed_embedding_test, indexed_snapshot) {
+  do_indexed_snapshot<long long>(1 << 14, 64, Embedding_t::DistributedSlotSparseEmbeddingHash);
+}
+
+TEST(parameter_server_localized_embedding_test, indexed_snapshot) {
+  do_indexed_snapshot<unsigned>(1 << 14, 64, Embedding_t::LocalizedSlotSparseEmbeddingHash);
+}
+
+TEST(parameter_server_distributed_embedding_test, storage_precision) {
+  const Embedding_t dis_embedding = Embedding_t::DistributedSlotSparseEmbeddingHash;
+  do_storage_precision<long long>(1 << 12, 64, dis_embedding, StoragePrecision_t::FP32, 0.f);
+  do_storage_precision<long long>(1 << 12, 64, dis_embedding, StoragePrecision_t::FP16, 1e-3f);
+  do_storage_precision<long long>(1 << 12, 64, dis_embedding, StoragePrecision_t::BF16, 4e-3f);
+  do_storage_precision<long long>(1 << 12, 64, dis_embedding, StoragePrecision_t::INT8, 4e-3f);
+}
+
+TEST(parameter_server_localized_embedding_test, storage_precision) {
+  const Embedding_t loc_embedding = Embedding_t::LocalizedSlotSparseEmbeddingHash;
+  do_storage_precision<unsigned>(1 << 12, 70, loc_embedding, StoragePrecision_t::FP16, 1e-3f);
+  do_storage_precision<unsigned>(1 << 12, 70, loc_embedding, StoragePrecision_t::INT8, 4e-3f);
+}
+
 TEST(parameter_server_test_localized_embedding_one_hot_test, long_long_float) {
   const Embedding_t loc_oh_embedding = Embedding_t::LocalizedSlotSparseEmbeddingOneHot;
   do_upload_and_download_snapshot<long long, float>(20, 64, loc_oh_embedding);
@@ -0,0 +1,138 @@
+/*
+ * Copyright (c) 2020, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "HugeCTR/include/model_oversubscriber/row_codec.hpp"
+#include "gtest/gtest.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <random>
+#include <vector>
+
+using namespace HugeCTR;
+
+namespace {
+
+// the largest error of a value after a round trip, relative to the value, or to the largest
+// value of the vector for int8
+double max_error(StoragePrecision_t precision) {
+  switch (precision) {
+    case StoragePrecision_t::FP32:
+      return 0.;
+    case StoragePrecision_t::FP16:
+      return std::ldexp(1., -11);
+    case StoragePrecision_t::BF16:
+      return std::ldexp(1., -8);
+    default:
+      return 0.5 / 127;
+  }
+}
+
+// vectors of all the sizes around the SIMD widths, with the values of a trained embedding
+void round_trip_test(StoragePrecision_t precision) {
+  std::mt19937 gen(0);
+  std::normal_distribution<float> dis(0.f, 0.05f);
+  for (size_t embedding_vec_size = 1; embedding_vec_size <= 70; embedding_vec_size++) {
+    RowCodec codec(precision, embedding_vec_size);
+    ASSERT_EQ(codec.row_size_in_byte(),
+              RowCodec::row_size_in_byte(precision, embedding_vec_size));
+    std::vector<float> src(embedding_vec_size), dst(embedding_vec_size);
+    std::vector<char> row(codec.row_size_in_byte());
+    for (int round = 0; round < 20; round++) {
+      std::generate(src.begin(), src.end(), [&]() { return dis(gen); });
+      codec.encode(src.data(), row.data());
+      codec.decode(row.data(), dst.data());
+      float max_abs = 0.f;
+      for (float value : src) max_abs = std::max(max_abs, std::fabs(value));
+      for (size_t i = 0; i < embedding_vec_size; i++) {
+        // the float rounding of the scale for int8, and the denormals of fp16
+        const double bound = precision == StoragePrecision_t::INT8
+                                 ? max_error(precision) * max_abs * (1 + 1e-4)
+                                 : max_error(precision) * std::fabs(src[i]) +
+                                       (precision == StoragePrecision_t::FP16 ? std::ldexp(1., -25) : 0.);
+        ASSERT_LE(std::fabs(dst[i] - src[i]), bound)
+            << "size " << embedding_vec_size << ", element " << i;
+      }
+    }
+  }
+}
+
+// the special values go through the SIMD lanes and the scalar tail alike
+void special_values_test(StoragePrecision_t precision) {
+  const float inf = std::numeric_limits<float>::infinity();
+  const float nan = std::numeric_limits<float>::quiet_NaN();
+  std::vector<float> src = {0.f, -0.f, 1.f, -2.f, 0.5f, 1e-6f, -3e-5f, 65504.f, 1e5f, inf, -inf,
+                            nan, 1e-30f, 3.f, -1.f, 0.25f};
+  if (precision == StoragePrecision_t::INT8) {
+    src.resize(7);
+  }
+  const size_t size = src.size();
+  src.insert(src.end(), src.begin(), src.end());
+  src.resize(2 * size + 1, 7.f);
+
+  RowCodec codec(precision, src.size());
+  std::vector<float> dst(src.size());
+  std::vector<char> row(codec.row_size_in_byte());
+  codec.encode(src.data(), row.data());
+  codec.decode(row.data(), dst.data());
+  for (size_t i = 0; i < src.size(); i++) {
+    const float value = src[i];
+    if (std::isnan(value)) {
+      ASSERT_TRUE(std::isnan(dst[i]));
+    } else if (precision == StoragePrecision_t::FP16 && std::fabs(value) > 65504.f) {
+      ASSERT_EQ(dst[i], std::copysign(inf, value)) << i;
+    } else if (precision == StoragePrecision_t::FP16 && std::fabs(value) < 6e-8f) {
+      ASSERT_EQ(dst[i], 0.f) << i;
+    } else if (precision == StoragePrecision_t::FP16 && std::fabs(value) < 6.2e-5f) {
+      // a denormal half
+      ASSERT_NEAR(dst[i], value, std::ldexp(1., -25)) << i;
+    } else if (precision == StoragePrecision_t::INT8) {
+      ASSERT_NEAR(dst[i], value, 0.5 / 127 * 7.f) << i;
+    } else if (std::isinf(value) || value == 0.f) {
+      ASSERT_EQ(dst[i], value) << i;
+      ASSERT_EQ(std::signbit(dst[i]), std::signbit(value)) << i;
+    } else {
+      ASSERT_LE(std::fabs(dst[i] - value), max_error(precision) * std::fabs(value)) << i;
+    }
+  }
+
+  // and a vector of zeros
+  if (precision == StoragePrecision_t::INT8) {
+    std::vector<float> zeros(33, 0.f), decoded(33, 1.f);
+    RowCodec zero_codec(precision, zeros.size());
+    std::vector<char> zero_row(zero_codec.row_size_in_byte());
+    zero_codec.encode(zeros.data(), zero_row.data());
+    zero_codec.decode(zero_row.data(), decoded.data());
+    ASSERT_EQ(decoded, zeros);
+  }
+}
+
+}  // namespace
+
+TEST(row_codec, fp32_test) { round_trip_test(StoragePrecision_t::FP32); }
+TEST(row_codec, fp16_test) {
+  round_trip_test(StoragePrecision_t::FP16);
+  special_values_test(StoragePrecision_t::FP16);
+}
+TEST(row_codec, bf16_test) {
+  round_trip_test(StoragePrecision_t::BF16);
+  special_values_test(StoragePrecision_t::BF16);
+}
+TEST(row_codec, int8_test) {
+  round_trip_test(StoragePrecision_t::INT8);
+  special_values_test(StoragePrecision_t::INT8);
+}
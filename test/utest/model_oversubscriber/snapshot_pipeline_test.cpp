@@ -0,0 +1,142 @@
+/*
+ * Copyright (c) 2020, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "HugeCTR/include/model_oversubscriber/snapshot_pipeline.hpp"
+#include "gtest/gtest.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <vector>
+
+using namespace HugeCTR;
+
+namespace {
+
+const char* src_snapshot_file = "snapshot_pipeline_src.bin";
+const char* dst_snapshot_file = "snapshot_pipeline_dst.bin";
+const char* embedding_file = "snapshot_pipeline_embedding.bin";
+
+// a snapshot of num_rows rows with distinct keys, and the vector of each row filled with its row
+template <typename KeyType>
+void write_snapshot(const char* file_name, size_t num_rows, size_t embedding_vec_size,
+                    bool has_slot_id) {
+  std::ofstream snapshot(file_name, std::ofstream::binary | std::ofstream::trunc);
+  std::vector<float> vector(embedding_vec_size);
+  const size_t chunk_rows = 1 << 16;
+  std::vector<char> chunk;
+  for (size_t row = 0; row < num_rows; row++) {
+    KeyType key = static_cast<KeyType>(row * 7 + 3);
+    size_t slot_id = row % 26;
+    std::fill(vector.begin(), vector.end(), static_cast<float>(row));
+    chunk.insert(chunk.end(), (char*)&key, (char*)&key + sizeof(KeyType));
+    if (has_slot_id) chunk.insert(chunk.end(), (char*)&slot_id, (char*)&slot_id + sizeof(size_t));
+    chunk.insert(chunk.end(), (char*)vector.data(), (char*)(vector.data() + embedding_vec_size));
+    if ((row + 1) % chunk_rows == 0 || row + 1 == num_rows) {
+      snapshot.write(chunk.data(), chunk.size());
+      chunk.clear();
+    }
+  }
+}
+
+std::vector<char> read_file(const char* file_name) {
+  std::ifstream file(file_name, std::ifstream::binary);
+  return std::vector<char>(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+}
+
+template <typename KeyType>
+void snapshot_pipeline_test(size_t num_rows, size_t embedding_vec_size, bool has_slot_id,
+                            size_t block_size_in_byte, int num_threads) {
+  write_snapshot<KeyType>(src_snapshot_file, num_rows, embedding_vec_size, has_slot_id);
+  SnapshotPipeline<KeyType> pipeline(embedding_vec_size, has_slot_id, StoragePrecision_t::FP32,
+                                     block_size_in_byte, num_threads);
+
+  FlatHashTable<KeyType> hash_table;
+  pipeline.import_snapshot(src_snapshot_file, embedding_file, hash_table);
+  ASSERT_EQ(hash_table.size(), num_rows);
+  std::vector<char> embedding_table = read_file(embedding_file);
+  ASSERT_EQ(embedding_table.size(), num_rows * embedding_vec_size * sizeof(float));
+  const float* vectors = reinterpret_cast<const float*>(embedding_table.data());
+  for (size_t row = 0; row < num_rows; row++) {
+    auto entry = hash_table.find(static_cast<KeyType>(row * 7 + 3));
+    ASSERT_NE(entry, nullptr);
+    ASSERT_EQ(entry->offset(), row);
+    ASSERT_EQ(entry->slot_id(), has_slot_id ? row % 26 : 0);
+    ASSERT_EQ(vectors[row * embedding_vec_size], static_cast<float>(row));
+    ASSERT_EQ(vectors[(row + 1) * embedding_vec_size - 1], static_cast<float>(row));
+  }
+
+  pipeline.export_snapshot(embedding_file, dst_snapshot_file, hash_table);
+  ASSERT_TRUE(read_file(src_snapshot_file) == read_file(dst_snapshot_file));
+}
+
+// the first row of a repeated key is kept, and the other ones are left out of the embedding
+// file, so that the export gives the snapshot without them
+void snapshot_pipeline_repeated_key_test() {
+  const size_t embedding_vec_size = 4;
+  const size_t row_size = sizeof(long long) + sizeof(float) * embedding_vec_size;
+  write_snapshot<long long>(dst_snapshot_file, 100, embedding_vec_size, false);
+  const std::vector<char> rows = read_file(dst_snapshot_file);
+  {
+    // the key of row 0 again, after row 49 and at the end
+    std::ofstream snapshot(src_snapshot_file, std::ofstream::binary | std::ofstream::trunc);
+    long long key = 3;
+    std::vector<float> vector(embedding_vec_size, -1.0f);
+    for (size_t part = 0; part < 2; part++) {
+      snapshot.write(rows.data() + part * 50 * row_size, 50 * row_size);
+      snapshot.write((char*)&key, sizeof(key));
+      snapshot.write((char*)vector.data(), sizeof(float) * embedding_vec_size);
+    }
+    // a partial row is ignored
+    snapshot.write((char*)&key, sizeof(key));
+  }
+  SnapshotPipeline<long long> pipeline(embedding_vec_size, false, StoragePrecision_t::FP32, 256,
+                                       2);
+  FlatHashTable<long long> hash_table;
+  pipeline.import_snapshot(src_snapshot_file, embedding_file, hash_table);
+  EXPECT_EQ(hash_table.size(), 100);
+  EXPECT_EQ(hash_table.find(3)->offset(), 0);
+  EXPECT_EQ(hash_table.find(50 * 7 + 3)->offset(), 50);
+  EXPECT_EQ(read_file(embedding_file).size(), 100 * embedding_vec_size * sizeof(float));
+  pipeline.export_snapshot(embedding_file, dst_snapshot_file, hash_table);
+  ASSERT_TRUE(read_file(dst_snapshot_file) == rows);
+
+  // no snapshot to import from
+  hash_table.clear();
+  pipeline.import_snapshot("", embedding_file, hash_table);
+  EXPECT_EQ(hash_table.size(), 0);
+  EXPECT_EQ(read_file(embedding_file).size(), 0);
+  EXPECT_THROW(pipeline.import_snapshot("no_such_snapshot.bin", embedding_file, hash_table),
+               internal_runtime_error);
+  std::remove(src_snapshot_file);
+  std::remove(dst_snapshot_file);
+  std::remove(embedding_file);
+}
+
+}  // namespace
+
+TEST(snapshot_pipeline, long_long_distributed_test) {
+  snapshot_pipeline_test<long long>(100000, 16, false, 1 << 16, 3);
+}
+TEST(snapshot_pipeline, unsigned_localized_test) {
+  snapshot_pipeline_test<unsigned>(100000, 16, true, 1 << 16, 3);
+}
+TEST(snapshot_pipeline, small_blocks_test) {
+  snapshot_pipeline_test<long long>(1000, 3, true, 1, 4);
+  snapshot_pipeline_test<unsigned>(0, 8, false, 1 << 20, 0);
+}
+TEST(snapshot_pipeline, repeated_key_test) { snapshot_pipeline_repeated_key_test(); }
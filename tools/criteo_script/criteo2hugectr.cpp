@@ -29,7 +29,8 @@ using namespace HugeCTR;
 
 static std::string usage_str =
     "usage: ./criteo2hugectr in.txt dir/prefix file_list.txt [option:#keys for wide model,default "
-    "is 0] [option: Number of files in each file_list.txt,default is 0(all in one file)]";
+    "is 0] [option: Number of files in each file_list.txt,default is 0(all in one file)] "
+    "[option: --compression=none|lz4|zstd, default is none]";
 static const int N = 40960;  // number of samples per data file
 static int KEYS_WIDE_MODEL = 0;
 static const int KEYS_DENSE_MODEL = 26;
@@ -38,6 +39,7 @@ typedef unsigned int T;
 static const long long label_dim = 1;
 static int SLOT_NUM = 26;
 static int FILELIST_LENGTH = 0;  // number of files in each file_list.txt
+static Compression_t COMPRESSION = Compression_t::None;
 std::unordered_set<unsigned int> keyset;
 
 std::vector<std::string> &split(const std::string &s, char delim, std::vector<std::string> &elems) {
@@ -52,6 +54,25 @@ std::vector<std::string> &split(const std::string &s, char delim, std::vector<st
 int main(int argc, char *argv[]) {
   const std::string tmp_file_list_name("file_list.tmp");
 
+  // the flag can be anywhere, and is removed from the positional arguments
+  const std::string compression_flag("--compression=");
+  for (int i = 1; i < argc; i++) {
+    std::string arg(argv[i]);
+    if (arg.compare(0, compression_flag.size(), compression_flag) == 0) {
+      try {
+        COMPRESSION = compression_from_string(arg.substr(compression_flag.size()));
+      } catch (const std::runtime_error &rt_err) {
+        std::cerr << rt_err.what() << std::endl;
+        exit(-1);
+      }
+      for (int j = i; j < argc - 1; j++) {
+        argv[j] = argv[j + 1];
+      }
+      argc--;
+      i--;
+    }
+  }
+
   if (argc != 4 && argc != 5 && argc != 6) {
     std::cout << usage_str << std::endl;
     exit(-1);
@@ -126,12 +147,17 @@ int main(int argc, char *argv[]) {
       std::cerr << "Cannot open data_file" << std::endl;
     }
 
-    DataWriter<Check_t::Sum> data_writer(data_file);
-    DataSetHeader header = {
-        1, static_cast<long long>(N), label_dim, dense_dim, static_cast<long long>(SLOT_NUM), 0, 0,
-        0};
+    DataWriter<Check_t::Sum> data_writer(data_file, COMPRESSION);
+    DataSetHeader header = {1,
+                            static_cast<long long>(N),
+                            label_dim,
+                            dense_dim,
+                            static_cast<long long>(SLOT_NUM),
+                            static_cast<long long>(COMPRESSION),
+                            0,
+                            0};
     data_writer.append(reinterpret_cast<char *>(&header), sizeof(DataSetHeader));
-    data_writer.write();
+    data_writer.write_header();
     // read N lines
     int i = 0;
     for (; i < N; i++) {
@@ -144,17 +170,18 @@ int main(int argc, char *argv[]) {
         if (i == 0 && keyset.size() == 0) {
           return 0;
         }
+        data_writer.flush();
         data_file.seekp(std::ios_base::beg);
         DataSetHeader last_header = {1,
                                      static_cast<long long>(i),
                                      label_dim,
                                      dense_dim,
                                      static_cast<long long>(SLOT_NUM),
-                                     0,
+                                     static_cast<long long>(COMPRESSION),
                                      0,
                                      0};
         data_writer.append(reinterpret_cast<char *>(&last_header), sizeof(DataSetHeader));
-        data_writer.write();
+        data_writer.write_header();
         data_file.close();
         std::cout << "last keyset size is:" << keyset.size() << std::endl;
         keyset_writer.write();
@@ -256,6 +283,7 @@ int main(int argc, char *argv[]) {
       }
       data_writer.write();
     }
+    data_writer.flush();
     data_file.close();
 
     if (FILELIST_LENGTH > 0 && (file_counter + 1) % FILELIST_LENGTH == 0) {
@@ -0,0 +1,367 @@
+/*
+ * Copyright (c) 2020, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "HugeCTR/include/data_generator.hpp"
+#include "HugeCTR/include/data_readers/block_codec.hpp"
+#include "HugeCTR/include/data_readers/check_none.hpp"
+#include "HugeCTR/include/data_readers/check_sum.hpp"
+#include "HugeCTR/include/data_readers/check_sum_block.hpp"
+#include "HugeCTR/include/data_readers/data_reader_worker.hpp"
+#include "HugeCTR/include/data_readers/file_source.hpp"
+#include "HugeCTR/include/data_readers/file_source_async.hpp"
+#include "HugeCTR/include/data_readers/file_source_mmap.hpp"
+#include "HugeCTR/include/data_readers/mmap_offset_list.hpp"
+#include <sys/stat.h>
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+using namespace HugeCTR;
+
+static std::string usage_str = "usage: ./data_reader_benchmark <checker|shuffle|gather|async|compressed>";
+
+// The seconds which f takes
+template <typename F>
+static double seconds_of(F f) {
+  auto start = std::chrono::steady_clock::now();
+  f();
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+static void check(Error_t err) {
+  if (err != Error_t::Success) {
+    CK_THROW_(err, "Failed to read the generated data");
+  }
+}
+
+// Norm records parsed with each checker, from a stream or a memory mapped file
+namespace checker {
+
+const int num_records = 32768;
+const int label_dim = 1;
+const int dense_dim = 13;
+const int slot_num = 26;
+const int max_nnz = 2;
+
+template <typename TypeKey>
+size_t parse_norm_file(Checker& checker, bool zero_copy) {
+  std::vector<char> label_dense(sizeof(float) * (label_dim + dense_dim));
+  std::vector<char> keys(sizeof(TypeKey) * max_nnz);
+  size_t key_sum = 0;
+  check(checker.next_source());
+  DataSetHeader header;
+  check(checker.read(reinterpret_cast<char*>(&header), sizeof(DataSetHeader)));
+  // reads the fields as DataReaderWorker does
+  auto read = [&](char* buffer, size_t bytes) {
+    const char* ptr = buffer;
+    check(zero_copy ? checker.read_ptr(&ptr, bytes) : checker.read(buffer, bytes));
+    return ptr;
+  };
+  for (long long i = 0; i < header.number_of_records; i++) {
+    read(label_dense.data(), label_dense.size());
+    for (int k = 0; k < slot_num; k++) {
+      int nnz;
+      memcpy(&nnz, read(reinterpret_cast<char*>(&nnz), sizeof(int)), sizeof(int));
+      const char* ptr = read(keys.data(), sizeof(TypeKey) * nnz);
+      for (int j = 0; j < nnz; j++) {
+        TypeKey key;
+        memcpy(&key, ptr + j * sizeof(TypeKey), sizeof(TypeKey));
+        key_sum += key;
+      }
+    }
+  }
+  return key_sum;
+}
+
+void run() {
+  typedef long long TypeKey;
+  const std::string sum_file_list("checker_benchmark_sum_file_list.txt");
+  const std::string none_file_list("checker_benchmark_none_file_list.txt");
+  data_generation_for_test<TypeKey, Check_t::Sum>(sum_file_list, "./checker_benchmark_data/sum_",
+                                                  1, num_records, slot_num, 10000, label_dim,
+                                                  dense_dim, max_nnz);
+  data_generation_for_test<TypeKey, Check_t::None>(none_file_list,
+                                                   "./checker_benchmark_data/none_", 1,
+                                                   num_records, slot_num, 10000, label_dim,
+                                                   dense_dim, max_nnz);
+
+  std::cout << "source\tCheckNone\tCheckSum\tCheckSumBlock (records/s)" << std::endl;
+  for (bool use_mmap : {false, true}) {
+    auto make_source = [use_mmap](const std::string& file_list) -> std::shared_ptr<Source> {
+      if (use_mmap) {
+        return std::make_shared<MmapFileSource>(0, 1, file_list, true);
+      }
+      return std::make_shared<FileSource>(0, 1, file_list, true);
+    };
+    auto none_source = make_source(none_file_list);
+    auto sum_source = make_source(sum_file_list);
+    auto block_source = make_source(sum_file_list);
+    CheckNone check_none(*none_source);
+    CheckSum check_sum(*sum_source);
+    CheckSumBlock check_sum_block(*block_source);
+
+    size_t sum_keys = 0, block_keys = 0;
+    double none_time = seconds_of([&]() { parse_norm_file<TypeKey>(check_none, use_mmap); });
+    double sum_time =
+        seconds_of([&]() { sum_keys = parse_norm_file<TypeKey>(check_sum, false); });
+    double block_time =
+        seconds_of([&]() { block_keys = parse_norm_file<TypeKey>(check_sum_block, true); });
+    if (sum_keys != block_keys) {
+      CK_THROW_(Error_t::UnspecificError, "CheckSumBlock read other keys than CheckSum");
+    }
+    std::cout << (use_mmap ? "mmap" : "stream") << "\t" << num_records / none_time << "\t"
+              << num_records / sum_time << "\t" << num_records / block_time << std::endl;
+  }
+}
+
+}  // namespace checker
+
+// Norm samples read by a DataReaderWorker through shuffle buffers of several sizes
+namespace shuffle {
+
+typedef long long T;
+const int num_files = 20;
+const long long label_dim = 2;
+const long long dense_dim = 64;
+const long long slot_num = 10;
+const long long num_records = 2048 * 2;
+const int max_nnz = 30;
+const int vocabulary_size = 511;
+const Check_t CHK = Check_t::Sum;
+
+void run() {
+  const std::string file_list_name("shuffle_benchmark_file_list.txt");
+  data_generation_for_test<T, CHK>(file_list_name, "./shuffle_benchmark_data/temp_dataset_",
+                                   num_files, num_records, slot_num, vocabulary_size, label_dim,
+                                   dense_dim, max_nnz);
+
+  const int num_devices = 1;
+  const int batchsize = 2048;
+  const std::vector<DataReaderSparseParam> params = {
+      {DataReaderSparse_t::Distributed, max_nnz * slot_num, max_nnz, slot_num}};
+  const size_t buffer_length = max_nnz;
+  const int num_batches = 32;
+  std::cout << "shuffle_buffer_size\tsamples/s" << std::endl;
+  for (int shuffle_buffer_size : {0, 1024, 16384}) {
+    std::shared_ptr<HeapEx<CSRChunk<T>>> csr_heap(
+        new HeapEx<CSRChunk<T>>(1, 1, num_devices, batchsize, label_dim + dense_dim, params));
+    DataReaderWorker<T> data_reader(0, 1, csr_heap, file_list_name, buffer_length, true, CHK,
+                                    params, false, 1, shuffle_buffer_size, shuffle_buffer_size > 0);
+    // the reservoir is filled up by the first batch
+    data_reader.read_a_batch();
+    csr_heap->checkout_data_chunk();
+    csr_heap->return_free_chunk();
+    double time = seconds_of([&]() {
+      for (int iter = 0; iter < num_batches; iter++) {
+        data_reader.read_a_batch();
+        csr_heap->checkout_data_chunk();
+        csr_heap->return_free_chunk();
+      }
+    });
+    std::cout << shuffle_buffer_size << "\t" << num_batches * batchsize / time << std::endl;
+  }
+}
+
+}  // namespace shuffle
+
+// Raw batches gathered from shuffled blocks of samples, against the batches copied in place
+namespace gather {
+
+const long long num_samples = 1 << 19;
+const int label_dim = 1;
+const int dense_dim = 13;
+const int slot_num = 26;
+
+void run() {
+  const std::string file_name = "./gather_benchmark.bin";
+  const size_t stride = (label_dim + dense_dim + slot_num) * sizeof(int);
+  const int batchsize = 8192;
+  data_generation_for_raw(file_name, num_samples, label_dim, dense_dim, slot_num, true);
+  const long long num_batches = num_samples / batchsize;
+  std::vector<char> buffer(batchsize * stride);
+  std::cout << "shuffle_block_size\tsamples/s" << std::endl;
+  for (long long shuffle_block_size : {0, 1, 16, 256}) {
+    MmapOffsetList list(file_name, num_samples, stride, batchsize, true, 1, true,
+                        shuffle_block_size);
+    double time = seconds_of([&]() {
+      for (int round = 0; round < num_batches; round++) {
+        if (shuffle_block_size > 0) {
+          list.gather(round, 0, buffer.data());
+        } else {
+          // the batches are copied as they are, which is the upper bound
+          MmapOffset offset = list.get_offset(round, 0);
+          memcpy(buffer.data(), offset.offset, offset.samples * stride);
+        }
+      }
+    });
+    std::cout << shuffle_block_size << "\t" << num_batches * batchsize / time << std::endl;
+  }
+}
+
+}  // namespace gather
+
+// Norm files read in 64 KB pieces through an ifstream and the asynchronous source
+namespace async_io {
+
+typedef long long T;
+const int num_files = 20;
+const long long label_dim = 2;
+const long long dense_dim = 64;
+const long long slot_num = 10;
+const long long num_records = 2048 * 2;
+const int max_nnz = 30;
+const int vocabulary_size = 511;
+
+void run() {
+  const std::string file_list_name("async_benchmark_file_list.txt");
+  data_generation_for_test<T, Check_t::Sum>(
+      file_list_name, "./async_benchmark_data/temp_dataset_", num_files, num_records, slot_num,
+      vocabulary_size, label_dim, dense_dim, max_nnz);
+  const size_t piece = 64 * 1024;
+  std::vector<char> buffer(piece);
+  auto read_epoch = [&](Source& source) {
+    size_t bytes = 0;
+    for (int f = 0; f < num_files; f++) {
+      check(source.next_source());
+      Error_t err;
+      do {
+        err = source.read(buffer.data(), piece);
+        bytes += piece;
+      } while (err == Error_t::Success);
+      if (err != Error_t::OutOfBound) {
+        check(err);
+      }
+    }
+    return bytes;
+  };
+  std::cout << "source\tMB/s\taverage queue depth" << std::endl;
+  {
+    FileSource source(0, 1, file_list_name, true);
+    size_t bytes = 0;
+    double time = seconds_of([&]() { bytes = read_epoch(source); });
+    std::cout << "ifstream\t" << bytes / time / (1 << 20) << "\t-" << std::endl;
+  }
+  for (int queue_depth : {1, 4, 16}) {
+    AsyncFileSource source(0, 1, file_list_name, true, false, 0, queue_depth);
+    read_epoch(source);
+    const AsyncIoStats& stats = source.get_io_stats();
+    std::cout << "async " << queue_depth << "\t" << stats.bytes_per_sec() / (1 << 20) << "\t"
+              << stats.average_depth() << std::endl;
+  }
+}
+
+}  // namespace async_io
+
+// Raw batches decompressed from LZ4 and Zstd frames, against the batches copied in place
+namespace compressed {
+
+const long long num_samples = 1 << 17;
+const int label_dim = 1;
+const int dense_dim = 13;
+const int slot_num = 26;
+const std::vector<long long> slot_size(slot_num, 10000);
+
+// copy a Raw file into the compressed format, in frames of about "block_bytes"
+void compress_raw_file(const std::string& in_name, const std::string& out_name,
+                       Compression_t compression, size_t block_bytes) {
+  const size_t stride = (label_dim + dense_dim + slot_num) * sizeof(int);
+  std::ifstream in(in_name, std::ifstream::binary);
+  std::ofstream out(out_name, std::ofstream::binary);
+  write_raw_compressed_header(out, num_samples, label_dim, dense_dim, slot_num, compression);
+  BlockWriter block_writer(out, compression, block_bytes);
+  std::vector<char> sample(stride);
+  for (long long i = 0; i < num_samples; i++) {
+    in.read(sample.data(), stride);
+    block_writer.write(sample.data(), stride);
+    block_writer.end_record();
+  }
+  block_writer.flush();
+}
+
+void run() {
+  const std::string raw_file_name = "./compressed_benchmark.bin";
+  const size_t stride = (label_dim + dense_dim + slot_num) * sizeof(int);
+  const int batchsize = 8192;
+  data_generation_for_raw(raw_file_name, num_samples, label_dim, dense_dim, slot_num, true,
+                          slot_size);
+  std::vector<std::string> file_names = {raw_file_name};
+#ifdef ENABLE_LZ4
+  compress_raw_file(raw_file_name, raw_file_name + ".lz4", Compression_t::LZ4, 1 << 20);
+  file_names.push_back(raw_file_name + ".lz4");
+#endif
+#ifdef ENABLE_ZSTD
+  compress_raw_file(raw_file_name, raw_file_name + ".zst", Compression_t::Zstd, 1 << 20);
+  file_names.push_back(raw_file_name + ".zst");
+#endif
+  struct stat raw_stat;
+  stat(raw_file_name.c_str(), &raw_stat);
+
+  const long long num_batches = num_samples / batchsize;
+  std::vector<char> buffer(batchsize * stride);
+  std::cout << "file\tcompression ratio\tsamples/s" << std::endl;
+  for (const std::string& name : file_names) {
+    struct stat file_stat;
+    stat(name.c_str(), &file_stat);
+    MmapOffsetList list(name, num_samples, stride, batchsize, false, 1, true);
+    MmapOffsetList::FrameCache cache;
+    double time = seconds_of([&]() {
+      for (int round = 0; round < num_batches; round++) {
+        if (list.is_compressed()) {
+          list.decompress(round, 0, buffer.data(), &cache);
+        } else {
+          MmapOffset offset = list.get_offset(round, 0);
+          memcpy(buffer.data(), offset.offset, offset.samples * stride);
+        }
+      }
+    });
+    std::cout << name << "\t" << double(raw_stat.st_size) / file_stat.st_size << "\t"
+              << num_batches * batchsize / time << std::endl;
+  }
+}
+
+}  // namespace compressed
+
+int main(int argc, char* argv[]) {
+  try {
+    if (argc != 2) {
+      std::cout << usage_str << std::endl;
+      exit(-1);
+    }
+    const std::string benchmark(argv[1]);
+    if (benchmark == "checker") {
+      checker::run();
+    } else if (benchmark == "shuffle") {
+      shuffle::run();
+    } else if (benchmark == "gather") {
+      gather::run();
+    } else if (benchmark == "async") {
+      async_io::run();
+    } else if (benchmark == "compressed") {
+      compressed::run();
+    } else {
+      std::cout << usage_str << std::endl;
+      exit(-1);
+    }
+  } catch (const std::exception& err) {
+    std::cerr << err.what() << std::endl;
+    return -1;
+  }
+  return 0;
+}
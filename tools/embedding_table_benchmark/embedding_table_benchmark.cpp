@@ -0,0 +1,227 @@
+/*
+ * Copyright (c) 2020, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "HugeCTR/include/inference/embedding_table.hpp"
+#include "HugeCTR/include/model_oversubscriber/indexed_snapshot.hpp"
+#include <omp.h>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <fcntl.h>
+#include <unistd.h>
+
+using namespace HugeCTR;
+
+static std::string usage_str =
+    "usage: ./embedding_table_benchmark num_rows embedding_vec_size batch_size zipf_exponent "
+    "[num_batches=100] [miss_ratio=0.1] [indexed=0] "
+    "[sparse_model_file=./embedding_table_benchmark.bin]";
+
+// The rank of a key in popularity is scattered over the key space
+static long long key_of_rank(size_t rank) {
+  return static_cast<long long>((rank * 0x9e3779b97f4a7c15ULL) >> 1);
+}
+
+// Draw batches of keys whose ranks follow a Zipf distribution over the rows of the table, with
+// miss_ratio of them out of the table
+class ZipfKeyGenerator {
+  std::vector<double> cdf_;
+  size_t num_rows_;
+  double miss_ratio_;
+  std::mt19937_64 gen_;
+
+ public:
+  ZipfKeyGenerator(size_t num_rows, double exponent, double miss_ratio)
+      : cdf_(num_rows), num_rows_(num_rows), miss_ratio_(miss_ratio), gen_(num_rows) {
+    double sum = 0.;
+    for (size_t rank = 0; rank < num_rows; rank++) {
+      sum += 1. / std::pow(static_cast<double>(rank + 1), exponent);
+      cdf_[rank] = sum;
+    }
+    for (auto& p : cdf_) p /= sum;
+  }
+
+  void fill(std::vector<long long>& keys) {
+    std::uniform_real_distribution<double> uniform(0., 1.);
+    for (auto& key : keys) {
+      if (uniform(gen_) < miss_ratio_) {
+        key = key_of_rank(num_rows_ + gen_() % num_rows_);
+      } else {
+        const size_t rank =
+            std::lower_bound(cdf_.begin(), cdf_.end(), uniform(gen_)) - cdf_.begin();
+        key = key_of_rank(std::min(rank, num_rows_ - 1));
+      }
+    }
+  }
+};
+
+// The resident set of the process in KB, from /proc/self/status
+static size_t resident_set_kb() {
+  std::ifstream status("/proc/self/status");
+  std::string line;
+  while (std::getline(status, line)) {
+    if (line.compare(0, 6, "VmRSS:") == 0) {
+      return std::stoul(line.substr(6));
+    }
+  }
+  return 0;
+}
+
+static void write_sparse_model(const std::string& file_name, size_t num_rows,
+                               size_t embedding_vec_size) {
+  std::ofstream file(file_name, std::ofstream::binary);
+  if (!file.is_open()) {
+    CK_THROW_(Error_t::FileCannotOpen, "Cannot open the file: " + file_name);
+  }
+  std::vector<float> vector(embedding_vec_size);
+  for (size_t rank = 0; rank < num_rows; rank++) {
+    const long long key = key_of_rank(rank);
+    std::fill(vector.begin(), vector.end(), static_cast<float>(rank));
+    file.write(reinterpret_cast<const char*>(&key), sizeof(key));
+    file.write(reinterpret_cast<const char*>(vector.data()), sizeof(float) * embedding_vec_size);
+  }
+}
+
+// The seconds which the unordered_map replaced by cpu_embedding_table takes to load the file
+static double unordered_map_load_seconds(const std::string& file_name, size_t num_rows,
+                                         size_t embedding_vec_size) {
+  const auto start = std::chrono::steady_clock::now();
+  std::unordered_map<long long, std::vector<float>> table;
+  std::ifstream file(file_name, std::ifstream::binary);
+  long long key;
+  std::vector<float> vector(embedding_vec_size);
+  for (size_t row = 0; row < num_rows; row++) {
+    file.read(reinterpret_cast<char*>(&key), sizeof(key));
+    file.read(reinterpret_cast<char*>(vector.data()), sizeof(float) * embedding_vec_size);
+    table.emplace(key, vector);
+  }
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+// The batches are looked up one after the other, like the missing keys of consecutive queries
+template <typename LookUp>
+static void run(const std::string& name, const std::vector<std::vector<long long>>& batches,
+                size_t embedding_vec_size, LookUp look_up) {
+  std::vector<float> vectors(batches[0].size() * embedding_vec_size);
+  std::vector<double> latencies;
+  // a warm-up batch
+  look_up(batches[0], vectors.data());
+  const auto start = std::chrono::steady_clock::now();
+  for (const auto& keys : batches) {
+    const auto batch_start = std::chrono::steady_clock::now();
+    look_up(keys, vectors.data());
+    latencies.push_back(
+        std::chrono::duration<double>(std::chrono::steady_clock::now() - batch_start).count());
+  }
+  const double seconds =
+      std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  std::sort(latencies.begin(), latencies.end());
+  std::cout << name << "\t" << batches.size() * batches[0].size() / seconds / 1e6 << "\t"
+            << latencies[latencies.size() / 2] * 1e3 << "\t"
+            << latencies[latencies.size() * 99 / 100] * 1e3 << std::endl;
+}
+
+int main(int argc, char* argv[]) {
+  try {
+    if (argc < 5 || argc > 9) {
+      std::cout << usage_str << std::endl;
+      exit(-1);
+    }
+    const size_t num_rows = std::stoul(argv[1]);
+    const size_t embedding_vec_size = std::stoul(argv[2]);
+    const size_t batch_size = std::stoul(argv[3]);
+    const double zipf_exponent = std::stod(argv[4]);
+    const size_t num_batches = argc > 5 ? std::stoul(argv[5]) : 100;
+    const double miss_ratio = argc > 6 ? std::stod(argv[6]) : 0.1;
+    // Look up an indexed snapshot of the model in place instead of loading it
+    const bool indexed = argc > 7 && std::stoi(argv[7]) != 0;
+    const std::string file_name = argc > 8 ? argv[8] : "./embedding_table_benchmark.bin";
+    if (num_rows == 0 || batch_size == 0 || num_batches == 0) {
+      std::cout << usage_str << std::endl;
+      exit(-1);
+    }
+
+    const std::string indexed_file_name = file_name + ".indexed";
+    write_sparse_model(file_name, num_rows, embedding_vec_size);
+    if (indexed) {
+      IndexedSnapshot<long long>::convert_from_snapshot(file_name, indexed_file_name,
+                                                        embedding_vec_size, false);
+      std::remove(file_name.c_str());
+      // start cold, as after a restart, and not from the pages just written
+      int fd = open(indexed_file_name.c_str(), O_RDONLY);
+      if (fd != -1) {
+        fdatasync(fd);
+        posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+        close(fd);
+      }
+    } else {
+      std::cout << "unordered_map loaded in "
+                << unordered_map_load_seconds(file_name, num_rows, embedding_vec_size) << " s"
+                << std::endl;
+    }
+    const size_t start_rss_kb = resident_set_kb();
+    const auto load_start = std::chrono::steady_clock::now();
+    cpu_embedding_table<long long> table(indexed ? indexed_file_name : file_name,
+                                         embedding_vec_size, false);
+    std::cout << (table.is_mapped() ? "mapped " : "loaded ") << table.size() << " rows in "
+              << std::chrono::duration<double>(std::chrono::steady_clock::now() - load_start)
+                     .count()
+              << " s, " << table.memory_usage() / double(num_rows) << " bytes per row, "
+              << (resident_set_kb() - start_rss_kb) / 1024 << " MB resident" << std::endl;
+    // a mapped file stays readable after it is removed
+    std::remove(indexed ? indexed_file_name.c_str() : file_name.c_str());
+
+    ZipfKeyGenerator generator(num_rows, zipf_exponent, miss_ratio);
+    std::vector<std::vector<long long>> batches(num_batches, std::vector<long long>(batch_size));
+    for (auto& keys : batches) generator.fill(keys);
+
+    std::cout << "look-up\tM keys/s\tp50 ms\tp99 ms" << std::endl;
+    // one find() and one copy at a time, with a default vector built for each miss
+    run("serial", batches, embedding_vec_size,
+        [&](const std::vector<long long>& keys, float* vectors) {
+          for (size_t i = 0; i < keys.size(); i++) {
+            const float* row = table.find(keys[i]);
+            if (row) {
+              memcpy(vectors + i * embedding_vec_size, row, sizeof(float) * embedding_vec_size);
+            } else {
+              std::vector<float> default_vector(embedding_vec_size, 0.f);
+              memcpy(vectors + i * embedding_vec_size, default_vector.data(),
+                     sizeof(float) * embedding_vec_size);
+            }
+          }
+        });
+    for (int num_threads = 1; num_threads <= omp_get_max_threads(); num_threads *= 2) {
+      run("batched x" + std::to_string(num_threads), batches, embedding_vec_size,
+          [&](const std::vector<long long>& keys, float* vectors) {
+            table.look_up(keys.data(), keys.size(), vectors, num_threads);
+          });
+    }
+    std::cout << (resident_set_kb() - start_rss_kb) / 1024 << " MB resident after the look-ups"
+              << std::endl;
+  } catch (const std::exception& err) {
+    std::cerr << err.what() << std::endl;
+    return -1;
+  }
+  return 0;
+}
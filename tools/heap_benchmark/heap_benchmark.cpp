@@ -0,0 +1,107 @@
+/*
+ * Copyright (c) 2020, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "HugeCTR/include/data_readers/heapex.hpp"
+#include "HugeCTR/include/data_readers/lock_free_heap.hpp"
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace HugeCTR;
+
+static std::string usage_str =
+    "usage: ./heap_benchmark [num_batches_per_worker=200] [batchsize=2048]";
+
+struct FakeChunk {
+  std::vector<float> data;
+  long long seq{-1};
+  FakeChunk(size_t size) : data(size) {}
+};
+
+// spin for about "us" microseconds to emulate parsing or H2D staging
+static void busy_wait(long long us) {
+  auto end = std::chrono::steady_clock::now() + std::chrono::microseconds(us);
+  while (std::chrono::steady_clock::now() < end)
+    ;
+}
+
+// The samples per second which num_workers producers pass through the heap to one consumer
+template <template <typename> class Heap>
+static double heap_throughput(int num_workers, int depth, int num_batches_per_worker,
+                              int batchsize) {
+  Heap<FakeChunk> heap(num_workers, depth, static_cast<size_t>(batchsize));
+  auto producer = [&heap, num_workers, num_batches_per_worker](int worker_id) {
+    std::mt19937 gen(worker_id);
+    std::uniform_int_distribution<long long> parse_us(50, 450);
+    for (int b = 0; b < num_batches_per_worker; b++) {
+      FakeChunk* chunk = heap.checkout_free_chunk(worker_id);
+      busy_wait(parse_us(gen));
+      chunk->seq = static_cast<long long>(b) * num_workers + worker_id;
+      heap.commit_data_chunk(worker_id, false);
+    }
+  };
+
+  auto start = std::chrono::steady_clock::now();
+  std::vector<std::thread> producers;
+  for (int w = 0; w < num_workers; w++) {
+    producers.emplace_back(producer, w);
+  }
+  std::mt19937 gen(num_workers);
+  std::uniform_int_distribution<long long> copy_us(10, 60);
+  long long total_batches = static_cast<long long>(num_workers) * num_batches_per_worker;
+  for (long long i = 0; i < total_batches; i++) {
+    FakeChunk* chunk = heap.checkout_data_chunk();
+    if (chunk->seq != i) {
+      CK_THROW_(Error_t::UnspecificError, "The batches are out of order");
+    }
+    busy_wait(copy_us(gen));
+    heap.return_free_chunk();
+  }
+  for (auto& t : producers) {
+    t.join();
+  }
+  std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+  return total_batches * batchsize / elapsed.count();
+}
+
+int main(int argc, char* argv[]) {
+  try {
+    if (argc > 3) {
+      std::cout << usage_str << std::endl;
+      exit(-1);
+    }
+    const int num_batches_per_worker = argc > 1 ? std::stoi(argv[1]) : 200;
+    const int batchsize = argc > 2 ? std::stoi(argv[2]) : 2048;
+    std::cout << "workers\tdepth\tHeapEx samples/s\tLockFreeHeap samples/s" << std::endl;
+    for (int num_workers : {1, 2, 4, 8, 16}) {
+      for (int depth : {1, 2, 4}) {
+        double heapex_samples_per_sec =
+            heap_throughput<HeapEx>(num_workers, depth, num_batches_per_worker, batchsize);
+        double lock_free_samples_per_sec =
+            heap_throughput<LockFreeHeap>(num_workers, depth, num_batches_per_worker, batchsize);
+        std::cout << num_workers << "\t" << depth << "\t" << heapex_samples_per_sec << "\t"
+                  << lock_free_samples_per_sec << std::endl;
+      }
+    }
+  } catch (const std::exception& err) {
+    std::cerr << err.what() << std::endl;
+    return -1;
+  }
+  return 0;
+}
@@ -0,0 +1,346 @@
+/*
+ * Copyright (c) 2020, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "HugeCTR/include/model_oversubscriber/flat_hash_table.hpp"
+#include "HugeCTR/include/model_oversubscriber/radix_sort.hpp"
+#include "HugeCTR/include/model_oversubscriber/row_codec.hpp"
+#include "HugeCTR/include/model_oversubscriber/snapshot_pipeline.hpp"
+#include <sys/statvfs.h>
+#include <unistd.h>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+using namespace HugeCTR;
+
+static std::string usage_str = "usage: ./model_oversubscriber_benchmark <flat_hash_table|keyset|snapshot|row_codec>";
+
+// The seconds which f takes
+template <typename F>
+static double seconds_of(F f) {
+  auto start = std::chrono::steady_clock::now();
+  f();
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+// Inserts and lookups of random keys, in a FlatHashTable against a std::unordered_map
+namespace flat_hash_table {
+
+template <typename Table, typename Insert, typename Find>
+void benchmark(const char* name, size_t num_keys, const std::vector<long long>& keys,
+               Insert insert, Find find) {
+  Table table;
+  double insert_time = seconds_of([&]() {
+    for (size_t i = 0; i < num_keys; i++) {
+      insert(table, keys[i], i);
+    }
+  });
+  // half of the lookups miss
+  size_t hits = 0;
+  double find_time = seconds_of([&]() {
+    for (size_t i = 0; i < 2 * num_keys; i++) {
+      hits += find(table, keys[i]);
+    }
+  });
+  if (hits != num_keys) {
+    CK_THROW_(Error_t::UnspecificError, std::string(name) + " found other keys than inserted");
+  }
+  std::cout << name << "\t" << num_keys << "\t" << num_keys / insert_time << "\t"
+            << 2 * num_keys / find_time << std::endl;
+}
+
+// the keys of the sizes which don't fit in the memory are skipped
+void run() {
+  const size_t phys_bytes =
+      static_cast<size_t>(sysconf(_SC_PHYS_PAGES)) * static_cast<size_t>(sysconf(_SC_PAGESIZE));
+  std::cout << "table\tkeys\tinserts/s\tlookups/s" << std::endl;
+  for (size_t num_keys : {10000000ul, 100000000ul, 1000000000ul}) {
+    // 8 bytes of a key to insert and another to miss, plus about 64 bytes per key of the
+    // std::unordered_map node and bucket
+    if (num_keys * (2 * sizeof(long long) + 64) > phys_bytes / 4 * 3) {
+      std::cout << "skip " << num_keys << " keys of " << phys_bytes / (1 << 20) << " MB memory"
+                << std::endl;
+      continue;
+    }
+    std::vector<long long> keys(2 * num_keys);
+    std::mt19937_64 gen(num_keys);
+    std::generate(keys.begin(), keys.end(), [&gen]() { return static_cast<long long>(gen() >> 1); });
+    std::sort(keys.begin(), keys.end());
+    keys.erase(std::unique(keys.begin(), keys.end()), keys.end());
+    while (keys.size() < 2 * num_keys) {
+      keys.push_back(keys.back() + 1);
+    }
+    std::shuffle(keys.begin(), keys.end(), gen);
+
+    using Map = std::unordered_map<long long, std::pair<size_t, size_t>>;
+    benchmark<Map>(
+        "unordered_map", num_keys, keys,
+        [](Map& map, long long key, size_t i) { map.insert({key, {0, i}}); },
+        [](const Map& map, long long key) { return map.find(key) != map.end(); });
+    benchmark<FlatHashTable<long long>>(
+        "flat", num_keys, keys,
+        [](FlatHashTable<long long>& table, long long key, size_t i) { table.insert(key, 0, i); },
+        [](const FlatHashTable<long long>& table, long long key) {
+          return table.find(key) != nullptr;
+        });
+  }
+}
+
+}  // namespace flat_hash_table
+
+// The hits of a keyset ordered by a std::map, as it used to be, and by the radix sort
+namespace keyset {
+
+const size_t num_keys = 1 << 23;
+const size_t keyset_size = num_keys / 2;
+
+void run() {
+  FlatHashTable<long long> table;
+  table.reserve(num_keys);
+  std::mt19937_64 gen(0);
+  for (size_t i = 0; i < num_keys; i++) {
+    table.insert(static_cast<long long>(gen() >> 1), 0, i);
+  }
+  std::vector<long long> keyset;
+  keyset.reserve(keyset_size);
+  table.for_each([&](const FlatHashTable<long long>::Entry& entry) {
+    if (keyset.size() < keyset_size) keyset.push_back(entry.key);
+  });
+  std::shuffle(keyset.begin(), keyset.end(), gen);
+
+  std::map<size_t, long long> pair_exist;
+  double map_time = seconds_of([&]() {
+    for (long long key : keyset) {
+      auto entry = table.find(key);
+      pair_exist.insert({entry->offset(), entry->key});
+    }
+  });
+  std::vector<FlatHashTable<long long>::Entry> hits;
+  hits.reserve(keyset_size);
+  double radix_sort_time = seconds_of([&]() {
+    for (long long key : keyset) {
+      hits.push_back(*table.find(key));
+    }
+    radix_sort_by_offset(hits, table.size(), omp_get_max_threads());
+  });
+  if (hits.size() != pair_exist.size() || hits.front().offset() != pair_exist.begin()->first) {
+    CK_THROW_(Error_t::UnspecificError, "The radix sort ordered the hits otherwise");
+  }
+  std::cout << "keyset of " << keyset_size << " keys: std::map " << map_time << " s, radix sort "
+            << radix_sort_time << " s" << std::endl;
+}
+
+}  // namespace keyset
+
+// The import and the export of a synthetic snapshot of up to 4 GB, as large as the disk and the
+// memory allow, by the SnapshotPipeline and by the delegates before it. The three files fit in
+// the page cache, so the numbers are an upper bound of what the disk gives, and each pass runs
+// twice in turns not to favour the one run right after the snapshot is written
+namespace snapshot {
+
+const size_t embedding_vec_size = 128;
+const char* src_snapshot_file = "snapshot_benchmark_src.bin";
+const char* dst_snapshot_file = "snapshot_benchmark_dst.bin";
+const char* embedding_file = "snapshot_benchmark_embedding.bin";
+
+// a snapshot of num_rows rows with distinct keys, and the vector of each row filled with its row
+void write_snapshot(const char* file_name, size_t num_rows) {
+  std::ofstream snapshot(file_name, std::ofstream::binary | std::ofstream::trunc);
+  std::vector<float> vector(embedding_vec_size);
+  const size_t chunk_rows = 1 << 16;
+  std::vector<char> chunk;
+  for (size_t row = 0; row < num_rows; row++) {
+    long long key = static_cast<long long>(row * 7 + 3);
+    std::fill(vector.begin(), vector.end(), static_cast<float>(row));
+    chunk.insert(chunk.end(), (char*)&key, (char*)&key + sizeof(long long));
+    chunk.insert(chunk.end(), (char*)vector.data(), (char*)(vector.data() + embedding_vec_size));
+    if ((row + 1) % chunk_rows == 0 || row + 1 == num_rows) {
+      snapshot.write(chunk.data(), chunk.size());
+      chunk.clear();
+    }
+  }
+}
+
+// the import of the delegates before the pipeline: 1024 rows at a time on one thread, through
+// the streams
+void legacy_import(const char* snapshot_file, const char* embedding_table_file,
+                   FlatHashTable<long long>& hash_table) {
+  std::ifstream snapshot(snapshot_file, std::ifstream::binary | std::ifstream::ate);
+  const size_t file_size_in_byte = snapshot.tellg();
+  snapshot.seekg(0);
+  std::ofstream embedding_table(embedding_table_file, std::ofstream::binary | std::ofstream::trunc);
+  const size_t vector_size = sizeof(float) * embedding_vec_size;
+  const size_t row_size = sizeof(long long) + vector_size;
+  const size_t num_rows = file_size_in_byte / row_size;
+  const size_t num_unit_rows = 1024;
+  std::unique_ptr<char[]> read_chunk(new char[num_unit_rows * row_size]);
+  std::unique_ptr<char[]> write_chunk(new char[num_unit_rows * vector_size]);
+  for (size_t begin = 0; begin < num_rows; begin += num_unit_rows) {
+    const size_t rows = std::min(num_unit_rows, num_rows - begin);
+    snapshot.read(read_chunk.get(), rows * row_size);
+    for (size_t k = 0; k < rows; k++) {
+      const char* src = read_chunk.get() + k * row_size;
+      hash_table.insert(*(const long long*)src, 0, begin + k);
+      memcpy(write_chunk.get() + k * vector_size, src + sizeof(long long), vector_size);
+    }
+    embedding_table.write(write_chunk.get(), rows * vector_size);
+  }
+}
+
+// the export of the delegates before the pipeline
+void legacy_export(const char* embedding_table_file, const char* snapshot_file,
+                   const FlatHashTable<long long>& hash_table) {
+  std::vector<long long> idx2key(hash_table.size());
+  hash_table.for_each([&idx2key](const FlatHashTable<long long>::Entry& entry) {
+    idx2key[entry.offset()] = entry.key;
+  });
+  std::ifstream embedding_table(embedding_table_file, std::ifstream::binary);
+  std::ofstream snapshot(snapshot_file, std::ofstream::binary | std::ofstream::trunc);
+  const size_t vector_size = sizeof(float) * embedding_vec_size;
+  const size_t row_size = sizeof(long long) + vector_size;
+  const size_t num_unit_rows = 1024;
+  std::unique_ptr<char[]> read_chunk(new char[num_unit_rows * vector_size]);
+  std::unique_ptr<char[]> write_chunk(new char[num_unit_rows * row_size]);
+  for (size_t begin = 0; begin < idx2key.size(); begin += num_unit_rows) {
+    const size_t rows = std::min(num_unit_rows, idx2key.size() - begin);
+    embedding_table.read(read_chunk.get(), rows * vector_size);
+    for (size_t k = 0; k < rows; k++) {
+      char* dst = write_chunk.get() + k * row_size;
+      *(long long*)dst = idx2key[begin + k];
+      memcpy(dst + sizeof(long long), read_chunk.get() + k * vector_size, vector_size);
+    }
+    snapshot.write(write_chunk.get(), rows * row_size);
+  }
+}
+
+void run() {
+  const size_t row_size = sizeof(long long) + sizeof(float) * embedding_vec_size;
+  struct statvfs fs;
+  size_t snapshot_size = size_t(4) << 30;
+  if (statvfs(".", &fs) == 0) {
+    snapshot_size = std::min(snapshot_size, fs.f_bavail * fs.f_frsize / 4);
+  }
+  const size_t phys_bytes =
+      static_cast<size_t>(sysconf(_SC_PHYS_PAGES)) * static_cast<size_t>(sysconf(_SC_PAGESIZE));
+  snapshot_size = std::min(snapshot_size, phys_bytes / 8);
+  const size_t num_rows = snapshot_size / row_size;
+  write_snapshot(src_snapshot_file, num_rows);
+
+  auto report = [num_rows, row_size](const char* name, double seconds) {
+    std::cout << name << "\t" << num_rows << "\t" << seconds << "\t"
+              << num_rows * row_size / seconds / (1 << 20) << std::endl;
+  };
+  std::cout << "pass\trows\tseconds\tMB/s of snapshot" << std::endl;
+  for (int round = 0; round < 2; round++) {
+    {
+      SnapshotPipeline<long long> pipeline(embedding_vec_size, false);
+      FlatHashTable<long long> hash_table;
+      report("pipeline import", seconds_of([&]() {
+               pipeline.import_snapshot(src_snapshot_file, embedding_file, hash_table);
+             }));
+      report("pipeline export", seconds_of([&]() {
+               pipeline.export_snapshot(embedding_file, dst_snapshot_file, hash_table);
+             }));
+      if (hash_table.size() != num_rows) {
+        CK_THROW_(Error_t::UnspecificError, "The pipeline imported other keys than written");
+      }
+    }
+    {
+      FlatHashTable<long long> hash_table;
+      report("legacy import", seconds_of([&]() {
+               legacy_import(src_snapshot_file, embedding_file, hash_table);
+             }));
+      report("legacy export", seconds_of([&]() {
+               legacy_export(embedding_file, dst_snapshot_file, hash_table);
+             }));
+    }
+  }
+  std::remove(src_snapshot_file);
+  std::remove(dst_snapshot_file);
+  std::remove(embedding_file);
+}
+
+}  // namespace snapshot
+
+// The bytes of a row in each StoragePrecision_t, and the rows converted per second each way
+namespace row_codec {
+
+const size_t num_rows = 1 << 18;
+const size_t embedding_vec_size = 128;
+
+void run() {
+  const StoragePrecision_t precisions[] = {StoragePrecision_t::FP32, StoragePrecision_t::FP16,
+                                           StoragePrecision_t::BF16, StoragePrecision_t::INT8};
+  const char* precision_names[] = {"fp32", "fp16", "bf16", "int8"};
+  std::mt19937 gen(0);
+  std::normal_distribution<float> dis(0.f, 0.05f);
+  std::vector<float> src(num_rows * embedding_vec_size), dst(src.size());
+  std::generate(src.begin(), src.end(), [&]() { return dis(gen); });
+  for (size_t p = 0; p < 4; p++) {
+    RowCodec codec(precisions[p], embedding_vec_size);
+    std::vector<char> rows(num_rows * codec.row_size_in_byte());
+    double encode_time = seconds_of([&]() {
+      for (size_t row = 0; row < num_rows; row++) {
+        codec.encode(&src[row * embedding_vec_size], &rows[row * codec.row_size_in_byte()]);
+      }
+    });
+    double decode_time = seconds_of([&]() {
+      for (size_t row = 0; row < num_rows; row++) {
+        codec.decode(&rows[row * codec.row_size_in_byte()], &dst[row * embedding_vec_size]);
+      }
+    });
+    std::cout << precision_names[p] << ": " << codec.row_size_in_byte() << " bytes per row, "
+              << num_rows / encode_time / 1e6 << " M rows/s encoded, "
+              << num_rows / decode_time / 1e6 << " M rows/s decoded" << std::endl;
+  }
+}
+
+}  // namespace row_codec
+
+int main(int argc, char* argv[]) {
+  try {
+    if (argc != 2) {
+      std::cout << usage_str << std::endl;
+      exit(-1);
+    }
+    const std::string benchmark(argv[1]);
+    if (benchmark == "flat_hash_table") {
+      flat_hash_table::run();
+    } else if (benchmark == "keyset") {
+      keyset::run();
+    } else if (benchmark == "snapshot") {
+      snapshot::run();
+    } else if (benchmark == "row_codec") {
+      row_codec::run();
+    } else {
+      std::cout << usage_str << std::endl;
+      exit(-1);
+    }
+  } catch (const std::exception& err) {
+    std::cerr << err.what() << std::endl;
+    return -1;
+  }
+  return 0;
+}
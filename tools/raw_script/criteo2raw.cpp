@@ -15,6 +15,7 @@
  */
 
 #include "HugeCTR/include/utils.hpp"
+#include "HugeCTR/include/data_readers/block_codec.hpp"
 #include <fstream>
 #include <iostream>
 #include <ios>
@@ -23,7 +24,7 @@
 #include <vector>
 using namespace HugeCTR;
 
-static std::string usage_str = "usage: ./criteo2raw in.txt out.bin"; 
+static std::string usage_str = "usage: ./criteo2raw in.txt out.bin [option: none|lz4|zstd, default is none]"; 
 
 static const int dense_dim = 13;
 static const int label_dim = 1;
@@ -39,10 +40,19 @@ std::vector<std::string> &split(const std::string &s, char delim, std::vector<st
 }
 
 int main(int argc, char* argv[]){
-  if (argc != 3){
+  if (argc != 3 && argc != 4){
     std::cout << usage_str << std::endl;
     exit(-1);
   }
+  Compression_t compression = Compression_t::None;
+  if (argc == 4) {
+    try {
+      compression = compression_from_string(argv[3]);
+    } catch (const std::runtime_error& rt_err) {
+      std::cerr << rt_err.what() << std::endl;
+      exit(-1);
+    }
+  }
 
   //open txt file
   std::ifstream txt_file(argv[1], std::ifstream::binary);
@@ -51,12 +61,23 @@ int main(int argc, char* argv[]){
   }
 
   std::ofstream out_file(argv[2], std::ofstream::out);
+  if (compression != Compression_t::None) {
+    // the number of samples is written at the end
+    write_raw_compressed_header(out_file, 0, label_dim, dense_dim, SLOT_NUM, compression);
+  }
+  BlockWriter block_writer(out_file, compression);
   int num_samples = 0;
   do{
     std::string line;
     std::getline(txt_file, line);
     if(txt_file.eof()){
       txt_file.close();
+      block_writer.flush();
+      if (compression != Compression_t::None) {
+        out_file.seekp(std::ios_base::beg);
+        write_raw_compressed_header(out_file, num_samples, label_dim, dense_dim, SLOT_NUM,
+                                    compression);
+      }
       out_file.close();
       std::cout << "#samples: " << num_samples << std::endl;
       break;
@@ -69,12 +90,13 @@ int main(int argc, char* argv[]){
     }
     for(int j = 0; j < dense_dim+label_dim; j++){
       float label_dense = std::stod(vec_string[j]);
-      out_file.write(reinterpret_cast<char*>(&label_dense), sizeof(float));
+      block_writer.write(reinterpret_cast<char*>(&label_dense), sizeof(float));
     }
     for(int j = dense_dim+label_dim; j < dense_dim+label_dim+SLOT_NUM; j++){
       int sparse = std::stod(vec_string[j]);
-      out_file.write(reinterpret_cast<char*>(&sparse), sizeof(int));
+      block_writer.write(reinterpret_cast<char*>(&sparse), sizeof(int));
     }
+    block_writer.end_record();
     num_samples++;
   }while(1);
   return 0;
@@ -0,0 +1,70 @@
+/*
+ * Copyright (c) 2020, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "HugeCTR/include/model_oversubscriber/indexed_snapshot.hpp"
+#include <iostream>
+#include <string>
+
+using namespace HugeCTR;
+
+static std::string usage_str =
+    "usage: ./snapshot_converter <to-indexed|to-raw> src_snapshot dst_snapshot "
+    "embedding_vec_size <distributed|localized> <I64|I32>";
+
+template <typename KeyType>
+static void convert(const std::string& direction, const std::string& src, const std::string& dst,
+                    size_t embedding_vec_size, bool has_slot_id) {
+  if (direction == "to-indexed") {
+    IndexedSnapshot<KeyType>::convert_from_snapshot(src, dst, embedding_vec_size, has_slot_id);
+  } else {
+    // the embedding_vec_size and the slot_id are read from the header
+    auto header = IndexedSnapshot<KeyType>::read_header(src);
+    if (header.embedding_vec_size != embedding_vec_size ||
+        (header.has_slot_id != 0) != has_slot_id) {
+      CK_THROW_(Error_t::WrongInput, "The indexed snapshot doesn't match the arguments");
+    }
+    IndexedSnapshot<KeyType>::convert_to_snapshot(src, dst);
+  }
+}
+
+int main(int argc, char* argv[]) {
+  try {
+    if (argc != 7) {
+      std::cout << usage_str << std::endl;
+      exit(-1);
+    }
+    const std::string direction(argv[1]);
+    const std::string embedding_type(argv[5]);
+    const std::string key_type(argv[6]);
+    if ((direction != "to-indexed" && direction != "to-raw") ||
+        (embedding_type != "distributed" && embedding_type != "localized") ||
+        (key_type != "I64" && key_type != "I32")) {
+      std::cout << usage_str << std::endl;
+      exit(-1);
+    }
+    const size_t embedding_vec_size = std::stoul(argv[4]);
+    const bool has_slot_id = embedding_type == "localized";
+    if (key_type == "I64") {
+      convert<long long>(direction, argv[2], argv[3], embedding_vec_size, has_slot_id);
+    } else {
+      convert<unsigned int>(direction, argv[2], argv[3], embedding_vec_size, has_slot_id);
+    }
+  } catch (const std::exception& err) {
+    std::cerr << err.what() << std::endl;
+    return -1;
+  }
+  return 0;
+}